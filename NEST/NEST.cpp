@@ -19,9 +19,10 @@
  */
 NEST::NEST()
 	: pWnd(nullptr), pRenderer(nullptr), 
-	iv(NES::Instance())
+	nes(std::make_unique<NES>()), iv(nes.get(), &textures)
 {
 	x = y = width = height = 0;
+	perf_freq = next_frame = 0;
 
 	// NEST states
 	isrunning = true;
@@ -80,7 +81,7 @@ bool NEST::Init(const std::string title, const bool full_screen,
 	} // end pRender
 	
 	// load font
-	TextureManager::Instance()->Load_Font("C:\\Windows\\Fonts\\Consola.ttf");
+	textures.Load_Font("C:\\Windows\\Fonts\\Consola.ttf");
 
 	this->x = x;
 	this->y = y;
@@ -90,17 +91,43 @@ bool NEST::Init(const std::string title, const bool full_screen,
 
 	// create a dummy surface
 	iv.Init(pRenderer);
-	screen_id = TextureManager::Instance()->Create_Texture(256, 240, pRenderer);
+	screen_id = textures.Create_Texture(256, 240, pRenderer);
+
+	// start the frame clock
+	perf_freq = SDL_GetPerformanceFrequency();
+	next_frame = SDL_GetPerformanceCounter();
 	return true;
 } // end Init
 
 
+//=====================================================================|
+/**
+ * @brief Puts the ROM at path into the console and resets it.
+ *
+ * @param path the .nes file
+ *
+ * @return false with the reason in error_string when it won't load
+ */
+bool NEST::Load_ROM(const std::string& path)
+{
+	if (!nes->Insert_Cartridge(path))
+	{
+		error_string = nes->Get_Error_Message();
+		return false;
+	} // end if
+
+	return true;
+} // end Load_ROM
+
+
 //=====================================================================|
 /**
  * @brief Cleans the resources and kills the main window
  */
 void NEST::Cleanup()
 {
+	Stop();
+
 	SDL_DestroyRenderer(pRenderer);
 	SDL_DestroyWindow(pWnd);
 	pWnd = nullptr;
@@ -134,24 +161,23 @@ bool NEST::Is_Running() const
 
 //=====================================================================|
 /**
- * @brief Renders the texturs on the screen at warap speeds for emulator
+ * @brief Renders the texturs on the screen at warap speeds for emulator;
+ *	the newest frame the emulation thread finished, picture and IV alike,
+ *	when there is one it hasn't shown yet. However long presenting takes,
+ *	vsync or IV redraws, the emulation thread goes on without it.
+ *
+ * @return false when there was no new frame, and nothing was drawn
  */
-void NEST::Render()
+bool NEST::Render()
 {
+	if (!frames.Acquire())
+		return false;
+
+	NEST_Frame& frame = frames.Front();
 	SDL_RenderClear(pRenderer);
 	
-	//
-	TextureManager::Instance()->Lock(screen_id);
-
-	for (int i = 0; i < 1000; i++)
-	{
-		int x = rand() % 256;
-		int y = rand() % 240;
-		u32 color = RGBA(rand(), rand(), rand(), rand());
-		TextureManager::Instance()->Plot_Pixel(x, y, color);
-	}
-
-	TextureManager::Instance()->Unlock(screen_id);
+	// the PPU's frame, already in colors
+	textures.Upload_Pixels(screen_id, frame.rgba);
 
 	SDL_Rect src, dest;
 	src.x = dest.x = 0;
@@ -161,35 +187,110 @@ void NEST::Render()
 	src.h = 240;
 	dest.h = 480;
 	SDL_RenderCopyEx(pRenderer, 
-		TextureManager::Instance()->Get_Texture_Info(screen_id).ptexture, 
+		textures.Get_Texture_Info(screen_id).ptexture, 
 		&src, &dest, 0, 0, SDL_FLIP_NONE);
 
+	iv.Show(&frame.state);
 	iv.Draw_CPU();
 	iv.Draw_RAM();
 	iv.Draw_Disasm();
 
 	SDL_RenderPresent(pRenderer);
+	return true;
 } // Render
 
 
 //=====================================================================|
 /**
- * @brief updates the state of emulator
+ * @brief Starts the emulation thread; the console runs on it from now on,
+ *	and the thread that called only handles events and presents. The ROM
+ *	goes in before, and nothing else touches the console until Stop.
+ */
+void NEST::Start()
+{
+	if (emulator.joinable())
+		return;
+
+	next_frame = SDL_GetPerformanceCounter();
+	emulator = std::thread(&NEST::Emulate, this);
+} // end Start
+
+
+//=====================================================================|
+/**
+ * @brief Asks the emulation thread to stop once it is through with the
+ *	frame it is on, and waits for it to.
+ */
+void NEST::Stop()
+{
+	if (!emulator.joinable())
+		return;
+
+	while (!commands.Push(Command::Stop))
+		SDL_Delay(1);
+
+	emulator.join();
+} // end Stop
+
+
+//=====================================================================|
+/**
+ * @brief The emulation thread: takes the commands that came in, runs a
+ *	frame unless paused, and waits out the rest of the 1/60th second. It
+ *	never waits on the render thread; a frame the render thread was too
+ *	slow to show is simply replaced by the next.
+ */
+void NEST::Emulate()
+{
+	bool paused = false;
+	for (;;)
+	{
+		Command command;
+		while (commands.Pop(command))
+		{
+			if (command == Command::Stop)
+				return;
+			if (command == Command::Pause)
+				paused = !paused;
+		} // end while
+
+		if (!paused)
+			Update();
+
+		Wait_Frame();
+	} // end for
+} // end Emulate
+
+
+//=====================================================================|
+/**
+ * @brief updates the state of emulator by running one whole NTSC frame;
+ *	the PPU keeps the time, 29780.5 CPU cycles a frame on average. The
+ *	picture and a snapshot for IV go out through the triple buffer. A
+ *	frame the render thread was too slow for is dropped, writes and all;
+ *	the snapshot after it doesn't follow the one IV drew last, and IV
+ *	redraws in full.
  */
 void NEST::Update()
 {
-	NES::Instance()->cpu.Clock();
+	nes->Run_Frame();
+
+	NEST_Frame& frame = frames.Back();
+	memcpy(frame.rgba, nes->ppu.Get_Frame_RGBA(), sizeof(frame.rgba));
+	nes->Take_Snapshot(frame.state);
+	frames.Publish();
 } // end Update
 
 
 //=====================================================================|
 /**
- * @brief handles keyboard entries and processes them
+ * @brief handles keyboard entries and processes them; drains every event
+ *	that queued up since the last frame.
  */
 void NEST::Handle_Events()
 {
 	SDL_Event event;
-	if (SDL_PollEvent(&event))
+	while (SDL_PollEvent(&event))
 	{
 		switch (event.type)
 		{
@@ -204,10 +305,43 @@ void NEST::Handle_Events()
 		default:
 			break;
 		} // end switch
-	} // end if poll event
+	} // end while poll event
 } // end Handle_Events
 
 
+//=====================================================================|
+/**
+ * @brief paces the emulation thread to the NTSC frame rate of 60.0988 Hz. It
+ *	sleeps off most of the time left in the frame and spins for the last
+ *	couple of milliseconds, since SDL_Delay is only millisecond accurate
+ *	(and much worse on some systems). If we fall behind by more than a few
+ *	frames the clock is resynced rather than racing to catch up.
+ */
+void NEST::Wait_Frame()
+{
+	const u64 frame_ticks = (u64)(perf_freq / FRAME_RATE_NTSC);
+	const u64 spin_ticks = perf_freq / 500;		// last 2ms are spun
+	
+	next_frame += frame_ticks;
+	u64 now = SDL_GetPerformanceCounter();
+
+	if (now > next_frame + frame_ticks * 4)
+	{
+		next_frame = now;	// too far behind, don't try to catch up
+		return;
+	} // end if lagging
+
+	while (now < next_frame)
+	{
+		u64 left = next_frame - now;
+		if (left > spin_ticks)
+			SDL_Delay((u32)(((left - spin_ticks) * 1000) / perf_freq));
+
+		now = SDL_GetPerformanceCounter();
+	} // end while waiting
+} // end Wait_Frame
+
+
 //=====================================================================|
 /**
  * @brief toggles pause on/off
@@ -215,6 +349,7 @@ void NEST::Handle_Events()
 void NEST::Pause()
 {
 	isPaused = !isPaused;
+	commands.Push(Command::Pause);
 } // end Pause
 
 
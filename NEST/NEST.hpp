@@ -10,11 +10,25 @@
 
 //=====================================================================|
 #include "iv.hpp"
+#include "triple-buffer.hpp"
+#include "spsc-queue.hpp"
+#include <thread>
 
 
 
 
 //=====================================================================|
+/**
+ * @brief What the emulation thread hands the render thread each frame:
+ *	the picture and, for IV, the state it was left in.
+ */
+struct NEST_Frame
+{
+	u32 rgba[SCREEN_WIDTH * SCREEN_HEIGHT];
+	NES_Snapshot state;
+};
+
+
 class NEST
 {
 public:
@@ -26,13 +40,18 @@ public:
 		const int x = WINDOW_X, const int y = WINDOW_Y,
 		const int width = WINDOW_WIDTH, const int height = WINDOW_HEIGHT);
 	void Cleanup();
+	bool Load_ROM(const std::string& path);
 
 	void Set_IsRunning(const bool v);
 	bool Is_Running() const;
 
-	void Render();
+	void Start();
+	void Stop();
+
+	bool Render();
 	void Update();
 	void Handle_Events();
+	void Wait_Frame();
 
 	void Pause();
 	bool Is_Paused() const;
@@ -49,16 +68,33 @@ private:
 	bool isfull_screen;	// fullscreen vs windowed mode
 	bool isPaused;		// stops running NEST code when true
 
+	// the console and what draws it; the NES is big enough to keep off
+	//	the stack
+	std::unique_ptr<NES> nes;
+	TextureManager textures;
 	IV iv;				// internal view - snapshot of NES internal dump
 	int screen_id = 0;
 
 	// window props
 	int x, y, width, height;
 
+	// frame pacing
+	u64 perf_freq;		// performance counter ticks per second
+	u64 next_frame;		// counter value at which the next frame is due
+
+
+	// the emulation thread, and what goes between it and this one; frames
+	//	one way, commands the other
+	enum class Command : u8 { Pause, Stop };
+
+	std::thread emulator;
+	TripleBuffer<NEST_Frame> frames;
+	SpscQueue<Command, 64> commands;
 
 	// misc
 	std::string error_string;
 
 	// util
 	void Handle_Keys(SDL_Event& event);
+	void Emulate();
 };
\ No newline at end of file
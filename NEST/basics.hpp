@@ -11,9 +11,15 @@
 #include <string>
 #include <vector>
 #include <cstdlib>
+#include <cstdint>
+#include <cstring>
 #include <cctype>
 #include <map>
 
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
 
 
 //=====================================================================|
@@ -37,6 +43,82 @@ typedef int64_t s64;
 
 
 
+//=====================================================================|
+/**
+ * @brief The tables for Crc32, made at compile time: t[0] is the usual
+ *	byte at a time one, and t[k] what a byte does to the crc k bytes
+ *	further back, so eight bytes fold in with eight lookups.
+ */
+struct Crc32_Tables
+{
+	u32 t[8][256];
+
+	constexpr Crc32_Tables() : t()
+	{
+		for (u32 i = 0; i < 256; ++i)
+		{
+			u32 crc = i;
+			for (int bit = 0; bit < 8; ++bit)
+				crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+			t[0][i] = crc;
+		} // end for
+
+		for (u32 k = 1; k < 8; ++k)
+		{
+			for (u32 i = 0; i < 256; ++i)
+				t[k][i] = (t[k - 1][i] >> 8) ^ t[0][t[k - 1][i] & 0xFF];
+		} // end for
+	} // end constructor
+};
+
+inline constexpr Crc32_Tables crc32_tables;
+
+
+
+//=====================================================================|
+/**
+ * @brief The crc32 zip uses, eight bytes at a time; names ROMs to the
+ *	static recompiler and its programs, and frames and RAM in the batch
+ *	reports.
+ */
+inline u32 Crc32(const u8* data, size_t size)
+{
+	const u32 (&t)[8][256] = crc32_tables.t;
+	u32 crc = 0xFFFFFFFF;
+
+	for (; size >= 8; size -= 8, data += 8)
+	{
+		const u32 lo = crc ^ (data[0] | (data[1] << 8) | (data[2] << 16) | ((u32)data[3] << 24));
+		const u32 hi = data[4] | (data[5] << 8) | (data[6] << 16) | ((u32)data[7] << 24);
+		crc = t[7][lo & 0xFF] ^ t[6][(lo >> 8) & 0xFF] ^ t[5][(lo >> 16) & 0xFF] ^ t[4][lo >> 24] ^
+			t[3][hi & 0xFF] ^ t[2][(hi >> 8) & 0xFF] ^ t[1][(hi >> 16) & 0xFF] ^ t[0][hi >> 24];
+	} // end for
+
+	for (; size; --size, ++data)
+		crc = (crc >> 8) ^ t[0][(crc ^ *data) & 0xFF];
+
+	return ~crc;
+} // end Crc32
+
+
+
+//=====================================================================|
+/**
+ * @brief The index of the lowest set bit of a non zero word.
+ */
+inline u32 Ctz64(const u64 v)
+{
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward64(&index, v);
+	return (u32)index;
+#else
+	return (u32)__builtin_ctzll(v);
+#endif
+} // end Ctz64
+
+
+
 //=====================================================================|
 #define WINDOW_WIDTH	1024
 #define WINDOW_HEIGHT	768
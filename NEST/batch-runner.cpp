@@ -0,0 +1,307 @@
+/**
+ * @brief The implementation of the batch runner.
+ *
+ * @author Rediet Worku
+ * @date 26th of October 2021, Sunday
+ */
+
+//=====================================================================|
+#include "batch-runner.hpp"
+
+#include <chrono>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+
+#include <cstdio>
+#include <set>
+#endif
+
+
+
+//=====================================================================|
+/**
+ * @brief constructor
+ *
+ * @param threads how many workers; 0 for one per physical core
+ * @param pin whether each worker stays on a core of its own
+ */
+BatchRunner::BatchRunner(const u32 threads, const bool pin)
+	: threads(threads), pin(pin), pin_failures(0), steals(0)
+{
+	const u32 cores = Find_Cpus(cpus);
+	if (!this->threads)
+		this->threads = cores;
+	if (!this->threads)
+		this->threads = 1;
+} // end constructor
+
+
+//=====================================================================|
+/**
+ * @brief Runs every job to the end on the pool. The jobs are dealt out
+ *	round the workers, and the workers started; the calling thread only
+ *	waits for them.
+ *
+ * @param jobs what to run
+ * @param results gets one for each job, in the same order
+ *
+ * @return the wall time the whole batch took, in seconds
+ */
+double BatchRunner::Run(const std::vector<Batch_Job>& jobs, std::vector<Batch_Result>& results)
+{
+	results.assign(jobs.size(), Batch_Result());
+
+	workers.clear();
+	for (u32 i = 0; i < threads; i++)
+		workers.push_back(std::make_unique<Worker>());
+
+	for (size_t i = 0; i < jobs.size(); i++)
+		workers[i % threads]->jobs.push_back((u32)i);
+
+	steals = 0;
+	pin_failures = 0;
+
+	const auto start = std::chrono::steady_clock::now();
+
+	std::vector<std::thread> pool;
+	for (u32 i = 0; i < threads; i++)
+	{
+		pool.emplace_back(&BatchRunner::Work, this, i, std::cref(jobs), std::ref(results));
+		if (pin && (cpus.empty() || !Pin_Thread(pool.back(), cpus[i % cpus.size()])))
+			pin_failures++;
+	} // end for
+
+	for (std::thread& t : pool)
+		t.join();
+
+	const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+	workers.clear();
+	return elapsed.count();
+} // end Run
+
+
+//=====================================================================|
+/**
+ * @brief A worker: runs whatever job it can take until there's none left
+ *	to start anywhere. Jobs never go back on a deque, so once every deque
+ *	is empty nothing more can turn up and the worker is done, even if
+ *	others are still running theirs.
+ *
+ * @param id the worker's index
+ * @param jobs the batch
+ * @param results where each job's goes
+ */
+void BatchRunner::Work(const u32 id, const std::vector<Batch_Job>& jobs, std::vector<Batch_Result>& results)
+{
+	u32 job;
+	while (Take(id, job))
+	{
+		Run_Job(jobs[job], results[job]);
+		results[job].worker = id;
+	} // end while
+} // end Work
+
+
+//=====================================================================|
+/**
+ * @brief Finds the next job for worker id: the back of its own deque, or
+ *	failing that the front of another's.
+ *
+ * @param id the worker
+ * @param job gets the job's index
+ *
+ * @return false when no deque has any
+ */
+bool BatchRunner::Take(const u32 id, u32& job)
+{
+	{
+		Worker& self = *workers[id];
+		std::lock_guard<std::mutex> guard(self.lock);
+		if (!self.jobs.empty())
+		{
+			job = self.jobs.back();
+			self.jobs.pop_back();
+			return true;
+		} // end if
+	}
+
+	for (u32 i = 1; i < threads; i++)
+	{
+		Worker& victim = *workers[(id + i) % threads];
+		std::lock_guard<std::mutex> guard(victim.lock);
+		if (!victim.jobs.empty())
+		{
+			job = victim.jobs.front();
+			victim.jobs.pop_front();
+			steals.fetch_add(1, std::memory_order_relaxed);
+			return true;
+		} // end if
+	} // end for
+
+	return false;
+} // end Take
+
+
+//=====================================================================|
+/**
+ * @brief Runs one job start to finish on a console of its own. Only the
+ *	very last frame is drawn, the rest skip their pixels, which the game
+ *	can't tell.
+ *
+ * @param job what to run
+ * @param result gets how it ended
+ */
+void BatchRunner::Run_Job(const Batch_Job& job, Batch_Result& result)
+{
+	const auto start = std::chrono::steady_clock::now();
+
+	std::unique_ptr<NES> nes = std::make_unique<NES>();
+	if (!nes->Insert_Cartridge(job.rom))
+	{
+		result.error = nes->Get_Error_Message();
+		return;
+	} // end if
+
+	nes->cpu.Set_Backend(job.backend);
+	nes->cpu.Set_Idle_Skip(job.idle_skip);
+	const u64 first_cycle = nes->cpu.Get_Cycles();
+
+	for (; result.frames < job.frames; result.frames++)
+		nes->Run_Frame(result.frames + 1 == job.frames);
+
+	const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+	result.ok = true;
+	result.seconds = elapsed.count();
+	result.cycles = nes->cpu.Get_Cycles() - first_cycle;
+	result.idle_loops = nes->cpu.Get_Idle_Loops();
+	result.frame_crc = Crc32(nes->ppu.Get_Frame_Buffer(), SCREEN_WIDTH * SCREEN_HEIGHT);
+	memcpy(result.ram, nes->ram, RAM_SIZE);
+} // end Run_Job
+
+
+//=====================================================================|
+/**
+ * @brief Lists the logical CPUs the process is allowed on, one of each
+ *	physical core first, then the rest. Where the topology can't be read
+ *	every logical CPU counts as a core of its own.
+ *
+ * @param cpus gets the list, empty where there's no way to know
+ *
+ * @return how many physical cores that is
+ */
+u32 BatchRunner::Find_Cpus(std::vector<u32>& cpus)
+{
+	cpus.clear();
+	std::vector<u32> siblings;
+
+#ifdef _WIN32
+	DWORD_PTR process = 0, system = 0;
+	if (!GetProcessAffinityMask(GetCurrentProcess(), &process, &system))
+		process = 0;
+
+	DWORD length = 0;
+	std::vector<SYSTEM_LOGICAL_PROCESSOR_INFORMATION> info;
+	GetLogicalProcessorInformation(nullptr, &length);
+	info.resize(length / sizeof(SYSTEM_LOGICAL_PROCESSOR_INFORMATION));
+	if (info.empty() || !GetLogicalProcessorInformation(info.data(), &length))
+		info.clear();
+
+	DWORD_PTR seen = 0;
+	for (const SYSTEM_LOGICAL_PROCESSOR_INFORMATION& entry : info)
+	{
+		if (entry.Relationship != RelationProcessorCore)
+			continue;
+
+		bool first = true;
+		for (u32 i = 0; i < sizeof(DWORD_PTR) * 8; i++)
+		{
+			const DWORD_PTR bit = (DWORD_PTR)1 << i;
+			if (!(entry.ProcessorMask & process & bit))
+				continue;
+			(first ? cpus : siblings).push_back(i);
+			seen |= bit;
+			first = false;
+		} // end for
+	} // end for
+
+	// whatever the topology left out counts as a core of its own
+	for (u32 i = 0; i < sizeof(DWORD_PTR) * 8; i++)
+	{
+		if ((process & ~seen) & ((DWORD_PTR)1 << i))
+			cpus.push_back(i);
+	} // end for
+#elif defined(__linux__)
+	cpu_set_t allowed;
+	CPU_ZERO(&allowed);
+	if (sched_getaffinity(0, sizeof(allowed), &allowed) == 0)
+	{
+		std::set<std::pair<long, long>> seen;	// package and core
+		for (u32 i = 0; i < CPU_SETSIZE; i++)
+		{
+			if (!CPU_ISSET(i, &allowed))
+				continue;
+
+			long ids[2] = { -1, -1 };
+			const char* names[2] = { "physical_package_id", "core_id" };
+			for (u32 k = 0; k < 2; k++)
+			{
+				char path[96];
+				snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%u/topology/%s", i, names[k]);
+				if (FILE* fp = fopen(path, "r"))
+				{
+					if (fscanf(fp, "%ld", &ids[k]) != 1)
+						ids[k] = -1;
+					fclose(fp);
+				} // end if
+			} // end for
+
+			if (ids[1] < 0 || seen.insert({ ids[0], ids[1] }).second)
+				cpus.push_back(i);
+			else
+				siblings.push_back(i);
+		} // end for
+	} // end if
+#else
+	for (u32 i = 0; i < std::thread::hardware_concurrency(); i++)
+		cpus.push_back(i);
+#endif
+
+	const u32 cores = (u32)cpus.size();
+	cpus.insert(cpus.end(), siblings.begin(), siblings.end());
+	return cores;
+} // end Find_Cpus
+
+
+//=====================================================================|
+/**
+ * @brief Keeps a thread on one logical CPU.
+ *
+ * @param thread the thread
+ * @param cpu which one, as Find_Cpus numbers them
+ *
+ * @return false when the system wouldn't, or there's no way to ask
+ */
+bool BatchRunner::Pin_Thread(std::thread& thread, const u32 cpu)
+{
+#ifdef _WIN32
+	return cpu < sizeof(DWORD_PTR) * 8
+		&& SetThreadAffinityMask((HANDLE)thread.native_handle(), (DWORD_PTR)1 << cpu) != 0;
+#elif defined(__linux__)
+	if (cpu >= CPU_SETSIZE)
+		return false;
+
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(cpu, &set);
+	return pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set) == 0;
+#else
+	(void)thread;
+	(void)cpu;
+	return false;
+#endif
+} // end Pin_Thread
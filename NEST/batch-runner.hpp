@@ -0,0 +1,104 @@
+/**
+ * @brief Runs a batch of consoles at once, ROM and frame count each, on a
+ *	pool of worker threads, one per core and pinned to it. Every worker has
+ *	a deque of its own, dealt a share of the jobs up front.
+ *
+ *	The cores are the ones the process may run on, one logical CPU from
+ *	each physical core first; two consoles on the two halves of a hyper
+ *	threaded core only get in each other's way. Past that, the workers go
+ *	on the remaining logical CPUs in turn.
+ *
+ *	A worker takes from the back of its own deque and runs that job start
+ *	to finish, so one console at a time has the core's caches to itself.
+ *	A worker whose deque has run dry steals from the front of someone
+ *	else's. Only jobs not started yet are ever in a deque, so a console
+ *	never moves between cores. Consoles are made when their job starts and
+ *	are gone the moment it ends, so there are never more alive than there
+ *	are workers however big the batch.
+ *
+ *	What each job ends with, its last frame and RAM, doesn't depend on the
+ *	worker it ran on or how many there were.
+ *
+ * @author Rediet Worku
+ * @date 26th of October 2021, Sunday
+ */
+#pragma once
+
+
+//=====================================================================|
+#include "nes.hpp"
+
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+
+
+//=====================================================================|
+struct Batch_Job
+{
+	std::string rom;
+	u64 frames = 600;
+	CPU6502::Backend backend = CPU6502::Backend::Jit;
+	bool idle_skip = true;
+};
+
+
+struct Batch_Result
+{
+	bool ok = false;
+	std::string error;		// why the ROM didn't go in, when not ok
+	u64 frames = 0;
+	u64 cycles = 0;
+	u64 idle_loops = 0;		// skipped; none with idle_skip off
+	double seconds = 0;		// time spent running it
+	u32 frame_crc = 0;		// Crc32 of the last frame's palette indices
+	u32 worker = 0;			// which worker ran it
+	u8 ram[RAM_SIZE];		// as the last frame left it
+};
+
+
+
+//=====================================================================|
+class BatchRunner
+{
+public:
+
+	// 0 threads for one per physical core the process may use
+	BatchRunner(const u32 threads = 0, const bool pin = true);
+
+	BatchRunner(const BatchRunner&) = delete;
+	BatchRunner& operator=(const BatchRunner&) = delete;
+
+	u32 Get_Threads() const { return threads; }
+
+	// runs every job and fills results, in the same order; returns the
+	//	seconds it took all told
+	double Run(const std::vector<Batch_Job>& jobs, std::vector<Batch_Result>& results);
+	u64 Get_Steals() const { return steals; }	// in the last Run
+	u32 Get_Pin_Failures() const { return pin_failures; }	// in the last Run
+
+private:
+
+	// the jobs each has yet to start, by index
+	struct Worker
+	{
+		std::mutex lock;
+		std::deque<u32> jobs;
+	};
+
+	u32 threads;
+	bool pin;
+	std::vector<u32> cpus;		// where the workers go, in order
+	u32 pin_failures;
+
+	std::vector<std::unique_ptr<Worker>> workers;
+	std::atomic<u64> steals;
+
+	void Work(const u32 id, const std::vector<Batch_Job>& jobs, std::vector<Batch_Result>& results);
+	bool Take(const u32 id, u32& job);
+	static void Run_Job(const Batch_Job& job, Batch_Result& result);
+	static u32 Find_Cpus(std::vector<u32>& cpus);
+	static bool Pin_Thread(std::thread& thread, const u32 cpu);
+};
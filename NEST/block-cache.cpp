@@ -0,0 +1,123 @@
+/**
+ * @brief The implementation of the 6502 basic block cache.
+ *
+ * @author Rediet Worku
+ * @date 26th of October 2021, Sunday
+ */
+
+//=====================================================================|
+#include "block-cache.hpp"
+
+#include <cstring>
+
+
+
+//=====================================================================|
+/**
+ * constructor; the op pool is allocated once up front so that pointers
+ *	into it stay good while a block is running
+ */
+BlockCache::BlockCache()
+	:pool(POOL_SIZE), pool_used{ 0 }, invalidated{ false }
+{
+	iZero(code_pages, sizeof(code_pages));
+	iZero(page_thrash, sizeof(page_thrash));
+} // end constructor
+
+
+//=====================================================================|
+/**
+ * @brief Looks up the block starting at the given key.
+ *
+ * @param key bank << 16 | start pc
+ *
+ * @return the block or nullptr when it is yet to be decoded
+ */
+Code_Block* BlockCache::Find(const u32 key)
+{
+	Code_Block& blk = slots[Slot(key)];
+	if (blk.key == key + 1)
+		return &blk;
+
+	return nullptr;
+} // end Find
+
+
+//=====================================================================|
+/**
+ * @brief Copies a freshly decoded run of instructions into the pool and
+ *	files it under key, pushing out whatever shared its slot. A full pool
+ *	throws everything away and starts over; that is far simpler than
+ *	tracking holes and is rare in practice since NES programs are small.
+ *
+ * @param key bank << 16 | start pc
+ * @param last_page the page holding the block's last byte
+ * @param max_cycles the most cycles one pass through the block can take
+ * @param ops the decoded instructions
+ * @param count how many of them
+ *
+ * @return the new block
+ */
+Code_Block* BlockCache::Insert(const u32 key, const u8 last_page, const u16 max_cycles,
+	const Decoded_Op* ops, const u8 count)
+{
+	if (pool_used + count > POOL_SIZE)
+		Flush();
+
+	Code_Block& blk = slots[Slot(key)];
+	blk.key = key + 1;
+	blk.first_op = pool_used;
+	blk.count = count;
+	blk.last_page = last_page;
+	blk.max_cycles = max_cycles;
+	blk.native = nullptr;
+	blk.hits = 0;
+	blk.idle = false;
+
+	memcpy(&pool[pool_used], ops, count * sizeof(Decoded_Op));
+	pool_used += count;
+
+	code_pages[(key >> 8) & 0xFF] = 1;
+	code_pages[last_page] = 1;
+	return &blk;
+} // end Insert
+
+
+//=====================================================================|
+/**
+ * @brief Throws away every block that has a byte in the given page, after
+ *	it was written to. A page that keeps getting its code rewritten (a
+ *	RAM routine that patches itself every pass, say) stops being cached
+ *	after THRASH_LIMIT of these and is left to the interpreter.
+ *
+ * @param page the page written to
+ */
+void BlockCache::Invalidate_Page(const u8 page)
+{
+	for (Code_Block& blk : slots)
+	{
+		if (blk.key && (((blk.key - 1) >> 8 & 0xFF) == page || blk.last_page == page))
+			blk.key = 0;
+	} // end for
+
+	code_pages[page] = 0;
+	if (page_thrash[page] < THRASH_LIMIT)
+		++page_thrash[page];
+
+	invalidated = true;
+} // end Invalidate_Page
+
+
+//=====================================================================|
+/**
+ * @brief Empties the cache; every block is decoded afresh on its next run.
+ */
+void BlockCache::Flush()
+{
+	for (Code_Block& blk : slots)
+		blk.key = 0;
+
+	pool_used = 0;
+	iZero(code_pages, sizeof(code_pages));
+	invalidated = true;
+} // end Flush
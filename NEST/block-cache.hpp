@@ -0,0 +1,112 @@
+/**
+ * @brief A cache of pre-decoded basic blocks for the 6502. Straight line
+ *	code is decoded once into a run of Decoded_Op's, each carrying a
+ *	handler with the addressing mode and operation already rolled into one,
+ *	plus its operand bytes already read. Running a block is then just a
+ *	walk down that array; no opcode fetch, no decode, no operand reads.
+ *
+ *	Blocks are keyed by their starting pc (and the bank it sits in, once
+ *	mappers start swapping banks around) and never run past the end of the
+ *	256 byte page they start in, so a write to a page that holds code can
+ *	simply throw away every block on that page.
+ *
+ * @author Rediet Worku
+ * @date 26th of October 2021, Sunday
+ */
+#pragma once
+
+
+//=====================================================================|
+#include "basics.hpp"
+
+
+
+
+//=====================================================================|
+class CPU6502;
+struct Decoded_Op;
+
+// a decoded instruction handler; returns the number of Decoded_Op's it
+//	consumed, which is 2 for the fused superinstructions
+typedef u8(*Decoded_Fn)(CPU6502& cpu, const Decoded_Op& op);
+
+
+/**
+ * one pre-decoded instruction
+ */
+struct Decoded_Op
+{
+	Decoded_Fn handler;		// mode + operation in one call
+	u16 operand;			// operand bytes; address, immediate or branch offset
+	u16 next_pc;			// address of the following instruction
+	u8 cycles;				// base cycle count
+	u8 opcode;				// the raw opcode
+};
+
+
+/**
+ * a run of straight line code, ending at a branch, jump, return or the
+ *	end of its page
+ */
+struct Code_Block
+{
+	u32 key = 0;			// bank << 16 | start pc, plus one; 0 means empty
+	u32 first_op = 0;		// index of the first op in the pool
+	u8 count = 0;			// number of decoded instructions
+	u8 last_page = 0;		// page holding the block's very last byte
+	u16 max_cycles = 0;		// the most cycles one pass can take
+
+	// for the recompiler
+	void* native = nullptr;	// compiled code, if it got hot enough
+	u16 hits = 0;			// times run before it was compiled
+	bool idle = false;		// an idle loop; left to the handlers, which skip it
+};
+
+
+//=====================================================================|
+class BlockCache
+{
+public:
+
+	static constexpr u32 SLOTS = 4096;			// direct mapped block slots
+	static constexpr u32 POOL_SIZE = 16384;		// decoded ops before a flush
+	static constexpr u8 MAX_BLOCK_OPS = 32;		// longest block we decode
+	static constexpr u8 THRASH_LIMIT = 64;		// invalidations before a page is left alone
+
+	BlockCache();
+
+	Code_Block* Find(const u32 key);
+	Code_Block* Insert(const u32 key, const u8 last_page, const u16 max_cycles,
+		const Decoded_Op* ops, const u8 count);
+	const Decoded_Op* Ops(const Code_Block& blk) const { return &pool[blk.first_op]; }
+
+	// called on every CPU write; only pages holding code pay anything
+	void Note_Write(const u16 addr)
+	{
+		if (code_pages[addr >> 8])
+			Invalidate_Page(addr >> 8);
+	} // end Note_Write
+
+	void Invalidate_Page(const u8 page);
+	void Flush();
+
+	// a bank switch; the blocks of the old bank stay filed under it for
+	//	when it comes back, but the one running must stop where it is
+	void Note_Remap() { invalidated = true; }
+
+	bool Is_Cacheable(const u8 page) const { return page_thrash[page] < THRASH_LIMIT; }
+	bool Was_Invalidated() const { return invalidated; }
+	void Clear_Invalidated() { invalidated = false; }
+
+private:
+
+	Code_Block slots[SLOTS];			// the blocks, by hashed key
+	std::vector<Decoded_Op> pool;		// every decoded instruction, bump allocated
+	u32 pool_used;						// next free entry in pool
+
+	u8 code_pages[256];		// non zero for pages that have blocks decoded from them
+	u8 page_thrash[256];	// times a page's blocks were thrown away
+	bool invalidated;		// set when a write hits a code page, or the map changes
+
+	static u32 Slot(const u32 key) { return (key ^ (key >> 12)) & (SLOTS - 1); }
+};
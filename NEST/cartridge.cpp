@@ -0,0 +1,281 @@
+/**
+ * @brief The implementation of the cartridge loader.
+ *
+ * @author Rediet Worku
+ * @date 26th of October 2021, Sunday
+ */
+
+//=====================================================================|
+#include "cartridge.hpp"
+
+#include <cstring>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+
+//=====================================================================|
+/**
+ * constructor
+ */
+Cartridge::Cartridge()
+	: image(nullptr), image_size(0),
+#ifdef _WIN32
+	file_handle(nullptr), mapping_handle(nullptr),
+#endif
+	nes2(false), mapper(0), submapper(0), mirroring(Mirroring::Horizontal),
+	battery(false), prg_ram_size(0), prg_crc(0), has_crc(false)
+{ }
+
+
+//=====================================================================|
+/**
+ * Destructor
+ */
+Cartridge::~Cartridge()
+{
+	Unload();
+} // end Destructor
+
+
+//=====================================================================|
+/**
+ * @brief Maps the ROM image at path and reads its header. Whatever was
+ *	loaded before is let go first.
+ *
+ * @param path the .nes file
+ *
+ * @return false with the reason in error_string when it can't be mapped
+ *	or isn't a sane iNES image
+ */
+bool Cartridge::Load(const std::string& path)
+{
+	Unload();
+	error_string.clear();
+
+	if (!Map_File(path))
+		return false;
+
+	if (!Parse())
+	{
+		Unload();
+		return false;
+	} // end if
+
+	return true;
+} // end Load
+
+
+//=====================================================================|
+/**
+ * @brief Unmaps the image; every span handed out dies with it.
+ */
+void Cartridge::Unload()
+{
+#ifdef _WIN32
+	if (image)
+		UnmapViewOfFile(image);
+	if (mapping_handle)
+		CloseHandle((HANDLE)mapping_handle);
+	if (file_handle)
+		CloseHandle((HANDLE)file_handle);
+	file_handle = mapping_handle = nullptr;
+#else
+	if (image)
+		munmap((void*)image, image_size);
+#endif
+
+	image = nullptr;
+	image_size = 0;
+	prg = chr = trainer = Rom_Span();
+	prg_crc = 0;
+	has_crc = false;
+} // end Unload
+
+
+//=====================================================================|
+/**
+ * @brief The crc32 of PRG ROM, worked out on first use; most loads never
+ *	need it, and on a big ROM it isn't free.
+ */
+u32 Cartridge::Prg_Crc() const
+{
+	if (!has_crc)
+	{
+		prg_crc = Crc32(prg.data, prg.size);
+		has_crc = true;
+	} // end if
+
+	return prg_crc;
+} // end Prg_Crc
+
+
+//=====================================================================|
+/**
+ * @brief Maps the whole file read only and private; nothing gets read
+ *	until something touches it.
+ */
+bool Cartridge::Map_File(const std::string& path)
+{
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		error_string = "can't open " + path;
+		return false;
+	} // end if
+	file_handle = file;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size) || size.QuadPart < 16)
+	{
+		error_string = path + " is too small to be a ROM";
+		return false;
+	} // end if
+	image_size = (size_t)size.QuadPart;
+
+	mapping_handle = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mapping_handle)
+		image = (const u8*)MapViewOfFile((HANDLE)mapping_handle, FILE_MAP_READ, 0, 0, 0);
+#else
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+	{
+		error_string = "can't open " + path;
+		return false;
+	} // end if
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size < 16)
+	{
+		error_string = path + " is too small to be a ROM";
+		close(fd);
+		return false;
+	} // end if
+	image_size = (size_t)st.st_size;
+
+	// the mapping keeps the file alive on its own
+	void* p = mmap(nullptr, image_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (p != MAP_FAILED)
+		image = (const u8*)p;
+#endif
+
+	if (!image)
+	{
+		error_string = "can't map " + path;
+		image_size = 0;
+		return false;
+	} // end if
+
+	return true;
+} // end Map_File
+
+
+//=====================================================================|
+/**
+ * @brief An NES 2.0 ROM size. With an MSB nibble of 0xF the LSB byte
+ *	is EEEEEEMM instead, for 2^E * (MM * 2 + 1) bytes.
+ *
+ * @param lsb the size byte of the iNES header
+ * @param msb its nibble from byte 9
+ * @param unit 16KB for PRG, 8KB for CHR
+ */
+u32 Cartridge::Nes2_Size(const u8 lsb, const u8 msb, const u32 unit)
+{
+	if (msb == 0x0F)
+	{
+		const u32 exponent = lsb >> 2;
+		if (exponent > 30)
+			return 0;		// bigger than anything we'd map
+		return (1u << exponent) * ((lsb & 0x03) * 2 + 1);
+	} // end if exponent notation
+
+	return (((u32)msb << 8) | lsb) * unit;
+} // end Nes2_Size
+
+
+//=====================================================================|
+/**
+ * @brief Reads the header and carves the image into its parts.
+ */
+bool Cartridge::Parse()
+{
+	const u8* header = image;
+	if (memcmp(header, "NES\x1A", 4))
+	{
+		error_string = "not an iNES ROM";
+		return false;
+	} // end if
+
+	nes2 = (header[7] & 0x0C) == 0x08;
+	mapper = (header[7] & 0xF0) | (header[6] >> 4);
+	battery = (header[6] & 0x02) != 0;
+
+	if (header[6] & 0x08)
+		mirroring = Mirroring::Four_Screen;
+	else
+		mirroring = (header[6] & 0x01) ? Mirroring::Vertical : Mirroring::Horizontal;
+
+	u32 prg_size, chr_size;
+	if (nes2)
+	{
+		mapper |= (u16)(header[8] & 0x0F) << 8;
+		submapper = header[8] >> 4;
+		prg_size = Nes2_Size(header[4], header[9] & 0x0F, 16384);
+		chr_size = Nes2_Size(header[5], header[9] >> 4, 8192);
+
+		// shift counts; 0 is none, otherwise 64 << count bytes
+		const u8 ram = header[10] & 0x0F, nvram = header[10] >> 4;
+		prg_ram_size = (ram ? 64u << ram : 0) + (nvram ? 64u << nvram : 0);
+	} // end if NES 2.0
+	else
+	{
+		submapper = 0;
+		prg_size = header[4] * 16384;
+		chr_size = header[5] * 8192;
+		prg_ram_size = 8192;	// iNES can't say; every board that has any has this much
+	} // end else
+
+	size_t offset = 16;
+	if (header[6] & 0x04)
+	{
+		trainer.data = image + offset;
+		trainer.size = 512;
+		offset += 512;
+	} // end if trainer
+
+	if (prg_size == 0 || offset + prg_size + chr_size > image_size)
+	{
+		error_string = "the PRG/CHR sizes in the header don't fit the file";
+		return false;
+	} // end if
+
+	// the smallest bank any board switches
+	if (prg_size % 8192)
+	{
+		error_string = "PRG ROM isn't a whole number of 8KB banks";
+		return false;
+	} // end if
+
+	prg.data = image + offset;
+	prg.size = prg_size;
+	offset += prg_size;
+
+	if (chr_size)
+	{
+		chr.data = image + offset;
+		chr.size = chr_size;
+	} // end if CHR ROM
+
+	return true;
+} // end Parse
@@ -0,0 +1,110 @@
+/**
+ * @brief The game cartridge; an iNES or NES 2.0 ROM image mapped straight
+ *	into memory, read only. PRG and CHR are handed out as spans into the
+ *	mapping, never copied, so the bus reads ROM right out of the page cache
+ *	and a big image costs nothing to open; the OS pages in only what the
+ *	game touches and shares it with every other process that has it open.
+ *
+ *	The 16 byte header:
+ *		0-3		"NES" 0x1A
+ *		4		PRG ROM size in 16KB units (LSB)
+ *		5		CHR ROM size in 8KB units (LSB), 0 means 8KB of CHR RAM
+ *		6		mapper low nibble, four screen, trainer, battery, mirroring
+ *		7		mapper high nibble, 0x08 in bits 2-3 marks NES 2.0
+ *		8		NES 2.0: submapper, mapper bits 8-11
+ *		9		NES 2.0: CHR size MSB, PRG size MSB
+ *		10		NES 2.0: PRG NVRAM and RAM shift counts
+ *
+ * @author Rediet Worku
+ * @date 26th of October 2021, Sunday
+ */
+#pragma once
+
+
+//=====================================================================|
+#include "basics.hpp"
+
+
+
+//=====================================================================|
+/**
+ * a run of read only bytes inside the mapped image
+ */
+struct Rom_Span
+{
+	const u8* data = nullptr;
+	u32 size = 0;
+
+	// bank index of bank_size bytes, wrapping around like the address
+	//	lines of a smaller chip would
+	const u8* Bank(const u32 index, const u32 bank_size) const
+	{
+		return data + (((size_t)index * bank_size) % size);
+	} // end Bank
+};
+
+
+// how the PPU's two 1KB nametables fill its four; the single screen kinds
+//	are only ever a mapper's doing
+enum class Mirroring : u8 { Horizontal, Vertical, Four_Screen, Single_Lower, Single_Upper };
+
+
+
+//=====================================================================|
+class Cartridge
+{
+public:
+
+	Cartridge();
+	~Cartridge();
+
+	Cartridge(const Cartridge&) = delete;
+	Cartridge& operator=(const Cartridge&) = delete;
+
+	bool Load(const std::string& path);
+	void Unload();
+
+	bool Is_Loaded() const { return image != nullptr; }
+	bool Is_NES2() const { return nes2; }
+	u16 Mapper() const { return mapper; }
+	u8 Submapper() const { return submapper; }
+	Mirroring Get_Mirroring() const { return mirroring; }
+	bool Has_Battery() const { return battery; }
+	bool Has_Chr_Ram() const { return chr.size == 0; }
+	u32 Prg_Ram_Size() const { return prg_ram_size; }
+
+	const Rom_Span& Prg() const { return prg; }
+	const Rom_Span& Chr() const { return chr; }
+	const Rom_Span& Trainer() const { return trainer; }
+	u32 Prg_Crc() const;
+
+	std::string Get_Error_Message() const { return error_string; }
+
+private:
+
+	// the mapping
+	const u8* image;		// the whole file
+	size_t image_size;
+#ifdef _WIN32
+	void* file_handle;
+	void* mapping_handle;
+#endif
+
+	// from the header
+	bool nes2;
+	u16 mapper;
+	u8 submapper;
+	Mirroring mirroring;
+	bool battery;
+	u32 prg_ram_size;
+
+	Rom_Span prg, chr, trainer;
+	mutable u32 prg_crc;	// names the ROM to the static recompiler; made
+	mutable bool has_crc;	//	the first time it's asked for
+
+	std::string error_string;
+
+	bool Map_File(const std::string& path);
+	bool Parse();
+	static u32 Nes2_Size(const u8 lsb, const u8 msb, const u32 unit);
+};
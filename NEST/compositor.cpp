@@ -0,0 +1,312 @@
+/**
+ * @brief The implementation of the scanline compositor.
+ *
+ * @author Rediet Worku
+ * @date 26th of October 2021, Sunday
+ */
+
+//=====================================================================|
+#include "compositor.hpp"
+
+#if NEST_SIMD
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// GCC and Clang only emit AVX2 for functions that ask for it; MSVC takes
+//	the intrinsics anywhere
+#if defined(__GNUC__) || defined(__clang__)
+#define NEST_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define NEST_TARGET_AVX2
+#endif
+
+
+
+//=====================================================================|
+/**
+ * constructor; starts out on the best path there is
+ */
+Compositor::Compositor()
+{
+	Set_Path(Best_Path());
+} // end constructor
+
+
+//=====================================================================|
+/**
+ * @brief Asks the CPU what it has; AVX2 needs the OS to save the ymm
+ *	registers as well, which is what OSXSAVE and XGETBV are about.
+ */
+Compositor::Path Compositor::Best_Path()
+{
+#if NEST_SIMD
+#ifdef _MSC_VER
+	int info[4];
+	__cpuid(info, 0);
+	const int max_leaf = info[0];
+
+	__cpuid(info, 1);
+	const bool sse2 = (info[3] & (1 << 26)) != 0;
+	const bool avx = (info[2] & (1 << 28)) && (info[2] & (1 << 27)) &&
+		(_xgetbv(0) & 0x06) == 0x06;
+
+	if (avx && max_leaf >= 7)
+	{
+		__cpuidex(info, 7, 0);
+		if (info[1] & (1 << 5))
+			return Path::AVX2;
+	} // end if
+
+	return sse2 ? Path::SSE2 : Path::Scalar;
+#else
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2"))
+		return Path::AVX2;
+	if (__builtin_cpu_supports("sse2"))
+		return Path::SSE2;
+#endif
+#endif
+
+	return Path::Scalar;
+} // end Best_Path
+
+
+//=====================================================================|
+/**
+ * @brief Picks the path Compose takes; for comparing them, mostly.
+ *
+ * @return false, leaving the path alone, for one this build or CPU
+ *	doesn't have
+ */
+bool Compositor::Set_Path(const Path p)
+{
+	if (p > Best_Path())
+		return false;
+
+	// SSE2 has no gather, so colors go a pixel at a time below AVX2
+	colorize = &Compositor::Colorize_Scalar;
+	switch (p)
+	{
+#if NEST_SIMD
+	case Path::AVX2:
+		compose = &Compositor::Compose_AVX2;
+		colorize = &Compositor::Colorize_AVX2;
+		break;
+	case Path::SSE2: compose = &Compositor::Compose_SSE2; break;
+#endif
+	default: compose = &Compositor::Compose_Scalar; break;
+	} // end switch
+
+	path = p;
+	return true;
+} // end Set_Path
+
+
+//=====================================================================|
+/**
+ * @brief The reference the vector paths have to agree with, a pixel at
+ *	a time.
+ */
+bool Compositor::Compose_Scalar(const u8* bg, const u8* sprite, const u8* palette,
+	const u8 mask, const u32* colors, u8* indices, u32* rgba)
+{
+	const u8 gray = (mask & 0x01) ? 0x30 : 0x3F;
+	bool hit = false;
+
+	for (u32 x = 0; x < 256; ++x)
+	{
+		u8 b = bg[x];
+		u8 s = sprite[x];
+		if (x < 8)
+		{
+			if (!(mask & 0x02))
+				b = 0;
+			if (!(mask & 0x04))
+				s = 0;
+		} // end if left column
+
+		if ((s & 0x80) && b && x != 255)
+			hit = true;
+
+		u8 index = b;
+		if (s && (!b || !(s & 0x40)))
+			index = s & 0x1F;
+
+		indices[x] = palette[index] & gray;
+		rgba[x] = colors[indices[x]];
+	} // end for
+
+	return hit;
+} // end Compose_Scalar
+
+
+//=====================================================================|
+/**
+ * @brief A table lookup a pixel.
+ */
+void Compositor::Colorize_Scalar(const u8* indices, const u32* colors, u32* rgba, const u32 count)
+{
+	for (u32 i = 0; i < count; ++i)
+		rgba[i] = colors[indices[i]];
+} // end Colorize_Scalar
+
+
+#if NEST_SIMD
+//=====================================================================|
+/**
+ * @brief 16 pixels a go. The mux is all compares and masks; SSE2 has no
+ *	byte shuffle to look the palette up with, so that and the colors are
+ *	done a pixel at a time off the indices it worked out.
+ */
+bool Compositor::Compose_SSE2(const u8* bg, const u8* sprite, const u8* palette,
+	const u8 mask, const u32* colors, u8* indices, u32* rgba)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i ones = _mm_set1_epi8(-1);
+	const __m128i low5 = _mm_set1_epi8(0x1F);
+	const __m128i behind = _mm_set1_epi8(0x40);
+	const __m128i left = _mm_set_epi64x(-1, 0);		// clears pixels 0 - 7
+	const __m128i bg_left = (mask & 0x02) ? ones : left;
+	const __m128i sprite_left = (mask & 0x04) ? ones : left;
+	const u8 gray = (mask & 0x01) ? 0x30 : 0x3F;
+
+	alignas(16) u8 index[16];
+	u32 hits = 0;
+
+	for (u32 x = 0; x < 256; x += 16)
+	{
+		__m128i b = _mm_loadu_si128((const __m128i*)(bg + x));
+		__m128i s = _mm_loadu_si128((const __m128i*)(sprite + x));
+		if (x == 0)
+		{
+			b = _mm_and_si128(b, bg_left);
+			s = _mm_and_si128(s, sprite_left);
+		} // end if left column
+
+		const __m128i b_clear = _mm_cmpeq_epi8(b, zero);
+		const __m128i s_clear = _mm_cmpeq_epi8(s, zero);
+		const __m128i in_front = _mm_cmpeq_epi8(_mm_and_si128(s, behind), zero);
+
+		// sprite 0 is bit 7, the one movemask takes
+		u32 hit = (u32)_mm_movemask_epi8(_mm_andnot_si128(b_clear, s));
+		if (x == 240)
+			hit &= 0x7FFF;
+		hits |= hit;
+
+		const __m128i use_s = _mm_andnot_si128(s_clear, _mm_or_si128(b_clear, in_front));
+		const __m128i idx = _mm_or_si128(_mm_and_si128(use_s, _mm_and_si128(s, low5)),
+			_mm_andnot_si128(use_s, b));
+		_mm_store_si128((__m128i*)index, idx);
+
+		for (u32 i = 0; i < 16; ++i)
+		{
+			const u8 c = palette[index[i]] & gray;
+			indices[x + i] = c;
+			rgba[x + i] = colors[c];
+		} // end for
+	} // end for
+
+	return hits != 0;
+} // end Compose_SSE2
+
+
+//=====================================================================|
+/**
+ * @brief 32 pixels a go, all the way through: the palette is two 16 byte
+ *	tables for vpshufb, picked between by bit 4 of the index, and the
+ *	colors are gathered 8 at a time.
+ */
+NEST_TARGET_AVX2
+bool Compositor::Compose_AVX2(const u8* bg, const u8* sprite, const u8* palette,
+	const u8 mask, const u32* colors, u8* indices, u32* rgba)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i ones = _mm256_set1_epi8(-1);
+	const __m256i low5 = _mm256_set1_epi8(0x1F);
+	const __m256i behind = _mm256_set1_epi8(0x40);
+	const __m256i upper = _mm256_set1_epi8(0x10);
+	const __m256i left = _mm256_set_epi64x(-1, -1, -1, 0);
+	const __m256i bg_left = (mask & 0x02) ? ones : left;
+	const __m256i sprite_left = (mask & 0x04) ? ones : left;
+	const __m256i gray = _mm256_set1_epi8((mask & 0x01) ? 0x30 : 0x3F);
+
+	const __m256i pal_lo = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)palette));
+	const __m256i pal_hi = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)(palette + 16)));
+
+	u32 hits = 0;
+
+	for (u32 x = 0; x < 256; x += 32)
+	{
+		__m256i b = _mm256_loadu_si256((const __m256i*)(bg + x));
+		__m256i s = _mm256_loadu_si256((const __m256i*)(sprite + x));
+		if (x == 0)
+		{
+			b = _mm256_and_si256(b, bg_left);
+			s = _mm256_and_si256(s, sprite_left);
+		} // end if left column
+
+		const __m256i b_clear = _mm256_cmpeq_epi8(b, zero);
+		const __m256i s_clear = _mm256_cmpeq_epi8(s, zero);
+		const __m256i in_front = _mm256_cmpeq_epi8(_mm256_and_si256(s, behind), zero);
+
+		u32 hit = (u32)_mm256_movemask_epi8(_mm256_andnot_si256(b_clear, s));
+		if (x == 224)
+			hit &= 0x7FFFFFFF;
+		hits |= hit;
+
+		const __m256i use_s = _mm256_andnot_si256(s_clear, _mm256_or_si256(b_clear, in_front));
+		const __m256i idx = _mm256_or_si256(_mm256_and_si256(use_s, _mm256_and_si256(s, low5)),
+			_mm256_andnot_si256(use_s, b));
+
+		// both halves of the palette, then the right one for each index
+		const __m256i lo = _mm256_shuffle_epi8(pal_lo, idx);
+		const __m256i hi = _mm256_shuffle_epi8(pal_hi, idx);
+		const __m256i in_hi = _mm256_cmpeq_epi8(_mm256_and_si256(idx, upper), upper);
+		const __m256i c = _mm256_and_si256(_mm256_blendv_epi8(lo, hi, in_hi), gray);
+		_mm256_storeu_si256((__m256i*)(indices + x), c);
+
+		const __m128i c0 = _mm256_castsi256_si128(c);
+		const __m128i c1 = _mm256_extracti128_si256(c, 1);
+		const __m128i parts[4] = { c0, _mm_srli_si128(c0, 8), c1, _mm_srli_si128(c1, 8) };
+		for (u32 k = 0; k < 4; ++k)
+		{
+			const __m256i i32 = _mm256_cvtepu8_epi32(parts[k]);
+			_mm256_storeu_si256((__m256i*)(rgba + x + k * 8),
+				_mm256_i32gather_epi32((const int*)colors, i32, 4));
+		} // end for
+	} // end for
+
+	return hits != 0;
+} // end Compose_AVX2
+
+
+//=====================================================================|
+/**
+ * @brief Gathers 8 colors at a time, 32 a pass; the tail that doesn't
+ *	fill a pass goes a pixel at a time.
+ */
+NEST_TARGET_AVX2
+void Compositor::Colorize_AVX2(const u8* indices, const u32* colors, u32* rgba, const u32 count)
+{
+	u32 i = 0;
+	for (; i + 32 <= count; i += 32)
+	{
+		const __m256i idx = _mm256_loadu_si256((const __m256i*)(indices + i));
+		const __m128i c0 = _mm256_castsi256_si128(idx);
+		const __m128i c1 = _mm256_extracti128_si256(idx, 1);
+		const __m128i parts[4] = { c0, _mm_srli_si128(c0, 8), c1, _mm_srli_si128(c1, 8) };
+		for (u32 k = 0; k < 4; ++k)
+		{
+			const __m256i i32 = _mm256_cvtepu8_epi32(parts[k]);
+			_mm256_storeu_si256((__m256i*)(rgba + i + k * 8),
+				_mm256_i32gather_epi32((const int*)colors, i32, 4));
+		} // end for
+	} // end for
+
+	for (; i < count; ++i)
+		rgba[i] = colors[indices[i]];
+} // end Colorize_AVX2
+#endif
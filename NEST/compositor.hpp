@@ -0,0 +1,96 @@
+/**
+ * @brief The last stage of the PPU: puts a scanline's background and
+ *	sprite pixels together the way the 2C02's priority mux does, looks the
+ *	winners up in the palette and turns them into screen colors. It is the
+ *	innermost loop of the PPU, 61440 pixels a frame, so besides the plain
+ *	C++ version there are SSE2 and AVX2 ones that do 16 and 32 pixels at a
+ *	time; the fastest the CPU has is picked when the program starts. All of
+ *	them give the same bytes out.
+ *
+ *	A pixel wins like this:
+ *		the left 8 columns drop background and/or sprites if PPUMASK says
+ *		an opaque sprite in front of the background, or over a transparent
+ *			one, shows; otherwise the background does, palette entry 0 when
+ *			it too is transparent
+ *		sprite 0 hits where it is opaque over opaque background, but never
+ *			in column 255
+ *
+ *	Colorize is the last step on its own, palette indices to colors, for
+ *	whoever has a frame of indices to show.
+ *
+ * @author Rediet Worku
+ * @date 26th of October 2021, Sunday
+ */
+#pragma once
+
+
+//=====================================================================|
+#include "basics.hpp"
+
+
+// the vector paths are x86 only, and need the compiler's say so
+#ifndef NEST_SIMD
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define NEST_SIMD 1
+#else
+#define NEST_SIMD 0
+#endif
+#endif
+
+
+
+//=====================================================================|
+/**
+ * composes one 256 pixel scanline; bg holds background palette entries
+ *	0x00 - 0x0F (0 transparent), sprite the entries 0x10 - 0x1F with bit 6
+ *	for behind the background and bit 7 for sprite 0 (0 for none). Writes
+ *	the palette index and the color of every pixel, and returns true when
+ *	sprite 0 hit.
+ */
+typedef bool(*Compose_Fn)(const u8* bg, const u8* sprite, const u8* palette,
+	const u8 mask, const u32* colors, u8* indices, u32* rgba);
+
+// looks count palette indices up in colors
+typedef void(*Colorize_Fn)(const u8* indices, const u32* colors, u32* rgba, const u32 count);
+
+
+class Compositor
+{
+public:
+
+	enum class Path : u8 { Scalar, SSE2, AVX2 };
+
+	Compositor();
+
+	static Path Best_Path();
+	bool Set_Path(const Path p);
+	Path Get_Path() const { return path; }
+
+	bool Compose(const u8* bg, const u8* sprite, const u8* palette,
+		const u8 mask, const u32* colors, u8* indices, u32* rgba) const
+	{
+		return compose(bg, sprite, palette, mask, colors, indices, rgba);
+	} // end Compose
+
+	void Colorize(const u8* indices, const u32* colors, u32* rgba, const u32 count) const
+	{
+		colorize(indices, colors, rgba, count);
+	} // end Colorize
+
+private:
+
+	Path path;
+	Compose_Fn compose;
+	Colorize_Fn colorize;
+
+	static bool Compose_Scalar(const u8* bg, const u8* sprite, const u8* palette,
+		const u8 mask, const u32* colors, u8* indices, u32* rgba);
+	static void Colorize_Scalar(const u8* indices, const u32* colors, u32* rgba, const u32 count);
+#if NEST_SIMD
+	static bool Compose_SSE2(const u8* bg, const u8* sprite, const u8* palette,
+		const u8 mask, const u32* colors, u8* indices, u32* rgba);
+	static bool Compose_AVX2(const u8* bg, const u8* sprite, const u8* palette,
+		const u8 mask, const u32* colors, u8* indices, u32* rgba);
+	static void Colorize_AVX2(const u8* indices, const u32* colors, u32* rgba, const u32 count);
+#endif
+};
@@ -0,0 +1,98 @@
+/**
+ * @brief The 6502 opcode matrix as an X-macro, one entry per opcode:
+ *
+ *		X(opcode, mnemonic, operation, addressing mode, cycles, bytes)
+ *
+ *	Everything that needs to know about the 256 opcodes (the disassembly
+ *	lookup table, the switch interpreter and its computed goto twin) is 
+ *	expanded from this one list so they can never disagree. Unofficial 
+ *	opcodes show up as "???" and run as UNK or NOP.
+ *
+ * @author Rediet Worku
+ * @date 26th of October 2021, Sunday
+ */
+#pragma once
+
+
+//=====================================================================|
+#define CPU6502_OPCODES(X) \
+	/* 0x00 */ \
+	X(0x00, "BRK", BRK, IMP, 7, 1) X(0x01, "ORA", ORA, IZX, 6, 2) X(0x02, "???", UNK, IMP, 2, 1) X(0x03, "???", UNK, IMP, 8, 1) \
+	X(0x04, "???", NOP, IMP, 3, 1) X(0x05, "ORA", ORA, ZP0, 3, 2) X(0x06, "ASL", ASL, ZP0, 5, 2) X(0x07, "???", UNK, IMP, 5, 1) \
+	X(0x08, "PHP", PHP, IMP, 3, 1) X(0x09, "ORA", ORA, IMM, 2, 2) X(0x0A, "ASL", ASL, IMP, 2, 1) X(0x0B, "???", UNK, IMP, 2, 1) \
+	X(0x0C, "???", NOP, IMP, 4, 1) X(0x0D, "ORA", ORA, ABS, 4, 3) X(0x0E, "ASL", ASL, ABS, 6, 3) X(0x0F, "???", UNK, IMP, 6, 1) \
+	/* 0x10 */ \
+	X(0x10, "BPL", BPL, REL, 2, 2) X(0x11, "ORA", ORA, IZY, 5, 2) X(0x12, "???", UNK, IMP, 2, 1) X(0x13, "???", UNK, IMP, 8, 1) \
+	X(0x14, "???", NOP, IMP, 4, 1) X(0x15, "ORA", ORA, ZPX, 4, 2) X(0x16, "ASL", ASL, ZPX, 6, 2) X(0x17, "???", UNK, IMP, 6, 1) \
+	X(0x18, "CLC", CLC, IMP, 2, 1) X(0x19, "ORA", ORA, ABY, 4, 3) X(0x1A, "???", NOP, IMP, 2, 1) X(0x1B, "???", UNK, IMP, 7, 1) \
+	X(0x1C, "???", NOP, IMP, 4, 1) X(0x1D, "ORA", ORA, ABX, 4, 3) X(0x1E, "ASL", ASL, ABX, 7, 3) X(0x1F, "???", UNK, IMP, 7, 1) \
+	/* 0x20 */ \
+	X(0x20, "JSR", JSR, ABS, 6, 3) X(0x21, "AND", AND, IZX, 6, 2) X(0x22, "???", UNK, IMP, 2, 1) X(0x23, "???", UNK, IMP, 8, 1) \
+	X(0x24, "BIT", BIT, ZP0, 3, 2) X(0x25, "AND", AND, ZP0, 3, 2) X(0x26, "ROL", ROL, ZP0, 5, 2) X(0x27, "???", UNK, IMP, 5, 1) \
+	X(0x28, "PLP", PLP, IMP, 4, 1) X(0x29, "AND", AND, IMM, 2, 2) X(0x2A, "ROL", ROL, IMP, 2, 1) X(0x2B, "???", UNK, IMP, 2, 1) \
+	X(0x2C, "BIT", BIT, ABS, 4, 3) X(0x2D, "AND", AND, ABS, 4, 3) X(0x2E, "ROL", ROL, ABS, 6, 3) X(0x2F, "???", UNK, IMP, 6, 1) \
+	/* 0x30 */ \
+	X(0x30, "BMI", BMI, REL, 2, 2) X(0x31, "AND", AND, IZY, 5, 2) X(0x32, "???", UNK, IMP, 2, 1) X(0x33, "???", UNK, IMP, 8, 1) \
+	X(0x34, "???", NOP, IMP, 4, 1) X(0x35, "AND", AND, ZPX, 4, 2) X(0x36, "ROL", ROL, ZPX, 6, 2) X(0x37, "???", UNK, IMP, 6, 1) \
+	X(0x38, "SEC", SEC, IMP, 2, 1) X(0x39, "AND", AND, ABY, 4, 3) X(0x3A, "???", NOP, IMP, 2, 1) X(0x3B, "???", UNK, IMP, 7, 1) \
+	X(0x3C, "???", NOP, IMP, 4, 1) X(0x3D, "AND", AND, ABX, 4, 3) X(0x3E, "ROL", ROL, ABX, 7, 3) X(0x3F, "???", UNK, IMP, 7, 1) \
+	/* 0x40 */ \
+	X(0x40, "RTI", RTI, IMP, 6, 1) X(0x41, "EOR", EOR, IZX, 6, 2) X(0x42, "???", UNK, IMP, 2, 1) X(0x43, "???", UNK, IMP, 8, 1) \
+	X(0x44, "???", NOP, IMP, 3, 1) X(0x45, "EOR", EOR, ZP0, 3, 2) X(0x46, "LSR", LSR, ZP0, 5, 2) X(0x47, "???", UNK, IMP, 5, 1) \
+	X(0x48, "PHA", PHA, IMP, 3, 1) X(0x49, "EOR", EOR, IMM, 2, 2) X(0x4A, "LSR", LSR, IMP, 2, 1) X(0x4B, "???", UNK, IMP, 2, 1) \
+	X(0x4C, "JMP", JMP, ABS, 3, 3) X(0x4D, "EOR", EOR, ABS, 4, 3) X(0x4E, "LSR", LSR, ABS, 6, 3) X(0x4F, "???", UNK, IMP, 6, 1) \
+	/* 0x50 */ \
+	X(0x50, "BVC", BVC, REL, 2, 2) X(0x51, "EOR", EOR, IZY, 5, 2) X(0x52, "???", UNK, IMP, 2, 1) X(0x53, "???", UNK, IMP, 8, 1) \
+	X(0x54, "???", NOP, IMP, 4, 1) X(0x55, "EOR", EOR, ZPX, 4, 2) X(0x56, "LSR", LSR, ZPX, 6, 2) X(0x57, "???", UNK, IMP, 6, 1) \
+	X(0x58, "CLI", CLI, IMP, 2, 1) X(0x59, "EOR", EOR, ABY, 4, 3) X(0x5A, "???", NOP, IMP, 2, 1) X(0x5B, "???", UNK, IMP, 7, 1) \
+	X(0x5C, "???", NOP, IMP, 4, 1) X(0x5D, "EOR", EOR, ABX, 4, 3) X(0x5E, "LSR", LSR, ABX, 7, 3) X(0x5F, "???", UNK, IMP, 7, 1) \
+	/* 0x60 */ \
+	X(0x60, "RTS", RTS, IMP, 6, 1) X(0x61, "ADC", ADC, IZX, 6, 2) X(0x62, "???", UNK, IMP, 2, 1) X(0x63, "???", UNK, IMP, 8, 1) \
+	X(0x64, "???", NOP, IMP, 3, 1) X(0x65, "ADC", ADC, ZP0, 3, 2) X(0x66, "ROR", ROR, ZP0, 5, 2) X(0x67, "???", UNK, IMP, 5, 1) \
+	X(0x68, "PLA", PLA, IMP, 4, 1) X(0x69, "ADC", ADC, IMM, 2, 2) X(0x6A, "ROR", ROR, IMP, 2, 1) X(0x6B, "???", UNK, IMP, 2, 1) \
+	X(0x6C, "JMP", JMP, IND, 5, 3) X(0x6D, "ADC", ADC, ABS, 4, 3) X(0x6E, "ROR", ROR, ABS, 6, 3) X(0x6F, "???", UNK, IMP, 6, 1) \
+	/* 0x70 */ \
+	X(0x70, "BVS", BVS, REL, 2, 2) X(0x71, "ADC", ADC, IZY, 5, 2) X(0x72, "???", UNK, IMP, 2, 1) X(0x73, "???", UNK, IMP, 8, 1) \
+	X(0x74, "???", NOP, IMP, 4, 1) X(0x75, "ADC", ADC, ZPX, 4, 2) X(0x76, "ROR", ROR, ZPX, 6, 2) X(0x77, "???", UNK, IMP, 6, 1) \
+	X(0x78, "SEI", SEI, IMP, 2, 1) X(0x79, "ADC", ADC, ABY, 4, 3) X(0x7A, "???", NOP, IMP, 2, 1) X(0x7B, "???", UNK, IMP, 7, 1) \
+	X(0x7C, "???", NOP, IMP, 4, 1) X(0x7D, "ADC", ADC, ABX, 4, 3) X(0x7E, "ROR", ROR, ABX, 7, 3) X(0x7F, "???", UNK, IMP, 7, 1) \
+	/* 0x80 */ \
+	X(0x80, "???", NOP, IMP, 2, 1) X(0x81, "STA", STA, IZX, 6, 2) X(0x82, "???", NOP, IMP, 2, 1) X(0x83, "???", UNK, IMP, 6, 1) \
+	X(0x84, "STY", STY, ZP0, 3, 2) X(0x85, "STA", STA, ZP0, 3, 2) X(0x86, "STX", STX, ZP0, 3, 2) X(0x87, "???", UNK, IMP, 3, 1) \
+	X(0x88, "DEY", DEY, IMP, 2, 1) X(0x89, "???", NOP, IMP, 2, 1) X(0x8A, "TXA", TXA, IMP, 2, 1) X(0x8B, "???", UNK, IMP, 2, 1) \
+	X(0x8C, "STY", STY, ABS, 4, 3) X(0x8D, "STA", STA, ABS, 4, 3) X(0x8E, "STX", STX, ABS, 4, 3) X(0x8F, "???", UNK, IMP, 4, 1) \
+	/* 0x90 */ \
+	X(0x90, "BCC", BCC, REL, 2, 2) X(0x91, "STA", STA, IZY, 6, 2) X(0x92, "???", UNK, IMP, 2, 1) X(0x93, "???", UNK, IMP, 6, 1) \
+	X(0x94, "STY", STY, ZPX, 4, 2) X(0x95, "STA", STA, ZPX, 4, 2) X(0x96, "STX", STX, ZPY, 4, 2) X(0x97, "???", UNK, IMP, 4, 1) \
+	X(0x98, "TYA", TYA, IMP, 2, 1) X(0x99, "STA", STA, ABY, 5, 3) X(0x9A, "TXS", TXS, IMP, 2, 1) X(0x9B, "???", UNK, IMP, 5, 1) \
+	X(0x9C, "???", NOP, IMP, 5, 1) X(0x9D, "STA", STA, ABX, 5, 3) X(0x9E, "???", UNK, IMP, 5, 1) X(0x9F, "???", UNK, IMP, 5, 1) \
+	/* 0xA0 */ \
+	X(0xA0, "LDY", LDY, IMM, 2, 2) X(0xA1, "LDA", LDA, IZX, 6, 2) X(0xA2, "LDX", LDX, IMM, 2, 2) X(0xA3, "???", UNK, IMP, 6, 1) \
+	X(0xA4, "LDY", LDY, ZP0, 3, 2) X(0xA5, "LDA", LDA, ZP0, 3, 2) X(0xA6, "LDX", LDX, ZP0, 3, 2) X(0xA7, "???", UNK, IMP, 3, 1) \
+	X(0xA8, "TAY", TAY, IMP, 2, 1) X(0xA9, "LDA", LDA, IMM, 2, 2) X(0xAA, "TAX", TAX, IMP, 2, 1) X(0xAB, "???", UNK, IMP, 2, 1) \
+	X(0xAC, "LDY", LDY, ABS, 4, 3) X(0xAD, "LDA", LDA, ABS, 4, 3) X(0xAE, "LDX", LDX, ABS, 4, 3) X(0xAF, "???", UNK, IMP, 4, 1) \
+	/* 0xB0 */ \
+	X(0xB0, "BCS", BCS, REL, 2, 2) X(0xB1, "LDA", LDA, IZY, 5, 2) X(0xB2, "???", UNK, IMP, 2, 1) X(0xB3, "???", UNK, IMP, 5, 1) \
+	X(0xB4, "LDY", LDY, ZPX, 4, 2) X(0xB5, "LDA", LDA, ZPX, 4, 2) X(0xB6, "LDX", LDX, ZPY, 4, 2) X(0xB7, "???", UNK, IMP, 4, 1) \
+	X(0xB8, "CLV", CLV, IMP, 2, 1) X(0xB9, "LDA", LDA, ABY, 4, 3) X(0xBA, "TSX", TSX, IMP, 2, 1) X(0xBB, "???", UNK, IMP, 4, 1) \
+	X(0xBC, "LDY", LDY, ABX, 4, 3) X(0xBD, "LDA", LDA, ABX, 4, 3) X(0xBE, "LDX", LDX, ABY, 4, 3) X(0xBF, "???", UNK, IMP, 4, 1) \
+	/* 0xC0 */ \
+	X(0xC0, "CPY", CPY, IMM, 2, 2) X(0xC1, "CMP", CMP, IZX, 6, 2) X(0xC2, "???", NOP, IMP, 2, 1) X(0xC3, "???", UNK, IMP, 8, 1) \
+	X(0xC4, "CPY", CPY, ZP0, 3, 2) X(0xC5, "CMP", CMP, ZP0, 3, 2) X(0xC6, "DEC", DEC, ZP0, 5, 2) X(0xC7, "???", UNK, IMP, 5, 1) \
+	X(0xC8, "INY", INY, IMP, 2, 1) X(0xC9, "CMP", CMP, IMM, 2, 2) X(0xCA, "DEX", DEX, IMP, 2, 1) X(0xCB, "???", UNK, IMP, 2, 1) \
+	X(0xCC, "CPY", CPY, ABS, 4, 3) X(0xCD, "CMP", CMP, ABS, 4, 3) X(0xCE, "DEC", DEC, ABS, 6, 3) X(0xCF, "???", UNK, IMP, 6, 1) \
+	/* 0xD0 */ \
+	X(0xD0, "BNE", BNE, REL, 2, 2) X(0xD1, "CMP", CMP, IZY, 5, 2) X(0xD2, "???", UNK, IMP, 2, 1) X(0xD3, "???", UNK, IMP, 8, 1) \
+	X(0xD4, "???", NOP, IMP, 4, 1) X(0xD5, "CMP", CMP, ZPX, 4, 2) X(0xD6, "DEC", DEC, ZPX, 6, 2) X(0xD7, "???", UNK, IMP, 6, 1) \
+	X(0xD8, "CLD", CLD, IMP, 2, 1) X(0xD9, "CMP", CMP, ABY, 4, 3) X(0xDA, "NOP", NOP, IMP, 2, 1) X(0xDB, "???", UNK, IMP, 7, 1) \
+	X(0xDC, "???", NOP, IMP, 4, 1) X(0xDD, "CMP", CMP, ABX, 4, 3) X(0xDE, "DEC", DEC, ABX, 7, 3) X(0xDF, "???", UNK, IMP, 7, 1) \
+	/* 0xE0 */ \
+	X(0xE0, "CPX", CPX, IMM, 2, 2) X(0xE1, "SBC", SBC, IZX, 6, 2) X(0xE2, "???", NOP, IMP, 2, 1) X(0xE3, "???", UNK, IMP, 8, 1) \
+	X(0xE4, "CPX", CPX, ZP0, 3, 2) X(0xE5, "SBC", SBC, ZP0, 3, 2) X(0xE6, "INC", INC, ZP0, 5, 2) X(0xE7, "???", UNK, IMP, 5, 1) \
+	X(0xE8, "INX", INX, IMP, 2, 1) X(0xE9, "SBC", SBC, IMM, 2, 2) X(0xEA, "NOP", NOP, IMP, 2, 1) X(0xEB, "???", SBC, IMP, 2, 1) \
+	X(0xEC, "CPX", CPX, ABS, 4, 3) X(0xED, "SBC", SBC, ABS, 4, 3) X(0xEE, "INC", INC, ABS, 6, 3) X(0xEF, "???", UNK, IMP, 6, 1) \
+	/* 0xF0 */ \
+	X(0xF0, "BEQ", BEQ, REL, 2, 2) X(0xF1, "SBC", SBC, IZY, 5, 2) X(0xF2, "???", UNK, IMP, 2, 1) X(0xF3, "???", UNK, IMP, 8, 1) \
+	X(0xF4, "???", NOP, IMP, 4, 1) X(0xF5, "SBC", SBC, ZPX, 4, 2) X(0xF6, "INC", INC, ZPX, 6, 2) X(0xF7, "???", UNK, IMP, 6, 1) \
+	X(0xF8, "SED", SED, IMP, 2, 1) X(0xF9, "SBC", SBC, ABY, 4, 3) X(0xFA, "NOP", NOP, IMP, 2, 1) X(0xFB, "???", UNK, IMP, 7, 1) \
+	X(0xFC, "???", NOP, IMP, 4, 1) X(0xFD, "SBC", SBC, ABX, 4, 3) X(0xFE, "INC", INC, ABX, 7, 3) X(0xFF, "???", UNK, IMP, 7, 1)
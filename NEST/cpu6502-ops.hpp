@@ -0,0 +1,953 @@
+/**
+ * @brief The operations of the 6502 and the pre-decoded instruction 
+ *	runner, kept in a header so that anything with compile time knowledge
+ *	of the code it runs can have them inlined; the interpreters in 
+ *	cpu6502.cpp, and the C++ the static recompiler (nest-recomp) writes 
+ *	out for a ROM.
+ *
+ * @author Rediet Worku
+ * @date 26th of October 2021, Sunday
+ */
+#pragma once
+
+
+//=====================================================================|
+#include "cpu6502.hpp"
+#include "nes.hpp"
+
+
+
+//=====================================================================|
+/**
+ * @brief Reads the data from the 16-bit address put out on the bus. RAM
+ *	and ROM are read right out of the page table, only I/O goes through
+ *	the NES; every op reads through here, so it lives in the header.
+ */
+inline u8 CPU6502::Read(u16 addr)
+{
+	if (const u8* mem = bus[addr >> 8].read)
+		return mem[addr & 0xFF];
+
+	return nes->Read(addr);
+} // end Read
+
+
+//=====================================================================|
+/**
+ * @brief a little helper function that is used to fetch a data from 
+ *	main memory, according to the addressing mode involved, this makes the 
+ *	instructions/opcode excution uniform and easy to deal with. The mode 
+ *	is a template parameter, so the test for implied is settled at compile
+ *	time and costs nothing at runtime.
+ */
+template <CPU6502::Handler Mode>
+inline u8 CPU6502::Fetch()
+{
+	if constexpr (Mode != &CPU6502::IMP && Mode != &CPU6502::PRE)
+		fetched = Read(addr_abs);		// for all modes except implied
+	return fetched;
+} // end Fetch
+
+
+
+//=====================================================================|
+/**
+ * @brief What every branch does when taken: a cycle more, another when
+ *	it lands in another page. One going backwards may be closing an idle
+ *	loop, which Loop_Back looks into.
+ */
+inline void CPU6502::Take_Branch()
+{
+	++cycles;
+	addr_abs = pc + addr_rel;
+	if ((addr_abs & 0xFF00) != (pc & 0xFF00))
+		cycles++;
+
+	if (idle_skip && addr_abs < pc)
+		Loop_Back(addr_abs, pc);
+	pc = addr_abs;
+} // end Take_Branch
+
+
+//=====================================================================|
+// OPCODES
+//=====================================================================|
+/**
+ * @brief Add With Carry (the complications of 8-bit addition); 
+ *	sets Z,V,N,C flags
+ */
+template <CPU6502::Handler Mode>
+u8 CPU6502::ADC()
+{
+	u16 t = (u16)a + (u16)Fetch<Mode>() + (u16)flag_c;
+	flag_c = t > 255;
+	flag_v = (~((u16)a ^ (u16)fetched) & ((u16)a ^ (u16)t)) & 0x0080;
+	a = t & 0x00FF;
+	Set_NZ(a);
+	return 1;
+} // end ADC
+
+
+//=====================================================================|
+/**
+ * @brief Implements the logical AND operation on the accumulator 
+ *	register, almost same as x86/x64: AND AL, m8 and sets the Zero and 
+ *	Negative flags depending on the result of the operation
+ */
+template <CPU6502::Handler Mode>
+u8 CPU6502::AND()
+{
+	a &= Fetch<Mode>();
+	Set_NZ(a);
+	return 1;
+} // end AND
+
+
+//=====================================================================|
+/**
+ * @brief Arithemtic Shift Left; sets Z, N, C flags
+ */
+template <CPU6502::Handler Mode>
+u8 CPU6502::ASL()
+{
+	u16 t = (u16)Fetch<Mode>() << 1;
+	flag_c = t >> 8;
+	Set_NZ(t & 0x00FF);
+
+	if constexpr (Mode == &CPU6502::IMP)
+		a = t & 0x00FF;
+	else
+		Write(addr_abs, t & 0x00FF);
+	return 0;
+} // end ASL
+
+
+//=====================================================================|
+/**
+ * @brief Branch if Carry Clear
+ */
+template <CPU6502::Handler Mode>
+u8 CPU6502::BCC()
+{
+	if (!flag_c)
+		Take_Branch();
+
+	return 0;
+} // end BCC
+
+
+//=====================================================================|
+/**
+ * @brief Branch if Carry Set
+ */
+template <CPU6502::Handler Mode>
+u8 CPU6502::BCS()
+{
+	if (flag_c)
+		Take_Branch();
+
+	return 0;
+} // end BCS
+
+
+//=====================================================================|
+/**
+ * @brief Branch if Equal; i.e. Z == 1
+ */
+template <CPU6502::Handler Mode>
+u8 CPU6502::BEQ()
+{
+	if (!flag_z)
+		Take_Branch();
+
+	return 0;
+} // end BEQ
+
+
+//=====================================================================|
+/**
+ * @brief sets N,Z,V flags based on and operation with accumulator register
+ */
+template <CPU6502::Handler Mode>
+u8 CPU6502::BIT()
+{
+	flag_z = a & Fetch<Mode>();
+	flag_n = fetched;		// only 2 times I'll ever use 'fetched'
+	flag_v = fetched & 0x40;
+	return 0;
+} // end BIT
+
+
+//=====================================================================|
+/**
+ * @brief Branch if Negative; i.e. N == 1
+ */
+template <CPU6502::Handler Mode>
+u8 CPU6502::BMI()
+{
+	if (flag_n & N)
+		Take_Branch();
+
+	return 0;
+} // end BMI
+
+
+//=====================================================================|
+/**
+ * @brief Branch if Not Equal; i.e. Z == 0
+ */
+template <CPU6502::Handler Mode>
+u8 CPU6502::BNE()
+{
+	if (flag_z)
+		Take_Branch();
+
+	return 0;
+} // end BNE
+
+
+//=====================================================================|
+/**
+ * @brief Branch if PLus (postive); i.e. N == 0
+ */
+template <CPU6502::Handler Mode>
+u8 CPU6502::BPL()
+{
+	if (!(flag_n & N))
+		Take_Branch();
+
+	return 0;
+} // end BPL
+
+
+//=====================================================================|
+/**
+ * @brief Beak; program sourced interrupt, saves the current program 
+ *	counter and status flag states; sets B,I flags
+ */
+template <CPU6502::Handler Mode>
+u8 CPU6502::BRK()
+{
+	SET_FLAG(status, I, true);
+	Write(0x0100 + sp--, (++pc >> 8) & 0x00FF); // HO
+	Write(0x0100 + sp--, pc & 0x00FF);	// LO
+
+	SET_FLAG(status, B, true);
+	Write(0x0100 + sp--, Get_Status());
+	SET_FLAG(status, B, false);
+
+	pc = Read(0xFFFE) | ((u16)Read(0xFFFF) << 8);
+	return 0;
+} // end BRK
+
+
+//=====================================================================|
+/**
+ * @brief Branch if Overflow Clear; i.e. V == 0
+ */
+template <CPU6502::Handler Mode>
+u8 CPU6502::BVC()
+{
+	if (!flag_v)
+		Take_Branch();
+
+	return 0;
+} // end BVC
+
+
+//=====================================================================|
+/**
+ * @brief Branch if Overflow Set; i.e. V == 1
+ */
+template <CPU6502::Handler Mode>
+u8 CPU6502::BVS()
+{
+	if (flag_v)
+		Take_Branch();
+
+	return 0;
+} // end BVS
+
+
+//=====================================================================|
+/**
+ * @brief Clear's the carry bit
+ */
+template <CPU6502::Handler Mode>
+u8 CPU6502::CLC()
+{
+	flag_c = 0;
+	return 0;
+} // end CLC
+
+
+//=====================================================================|
+/**
+ * @brief Clear's the interrupt flag
+ */
+template <CPU6502::Handler Mode>
+u8 CPU6502::CLI()
+{
+	SET_FLAG(status, I, false);
+	return 0;
+} // end CLI
+
+
+//=====================================================================|
+/**
+ * @brief Clear's the decimal flag, but if the decimal flag was not part of NES console, then why here?
+ */
+template <CPU6502::Handler Mode>
+u8 CPU6502::CLD()
+{
+	SET_FLAG(status, D, false);
+	return 0;
+} // end CLD
+
+
+//=====================================================================|
+/**
+ * @brief Clear's the overflow flag
+ */
+template <CPU6502::Handler Mode>
+u8 CPU6502::CLV()
+{
+	flag_v = 0;
+	return 0;
+} // CLV
+
+
+//=====================================================================|
+/**
+ * @brief CoMPare accumulator, sets Z,N,C flags
+ */
+template <CPU6502::Handler Mode>
+u8 CPU6502::CMP()
+{
+	u16 t = (u16)a - (u16)Fetch<Mode>();
+	flag_c = a >= fetched;
+	Set_NZ(t & 0x00FF);
+	return 1;
+} // end CMP
+
+
+//=====================================================================|
+/**
+ * @brief CoMPare x register, sets Z,N,C flags
+ */
+template <CPU6502::Handler Mode>
+u8 CPU6502::CPX()
+{
+	u16 t = (u16)x - (u16)Fetch<Mode>();
+	flag_c = x >= fetched;
+	Set_NZ(t & 0x00FF);
+	return 0;
+} // end CPX
+
+
+//=====================================================================|
+/**
+ * @brief CoMPare x register, sets Z,N,C flags
+ */
+template <CPU6502::Handler Mode>
+u8 CPU6502::CPY()
+{
+	u16 t = (u16)y - (u16)Fetch<Mode>();
+	flag_c = y >= fetched;
+	Set_NZ(t & 0x00FF);
+	return 0;
+} // end CPY
+
+
+//=====================================================================|
+/**
+ * @brief Decrements the byte data at the memory location and set the 
+ *	necessary flags for the operation.
+ */
+template <CPU6502::Handler Mode>
+u8 CPU6502::DEC()
+{
+	u8 t = Fetch<Mode>() - 1;
+	Write(addr_abs, t);
+	Set_NZ(t);
+	return 0;
+} // end Dec
+
+
+//=====================================================================|
+/**
+ * @brief Decrements the X register and sets the Zero and Negative flags
+ */
+template <CPU6502::Handler Mode>
+u8 CPU6502::DEX()
+{
+	--x;
+	Set_NZ(x);
+	return 0;
+} // end DEX
+
+//=====================================================================|
+/**
+ * @brief Same as DEX but for Y
+ */
+template <CPU6502::Handler Mode>
+u8 CPU6502::DEY()
+{
+	--y;
+	Set_NZ(y);
+	return 0;
+} // end DEY
+
+
+//=====================================================================|
+/**
+ * @brief Performs exclusive or operation on the accumulator.
+ */
+template <CPU6502::Handler Mode>
+u8 CPU6502::EOR()
+{
+	a ^= Fetch<Mode>();
+	Set_NZ(a);
+	return 1;
+} // end EOR
+
+
+//=====================================================================|
+/**
+ * @brief Increments the data stored at memory location by 1 and 
+ *	set's the valid flags
+ */
+template <CPU6502::Handler Mode>
+u8 CPU6502::INC()
+{
+	u8 t = Fetch<Mode>() + 1;
+	Write(addr_abs, t);
+	Set_NZ(t);
+	return 0;
+} // end INC
+
+
+//=====================================================================|
+/**
+ * @brief Increments the X register by 1 and sets the Z, N flags
+ */
+template <CPU6502::Handler Mode>
+u8 CPU6502::INX()
+{
+	++x;
+	Set_NZ(x);
+	return 0;
+} // end INX
+
+
+//=====================================================================|
+/**
+ * @brief Increments the Y register by 1 and sets Z, N flags
+ */
+template <CPU6502::Handler Mode>
+u8 CPU6502::INY()
+{
+	++y;
+	Set_NZ(y);
+	return 0;
+} // end INY
+
+
+//=====================================================================|
+/**
+ * @brief Changes the current pc to the address provided; i.e. 
+ *	implement jump instruction
+ */
+template <CPU6502::Handler Mode>
+u8 CPU6502::JMP()
+{
+	if (idle_skip && addr_abs < pc)
+		Loop_Back(addr_abs, pc);
+	pc = addr_abs;
+	return 0;
+} // end JMP
+
+
+//=====================================================================|
+/**
+ * @brief Jump to Subroutine -- push the current pc to stack
+ */
+template <CPU6502::Handler Mode>
+u8 CPU6502::JSR()
+{
+	--pc;
+	Write(0x0100 + sp--, (pc >> 8) & 0x00FF);
+	Write(0x0100 + sp--, pc & 0x00FF);
+
+	pc = addr_abs;
+	return 0;
+} // end JSR
+
+
+//=====================================================================|
+/**
+ * @brief Loads the accumulator from the value supplied at memory. 
+ *	Sets Z,N flags.
+ */
+template <CPU6502::Handler Mode>
+u8 CPU6502::LDA()
+{
+	a = Fetch<Mode>();
+	Set_NZ(a);
+	return 1;
+} // end LDA
+
+
+//=====================================================================|
+/**
+ * @brief Loads the X register, sets N,Z flags
+ */
+template <CPU6502::Handler Mode>
+u8 CPU6502::LDX()
+{
+	x = Fetch<Mode>();
+	Set_NZ(x);
+	return 1;
+} // end LDX
+
+
+//=====================================================================|
+/**
+ * @brief Loads the Y register, sets N,Z flags
+ */
+template <CPU6502::Handler Mode>
+u8 CPU6502::LDY()
+{
+	y = Fetch<Mode>();
+	Set_NZ(y);
+	return 1;
+} // end LDY
+
+
+//=====================================================================|
+/**
+ * @brief Left shits operand by 1, affects C,Z,N flags.
+ */
+template <CPU6502::Handler Mode>
+u8 CPU6502::LSR()
+{
+	flag_c = Fetch<Mode>() & 0x0001;
+	u8 t = fetched >> 1;
+
+	Set_NZ(t);
+	if constexpr (Mode == &CPU6502::IMP)
+		a = t & 0x00FF;
+	else
+		Write(addr_abs, t);
+
+	return 0;
+} // end LSR
+
+
+//=====================================================================|
+/**
+ * @brief NOP, no operation, do nothing; however some do nothings 
+ *	according to specs at nesdev.wiki, can take more clock cycles depending 
+ *	on the opcode.
+ */
+template <CPU6502::Handler Mode>
+u8 CPU6502::NOP()
+{
+	switch (opcode)
+	{
+	case 0x1C:
+	case 0x3C:
+	case 0x5C:
+	case 0x7C:
+	case 0xDC:
+	case 0xFC:
+		return 1;
+	} // end switch
+
+	return 0;
+} // end NOP
+
+
+//=====================================================================|
+/**
+ * @brief Performs a logical OR operation on the accumulator register
+ */
+template <CPU6502::Handler Mode>
+u8 CPU6502::ORA()
+{
+	a |= Fetch<Mode>();
+	Set_NZ(a);
+	return 1;
+} // end ORA
+
+
+//=====================================================================|
+/**
+ * @brief Pushes the accumulator to the stack and updates the stack pointer
+ */
+template <CPU6502::Handler Mode>
+u8 CPU6502::PHA()
+{
+	Write(0x0100 + sp, a);
+	--sp;
+	return 0;
+} // end PHA
+
+
+//=====================================================================|
+/**
+ * @brief Pushes the flags to the stack; clears B,U flags and updates 
+ *	the stack pointer
+ */
+template <CPU6502::Handler Mode>
+u8 CPU6502::PHP()
+{
+	Write(0x0100 + sp, Get_Status() | B | U);
+	SET_FLAG(status, B, false);
+	SET_FLAG(status, U, false);
+	--sp;
+	return 0;
+} // end PHP
+
+
+//=====================================================================|
+/**
+ * @brief Pulls/pops the accumlator from the stack, updates the stack 
+ *	pointer. Sets Z,N flags
+ */
+template <CPU6502::Handler Mode>
+u8 CPU6502::PLA()
+{
+	a = Read(0x0100 + (++sp));
+	Set_NZ(a);
+	return 0;
+} // end PLA
+
+
+//=====================================================================|
+/**
+ * @brief Pops the flags register from the stack, sets U flag (don know why).
+ */
+template <CPU6502::Handler Mode>
+u8 CPU6502::PLP()
+{
+	Set_Status(Read(0x0100 + (++sp)));
+	SET_FLAG(status, U, true);
+	return 0;
+} // end PLP
+
+
+//=====================================================================|
+/**
+ * @brief Rotate Left
+ */
+template <CPU6502::Handler Mode>
+u8 CPU6502::ROL()
+{
+	u16 t = (u16)((Fetch<Mode>() << 1) | flag_c);
+	flag_c = t >> 8;
+	Set_NZ(t & 0x00FF);
+	if constexpr (Mode == &CPU6502::IMP)
+		a = t & 0x00FF;
+	else
+		Write(addr_abs, t & 0x00FF);
+	return 0;
+} // end ROL
+
+
+//=====================================================================|
+/**
+ * @brief Rotate right
+ */
+template <CPU6502::Handler Mode>
+u8 CPU6502::ROR()
+{
+	u16 temp = (uint16_t)(flag_c << 7) | (Fetch<Mode>() >> 1);
+	flag_c = fetched & 0x01;
+	Set_NZ(temp & 0x00FF);
+	if constexpr (Mode == &CPU6502::IMP)
+		a = temp & 0x00FF;
+	else
+		Write(addr_abs, temp & 0x00FF);
+	return 0;
+} // end ROR
+
+
+//=====================================================================|
+/**
+ * @brief Return from interrupt
+ */
+template <CPU6502::Handler Mode>
+u8 CPU6502::RTI()
+{
+	Set_Status(Read(0x0100 + (++sp)));
+	status &= ~B;
+	status &= ~U;
+
+	pc = (uint16_t)Read(0x0100 + (++sp));
+	pc |= (uint16_t)Read(0x0100 + (++sp)) << 8;
+	return 0;
+} // end RTI
+
+
+//=====================================================================|
+/**
+ * @brief Return from subroutine
+ */
+template <CPU6502::Handler Mode>
+u8 CPU6502::RTS()
+{
+	pc = (uint16_t)Read(0x0100 + (++sp));
+	pc |= (uint16_t)Read(0x0100 + (++sp)) << 8;
+
+	pc++;
+	return 0;
+} // end RTS
+
+
+//=====================================================================|
+/**
+ * @brief Subtract with carray or should I say Borrow? sets Z,V,N,C flags
+ */
+template <CPU6502::Handler Mode>
+u8 CPU6502::SBC()
+{
+	u16 value = (u16)Fetch<Mode>() ^ 0x00FF;
+	u16 t = (u16)a + value + (u16)flag_c;
+
+	flag_c = t > 255;
+	flag_v = (~((u16)a ^ value) & ((u16)a ^ t)) & 0x0080;
+	a = t & 0x00FF;
+	Set_NZ(a);
+	return 1;
+} // end SBC
+
+
+//=====================================================================|
+/**
+ * @brief Sets the carry flag to on/1
+ */
+template <CPU6502::Handler Mode>
+u8 CPU6502::SEC()
+{
+	flag_c = 1;
+	return 0;
+} // end SEC
+
+
+//=====================================================================|
+/**
+ * @brief Set's the decimal flag
+ */
+template <CPU6502::Handler Mode>
+u8 CPU6502::SED()
+{
+	SET_FLAG(status, D, true);
+	return 0;
+} // end SED
+
+
+//=====================================================================|
+/**
+ * @brief Sets the Interrupt flag
+ */
+template <CPU6502::Handler Mode>
+u8 CPU6502::SEI()
+{
+	SET_FLAG(status, I, true);
+	return 0;
+} // end SEI
+
+
+//=====================================================================|
+/**
+ * @brief Store accumulator at address
+ */
+template <CPU6502::Handler Mode>
+u8 CPU6502::STA()
+{
+	Write(addr_abs, a);
+	return 0;
+} // end STA
+
+//=====================================================================|
+/**
+ * @brief Store X register at address
+ */
+template <CPU6502::Handler Mode>
+u8 CPU6502::STX()
+{
+	Write(addr_abs, x);
+	return 0;
+} // end STX
+
+
+//=====================================================================|
+/**
+ * @brief Store register Y at address
+ */
+template <CPU6502::Handler Mode>
+u8 CPU6502::STY()
+{
+	Write(addr_abs, y);
+	return 0;
+} // end STY
+
+
+//=====================================================================|
+/**
+ * @brief Transfers the accumulator to X register; sets N,Z
+ */
+template <CPU6502::Handler Mode>
+u8 CPU6502::TAX()
+{
+	x = a;
+	Set_NZ(x);
+	return 0;
+} // end TAX
+
+
+//=====================================================================|
+/**
+ * @brief Transfers accumulator to Y register, sets Z,V
+ */
+template <CPU6502::Handler Mode>
+u8 CPU6502::TAY()
+{
+	y = a;
+	Set_NZ(y);
+	return 0;
+} // end TAY
+
+
+//=====================================================================|
+/**
+ * @brief Moves the stack pointer to X register; sets Z and N flags
+ */
+template <CPU6502::Handler Mode>
+u8 CPU6502::TSX()
+{
+	x = sp;
+	Set_NZ(x);
+	return 0;
+} // end TSX
+
+
+//=====================================================================|
+/**
+ * @brief Transferes X register to accumulator, sets Z,N flags
+ */
+template <CPU6502::Handler Mode>
+u8 CPU6502::TXA()
+{
+	a = x;
+	Set_NZ(a);
+	return 0;
+} // end TXA
+
+
+//=====================================================================|
+/**
+ * @brief Transfers X register to stack pointer
+ */
+template <CPU6502::Handler Mode>
+u8 CPU6502::TXS()
+{
+	sp = x;
+	return 0;
+} // end sp
+
+
+//=====================================================================|
+/**
+ * @brief Transfer Y register to accumulator, sets Z,N flags
+ */
+template <CPU6502::Handler Mode>
+u8 CPU6502::TYA()
+{
+	a = y;
+	Set_NZ(a);
+	return 0;
+} // end TYA
+
+
+//=====================================================================|
+/**
+ * @brief The Unkown opcode
+ */
+template <CPU6502::Handler Mode>
+u8 CPU6502::UNK()
+{
+	return 0;
+} // end UNK
+
+
+//=====================================================================|
+/**
+ * @brief Runs one pre-decoded instruction. The operand bytes were read at
+ *	decode time, so the addressing mode boils down to a bit of arithmetic
+ *	on them; only the indirect modes still have to go to the bus for their
+ *	pointers and those simply rewind pc and run the real mode function.
+ *
+ * @param cpu the cpu to run on
+ * @param d the decoded instruction
+ *
+ * @return the number of decoded ops consumed; always 1
+ */
+template <u8 Mode_Id, CPU6502::Handler Mode, CPU6502::Handler Operate>
+u8 CPU6502::Run_Decoded(CPU6502& cpu, const Decoded_Op& d)
+{
+	cpu.opcode = d.opcode;
+	cpu.pc = d.next_pc;
+	cpu.cycles = d.cycles;
+
+	u8 add_cycle1 = 0;
+	if constexpr (Mode_Id == AM_IMP)
+		cpu.fetched = cpu.a;
+	else if constexpr (Mode_Id == AM_IMM)
+		cpu.fetched = (u8)d.operand;
+	else if constexpr (Mode_Id == AM_ZP0 || Mode_Id == AM_ABS)
+		cpu.addr_abs = d.operand;
+	else if constexpr (Mode_Id == AM_ZPX)
+		cpu.addr_abs = (d.operand + cpu.x) & 0x00FF;
+	else if constexpr (Mode_Id == AM_ZPY)
+		cpu.addr_abs = (d.operand + cpu.y) & 0x00FF;
+	else if constexpr (Mode_Id == AM_ABX || Mode_Id == AM_ABY)
+	{
+		cpu.addr_abs = d.operand + (Mode_Id == AM_ABX ? cpu.x : cpu.y);
+		add_cycle1 = (cpu.addr_abs & 0xFF00) != (d.operand & 0xFF00);
+	} // end else if indexed absolute
+	else if constexpr (Mode_Id == AM_REL)
+		cpu.addr_rel = d.operand;
+	else
+	{
+		cpu.pc = d.next_pc - lookup[d.opcode].bytes + 1;
+		add_cycle1 = (cpu.*Mode)();
+	} // end else indirect
+
+	u8 add_cycle2 = (cpu.*Operate)();
+	cpu.cycles += (add_cycle1 & add_cycle2);
+	return 1;
+} // end Run_Decoded
+
+
+//=====================================================================|
+// one instruction of an ahead of time recompiled block, as nest-recomp 
+//	writes them out; with the operand a constant the addressing mode folds
+//	away and the operation is inlined. Only usable from inside a 
+//	Recompiled<> specialization, which has cpu in scope.
+//
+//	A block only starts when all of it fits before the target, but a
+//	store to I/O can bring the target in (Stop_At) or stall the CPU past
+//	it (OAM DMA); the block then returns after that op, with pc already
+//	on the next one, and Run_Static carries on from there.
+#define NEST_STATIC_OP(mode, op, opc, operand, next_pc, cyc) \
+	{ \
+		static constexpr Decoded_Op d{ nullptr, operand, next_pc, cyc, opc }; \
+		CPU6502::Run_Decoded<CPU6502::AM_##mode, &CPU6502::mode, \
+			&CPU6502::op<CPU6502::Decoded_Mode(&CPU6502::mode)>>(cpu, d); \
+		cpu.total_cycles += cpu.cycles; \
+		cpu.cycles = 0; \
+		if (cpu.total_cycles >= cpu.run_target) \
+			return; \
+	}
@@ -7,8 +7,36 @@
 
 //=====================================================================|
 #include "cpu6502.hpp"
+#include "cpu6502-ops.hpp"
 #include "nes.hpp"
 
+#include <algorithm>
+
+
+
+//=====================================================================|
+// pairs of { addressing mode, operation } used by Execute_Lookup()
+#define LOOKUP_HANDLERS(opc, name, op, mode, cyc, len) \
+	{ &CPU6502::mode, &CPU6502::op<&CPU6502::mode> },
+
+const CPU6502::Handler CPU6502::lookup_handlers[256][2] = { 
+	CPU6502_OPCODES(LOOKUP_HANDLERS) 
+};
+#undef LOOKUP_HANDLERS
+
+
+// the handler for an op with mode and operation fixed at compile time, 
+//	as run by the block engine
+#define DECODED_HANDLER(mode, op) \
+	&CPU6502::Run_Decoded<AM_##mode, &CPU6502::mode, &CPU6502::op<Decoded_Mode(&CPU6502::mode)>>
+
+#define DECODED_HANDLERS(opc, name, op, mode, cyc, len) DECODED_HANDLER(mode, op),
+
+const Decoded_Fn CPU6502::decoded_handlers[256] = {
+	CPU6502_OPCODES(DECODED_HANDLERS)
+};
+#undef DECODED_HANDLERS
+
 
 
 //=====================================================================|
@@ -16,30 +44,16 @@
  * constructor
  */
 CPU6502::CPU6502()
-	:nes{ nullptr },
+	:nes{ nullptr }, bus{ nullptr },
 	a{ 0 }, x{ 0 }, y{ 0 }, sp{ 0 }, pc{ 0 }, status{ 0 },
-	addr_abs{ 0 }, addr_rel{ 0 }, cycles{ 0 }, fetched{ 0 }, opcode{ 0 }
-{
-	using a = CPU6502;
-	lookup =
-	{
-		{ "BRK", &a::BRK, &a::IMP, 7, 1 },{ "ORA", &a::ORA, &a::IZX, 6, 2 },{ "???", &a::UNK, &a::IMP, 2, 1 },{ "???", &a::UNK, &a::IMP, 8, 1 },{ "???", &a::NOP, &a::IMP, 3, 1 },{ "ORA", &a::ORA, &a::ZP0, 3, 2 },{ "ASL", &a::ASL, &a::ZP0, 5, 2 },{ "???", &a::UNK, &a::IMP, 5, 1 },{ "PHP", &a::PHP, &a::IMP, 3, 1 },{ "ORA", &a::ORA, &a::IMM, 2, 2 },{ "ASL", &a::ASL, &a::IMP, 2, 1 },{ "???", &a::UNK, &a::IMP, 2, 1 },{ "???", &a::NOP, &a::IMP, 4, 1 },{ "ORA", &a::ORA, &a::ABS, 4, 3 },{ "ASL", &a::ASL, &a::ABS, 6, 3 },{ "???", &a::UNK, &a::IMP, 6, 1 },
-		{ "BPL", &a::BPL, &a::REL, 2, 2 },{ "ORA", &a::ORA, &a::IZY, 5, 2 },{ "???", &a::UNK, &a::IMP, 2, 1 },{ "???", &a::UNK, &a::IMP, 8, 1 },{ "???", &a::NOP, &a::IMP, 4, 1 },{ "ORA", &a::ORA, &a::ZPX, 4, 2 },{ "ASL", &a::ASL, &a::ZPX, 6, 2 },{ "???", &a::UNK, &a::IMP, 6, 1 },{ "CLC", &a::CLC, &a::IMP, 2, 1 },{ "ORA", &a::ORA, &a::ABY, 4, 3 },{ "???", &a::NOP, &a::IMP, 2, 1 },{ "???", &a::UNK, &a::IMP, 7, 1 },{ "???", &a::NOP, &a::IMP, 4, 1 },{ "ORA", &a::ORA, &a::ABX, 4, 3 },{ "ASL", &a::ASL, &a::ABX, 7, 3 },{ "???", &a::UNK, &a::IMP, 7, 1 },
-		{ "JSR", &a::JSR, &a::ABS, 6, 3 },{ "AND", &a::AND, &a::IZX, 6, 2 },{ "???", &a::UNK, &a::IMP, 2, 1 },{ "???", &a::UNK, &a::IMP, 8, 1 },{ "BIT", &a::BIT, &a::ZP0, 3, 2 },{ "AND", &a::AND, &a::ZP0, 3, 2 },{ "ROL", &a::ROL, &a::ZP0, 5, 2 },{ "???", &a::UNK, &a::IMP, 5, 1 },{ "PLP", &a::PLP, &a::IMP, 4, 1 },{ "AND", &a::AND, &a::IMM, 2, 2 },{ "ROL", &a::ROL, &a::IMP, 2, 1 },{ "???", &a::UNK, &a::IMP, 2, 1 },{ "BIT", &a::BIT, &a::ABS, 4, 3 },{ "AND", &a::AND, &a::ABS, 4, 3 },{ "ROL", &a::ROL, &a::ABS, 6, 3 },{ "???", &a::UNK, &a::IMP, 6, 1 },
-		{ "BMI", &a::BMI, &a::REL, 2, 2 },{ "AND", &a::AND, &a::IZY, 5, 2 },{ "???", &a::UNK, &a::IMP, 2, 1 },{ "???", &a::UNK, &a::IMP, 8, 1 },{ "???", &a::NOP, &a::IMP, 4, 1 },{ "AND", &a::AND, &a::ZPX, 4, 2 },{ "ROL", &a::ROL, &a::ZPX, 6, 2 },{ "???", &a::UNK, &a::IMP, 6, 1 },{ "SEC", &a::SEC, &a::IMP, 2, 1 },{ "AND", &a::AND, &a::ABY, 4, 3 },{ "???", &a::NOP, &a::IMP, 2, 1 },{ "???", &a::UNK, &a::IMP, 7, 1 },{ "???", &a::NOP, &a::IMP, 4, 1 },{ "AND", &a::AND, &a::ABX, 4, 3 },{ "ROL", &a::ROL, &a::ABX, 7, 3 },{ "???", &a::UNK, &a::IMP, 7, 1 },
-		{ "RTI", &a::RTI, &a::IMP, 6, 1 },{ "EOR", &a::EOR, &a::IZX, 6, 2 },{ "???", &a::UNK, &a::IMP, 2, 1 },{ "???", &a::UNK, &a::IMP, 8, 1 },{ "???", &a::NOP, &a::IMP, 3, 1 },{ "EOR", &a::EOR, &a::ZP0, 3, 2 },{ "LSR", &a::LSR, &a::ZP0, 5, 2 },{ "???", &a::UNK, &a::IMP, 5, 1 },{ "PHA", &a::PHA, &a::IMP, 3, 1 },{ "EOR", &a::EOR, &a::IMM, 2, 2 },{ "LSR", &a::LSR, &a::IMP, 2, 1 },{ "???", &a::UNK, &a::IMP, 2, 1 },{ "JMP", &a::JMP, &a::ABS, 3, 3 },{ "EOR", &a::EOR, &a::ABS, 4, 3 },{ "LSR", &a::LSR, &a::ABS, 6, 3 },{ "???", &a::UNK, &a::IMP, 6, 1 },
-		{ "BVC", &a::BVC, &a::REL, 2, 2 },{ "EOR", &a::EOR, &a::IZY, 5, 2 },{ "???", &a::UNK, &a::IMP, 2, 1 },{ "???", &a::UNK, &a::IMP, 8, 1 },{ "???", &a::NOP, &a::IMP, 4, 1 },{ "EOR", &a::EOR, &a::ZPX, 4, 2 },{ "LSR", &a::LSR, &a::ZPX, 6, 2 },{ "???", &a::UNK, &a::IMP, 6, 1 },{ "CLI", &a::CLI, &a::IMP, 2, 1 },{ "EOR", &a::EOR, &a::ABY, 4, 3 },{ "???", &a::NOP, &a::IMP, 2, 1 },{ "???", &a::UNK, &a::IMP, 7, 1 },{ "???", &a::NOP, &a::IMP, 4, 1 },{ "EOR", &a::EOR, &a::ABX, 4, 3 },{ "LSR", &a::LSR, &a::ABX, 7, 3 },{ "???", &a::UNK, &a::IMP, 7, 1 },
-		{ "RTS", &a::RTS, &a::IMP, 6, 1 },{ "ADC", &a::ADC, &a::IZX, 6, 2 },{ "???", &a::UNK, &a::IMP, 2, 1 },{ "???", &a::UNK, &a::IMP, 8, 1 },{ "???", &a::NOP, &a::IMP, 3, 1 },{ "ADC", &a::ADC, &a::ZP0, 3, 2 },{ "ROR", &a::ROR, &a::ZP0, 5, 2 },{ "???", &a::UNK, &a::IMP, 5, 1 },{ "PLA", &a::PLA, &a::IMP, 4, 1 },{ "ADC", &a::ADC, &a::IMM, 2, 2 },{ "ROR", &a::ROR, &a::IMP, 2, 1 },{ "???", &a::UNK, &a::IMP, 2, 1 },{ "JMP", &a::JMP, &a::IND, 5, 3 },{ "ADC", &a::ADC, &a::ABS, 4, 3 },{ "ROR", &a::ROR, &a::ABS, 6, 3 },{ "???", &a::UNK, &a::IMP, 6, 1 },
-		{ "BVS", &a::BVS, &a::REL, 2, 2 },{ "ADC", &a::ADC, &a::IZY, 5, 2 },{ "???", &a::UNK, &a::IMP, 2, 1 },{ "???", &a::UNK, &a::IMP, 8, 1 },{ "???", &a::NOP, &a::IMP, 4, 1 },{ "ADC", &a::ADC, &a::ZPX, 4, 2 },{ "ROR", &a::ROR, &a::ZPX, 6, 2 },{ "???", &a::UNK, &a::IMP, 6, 1 },{ "SEI", &a::SEI, &a::IMP, 2, 1 },{ "ADC", &a::ADC, &a::ABY, 4, 3 },{ "???", &a::NOP, &a::IMP, 2, 1 },{ "???", &a::UNK, &a::IMP, 7, 1 },{ "???", &a::NOP, &a::IMP, 4, 1 },{ "ADC", &a::ADC, &a::ABX, 4, 3 },{ "ROR", &a::ROR, &a::ABX, 7, 3 },{ "???", &a::UNK, &a::IMP, 7, 1 },
-		{ "???", &a::NOP, &a::IMP, 2, 1 },{ "STA", &a::STA, &a::IZX, 6, 2 },{ "???", &a::NOP, &a::IMP, 2, 1 },{ "???", &a::UNK, &a::IMP, 6, 1 },{ "STY", &a::STY, &a::ZP0, 3, 2 },{ "STA", &a::STA, &a::ZP0, 3, 2 },{ "STX", &a::STX, &a::ZP0, 3, 2 },{ "???", &a::UNK, &a::IMP, 3, 1 },{ "DEY", &a::DEY, &a::IMP, 2, 1 },{ "???", &a::NOP, &a::IMP, 2, 1 },{ "TXA", &a::TXA, &a::IMP, 2, 1 },{ "???", &a::UNK, &a::IMP, 2, 1 },{ "STY", &a::STY, &a::ABS, 4, 3 },{ "STA", &a::STA, &a::ABS, 4, 3 },{ "STX", &a::STX, &a::ABS, 4, 3 },{ "???", &a::UNK, &a::IMP, 4, 1 },
-		{ "BCC", &a::BCC, &a::REL, 2, 2 },{ "STA", &a::STA, &a::IZY, 6, 2 },{ "???", &a::UNK, &a::IMP, 2, 1 },{ "???", &a::UNK, &a::IMP, 6, 1 },{ "STY", &a::STY, &a::ZPX, 4, 2 },{ "STA", &a::STA, &a::ZPX, 4, 2 },{ "STX", &a::STX, &a::ZPY, 4, 2 },{ "???", &a::UNK, &a::IMP, 4, 1 },{ "TYA", &a::TYA, &a::IMP, 2, 1 },{ "STA", &a::STA, &a::ABY, 5, 3 },{ "TXS", &a::TXS, &a::IMP, 2, 1 },{ "???", &a::UNK, &a::IMP, 5, 1 },{ "???", &a::NOP, &a::IMP, 5, 1 },{ "STA", &a::STA, &a::ABX, 5, 3 },{ "???", &a::UNK, &a::IMP, 5, 1 },{ "???", &a::UNK, &a::IMP, 5, 1 },
-		{ "LDY", &a::LDY, &a::IMM, 2, 2 },{ "LDA", &a::LDA, &a::IZX, 6, 2 },{ "LDX", &a::LDX, &a::IMM, 2, 2 },{ "???", &a::UNK, &a::IMP, 6, 1 },{ "LDY", &a::LDY, &a::ZP0, 3, 2 },{ "LDA", &a::LDA, &a::ZP0, 3, 2 },{ "LDX", &a::LDX, &a::ZP0, 3, 2 },{ "???", &a::UNK, &a::IMP, 3, 1 },{ "TAY", &a::TAY, &a::IMP, 2, 1 },{ "LDA", &a::LDA, &a::IMM, 2, 2 },{ "TAX", &a::TAX, &a::IMP, 2, 1 },{ "???", &a::UNK, &a::IMP, 2, 1 },{ "LDY", &a::LDY, &a::ABS, 4, 3 },{ "LDA", &a::LDA, &a::ABS, 4, 3 },{ "LDX", &a::LDX, &a::ABS, 4, 3 },{ "???", &a::UNK, &a::IMP, 4, 1 },
-		{ "BCS", &a::BCS, &a::REL, 2, 2 },{ "LDA", &a::LDA, &a::IZY, 5, 2 },{ "???", &a::UNK, &a::IMP, 2, 1 },{ "???", &a::UNK, &a::IMP, 5, 1 },{ "LDY", &a::LDY, &a::ZPX, 4, 2 },{ "LDA", &a::LDA, &a::ZPX, 4, 2 },{ "LDX", &a::LDX, &a::ZPY, 4, 2 },{ "???", &a::UNK, &a::IMP, 4, 1 },{ "CLV", &a::CLV, &a::IMP, 2, 1 },{ "LDA", &a::LDA, &a::ABY, 4, 3 },{ "TSX", &a::TSX, &a::IMP, 2, 1 },{ "???", &a::UNK, &a::IMP, 4, 1 },{ "LDY", &a::LDY, &a::ABX, 4, 3 },{ "LDA", &a::LDA, &a::ABX, 4, 3 },{ "LDX", &a::LDX, &a::ABY, 4, 3 },{ "???", &a::UNK, &a::IMP, 4, 1 },
-		{ "CPY", &a::CPY, &a::IMM, 2, 2 },{ "CMP", &a::CMP, &a::IZX, 6, 2 },{ "???", &a::NOP, &a::IMP, 2, 1 },{ "???", &a::UNK, &a::IMP, 8, 1 },{ "CPY", &a::CPY, &a::ZP0, 3, 2 },{ "CMP", &a::CMP, &a::ZP0, 3, 2 },{ "DEC", &a::DEC, &a::ZP0, 5, 2 },{ "???", &a::UNK, &a::IMP, 5, 1 },{ "INY", &a::INY, &a::IMP, 2, 1 },{ "CMP", &a::CMP, &a::IMM, 2, 2 },{ "DEX", &a::DEX, &a::IMP, 2, 1 },{ "???", &a::UNK, &a::IMP, 2, 1 },{ "CPY", &a::CPY, &a::ABS, 4, 3 },{ "CMP", &a::CMP, &a::ABS, 4, 3 },{ "DEC", &a::DEC, &a::ABS, 6, 3 },{ "???", &a::UNK, &a::IMP, 6, 1 },
-		{ "BNE", &a::BNE, &a::REL, 2, 2 },{ "CMP", &a::CMP, &a::IZY, 5, 2 },{ "???", &a::UNK, &a::IMP, 2, 1 },{ "???", &a::UNK, &a::IMP, 8, 1 },{ "???", &a::NOP, &a::IMP, 4, 1 },{ "CMP", &a::CMP, &a::ZPX, 4, 2 },{ "DEC", &a::DEC, &a::ZPX, 6, 2 },{ "???", &a::UNK, &a::IMP, 6, 1 },{ "CLD", &a::CLD, &a::IMP, 2, 1 },{ "CMP", &a::CMP, &a::ABY, 4, 3 },{ "NOP", &a::NOP, &a::IMP, 2, 1 },{ "???", &a::UNK, &a::IMP, 7, 1 },{ "???", &a::NOP, &a::IMP, 4, 1 },{ "CMP", &a::CMP, &a::ABX, 4, 3 },{ "DEC", &a::DEC, &a::ABX, 7, 3 },{ "???", &a::UNK, &a::IMP, 7, 1 },
-		{ "CPX", &a::CPX, &a::IMM, 2, 2 },{ "SBC", &a::SBC, &a::IZX, 6, 2 },{ "???", &a::NOP, &a::IMP, 2, 1 },{ "???", &a::UNK, &a::IMP, 8, 1 },{ "CPX", &a::CPX, &a::ZP0, 3, 2 },{ "SBC", &a::SBC, &a::ZP0, 3, 2 },{ "INC", &a::INC, &a::ZP0, 5, 2 },{ "???", &a::UNK, &a::IMP, 5, 1 },{ "INX", &a::INX, &a::IMP, 2, 1 },{ "SBC", &a::SBC, &a::IMM, 2, 2 },{ "NOP", &a::NOP, &a::IMP, 2, 1 },{ "???", &a::SBC, &a::IMP, 2, 1 },{ "CPX", &a::CPX, &a::ABS, 4, 3 },{ "SBC", &a::SBC, &a::ABS, 4, 3 },{ "INC", &a::INC, &a::ABS, 6, 3 },{ "???", &a::UNK, &a::IMP, 6, 1 },
-		{ "BEQ", &a::BEQ, &a::REL, 2, 2 },{ "SBC", &a::SBC, &a::IZY, 5, 2 },{ "???", &a::UNK, &a::IMP, 2, 1 },{ "???", &a::UNK, &a::IMP, 8, 1 },{ "???", &a::NOP, &a::IMP, 4, 1 },{ "SBC", &a::SBC, &a::ZPX, 4, 2 },{ "INC", &a::INC, &a::ZPX, 6, 2 },{ "???", &a::UNK, &a::IMP, 6, 1 },{ "SED", &a::SED, &a::IMP, 2, 1 },{ "SBC", &a::SBC, &a::ABY, 4, 3 },{ "NOP", &a::NOP, &a::IMP, 2, 1 },{ "???", &a::UNK, &a::IMP, 7, 1 },{ "???", &a::NOP, &a::IMP, 4, 1 },{ "SBC", &a::SBC, &a::ABX, 4, 3 },{ "INC", &a::INC, &a::ABX, 7, 3 },{ "???", &a::UNK, &a::IMP, 7, 1 },
-	};
+	flag_n{ 0 }, flag_z{ 1 }, flag_c{ 0 }, flag_v{ 0 },
+	addr_abs{ 0 }, addr_rel{ 0 }, cycles{ 0 }, fetched{ 0 }, opcode{ 0 },
+	total_cycles{ 0 }, backend{ Backend::Switch }, program{ nullptr }, run_target{ 0 },
+	idle_skip{ true }, loop_kind{ LOOP_NONE }, loop_start{ 0 }, loop_end{ 0 }, loop_max{ 0 },
+	loop_regs{ 0 }, loop_cycle{ 0 }, loop_status{ 0 }, idle_loops{ 0 }, idle_cycles{ 0 }
+{
+	// the opcode tables are all compile time constants, nothing to build
+	static_assert(sizeof(INSTRUCTION) == 2, "hot opcode entries must stay packed");
 } // end constructor
 
 
@@ -59,6 +73,7 @@ CPU6502::~CPU6502()
 void CPU6502::Connect_NES(NES* n)
 {
 	nes = n;
+	bus = n->Page_Table();
 } // end Connect_NESBus
 
 
@@ -69,17 +84,21 @@ void CPU6502::Connect_NES(NES* n)
 void CPU6502::Write(u16 addr, u8 data)
 {
 	nes->Write(addr, data);
-} // end Write
-
 
-//=====================================================================|
-/**
- * @brief Reads the data from the 16-bit address put out on the bus
- */
-u8 CPU6502::Read(u16 addr)
-{
-	return nes->Read(addr);
-} // end Read
+	// only memory can hold code; a write to ROM is a mapper register and
+	//	must not throw away the code around it
+	if (blocks && bus[addr >> 8].write)
+	{
+		// RAM shows up four times over, code may run from any of them
+		if (addr < 0x2000)
+		{
+			for (u16 mirror = addr & 0x07FF; mirror < 0x2000; mirror += 0x0800)
+				blocks->Note_Write(mirror);
+		} // end if RAM
+		else
+			blocks->Note_Write(addr);
+	} // end if blocks cached
+} // end Write
 
 
 //=====================================================================|
@@ -93,1107 +112,1157 @@ u8 CPU6502::Read(u16 addr)
 void CPU6502::Clock()
 {
 	if (!cycles)
-	{
-		opcode = Read(pc++);
-		cycles = lookup[opcode].cycles;
-		uint8_t add_cycle1 = (this->*lookup[opcode].Addrmode)();
-		uint8_t add_cycle2 = (this->*lookup[opcode].Operate)();
-		cycles += (add_cycle1 & add_cycle2);
-	} // end if
+		Execute();
 
 	--cycles;
+	++total_cycles;
 } // end Clock
 
 
 //=====================================================================|
 /**
- * @brief Reset's the CPU and start's it in the default state; 
- *	i.e. pc = 0xFFFC
- */
-void CPU6502::Reset()
-{
-	a = x = y = 0;
-	sp = 0xFD;
-	status = 0x0 | U;
-	pc = 0xFCFF;		// 0xFFFC
-
-	addr_rel = addr_abs = fetched = 0;
-	cycles = 8;		// take your time
-} // end Reset
-
-
-//=====================================================================|
-/**
- * @brief Handles the software based interrupts; IRQs -- reads the byte 
- *	stored at address 0xFFFE
- */
-void CPU6502::IRQ()
-{
-	if (!GET_FLAG(status, I))
-	{
-		Write(0x0100 + sp--, (pc >> 8) & 0x00FF);
-		Write(0x0100 + sp--, (pc & 0x00FF));
-
-		SET_FLAG(status, B, 0);
-		SET_FLAG(status, U, 1);
-		SET_FLAG(status, I, 1);
-		Write(0x0100 + sp--, status);
-
-		pc = (((u16)Read(0xFFFF) << 8) | ((u16)Read(0xFFFE)));
-		cycles = 7;
-	} // end if
-} // end IRQ
-
-
-//=====================================================================|
-/**
- * @brief Handles the non maskable interrupt; same as IRQ except that 
- *	this cannot be masked and address is at 0xFFFA
- */
-void CPU6502::NMI()
-{
-	Write(0x0100 + sp--, (pc >> 8) & 0x00FF);
-	Write(0x0100 + sp--, (pc & 0x00FF));
-
-	SET_FLAG(status, B, 0);
-	SET_FLAG(status, U, 1);
-	SET_FLAG(status, I, 1);
-	Write(0x0100 + sp--, status);
-
-	pc = (((u16)Read(0xFFFB) << 8) | ((u16)Read(0xFFFA)));
-	cycles = 8;
-} // end NMI
-
-
-
-//=====================================================================|
-// ADDRESSING MODES
-//=====================================================================|
-/**
- * @brief The impled addressing mode, requires no further data to excute 
- *	the instruction, i.e. the opcode itself imples a given instruction. 
- *	It could also mean that data is already being operated on the accumulator.
- */
-u8 CPU6502::IMP()
-{
-	fetched = a;
-	return 0;
-} // end IMM
-
-
-//=====================================================================|
-/**
- * @brief The immidate mode addressing implies (aint that ironic) the 
- *	next byte in memory is the data being supplied as part of the instruction.
- */
-u8 CPU6502::IMM()
-{
-	addr_abs = pc++;
-	return 0;
-} // end IMM
-
-
-//=====================================================================|
-/**
- * @brief Zero page addressing is a special addressing that puts the data 
- *	for the instruction somewhere in the first page of the RAM (the first 256 bytes).
- */
-u8 CPU6502::ZP0()
-{
-	addr_abs = Read(pc++) & 0x00FF;
-	return 0;
-} // end ZP0
-
-
-//=====================================================================|
-/**
- * @brief Zero Page X is like Zero Page, only difference, the value at 
- *	the program couter is offset by the byte val store in the X register. 
- *	It's like array's in C.
- */
-u8 CPU6502::ZPX()
-{
-	addr_abs = (Read(pc++) + x) & 0x00FF;
-	return 0;
-} // end ZPX
-
-
-//=====================================================================|
-/**
- * @brief ZPY is the same thing as ZPX but only the offset is the Y register.
- */
-u8 CPU6502::ZPY()
-{
-	addr_abs = (Read(pc++) + y) & 0x00FF;
-	return 0;
-} // end ZPY
-
-
-//=====================================================================|
-/**
- * @brief This is absoulte addressing with the next word (16-bits) 
- *	containing an address to data for the instruction anywhere within the 
- *	allowed range of the 6502.
- */
-u8 CPU6502::ABS()
-{
-	u16 lo = Read(pc++);
-	u16 hi = Read(pc++);
-	addr_abs = (hi << 8) | lo;
-	return 0;
-} // end ABS
-
-
-//=====================================================================|
-/**
- * @brief Like onto the ABS but with offset by the byte value at the X 
- *	register; however, since the addition may cause the system to flip 
- *	pages to the next page, we need to make sure to delay the clock cycle 
- *	accordingly
- */
-u8 CPU6502::ABX()
-{
-	u16 lo = Read(pc++);
-	u16 hi = Read(pc++);
-	addr_abs = ((hi << 8) | lo) + x;
-
-	if ((addr_abs & 0xFF00) != (hi << 8))
-		return 1;		// more clock cycles since page changed
-
-	return 0;
-} // end ABX
-
-
-//=====================================================================|
-/**
- * @brief Same as ABX, and similar to ABS, with its only difference 
- *	being the offset now is at the Y register
- */
-u8 CPU6502::ABY()
-{
-	u16 lo = Read(pc++);
-	u16 hi = Read(pc++);
-	addr_abs = ((hi << 8) | lo) + y;
-
-	if ((addr_abs & 0xFF00) != (hi << 8))
-		return 1;		// more clock cycles since page changed
-
-	return 0;
-} // end ABY
-
-
-//=====================================================================|
-/**
- * @brief These are effectively like pointers in C for the 6502.
- */
-u8 CPU6502::IND()
-{
-	u16 ptr_lo = Read(pc++);
-	u16 ptr_hi = Read(pc++);
-	u16 ptr = (ptr_hi << 8) | ptr_lo;
-
-	// 6502 bug: IND jumps never really go to the next page if the 
-	// hibyte was to change the page during
-	//	+1 operation, instead it wraps around the same page.
-	if (ptr_lo == 0x00FF)
-		addr_abs = ((Read(ptr & 0xFF00) << 8) | Read(ptr));
-	else // is normal
-		addr_abs = ((Read(ptr + 1) << 8) | Read(ptr));
-	return 0;
-} // end IND
-
-
-//=====================================================================|
-/**
- * @brief This is the most complex addressing mode in the 6502, the byte 
- *	at the current program counter references the zero page, this value 
- *	then when offset by the contents of the X register points to the 
- *	16-bit address that actually contains the data.
- */
-u8 CPU6502::IZX()
-{
-	u16 t = Read(pc++);
-	u16 lo = Read((t + x) & 0x00FF);
-	u16 hi = Read((t + x + 1) & 0x00FF);
-	addr_abs = (hi << 8) | lo;
-	return 0;
-} // end IZX
-
-
-//=====================================================================|
-/**
- * @brief Another complex addressing mode, like its counter part IZX the 
- *	pc points at zero page address but unlike IZX the data is reterived by 
- *	first reading the 16-bit address pointed by pc and offsetting that with
- *	the value stored in the Y register
- */
-u8 CPU6502::IZY()
-{
-	u16 t = Read(pc++);
-	u16 lo = Read(t + 0x00FF);
-	u16 hi = Read((t + 1) & 0x00FF);
-	addr_abs = ((hi << 8) | lo) + y;
-	if ((addr_abs & 0xFF00) != (hi << 8))
-		return 1;	// simulate page flipping
-	return 0;
-} // end IZY
-
-
-//=====================================================================|
-/**
- * @brief The relative addressing mode only occurs for branching 
- *	instructions, and it can only happen to a value that
- *	is within -/+127 bytes from the current address at pc.
- */
-u8 CPU6502::REL()
-{
-	addr_rel = Read(pc++);
-	if (addr_rel & 0x80)
-		addr_rel |= 0xFF00;
-	return 0;
-} // end REL
-
-
-//=====================================================================|
-/**
- * @brief a little helper function that is used to fetch a data from 
- *	main memory, according to the addressing mode involved, this makes the 
- *	instructions/opcode excution uniform and easy to deal with at the expense of
- *	a little overhead.
- */
-inline u8 CPU6502::Fetch()
-{
-	if (!(lookup[opcode].Addrmode == &CPU6502::IMP))
-		fetched = Read(addr_abs);		// for all modes except implied
-	return fetched;
-} // end Fetch
-
-
-
-//=====================================================================|
-// OPCODES
-//=====================================================================|
-/**
- * @brief Add With Carry (the complications of 8-bit addition); 
- *	sets Z,V,N,C flags
- */
-u8 CPU6502::ADC()
-{
-	u16 t = (u16)a + (u16)Fetch() + (u16)GET_FLAG(status, C);
-	SET_FLAG(status, C, t > 255);
-	SET_FLAG(status, Z, (t & 0x00FF) == 0x00);
-	SET_FLAG(status, V, (~((u16)a ^ (u16)fetched) & ((u16)a ^ (u16)t)) & 0x0080);
-	SET_FLAG(status, N, t & 0x80);
-	a = t & 0x00FF;
-	return 1;
-} // end ADC
-
-
-//=====================================================================|
-/**
- * @brief Implements the logical AND operation on the accumulator 
- *	register, almost same as x86/x64: AND AL, m8 and sets the Zero and 
- *	Negative flags depending on the result of the operation
- */
-u8 CPU6502::AND()
-{
-	a &= Fetch();
-	SET_FLAG(status, Z, a == 0x00);
-	SET_FLAG(status, N, a &= 0x80);
-	return 1;
-} // end AND
-
-
-//=====================================================================|
-/**
- * @brief Arithemtic Shift Left; sets Z, N, C flags
- */
-u8 CPU6502::ASL()
-{
-	u16 t = (u16)Fetch() << 1;
-	SET_FLAG(status, C, (t & 0xFF00) > 0);
-	SET_FLAG(status, Z, (t & 0x00FF) == 0);
-	SET_FLAG(status, N, t & 0x80);
-
-	if (lookup[opcode].Addrmode == &CPU6502::IMP)
-		a = t & 0x00FF;
-	else
-		Write(addr_abs, t & 0x00FF);
-	return 0;
-} // end ASL
-
-
-//=====================================================================|
-/**
- * @brief Branch if Carry Clear
- */
-u8 CPU6502::BCC()
-{
-	if (!GET_FLAG(status, C))
-	{
-		++cycles;
-		addr_abs = pc + addr_rel;
-		if ((addr_abs & 0xFF00) != (pc & 0xFF00))
-			cycles++;
-		pc = addr_abs;
-	} // end if
-
-	return 0;
-} // end BCC
-
-
-//=====================================================================|
-/**
- * @brief Branch if Carry Set
- */
-u8 CPU6502::BCS()
-{
-	if (GET_FLAG(status, C))
-	{
-		++cycles;
-		addr_abs = pc + addr_rel;
-		if ((addr_abs & 0xFF00) != (pc & 0xFF00))
-			cycles++;
-		pc = addr_abs;
-	} // end if
-
-	return 0;
-} // end BCS
-
-
-//=====================================================================|
-/**
- * @brief Branch if Equal; i.e. Z == 1
- */
-u8 CPU6502::BEQ()
-{
-	if (GET_FLAG(status, Z))
-	{
-		++cycles;
-		addr_abs = pc + addr_rel;
-		if ((addr_abs & 0xFF00) != (pc & 0xFF00))
-			cycles++;
-		pc = addr_abs;
-	} // end if
-
-	return 0;
-} // end BEQ
-
-
-//=====================================================================|
-/**
- * @brief sets N,Z,V flags based on and operation with accumulator register
+ * @brief Excutes one opcode whose addressing mode and operation are known
+ *	at compile time. With both handlers as template arguments the compiler
+ *	can inline the mode straight into the operation, which is the whole
+ *	point of the switch interpreter.
+ *
+ * @param base_cycles the cycle cost from the opcode matrix
  */
-u8 CPU6502::BIT()
+template <CPU6502::Handler Addrmode, CPU6502::Handler Operate>
+inline void CPU6502::Dispatch(const u8 base_cycles)
 {
-	u8 t = a & Fetch();
-	SET_FLAG(status, Z, t == 0);
-	SET_FLAG(status, N, fetched & 0x80);	// only 2 times I'll ever use 'fetched'
-	SET_FLAG(status, V, fetched & 0x40);
-	return 0;
-} // end BIT
+	cycles = base_cycles;
+	u8 add_cycle1 = (this->*Addrmode)();
+	u8 add_cycle2 = (this->*Operate)();
+	cycles += (add_cycle1 & add_cycle2);
+} // end Dispatch
 
 
 //=====================================================================|
 /**
- * @brief Branch if Negative; i.e. N == 1
+ * @brief Reads, decodes and excutes the instruction at pc, leaving the
+ *	number of cycles it costs in cycles. Each case of the switch is its
+ *	own instance of Dispatch.
  */
-u8 CPU6502::BMI()
+inline void CPU6502::Execute()
 {
-	if (GET_FLAG(status, N))
-	{
-		++cycles;
-		addr_abs = pc + addr_rel;
-		if ((addr_abs & 0xFF00) != (pc & 0xFF00))
-			cycles++;
-		pc = addr_abs;
-	} // end if
+	opcode = Read(pc++);
 
-	return 0;
-} // end BMI
-
-
-//=====================================================================|
-/**
- * @brief Branch if Not Equal; i.e. Z == 0
- */
-u8 CPU6502::BNE()
-{
-	if (!GET_FLAG(status, Z))
+	switch (opcode)
 	{
-		++cycles;
-		addr_abs = pc + addr_rel;
-		if ((addr_abs & 0xFF00) != (pc & 0xFF00))
-			cycles++;
-		pc = addr_abs;
-	} // end if
+	#define OPCODE_CASE(opc, name, op, mode, cyc, len) \
+		case opc: Dispatch<&CPU6502::mode, &CPU6502::op<&CPU6502::mode>>(cyc); break;
 
-	return 0;
-} // end BNE
+	CPU6502_OPCODES(OPCODE_CASE)
+	#undef OPCODE_CASE
+	} // end switch
+} // end Execute
 
 
 //=====================================================================|
 /**
- * @brief Branch if PLus (postive); i.e. N == 0
+ * @brief The original way of excuting an instruction; two calls through
+ *	pointers to members taken from a table. Kept as a reference 
+ *	for the switch interpreter and as a yardstick when benchmarking it.
  */
-u8 CPU6502::BPL()
+inline void CPU6502::Execute_Lookup()
 {
-	if (!GET_FLAG(status, N))
-	{
-		++cycles;
-		addr_abs = pc + addr_rel;
-		if ((addr_abs & 0xFF00) != (pc & 0xFF00))
-			cycles++;
-		pc = addr_abs;
-	} // end if
-
-	return 0;
-} // end BPL
+	opcode = Read(pc++);
+	cycles = lookup[opcode].cycles;
+	uint8_t add_cycle1 = (this->*lookup_handlers[opcode][0])();
+	uint8_t add_cycle2 = (this->*lookup_handlers[opcode][1])();
+	cycles += (add_cycle1 & add_cycle2);
+} // end Execute_Lookup
 
 
 //=====================================================================|
 /**
- * @brief Beak; program sourced interrupt, saves the current program 
- *	counter and status flag states; sets B,I flags
+ * @brief Excutes exactly one instruction and charges its whole cycle
+ *	cost at once, instead of waiting it out a Clock() at a time. Any
+ *	cycles still owed by a previous Clock() or an interrupt are retired
+ *	first.
+ *
+ * @return the number of cycles consumed
  */
-u8 CPU6502::BRK()
+u8 CPU6502::Step_Instruction()
 {
-	SET_FLAG(status, I, true);
-	Write(0x0100 + sp--, (++pc >> 8) & 0x00FF); // HO
-	Write(0x0100 + sp--, pc & 0x00FF);	// LO
-
-	SET_FLAG(status, B, true);
-	Write(0x0100 + sp--, status);
-	SET_FLAG(status, B, false);
+	u8 spent = cycles;
+	Execute();
+	spent += cycles;
 
-	pc = Read(0xFFFE) | ((u16)Read(0xFFFF) << 8);
-	return 0;
-} // end BRK
+	cycles = 0;
+	total_cycles += spent;
+	return spent;
+} // end Step_Instruction
 
 
 //=====================================================================|
 /**
- * @brief Branch if Overflow Clear; i.e. V == 0
+ * @brief Runs whole instructions until the running cycle count reaches
+ *	target_cycle. The last instruction may carry us a few cycles past the
+ *	target; since the target is absolute that overshoot is simply taken
+ *	off the next run, so calling this with evenly spaced targets never 
+ *	drifts.
+ *
+ *	A device whose next event moves up while we run can pull the target
+ *	in with Stop_At.
+ *
+ * @param target_cycle the absolute cycle count to run up to
+ *
+ * @return the number of cycles actually run
  */
-u8 CPU6502::BVC()
+u64 CPU6502::Run_Until(const u64 target_cycle)
 {
-	if (!GET_FLAG(status, V))
-	{
-		++cycles;
-		addr_abs = pc + addr_rel;
-		if ((addr_abs & 0xFF00) != (pc & 0xFF00))
-			cycles++;
-		pc = addr_abs;
-	} // end if
-
-	return 0;
-} // end BVC
+	const u64 start = total_cycles;
 
+	// retire whatever Clock() or an interrupt left owing
+	total_cycles += cycles;
+	cycles = 0;
+	run_target = target_cycle;
 
-//=====================================================================|
-/**
- * @brief Branch if Overflow Set; i.e. V == 1
- */
-u8 CPU6502::BVS()
-{
-	if (GET_FLAG(status, V))
+	switch (backend)
 	{
-		++cycles;
-		addr_abs = pc + addr_rel;
-		if ((addr_abs & 0xFF00) != (pc & 0xFF00))
-			cycles++;
-		pc = addr_abs;
-	} // end if
-
-	return 0;
-} // end BVS
-
-
-//=====================================================================|
-/**
- * @brief Clear's the carry bit
- */
-u8 CPU6502::CLC()
-{
-	SET_FLAG(status, C, false);
-	return 0;
-} // end CLC
-
-
-//=====================================================================|
-/**
- * @brief Clear's the interrupt flag
- */
-u8 CPU6502::CLI()
-{
-	SET_FLAG(status, I, false);
-	return 0;
-} // end CLI
-
-
-//=====================================================================|
-/**
- * @brief Clear's the decimal flag, but if the decimal flag was not part of NES console, then why here?
- */
-u8 CPU6502::CLD()
-{
-	SET_FLAG(status, D, false);
-	return 0;
-} // end CLD
+	case Backend::Lookup:
+		while (total_cycles < run_target)
+		{
+			Execute_Lookup();
+			total_cycles += cycles;
+			cycles = 0;
+		} // end while
+		break;
+
+	case Backend::Blocks:
+		Run_Blocks();
+		break;
+
+	case Backend::Jit:
+		Run_Jit();
+		break;
+
+	case Backend::Static:
+		Run_Static();
+		break;
+
+	default:
+		Run_Threaded();
+		break;
+	} // end switch
+
+	run_target = 0;
+	return total_cycles - start;
+} // end Run_Until
 
 
 //=====================================================================|
 /**
- * @brief Clear's the overflow flag
+ * @brief Ends the Run_Until going on by cycle, if it was going to run
+ *	longer; after the instruction running now when cycle has passed. The
+ *	block being walked stops where it is, the way it does for a bank
+ *	switch, so every backend stops at the same instruction. Outside a run
+ *	it does nothing.
+ *
+ * @param cycle the absolute cycle count to stop at
  */
-u8 CPU6502::CLV()
+void CPU6502::Stop_At(const u64 cycle)
 {
-	SET_FLAG(status, V, false);
-	return 0;
-} // CLV
+	if (cycle >= run_target)
+		return;
+
+	run_target = cycle;
+	if (blocks)
+		blocks->Note_Remap();
+} // end Stop_At
 
 
 //=====================================================================|
 /**
- * @brief CoMPare accumulator, sets Z,N,C flags
+ * @brief The hot loop of the switch interpreter. On GCC and Clang each
+ *	handler jumps straight to the next one through a table of label 
+ *	addresses (computed goto), which gives every opcode its own indirect
+ *	branch and so its own slot in the branch predictor. Everywhere else
+ *	it is a plain loop around the switch in Execute().
  */
-u8 CPU6502::CMP()
+void CPU6502::Run_Threaded()
 {
-	u16 t = (u16)a - (u16)Fetch();
-	SET_FLAG(status, C, a >= fetched);
-	SET_FLAG(status, Z, (t & 0x00FF) == 0);
-	SET_FLAG(status, N, t & 0x0080);
-	return 1;
-} // end CMP
+#if NEST_COMPUTED_GOTO
+	#define OPCODE_LABEL(opc, name, op, mode, cyc, len) &&opcode_##opc,
+	static void* const handlers[256] = { CPU6502_OPCODES(OPCODE_LABEL) };
+	#undef OPCODE_LABEL
+
+	#define NEXT_OPCODE() \
+		if (total_cycles >= run_target) \
+			return; \
+		opcode = Read(pc++); \
+		goto *handlers[opcode]
+
+	#define OPCODE_HANDLER(opc, name, op, mode, cyc, len) \
+		opcode_##opc: \
+			Dispatch<&CPU6502::mode, &CPU6502::op<&CPU6502::mode>>(cyc); \
+			total_cycles += cycles; \
+			cycles = 0; \
+			NEXT_OPCODE();
+
+	NEXT_OPCODE();
+	CPU6502_OPCODES(OPCODE_HANDLER)
+
+	#undef OPCODE_HANDLER
+	#undef NEXT_OPCODE
+#else
+	while (total_cycles < run_target)
+	{
+		Execute();
+		total_cycles += cycles;
+		cycles = 0;
+	} // end while
+#endif
+} // end Run_Threaded
 
 
 //=====================================================================|
 /**
- * @brief CoMPare x register, sets Z,N,C flags
+ * @brief Picks the interpreter Run_Until uses. The block cache is only
+ *	built for the Blocks and Jit backends, and thrown away when leaving 
+ *	them since nothing keeps it in step with memory in the meantime. Asking
+ *	for Jit where there is no recompiler gets Blocks.
+ *
+ * @param b the backend to switch to
  */
-u8 CPU6502::CPX()
+void CPU6502::Set_Backend(const Backend b)
 {
-	u16 t = (u16)x - (u16)Fetch();
-	SET_FLAG(status, C, x >= fetched);
-	SET_FLAG(status, Z, (t & 0x00FF) == 0);
-	SET_FLAG(status, N, t & 0x0080);
-	return 0;
-} // end CPX
+	backend = b;
+
+	if (b == Backend::Jit && !jit)
+	{
+		jit = std::make_unique<JitX64>(*this);
+		if (!jit->Is_Available())
+			backend = Backend::Blocks;
+	} // end if
+
+	if (backend != Backend::Jit && jit)
+	{
+		// the blocks still point at the code about to go
+		jit.reset();
+		if (blocks)
+			blocks->Flush();
+	} // end if
+
+	if (backend == Backend::Blocks || backend == Backend::Jit)
+	{
+		if (!blocks)
+			blocks = std::make_unique<BlockCache>();
+	} // end if
+	else
+		blocks.reset();
+} // end Set_Backend
 
 
 //=====================================================================|
-/**
- * @brief CoMPare x register, sets Z,N,C flags
- */
-u8 CPU6502::CPY()
-{
-	u16 t = (u16)y - (u16)Fetch();
-	SET_FLAG(status, C, y >= fetched);
-	SET_FLAG(status, Z, (t & 0x00FF) == 0);
-	SET_FLAG(status, N, t & 0x0080);
-	return 0;
-} // end CPY
+// the backends by name, in the order of Backend
+static const char* const backend_names[] = { "switch", "lookup", "blocks", "jit", "static" };
 
 
 //=====================================================================|
 /**
- * @brief Decrements the byte data at the memory location and set the 
- *	necessary flags for the operation.
+ * @brief The name of backend b
  */
-u8 CPU6502::DEC()
+const char* CPU6502::Backend_Name(const Backend b)
 {
-	u8 t = Fetch() - 1;
-	Write(addr_abs, t);
-	SET_FLAG(status, Z, t == 0x00);
-	SET_FLAG(status, N, t & 0x80);
-	return 0;
-} // end Dec
+	return backend_names[(u8)b];
+} // end Backend_Name
 
 
 //=====================================================================|
 /**
- * @brief Decrements the X register and sets the Zero and Negative flags
+ * @brief Looks up a backend by name
+ *
+ * @param name one of switch, lookup, blocks, jit or static
+ * @param b gets the backend
+ *
+ * @return false when there's none by that name, b left as it was
  */
-u8 CPU6502::DEX()
+bool CPU6502::Find_Backend(const std::string& name, Backend& b)
 {
-	--x;
-	SET_FLAG(status, Z, x == 0);
-	SET_FLAG(status, N, x & 0x80);
-	return 0;
-} // end DEX
+	for (u8 i = 0; i < sizeof(backend_names) / sizeof(backend_names[0]); i++)
+	{
+		if (name == backend_names[i])
+		{
+			b = (Backend)i;
+			return true;
+		} // end if
+	} // end for
+
+	return false;
+} // end Find_Backend
+
 
 //=====================================================================|
 /**
- * @brief Same as DEX but for Y
+ * @brief A superinstruction; two decoded ops that keep turning up next
+ *	to each other run back to back in one handler, saving a dispatch and
+ *	letting the compiler inline both halves together.
+ *
+ * @param cpu the cpu to run on
+ * @param d the first of the two decoded instructions
+ *
+ * @return the number of decoded ops consumed; always 2
  */
-u8 CPU6502::DEY()
+template <Decoded_Fn First, Decoded_Fn Second>
+u8 CPU6502::Run_Fused(CPU6502& cpu, const Decoded_Op& d)
 {
-	--y;
-	SET_FLAG(status, Z, y == 0);
-	SET_FLAG(status, N, y & 0x80);
-	return 0;
-} // end DEY
+	// the first half goes on the clock before the second runs, so an I/O
+	//	access in it sees the right time
+	First(cpu, d);
+	cpu.total_cycles += cpu.cycles;
+	cpu.cycles = 0;
+	Second(cpu, (&d)[1]);
+	return 2;
+} // end Run_Fused
 
 
 //=====================================================================|
 /**
- * @brief Performs exclusive or operation on the accumulator.
+ * @brief Finds the superinstruction for a pair of opcodes; counted loops
+ *	(DEX/BNE and friends), copies (LDA/STA) and compare and branch 
+ *	(CMP/Bxx). The first of a pair must never write to memory, so a write
+ *	that trips the block cache can only come from the second, after which
+ *	the block is left anyway.
+ *
+ * @param first the opcode of the first instruction
+ * @param second the opcode following it
+ *
+ * @return the fused handler or nullptr when the pair has none
  */
-u8 CPU6502::EOR()
+Decoded_Fn CPU6502::Fuse(const u8 first, const u8 second)
 {
-	a ^= Fetch();
-	SET_FLAG(status, Z, a == 0x00);
-	SET_FLAG(status, N, a == 0x80);
-	return 1;
-} // end EOR
+	#define FUSED(opc1, mode1, op1, opc2, mode2, op2) \
+		case (opc1 << 8) | opc2: \
+			return &Run_Fused<DECODED_HANDLER(mode1, op1), DECODED_HANDLER(mode2, op2)>;
+
+	switch ((first << 8) | second)
+	{
+	// counted loops
+	FUSED(0xCA, IMP, DEX, 0xD0, REL, BNE)
+	FUSED(0x88, IMP, DEY, 0xD0, REL, BNE)
+	FUSED(0xE8, IMP, INX, 0xD0, REL, BNE)
+	FUSED(0xC8, IMP, INY, 0xD0, REL, BNE)
+	FUSED(0xE0, IMM, CPX, 0xD0, REL, BNE)
+	FUSED(0xC0, IMM, CPY, 0xD0, REL, BNE)
+
+	// copies
+	FUSED(0xA9, IMM, LDA, 0x85, ZP0, STA)
+	FUSED(0xA9, IMM, LDA, 0x8D, ABS, STA)
+	FUSED(0xA5, ZP0, LDA, 0x85, ZP0, STA)
+	FUSED(0xA5, ZP0, LDA, 0x8D, ABS, STA)
+	FUSED(0xAD, ABS, LDA, 0x85, ZP0, STA)
+	FUSED(0xAD, ABS, LDA, 0x8D, ABS, STA)
+
+	// compare and branch, and the polling loops that test a load
+	FUSED(0xC9, IMM, CMP, 0xF0, REL, BEQ)
+	FUSED(0xC9, IMM, CMP, 0xD0, REL, BNE)
+	FUSED(0xC9, IMM, CMP, 0x90, REL, BCC)
+	FUSED(0xC9, IMM, CMP, 0xB0, REL, BCS)
+	FUSED(0xC5, ZP0, CMP, 0xF0, REL, BEQ)
+	FUSED(0xC5, ZP0, CMP, 0xD0, REL, BNE)
+	FUSED(0xC5, ZP0, CMP, 0x90, REL, BCC)
+	FUSED(0xC5, ZP0, CMP, 0xB0, REL, BCS)
+	FUSED(0xA5, ZP0, LDA, 0xF0, REL, BEQ)
+	FUSED(0xA5, ZP0, LDA, 0xD0, REL, BNE)
+	FUSED(0xAD, ABS, LDA, 0x10, REL, BPL)
+	FUSED(0x2C, ABS, BIT, 0x10, REL, BPL)
+	} // end switch
+
+	#undef FUSED
+	return nullptr;
+} // end Fuse
 
 
 //=====================================================================|
 /**
- * @brief Increments the data stored at memory location by 1 and 
- *	set's the valid flags
+ * @brief Tells whether an opcode is the last one of a basic block; 
+ *	anything that can change pc other than by falling through. 
  */
-u8 CPU6502::INC()
+bool CPU6502::Ends_Block(const u8 opc)
 {
-	u8 t = Fetch() + 1;
-	Write(addr_abs, t);
-	SET_FLAG(status, Z, t == 0x00);
-	SET_FLAG(status, N, t & 0x80);
-	return 0;
-} // end INC
+	switch (opc)
+	{
+	case 0x00:	// BRK
+	case 0x20:	// JSR
+	case 0x40:	// RTI
+	case 0x4C:	// JMP abs
+	case 0x60:	// RTS
+	case 0x6C:	// JMP ind
+		return true;
+	} // end switch
+
+	return lookup[opc].mode == AM_REL;
+} // end Ends_Block
 
 
 //=====================================================================|
 /**
- * @brief Increments the X register by 1 and sets the Z, N flags
+ * @brief Decodes the basic block starting at start into the block cache.
+ *	Decoding stops at the first branch, jump or return, after 
+ *	MAX_BLOCK_OPS instructions, or when the next instruction would start
+ *	in another page. Pairs that have a superinstruction get fused on the
+ *	way out.
+ *
+ * @param start the address of the first instruction
+ *
+ * @return the block, or nullptr when start lies in a page the cache has
+ *	given up on, or code runs out of I/O space
  */
-u8 CPU6502::INX()
+Code_Block* CPU6502::Decode_Block(const u16 start)
 {
-	++x;
-	SET_FLAG(status, Z, x == 0x00);
-	SET_FLAG(status, N, x & 0x80);
-	return 0;
-} // end INX
+	if (!blocks->Is_Cacheable(start >> 8) || !nes->Is_Memory(start >> 8))
+		return nullptr;
+
+	Decoded_Op ops[BlockCache::MAX_BLOCK_OPS];
+	u8 count = 0;
+	u16 addr = start;
+	u16 max_cycles = 0;
+
+	while (count < BlockCache::MAX_BLOCK_OPS)
+	{
+		const u8 opc = nes->Peek(addr);
+		const INSTRUCTION& ins = lookup[opc];
+
+		u16 operand = 0;
+		if (ins.bytes >= 2)
+			operand = nes->Peek(addr + 1);
+		if (ins.bytes == 3)
+			operand |= (u16)nes->Peek(addr + 2) << 8;
+		if (ins.mode == AM_REL && (operand & 0x80))
+			operand |= 0xFF00;
+
+		Decoded_Op& d = ops[count++];
+		d.handler = decoded_handlers[opc];
+		d.operand = operand;
+		d.next_pc = addr + ins.bytes;
+		d.cycles = ins.cycles;
+		d.opcode = opc;
+
+		// a taken branch can cost two more, a page crossing one
+		max_cycles += ins.cycles;
+		if (ins.mode == AM_REL)
+			max_cycles += 2;
+		else if (ins.mode == AM_ABX || ins.mode == AM_ABY || ins.mode == AM_IZY)
+			max_cycles += 1;
+
+		addr = d.next_pc;
+		if (Ends_Block(opc) || (addr & 0xFF00) != (start & 0xFF00))
+			break;
+	} // end while
+
+	// the last operand may hang over into a page reads of which do things,
+	//	or into another bank than the one the block is filed under
+	const u8 last_page = (u16)(addr - 1) >> 8;
+	if (!nes->Is_Memory(last_page) || nes->Bank_Of(last_page) != nes->Bank_Of(start >> 8))
+		return nullptr;
+
+	for (u8 i = 0; i + 1 < count; ++i)
+	{
+		if (Decoded_Fn fused = Fuse(ops[i].opcode, ops[i + 1].opcode))
+			ops[i].handler = fused;
+	} // end for
+
+	Code_Block* blk = blocks->Insert(Block_Key(start), last_page, max_cycles, ops, count);
+
+	// a loop round the whole block has to come back through the handlers
+	//	for Loop_Back to see it, so it is never compiled
+	const Decoded_Op& last = ops[count - 1];
+	const bool loops = lookup[last.opcode].mode == AM_REL ?
+		(u16)(last.next_pc + last.operand) == start : last.opcode == 0x4C && last.operand == start;
+	u16 loop_cycles;
+	if (loops)
+		blk->idle = Classify_Loop(start, addr, loop_cycles) != LOOP_NONE;
+	return blk;
+} // end Decode_Block
 
 
 //=====================================================================|
 /**
- * @brief Increments the Y register by 1 and sets Z, N flags
+ * @brief What a block starting at addr is filed under; the pc alone
+ *	would mix up the banks a mapper switches through the same addresses.
  */
-u8 CPU6502::INY()
+u32 CPU6502::Block_Key(const u16 addr) const
 {
-	++y;
-	SET_FLAG(status, Z, y == 0x00);
-	SET_FLAG(status, N, y & 0x80);
-	return 0;
-} // end INY
+	return ((u32)nes->Bank_Of(addr >> 8) << 16) | addr;
+} // end Block_Key
 
 
 //=====================================================================|
 /**
- * @brief Changes the current pc to the address provided; i.e. 
- *	implement jump instruction
+ * @brief The NES moved something in its page table; the block running
+ *	may have been switched out from under itself.
  */
-u8 CPU6502::JMP()
+void CPU6502::Note_Remap()
 {
-	pc = addr_abs;
-	return 0;
-} // end JMP
+	if (blocks)
+		blocks->Note_Remap();
+} // end Note_Remap
 
 
 //=====================================================================|
 /**
- * @brief Jump to Subroutine -- push the current pc to stack
+ * @brief Walks the handlers of one block. When the whole block fits before
+ *	the target it runs flat out, superinstructions and all. Otherwise it 
+ *	goes one plain handler at a time checking the target after each, so 
+ *	Run_Until stops where it would with the other backends; a fused pair
+ *	could carry us past it. A write that lands on a code page throws the
+ *	running block out from under us, which also ends the walk.
+ *
+ * @param blk the block to run
  */
-u8 CPU6502::JSR()
+inline void CPU6502::Walk_Block(const Code_Block& blk)
 {
-	--pc;
-	Write(0x0100 + sp--, (pc >> 8) & 0x00FF);
-	Write(0x0100 + sp--, pc & 0x00FF);
+	const Decoded_Op* op = blocks->Ops(blk);
+	const Decoded_Op* end = op + blk.count;
+	blocks->Clear_Invalidated();
 
-	pc = addr_abs;
-	return 0;
-} // end JSR
+	if (total_cycles + blk.max_cycles <= run_target)
+	{
+		while (op < end)
+		{
+			op += op->handler(*this, *op);
+			total_cycles += cycles;
+			cycles = 0;
+
+			if (blocks->Was_Invalidated())
+				break;
+		} // end while
+	} // end if it all fits
+	else
+	{
+		for (; op < end; ++op)
+		{
+			decoded_handlers[op->opcode](*this, *op);
+			total_cycles += cycles;
+			cycles = 0;
+
+			if (total_cycles >= run_target || blocks->Was_Invalidated())
+				break;
+		} // end for
+	} // end else
+} // end Walk_Block
 
 
 //=====================================================================|
 /**
- * @brief Loads the accumulator from the value supplied at memory. 
- *	Sets Z,N flags.
+ * @brief The hot loop of the block engine; finds (or decodes) the block at
+ *	pc and walks it.
  */
-u8 CPU6502::LDA()
+void CPU6502::Run_Blocks()
 {
-	a = Fetch();
-	SET_FLAG(status, Z, a == 0x00);
-	SET_FLAG(status, N, a & 0x80);
-	return 1;
-} // end LDA
+	while (total_cycles < run_target)
+	{
+		const Code_Block* blk = blocks->Find(Block_Key(pc));
+		if (!blk)
+			blk = Decode_Block(pc);
+
+		if (!blk)
+		{
+			// an uncacheable page, interpret it
+			Execute();
+			total_cycles += cycles;
+			cycles = 0;
+			continue;
+		} // end if
+
+		Walk_Block(*blk);
+	} // end while
+} // end Run_Blocks
 
 
 //=====================================================================|
 /**
- * @brief Loads the X register, sets N,Z flags
+ * @brief The block engine with a recompiler on top; a block that has run
+ *	HOT_THRESHOLD times gets compiled and from then on runs natively, as
+ *	long as all of it fits before the target. The last few cycles before
+ *	the target are walked op by op like Run_Blocks does, so both stop in
+ *	the same place. A native block bails out on an I/O access, which the
+ *	interpreter then runs.
  */
-u8 CPU6502::LDX()
+void CPU6502::Run_Jit()
 {
-	x = Fetch();
-	SET_FLAG(status, Z, x == 0x00);
-	SET_FLAG(status, N, x & 0x80);
-	return 1;
-} // end LDX
+	while (total_cycles < run_target)
+	{
+		if (jit->Is_Full())
+		{
+			// start over; every block that points into the buffer goes too
+			jit->Reset();
+			blocks->Flush();
+		} // end if
+
+		Code_Block* blk = blocks->Find(Block_Key(pc));
+		if (!blk)
+			blk = Decode_Block(pc);
+
+		if (!blk)
+		{
+			Execute();
+			total_cycles += cycles;
+			cycles = 0;
+			continue;
+		} // end if
+
+		if (!blk->native && !blk->idle && ++blk->hits == JitX64::HOT_THRESHOLD)
+			jit->Compile(*blk, blocks->Ops(*blk));
+
+		if (blk->native && total_cycles + blk->max_cycles <= run_target)
+		{
+			blocks->Clear_Invalidated();
+			if (jit->Run(*blk, run_target) == JitX64::EXIT_BAIL)
+			{
+				Execute();
+				total_cycles += cycles;
+				cycles = 0;
+			} // end if
+		} // end if
+		else
+			Walk_Block(*blk);
+	} // end while
+} // end Run_Jit
 
 
 //=====================================================================|
 /**
- * @brief Loads the Y register, sets N,Z flags
+ * @brief The recompiled programs linked into this build. Each generated
+ *	module adds itself from a static initializer, hence a function local
+ *	static rather than a plain one; no telling which runs first.
  */
-u8 CPU6502::LDY()
+std::vector<const Static_Program*>& CPU6502::Programs()
 {
-	y = Fetch();
-	SET_FLAG(status, Z, y == 0x00);
-	SET_FLAG(status, N, y & 0x80);
-	return 1;
-} // end LDY
+	static std::vector<const Static_Program*> programs;
+	return programs;
+} // end Programs
 
 
 //=====================================================================|
 /**
- * @brief Left shits operand by 1, affects C,Z,N flags.
+ * @brief Makes a recompiled program available to Select_Program; called
+ *	by the modules nest-recomp generates.
+ *
+ * @param prog the program; must outlive every CPU6502 using it
+ *
+ * @return true, so it can initialize a static
  */
-u8 CPU6502::LSR()
+bool CPU6502::Register_Program(const Static_Program& prog)
 {
-	SET_FLAG(status, C, Fetch() & 0x0001);
-	u8 t = fetched >> 1;
-
-	SET_FLAG(status, Z, t == 0);
-	SET_FLAG(status, N, t & 0x0080);
-	if (lookup[opcode].Addrmode == &CPU6502::IMP)
-		a = t & 0x00FF;
-	else
-		Write(addr_abs, t);
-
-	return 0;
-} // end LSR
+	Programs().push_back(&prog);
+	return true;
+} // end Register_Program
 
 
 //=====================================================================|
 /**
- * @brief NOP, no operation, do nothing; however some do nothings 
- *	according to specs at nesdev.wiki, can take more clock cycles depending 
- *	on the opcode.
+ * @brief Picks the recompiled program for the PRG ROM that was just
+ *	loaded, and indexes its blocks by pc for Run_Static. The blocks only
+ *	agree with what is in memory for that ROM, so whoever loads one must
+ *	select again (or clear it with a crc no program has).
+ *
+ * @param crc crc32 of the PRG ROM
+ *
+ * @return true when a program was found for it
  */
-u8 CPU6502::NOP()
+bool CPU6502::Select_Program(const u32 crc)
 {
-	switch (opcode)
+	program = nullptr;
+	program_index.clear();
+
+	for (const Static_Program* prog : Programs())
 	{
-	case 0x1C:
-	case 0x3C:
-	case 0x5C:
-	case 0x7C:
-	case 0xDC:
-	case 0xFC:
-		return 1;
-	} // end switch
+		if (prog->crc != crc)
+			continue;
 
-	return 0;
-} // end NOP
+		program = prog;
+		program_index.assign(0x8000, 0);
+		for (u32 i = 0; i < prog->count; ++i)
+		{
+			if (prog->blocks[i].pc >= 0x8000)
+				program_index[prog->blocks[i].pc - 0x8000] = (u16)(i + 1);
+		} // end for
 
+		return true;
+	} // end for
 
-//=====================================================================|
-/**
- * @brief Performs a logical OR operation on the accumulator register
- */
-u8 CPU6502::ORA()
-{
-	a |= Fetch();
-	SET_FLAG(status, Z, a == 0x00);
-	SET_FLAG(status, N, a == 0x80);
-	return 1;
-} // end ORA
+	return false;
+} // end Select_Program
 
 
 //=====================================================================|
 /**
- * @brief Pushes the accumulator to the stack and updates the stack pointer
+ * @brief Runs the selected recompiled program. A block starts only when
+ *	all of it fits before the target, and ends early should one of its
+ *	stores bring the target in (see NEST_STATIC_OP). Anything else, the
+ *	last few cycles, code in RAM, or a pc the recompiler never found (an
+ *	indirect jump, an RTS trick), goes through the interpreter an
+ *	instruction at a time until pc lands on a block again.
  */
-u8 CPU6502::PHA()
+void CPU6502::Run_Static()
 {
-	Write(0x0100 + sp, a);
-	--sp;
-	return 0;
-} // end PHA
+	if (!program)
+	{
+		Run_Threaded();
+		return;
+	} // end if
+
+	while (total_cycles < run_target)
+	{
+		const u16 index = pc >= 0x8000 ? program_index[pc - 0x8000] : 0;
+		if (index)
+		{
+			const Static_Block& blk = program->blocks[index - 1];
+			if (total_cycles + blk.max_cycles <= run_target)
+			{
+				blk.run(*this);
+				continue;
+			} // end if
+		} // end if
+
+		Execute();
+		total_cycles += cycles;
+		cycles = 0;
+	} // end while
+} // end Run_Static
 
 
 //=====================================================================|
 /**
- * @brief Pushes the flags to the stack; clears B,U flags and updates 
- *	the stack pointer
+ * @brief Runs at least n cycles worth of whole instructions.
+ *
+ * @param n the number of cycles to run
+ *
+ * @return the number of cycles actually run, which can be a few more than
+ *	asked for; use Run_Until for drift free pacing
  */
-u8 CPU6502::PHP()
+u64 CPU6502::Run_Cycles(const u64 n)
 {
-	Write(0x0100 + sp, status | B | U);
-	SET_FLAG(status, B, false);
-	SET_FLAG(status, U, false);
-	--sp;
-	return 0;
-} // end PHP
+	return Run_Until(total_cycles + n);
+} // end Run_Cycles
 
 
 //=====================================================================|
 /**
- * @brief Pulls/pops the accumlator from the stack, updates the stack 
- *	pointer. Sets Z,N flags
+ * @brief Takes n cycles off the CPU while something else has the bus,
+ *	OAM DMA for one. A block running when it happens stops there, as it
+ *	may no longer fit before its target, the same way it does when the
+ *	page table moves.
  */
-u8 CPU6502::PLA()
+void CPU6502::Stall(const u32 n)
 {
-	a = Read(0x0100 + (++sp));
-	SET_FLAG(status, Z, a == 0);
-	SET_FLAG(status, N, a & 0x80);
-	return 0;
-} // end PLA
+	total_cycles += n;
+	if (blocks)
+		blocks->Note_Remap();
+} // end Stall
 
 
 //=====================================================================|
 /**
- * @brief Pops the flags register from the stack, sets U flag (don know why).
+ * @brief Turns idle loop skipping on or off, forgetting the loop it was
+ *	watching either way.
  */
-u8 CPU6502::PLP()
+void CPU6502::Set_Idle_Skip(const bool on)
 {
-	status = Read(0x0100 + (++sp));
-	SET_FLAG(status, U, true);
-	return 0;
-} // end PLP
+	idle_skip = on;
+	loop_start = loop_end = 0;
+	loop_kind = LOOP_NONE;
+} // end Set_Idle_Skip
 
 
 //=====================================================================|
 /**
- * @brief Rotate Left
+ * @brief The ops an idle loop may have besides the branch closing it:
+ *	those that read memory or move registers about and nothing else.
  */
-u8 CPU6502::ROL()
+static bool Is_Read_Only(const u8 opc)
 {
-	u16 t = (u16)((Fetch() << 1) | GET_FLAG(status, C));
-	SET_FLAG(status, C, t & 0xFF00);
-	SET_FLAG(status, Z, (t & 0x00FF) == 0x0000);
-	SET_FLAG(status, N, t & 0x0080);
-	if (lookup[opcode].Addrmode == &CPU6502::IMP)
-		a = t & 0x00FF;
-	else
-		Write(addr_abs, t & 0x00FF);
-	return 0;
-} // end ROL
+	switch (opc)
+	{
+	case 0xA9: case 0xA5: case 0xB5: case 0xAD: case 0xBD: case 0xB9:	// LDA
+	case 0xA2: case 0xA6: case 0xB6: case 0xAE: case 0xBE:				// LDX
+	case 0xA0: case 0xA4: case 0xB4: case 0xAC: case 0xBC:				// LDY
+	case 0x24: case 0x2C:												// BIT
+	case 0xC9: case 0xC5: case 0xD5: case 0xCD: case 0xDD: case 0xD9:	// CMP
+	case 0xE0: case 0xE4: case 0xEC: case 0xC0: case 0xC4: case 0xCC:	// CPX, CPY
+	case 0x29: case 0x25: case 0x35: case 0x2D: case 0x3D: case 0x39:	// AND
+	case 0x09: case 0x05: case 0x15: case 0x0D: case 0x1D: case 0x19:	// ORA
+	case 0x49: case 0x45: case 0x55: case 0x4D: case 0x5D: case 0x59:	// EOR
+	case 0xAA: case 0xA8: case 0x8A: case 0x98:							// TAX, TAY, TXA, TYA
+	case 0x18: case 0x38: case 0xB8: case 0xEA:							// CLC, SEC, CLV, NOP
+		return true;
+	} // end switch
+
+	return false;
+} // end Is_Read_Only
 
 
 //=====================================================================|
 /**
- * @brief Rotate right
+ * @brief Whether the code from start up to end, closed by a branch or a
+ *	JMP back to start, can be an idle loop: straight line, at most 32
+ *	bytes, and reading nothing but memory and PPUSTATUS. Indexed reads
+ *	have to stay in memory whatever the index.
+ *
+ * @param max_cycles set to the most cycles a trip round can take
+ *
+ * @return one of LOOP
  */
-u8 CPU6502::ROR()
+u8 CPU6502::Classify_Loop(const u16 start, const u16 end, u16& max_cycles) const
 {
-	u16 temp = (uint16_t)(GET_FLAG(status, C) << 7) | (Fetch() >> 1);
-	SET_FLAG(status, C, fetched & 0x01);
-	SET_FLAG(status, Z, (temp & 0x00FF) == 0x00);
-	SET_FLAG(status, N, temp & 0x0080);
-	if (lookup[opcode].Addrmode == &CPU6502::IMP)
-		a = temp & 0x00FF;
+	max_cycles = 0;
+	if (end <= start || end - start > 32 || !nes->Is_Memory(start >> 8) ||
+		!nes->Is_Memory((end - 1) >> 8))
+		return LOOP_NONE;
+
+	u8 kind = LOOP_MEMORY;
+	u16 addr = start;
+	while (addr < end)
+	{
+		const u8 opc = nes->Peek(addr);
+		const INSTRUCTION& ins = lookup[opc];
+		const u16 operand = nes->Peek(addr + 1) | ((u16)nes->Peek(addr + 2) << 8);
+		max_cycles += ins.cycles + 2;		// a taken branch, a page crossing
+
+		addr += ins.bytes;
+		if (addr == end)
+			return (ins.mode == AM_REL || opc == 0x4C) ? kind : LOOP_NONE;
+		if (!Is_Read_Only(opc))
+			return LOOP_NONE;
+
+		if (ins.mode == AM_ABS && !nes->Is_Memory(operand >> 8))
+		{
+			if ((operand & 0xE007) != 0x2002)
+				return LOOP_NONE;
+			kind = LOOP_STATUS;
+		} // end if I/O
+		else if ((ins.mode == AM_ABX || ins.mode == AM_ABY) &&
+			(!nes->Is_Memory(operand >> 8) || !nes->Is_Memory((operand >> 8) + 1)))
+			return LOOP_NONE;
+	} // end while
+
+	return LOOP_NONE;
+} // end Classify_Loop
+
+
+//=====================================================================|
+/**
+ * @brief A branch or jump taken back to target, by the instruction that
+ *	ends at end. Coming round the same idle loop with the registers as
+ *	they were last time means the trip round changed nothing, and until
+ *	what it reads changes neither will the next; the ones that would fit
+ *	before then are skipped, leaving the last part trip to run as usual
+ *	so the loop sees the change at the very cycle it would have. Memory
+ *	only changes when the run ends, in an interrupt, and PPUSTATUS when
+ *	the PPU says it will; a change the PPU has since run past, between
+ *	the last trip's read and now, is one the next read has to see, so a
+ *	loop whose coming change isn't the one it was is run round once more.
+ */
+void CPU6502::Loop_Back(const u16 target, const u16 end)
+{
+	u64 now = total_cycles + cycles;
+	const u32 regs = a | ((u32)x << 8) | ((u32)y << 16) | ((u32)Get_Status() << 24);
+
+	// round the same loop, straight from its end last time?
+	if (target == loop_start && end == loop_end &&
+		(loop_kind == LOOP_NONE || now - loop_cycle <= loop_max))
+	{
+		if (loop_kind != LOOP_NONE && regs == loop_regs)
+		{
+			u64 until = run_target;
+			if (loop_kind == LOOP_STATUS)
+			{
+				const u64 change = nes->ppu.Next_Status_Change();
+				until = change == loop_status ? std::min(until, change) : now;
+			} // end if
+
+			const u64 trip = now - loop_cycle;
+			if (until > now && trip)
+			{
+				const u64 skip = (until - now) / trip * trip;
+				if (skip)
+				{
+					total_cycles += skip;
+					now += skip;
+					idle_cycles += skip;
+					++idle_loops;
+				} // end if
+			} // end if
+		} // end if idle
+	} // end if
 	else
-		Write(addr_abs, temp & 0x00FF);
-	return 0;
-} // end ROR
+	{
+		loop_start = target;
+		loop_end = end;
+		loop_kind = Classify_Loop(target, end, loop_max);
+	} // end else a new loop
+
+	loop_cycle = now;
+	loop_regs = regs;
+	if (loop_kind == LOOP_STATUS)
+		loop_status = nes->ppu.Next_Status_Change();
+} // end Loop_Back
 
 
 //=====================================================================|
 /**
- * @brief Return from interrupt
+ * @brief Reset's the CPU and start's it in the default state; 
+ *	i.e. pc = 0xFFFC
  */
-u8 CPU6502::RTI()
+void CPU6502::Reset()
 {
-	status = Read(0x0100 + sp);
-	status &= ~B;
-	status &= ~U;
+	a = x = y = 0;
+	sp = 0xFD;
+	Set_Status(0x0 | U);
+	pc = ((u16)Read(0xFFFD) << 8) | Read(0xFFFC);	// the reset vector
 
-	pc = (uint16_t)Read(0x0100 + sp++);
-	pc |= (uint16_t)Read(0x0100 + sp++) << 8;
-	return 0;
-} // end RTI
+	addr_rel = addr_abs = fetched = 0;
+	cycles = 8;		// take your time
+
+	if (blocks)
+		blocks->Flush();
+} // end Reset
 
 
 //=====================================================================|
 /**
- * @brief Return from subroutine
+ * @brief Handles the software based interrupts; IRQs -- reads the byte 
+ *	stored at address 0xFFFE
  */
-u8 CPU6502::RTS()
+void CPU6502::IRQ()
 {
-	pc = (uint16_t)Read(0x0100 + sp++);
-	pc |= (uint16_t)Read(0x0100 + sp++) << 8;
+	if (!GET_FLAG(status, I))
+	{
+		Write(0x0100 + sp--, (pc >> 8) & 0x00FF);
+		Write(0x0100 + sp--, (pc & 0x00FF));
 
-	pc++;
-	return 0;
-} // end RTS
+		// the flags go on the stack as they were; RTI has to unmask
+		SET_FLAG(status, B, 0);
+		SET_FLAG(status, U, 1);
+		Write(0x0100 + sp--, Get_Status());
+		SET_FLAG(status, I, 1);
+
+		pc = (((u16)Read(0xFFFF) << 8) | ((u16)Read(0xFFFE)));
+		cycles = 7;
+	} // end if
+} // end IRQ
 
 
 //=====================================================================|
 /**
- * @brief Subtract with carray or should I say Borrow? sets Z,V,N,C flags
+ * @brief Handles the non maskable interrupt; same as IRQ except that 
+ *	this cannot be masked and address is at 0xFFFA
  */
-u8 CPU6502::SBC()
+void CPU6502::NMI()
 {
-	u16 t = (u16)a + ((u16)Fetch() ^ 0x00FF) + (u16)GET_FLAG(status, C);
+	Write(0x0100 + sp--, (pc >> 8) & 0x00FF);
+	Write(0x0100 + sp--, (pc & 0x00FF));
+
+	SET_FLAG(status, B, 0);
+	SET_FLAG(status, U, 1);
+	Write(0x0100 + sp--, Get_Status());
+	SET_FLAG(status, I, 1);
+
+	pc = (((u16)Read(0xFFFB) << 8) | ((u16)Read(0xFFFA)));
+	cycles = 8;
+} // end NMI
 
-	SET_FLAG(status, C, t > 255);
-	SET_FLAG(status, Z, (t & 0x00FF) == 0x00);
-	SET_FLAG(status, V, (~((u16)a ^ (u16)fetched) & ((u16)a ^ (u16)t)) & 0x0080);
-	SET_FLAG(status, N, t & 0x80);
-	a = t & 0x00FF;
-	return 1;
-} // end SBC
 
 
+//=====================================================================|
+// ADDRESSING MODES
 //=====================================================================|
 /**
- * @brief Sets the carry flag to on/1
+ * @brief The impled addressing mode, requires no further data to excute 
+ *	the instruction, i.e. the opcode itself imples a given instruction. 
+ *	It could also mean that data is already being operated on the accumulator.
  */
-u8 CPU6502::SEC()
+u8 CPU6502::IMP()
 {
-	SET_FLAG(status, C, true);
+	fetched = a;
 	return 0;
-} // end SEC
+} // end IMM
 
 
 //=====================================================================|
 /**
- * @brief Set's the decimal flag
+ * @brief The immidate mode addressing implies (aint that ironic) the 
+ *	next byte in memory is the data being supplied as part of the instruction.
  */
-u8 CPU6502::SED()
+u8 CPU6502::IMM()
 {
-	SET_FLAG(status, D, true);
+	addr_abs = pc++;
 	return 0;
-} // end SED
+} // end IMM
 
 
 //=====================================================================|
 /**
- * @brief Sets the Interrupt flag
+ * @brief Zero page addressing is a special addressing that puts the data 
+ *	for the instruction somewhere in the first page of the RAM (the first 256 bytes).
  */
-u8 CPU6502::SEI()
+u8 CPU6502::ZP0()
 {
-	SET_FLAG(status, I, true);
+	addr_abs = Read(pc++) & 0x00FF;
 	return 0;
-} // end SEI
+} // end ZP0
 
 
 //=====================================================================|
 /**
- * @brief Store accumulator at address
+ * @brief Zero Page X is like Zero Page, only difference, the value at 
+ *	the program couter is offset by the byte val store in the X register. 
+ *	It's like array's in C.
  */
-u8 CPU6502::STA()
+u8 CPU6502::ZPX()
 {
-	Write(addr_abs, a);
+	addr_abs = (Read(pc++) + x) & 0x00FF;
 	return 0;
-} // end STA
+} // end ZPX
+
 
 //=====================================================================|
 /**
- * @brief Store X register at address
+ * @brief ZPY is the same thing as ZPX but only the offset is the Y register.
  */
-u8 CPU6502::STX()
+u8 CPU6502::ZPY()
 {
-	Write(addr_abs, x);
+	addr_abs = (Read(pc++) + y) & 0x00FF;
 	return 0;
-} // end STX
+} // end ZPY
 
 
 //=====================================================================|
 /**
- * @brief Store register Y at address
+ * @brief This is absoulte addressing with the next word (16-bits) 
+ *	containing an address to data for the instruction anywhere within the 
+ *	allowed range of the 6502.
  */
-u8 CPU6502::STY()
+u8 CPU6502::ABS()
 {
-	Write(addr_abs, y);
+	u16 lo = Read(pc++);
+	u16 hi = Read(pc++);
+	addr_abs = (hi << 8) | lo;
 	return 0;
-} // end STY
+} // end ABS
 
 
 //=====================================================================|
 /**
- * @brief Transfers the accumulator to X register; sets N,Z
+ * @brief Like onto the ABS but with offset by the byte value at the X 
+ *	register; however, since the addition may cause the system to flip 
+ *	pages to the next page, we need to make sure to delay the clock cycle 
+ *	accordingly
  */
-u8 CPU6502::TAX()
+u8 CPU6502::ABX()
 {
-	x = a;
-	SET_FLAG(status, Z, x == 0);
-	SET_FLAG(status, N, x & 0x80);
+	u16 lo = Read(pc++);
+	u16 hi = Read(pc++);
+	addr_abs = ((hi << 8) | lo) + x;
+
+	if ((addr_abs & 0xFF00) != (hi << 8))
+		return 1;		// more clock cycles since page changed
+
 	return 0;
-} // end TAX
+} // end ABX
 
 
 //=====================================================================|
 /**
- * @brief Transfers accumulator to Y register, sets Z,V
+ * @brief Same as ABX, and similar to ABS, with its only difference 
+ *	being the offset now is at the Y register
  */
-u8 CPU6502::TAY()
+u8 CPU6502::ABY()
 {
-	y = a;
-	SET_FLAG(status, Z, y == 0);
-	SET_FLAG(status, N, y & 0x80);
+	u16 lo = Read(pc++);
+	u16 hi = Read(pc++);
+	addr_abs = ((hi << 8) | lo) + y;
+
+	if ((addr_abs & 0xFF00) != (hi << 8))
+		return 1;		// more clock cycles since page changed
+
 	return 0;
-} // end TAY
+} // end ABY
 
 
 //=====================================================================|
 /**
- * @brief Moves the stack pointer to X register; sets Z and N flags
+ * @brief These are effectively like pointers in C for the 6502.
  */
-u8 CPU6502::TSX()
+u8 CPU6502::IND()
 {
-	x = sp;
-	SET_FLAG(status, Z, x == 0);
-	SET_FLAG(status, N, x & 0x80);
+	u16 ptr_lo = Read(pc++);
+	u16 ptr_hi = Read(pc++);
+	u16 ptr = (ptr_hi << 8) | ptr_lo;
+
+	// 6502 bug: IND jumps never really go to the next page if the 
+	// hibyte was to change the page during
+	//	+1 operation, instead it wraps around the same page.
+	if (ptr_lo == 0x00FF)
+		addr_abs = ((Read(ptr & 0xFF00) << 8) | Read(ptr));
+	else // is normal
+		addr_abs = ((Read(ptr + 1) << 8) | Read(ptr));
 	return 0;
-} // end TSX
+} // end IND
 
 
 //=====================================================================|
 /**
- * @brief Transferes X register to accumulator, sets Z,N flags
+ * @brief This is the most complex addressing mode in the 6502, the byte 
+ *	at the current program counter references the zero page, this value 
+ *	then when offset by the contents of the X register points to the 
+ *	16-bit address that actually contains the data.
  */
-u8 CPU6502::TXA()
+u8 CPU6502::IZX()
 {
-	a = x;
-	SET_FLAG(status, Z, a == 0);
-	SET_FLAG(status, N, a & 0x80);
+	u16 t = Read(pc++);
+	u16 lo = Read((t + x) & 0x00FF);
+	u16 hi = Read((t + x + 1) & 0x00FF);
+	addr_abs = (hi << 8) | lo;
 	return 0;
-} // end TXA
+} // end IZX
 
 
 //=====================================================================|
 /**
- * @brief Transfers X register to stack pointer
+ * @brief Another complex addressing mode, like its counter part IZX the 
+ *	pc points at zero page address but unlike IZX the data is reterived by 
+ *	first reading the 16-bit address pointed by pc and offsetting that with
+ *	the value stored in the Y register
  */
-u8 CPU6502::TXS()
+u8 CPU6502::IZY()
 {
-	sp = x;
+	u16 t = Read(pc++);
+	u16 lo = Read(t + 0x00FF);
+	u16 hi = Read((t + 1) & 0x00FF);
+	addr_abs = ((hi << 8) | lo) + y;
+	if ((addr_abs & 0xFF00) != (hi << 8))
+		return 1;	// simulate page flipping
 	return 0;
-} // end sp
+} // end IZY
 
 
 //=====================================================================|
 /**
- * @brief Transfer Y register to accumulator, sets Z,N flags
+ * @brief The relative addressing mode only occurs for branching 
+ *	instructions, and it can only happen to a value that
+ *	is within -/+127 bytes from the current address at pc.
  */
-u8 CPU6502::TYA()
+u8 CPU6502::REL()
 {
-	a = y;
-	SET_FLAG(status, Z, a == 0);
-	SET_FLAG(status, N, a & 0x80);
+	addr_rel = Read(pc++);
+	if (addr_rel & 0x80)
+		addr_rel |= 0xFF00;
 	return 0;
-} // end TYA
+} // end REL
 
 
 //=====================================================================|
 /**
- * @brief The Unkown opcode
+ * @brief The pre-fetched pseudo mode of the block engine; the immediate
+ *	was read into fetched when the block was decoded. Never appears in the
+ *	opcode matrix.
  */
-u8 CPU6502::UNK()
+u8 CPU6502::PRE()
 {
 	return 0;
-} // end UNK
\ No newline at end of file
+} // end PRE
@@ -32,7 +32,22 @@
 
 //=====================================================================|
 #include "basics.hpp"
+#include "cpu6502-opcodes.hpp"
+#include "block-cache.hpp"
+#include "jit-x64.hpp"
 
+#include <memory>
+
+
+// GCC and Clang can thread the interpreter through a table of label 
+//	addresses; MSVC has no such extension and uses a switch instead
+#ifndef NEST_COMPUTED_GOTO
+#if defined(__GNUC__) || defined(__clang__)
+#define NEST_COMPUTED_GOTO 1
+#else
+#define NEST_COMPUTED_GOTO 0
+#endif
+#endif
 
 
 
@@ -49,12 +64,43 @@
 
 // helper macros
 #define SET_FLAG(r8, f, b)	(b ? r8 |= f : r8 &= ~f)
-#define GET_FLAG(r8, f)		((r8 & f) > 0) ? 1 : 0
+#define GET_FLAG(r8, f)		(((r8 & f) > 0) ? 1 : 0)
 
 
 // forward declare
 class NES;
+struct Bus_Page;
 class IV;
+class CPU6502;
+
+
+//=====================================================================|
+// a basic block of a ROM recompiled ahead of time by nest-recomp; runs
+//	every instruction from pc to the end of the block
+typedef void(*Static_Fn)(CPU6502& cpu);
+
+struct Static_Block
+{
+	u16 pc;					// where the block starts
+	u16 max_cycles;			// the most cycles one pass can take
+	Static_Fn run;			// the compiled block
+};
+
+/**
+ * the recompiled code of one ROM, registered by the module nest-recomp
+ *	generated for it; blocks are sorted by pc
+ */
+struct Static_Program
+{
+	u32 crc;					// crc32 of the PRG ROM it was built from
+	const char* name;			// the ROM's file name, for the curious
+	const Static_Block* blocks;
+	u32 count;
+};
+
+// each generated module specializes this for its ROM's crc; CPU6502 
+//	befriends all of them so their blocks can run the op templates
+template <u32 Rom_Crc> struct Recompiled;
 
 
 //=====================================================================|
@@ -62,9 +108,19 @@ class CPU6502
 {
 	friend class NES;
 	friend class IV;
+	friend class JitX64;
+	template <u32 Rom_Crc> friend struct Recompiled;
 
 public:
 
+	// the interpreter cores to choose from; Switch is the templated switch
+	//	(or computed goto) interpreter, Lookup the original dispatch through
+	//	the lookup table, Blocks runs pre-decoded basic blocks, Jit
+	//	compiles the hot ones to x86-64 (Blocks where that is not available)
+	//	and Static runs the ROM's ahead of time recompiled blocks, if one
+	//	was linked in and selected
+	enum class Backend : u8 { Switch, Lookup, Blocks, Jit, Static };
+
 	CPU6502();
 	~CPU6502();
 
@@ -76,68 +132,223 @@ public:
 	void IRQ();
 	void NMI();
 
+	// batched execution; runs whole instructions at a time
+	u8 Step_Instruction();
+	u64 Run_Cycles(const u64 n);
+	u64 Run_Until(const u64 target_cycle);
+	void Stop_At(const u64 cycle);
+	u64 Get_Cycles() const { return total_cycles; }
+	u16 Get_PC() const { return pc; }
+
+	// when the bus access going on now happens, near enough: every backend
+	//	has the cycles before the instruction on the clock by the time it
+	//	touches I/O, and cycles holds the instruction's own
+	u64 Get_Bus_Cycle() const { return total_cycles + cycles; }
+	void Stall(const u32 n);
+
+	// the status register with N, Z, C and V packed back in
+	u8 Get_Status() const
+	{
+		return (status & ~(N | Z | C | V)) | (flag_n & N) | (flag_z ? 0 : Z) |
+			(flag_c ? C : 0) | (flag_v ? V : 0);
+	} // end Get_Status
+
+	void Set_Status(const u8 p)
+	{
+		status = p;
+		flag_n = p;
+		flag_z = ~p & Z;
+		flag_c = p & C;
+		flag_v = p & V;
+	} // end Set_Status
+
+	void Set_Backend(const Backend b);
+	Backend Get_Backend() const { return backend; }
+
+	// the backends by the names the tools take them as: switch, lookup,
+	//	blocks, jit and static
+	static const char* Backend_Name(const Backend b);
+	static bool Find_Backend(const std::string& name, Backend& b);
+
+	// idle loop skipping; on unless a game needs it off. A short loop that
+	//	only reads memory, or PPUSTATUS, and comes round with the registers
+	//	unchanged is spinning until something else happens, so the clock
+	//	jumps to the end of the run or to the next PPUSTATUS change,
+	//	whichever comes first, in whole trips round the loop
+	void Set_Idle_Skip(const bool on);
+	bool Get_Idle_Skip() const { return idle_skip; }
+	u64 Get_Idle_Loops() const { return idle_loops; }		// times skipped
+	u64 Get_Idle_Cycles() const { return idle_cycles; }		// cycles skipped
+
+	// the recompiled programs linked in; Select_Program picks the one for
+	//	the PRG ROM with the given crc
+	static bool Register_Program(const Static_Program& prog);
+	static bool Has_Programs() { return !Programs().empty(); }
+	bool Select_Program(const u32 crc);
+
+	// addressing mode ids, one for each of the 12 addressing mode handlers
+	enum ADDR_MODE : u8
+	{
+		AM_IMP, AM_IMM, AM_ZP0, AM_ZPX, AM_ZPY, AM_REL,
+		AM_ABS, AM_ABX, AM_ABY, AM_IND, AM_IZX, AM_IZY
+	};
+
+	// the hot half of the opcode matrix; two bytes an opcode so that all
+	//	256 of them sit in 8 cache lines
+	struct INSTRUCTION
+	{
+		u8 cycles : 4;	// base cycle count
+		u8 bytes : 4;	// during disassembly
+		u8 mode;		// one of ADDR_MODE
+	};
+
+	#define CPU6502_HOT_ENTRY(opc, name, op, mode, cyc, len) { cyc, len, AM_##mode },
+	static constexpr INSTRUCTION lookup[256] = { CPU6502_OPCODES(CPU6502_HOT_ENTRY) };
+	#undef CPU6502_HOT_ENTRY
+
+	// ... and the cold half, only the disassembler cares for names
+	#define CPU6502_COLD_ENTRY(opc, name, op, mode, cyc, len) name,
+	static constexpr const char* mnemonics[256] = { CPU6502_OPCODES(CPU6502_COLD_ENTRY) };
+	#undef CPU6502_COLD_ENTRY
+
 private:
 
 	// components
 	NES* nes;
+	const Bus_Page* bus;	// the NES page table; memory reads skip the call into NES
 
 	// 6502 registers
 	u8 a;			// the Accumulator
 	u8 x;			// the (x) indeX register
 	u8 y;			// y index register
 	u8 sp;			// the stack pointer
-	u8 status;		// 8-bit status registers
+	u8 status;		// 8-bit status registers; I, D, B and U only, see below
 	u16 pc;			// the program counter/instruction pointer
 
+	// N, Z, C and V live outside status as the values they were last set
+	//	from, so an op stores a byte instead of twiddling bits; they are only
+	//	packed into a status byte when it is pushed or looked at
+	u8 flag_n;		// N is bit 7 of this
+	u8 flag_z;		// Z is set when this is 0
+	u8 flag_c;		// C, 0 or 1
+	u8 flag_v;		// V is set when this is non zero
+
 	// helpers
 	u16 addr_abs;	// used with absoulte addressing mode
 	u16 addr_rel;	// used with relative addressing mode
 	u8 fetched;		// store's the next instruction fetched
 	u8 opcode;		// stores the next opcode
 	u8 cycles;		// the number of cycles for the instruction fetched
+	u64 total_cycles;	// running count of cycles since power up
+	Backend backend;	// which interpreter Run_Until uses
+	std::unique_ptr<BlockCache> blocks;		// only there for Backend::Blocks and Jit
+	std::unique_ptr<JitX64> jit;			// only there for Backend::Jit
+	const Static_Program* program;			// the selected recompiled program
+	std::vector<u16> program_index;			// block number + 1 by pc - 0x8000
+	u64 run_target;			// the target of the Run_Until going on, 0 outside one
+
+	// the loop last branched round, and how it was when it got back to its
+	//	start; what the loop reads decides what can end the spin
+	static constexpr u8 LOOP_NONE = 0;		// not an idle loop
+	static constexpr u8 LOOP_MEMORY = 1;	// reads RAM or ROM only
+	static constexpr u8 LOOP_STATUS = 2;	// polls PPUSTATUS as well
+	bool idle_skip;
+	u8 loop_kind;
+	u16 loop_start, loop_end;	// the first byte, and the one after the branch
+	u16 loop_max;				// the most cycles one trip round can take
+	u32 loop_regs;				// a, x, y and the status, packed
+	u64 loop_cycle;				// when it last got back to the start
+	u64 loop_status;			// the PPUSTATUS change it had coming then
+	u64 idle_loops, idle_cycles;
 
 
 	void Write(u16 addr, u8 data);
 	uint8_t Read(u16 addr);
 
 
+	// signature shared by the addressing modes and the operations
+	using Handler = u8(CPU6502::*)(void);
+
 	// the 12 addressing modes for a 6502 CPU
 	u8 IMP(); u8 IMM(); u8 ZP0(); u8 ZPX();
 	u8 ZPY(); u8 REL(); u8 ABS(); u8 ABX();
 	u8 ABY(); u8 IND(); u8 IZX(); u8 IZY();
 
-	// the 56 legal opcodes (the documented ones)
-	u8 ADC();	u8 AND();	u8 ASL();	u8 BCC();
-	u8 BCS();	u8 BEQ();	u8 BIT();	u8 BMI();
-	u8 BNE();	u8 BPL();	u8 BRK();	u8 BVC();
-	u8 BVS();	u8 CLC();	u8 CLD();	u8 CLI();
-	u8 CLV();	u8 CMP();	u8 CPX();	u8 CPY();
-	u8 DEC();	u8 DEX();	u8 DEY();	u8 EOR();
-	u8 INC();	u8 INX();	u8 INY();	u8 JMP();
-	u8 JSR();	u8 LDA();	u8 LDX();	u8 LDY();
-	u8 LSR();	u8 NOP();	u8 ORA();	u8 PHA();
-	u8 PHP();	u8 PLA();	u8 PLP();	u8 ROL();
-	u8 ROR();	u8 RTI();	u8 RTS();	u8 SBC();
-	u8 SEC();	u8 SED();	u8 SEI();	u8 STA();
-	u8 STX();	u8 STY();	u8 TAX();	u8 TAY();
-	u8 TSX();	u8 TXA();	u8 TXS();	u8 TYA();
+	// not a 6502 mode; marks an operand the block decoder has already 
+	//	read into fetched, so that Fetch() has nothing left to do
+	u8 PRE();
+
+	// the 56 legal opcodes (the documented ones); each is a template over
+	//	the addressing mode it is paired with in the opcode matrix
+	template <Handler Mode> u8 ADC();	template <Handler Mode> u8 AND();
+	template <Handler Mode> u8 ASL();	template <Handler Mode> u8 BCC();
+	template <Handler Mode> u8 BCS();	template <Handler Mode> u8 BEQ();
+	template <Handler Mode> u8 BIT();	template <Handler Mode> u8 BMI();
+	template <Handler Mode> u8 BNE();	template <Handler Mode> u8 BPL();
+	template <Handler Mode> u8 BRK();	template <Handler Mode> u8 BVC();
+	template <Handler Mode> u8 BVS();	template <Handler Mode> u8 CLC();
+	template <Handler Mode> u8 CLD();	template <Handler Mode> u8 CLI();
+	template <Handler Mode> u8 CLV();	template <Handler Mode> u8 CMP();
+	template <Handler Mode> u8 CPX();	template <Handler Mode> u8 CPY();
+	template <Handler Mode> u8 DEC();	template <Handler Mode> u8 DEX();
+	template <Handler Mode> u8 DEY();	template <Handler Mode> u8 EOR();
+	template <Handler Mode> u8 INC();	template <Handler Mode> u8 INX();
+	template <Handler Mode> u8 INY();	template <Handler Mode> u8 JMP();
+	template <Handler Mode> u8 JSR();	template <Handler Mode> u8 LDA();
+	template <Handler Mode> u8 LDX();	template <Handler Mode> u8 LDY();
+	template <Handler Mode> u8 LSR();	template <Handler Mode> u8 NOP();
+	template <Handler Mode> u8 ORA();	template <Handler Mode> u8 PHA();
+	template <Handler Mode> u8 PHP();	template <Handler Mode> u8 PLA();
+	template <Handler Mode> u8 PLP();	template <Handler Mode> u8 ROL();
+	template <Handler Mode> u8 ROR();	template <Handler Mode> u8 RTI();
+	template <Handler Mode> u8 RTS();	template <Handler Mode> u8 SBC();
+	template <Handler Mode> u8 SEC();	template <Handler Mode> u8 SED();
+	template <Handler Mode> u8 SEI();	template <Handler Mode> u8 STA();
+	template <Handler Mode> u8 STX();	template <Handler Mode> u8 STY();
+	template <Handler Mode> u8 TAX();	template <Handler Mode> u8 TAY();
+	template <Handler Mode> u8 TSX();	template <Handler Mode> u8 TXA();
+	template <Handler Mode> u8 TXS();	template <Handler Mode> u8 TYA();
 
 	// I'll capture all "unofficial" opcodes with this function. It is
 	// functionally identical to a NOP
-	u8 UNK();
+	template <Handler Mode> u8 UNK();
 
 	// utilities
-	inline u8 Fetch();
+	template <Handler Mode> inline u8 Fetch();
+	inline void Take_Branch();
+	void Loop_Back(const u16 target, const u16 end);
+	u8 Classify_Loop(const u16 start, const u16 end, u16& max_cycles) const;
+	void Set_NZ(const u8 result) { flag_n = flag_z = result; }
+	template <Handler Addrmode, Handler Operate>
+	inline void Dispatch(const u8 base_cycles);
+	inline void Execute();
+	inline void Execute_Lookup();
+	void Run_Threaded();
 
-	// a lookup table
-	struct INSTRUCTION
-	{
-		std::string name;		// opcode name
-		u8(CPU6502::* Operate)(void) = nullptr;
-		u8(CPU6502::* Addrmode)(void) = nullptr;
-		u8 cycles{ 0 };
-		u8 bytes{ 0 };	// during disassembly
-	};
+	// the basic block engine; an operation runs with the same mode as in 
+	//	the opcode matrix, except that immediates are read at decode time
+	static constexpr Handler Decoded_Mode(const Handler m) 
+		{ return m == &CPU6502::IMM ? &CPU6502::PRE : m; }
+	template <u8 Mode_Id, Handler Mode, Handler Operate>
+	static u8 Run_Decoded(CPU6502& cpu, const Decoded_Op& d);
+	template <Decoded_Fn First, Decoded_Fn Second>
+	static u8 Run_Fused(CPU6502& cpu, const Decoded_Op& d);
+	static Decoded_Fn Fuse(const u8 first, const u8 second);
+	static bool Ends_Block(const u8 opc);
+	u32 Block_Key(const u16 addr) const;
+	void Note_Remap();
+	Code_Block* Decode_Block(const u16 start);
+	inline void Walk_Block(const Code_Block& blk);
+	void Run_Blocks();
+	void Run_Jit();
+
+	// the ahead of time recompiled blocks
+	static std::vector<const Static_Program*>& Programs();
+	void Run_Static();
+
+	// the addressing mode and operation handlers for the Lookup interpreter
+	static const Handler lookup_handlers[256][2];
 
-	std::vector<INSTRUCTION> lookup;
+	// one pre-decoded handler per opcode for the block engine
+	static const Decoded_Fn decoded_handlers[256];
 };
\ No newline at end of file
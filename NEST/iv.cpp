@@ -45,8 +45,6 @@ const std::string ADDR_ABY{ "; ABY" };
 const std::string ADDR_IND{ "; IND" };
 const std::string ADDR_REL{ "; REL" };
 
-using TM = TextureManager;
-
 // helpers
 std::string hex8(uint8_t v) 
 {
@@ -68,10 +66,11 @@ std::string hex16(uint16_t v)
 /**
  * @brief constructor
  * 
- * @param pc pointer to NES CPU the 6502
+ * @param nes the console it looks into
+ * @param tm holds the textures it draws with
  */
-IV::IV(NES* nes)
-	: prend(nullptr), pnes(nes),
+IV::IV(NES* nes, TextureManager* tm)
+	: prend(nullptr), pnes(nes), ptm(tm), state(nullptr),
 	hex_texture_id(0), status_texture_id(0), flags_texture_id(0),
 	registers_texture_id(0),
 	ram_texture_id(0), dollar$_texture_id(0), pound_texture_id(0),
@@ -90,6 +89,7 @@ IV::IV(NES* nes)
 void IV::Init(SDL_Renderer* pr)
 {
 	prend = pr;
+	pnes->Track_Writes(true);
 
 	// create the textures and all
 	Create_Numeric_Textures();
@@ -100,7 +100,7 @@ void IV::Init(SDL_Renderer* pr)
 
 	// get a glyph info, since monospaced, all texts are
 	//	same size, coolio!
-	glyph_info = TM::Instance()->Get_Texture_Info(hex_texture_id);
+	glyph_info = ptm->Get_Texture_Info(hex_texture_id);
 
 	Create_Ram_Texture();
 	Create_Disasm_Texture();
@@ -109,13 +109,13 @@ void IV::Init(SDL_Renderer* pr)
 	
 	// draw dollar$ to cpu registers surface, for each A X Y SP PC
 	SDL_SetRenderTarget(prend,
-		TM::Instance()->Get_Texture_Info(registers_texture_id).ptexture);
+		ptm->Get_Texture_Info(registers_texture_id).ptexture);
 	int x = glyph_info.w * 2; 
 	int y = 0;
 
 	for (int i = 0; i < 5; i++)
 	{
-		TM::Instance()->Draw(dollar$_texture_id, prend, x, y);
+		ptm->Draw(dollar$_texture_id, prend, x, y);
 		if (i < 2)
 			x += glyph_info.w * 7;
 		else
@@ -142,19 +142,23 @@ void IV::Draw_CPU()
  */
 void IV::Draw_RAM()
 {
-	const static int ram_start_y = 490;
-	const static int ram_start_x = 10;
-	static u16 old_addr = start_addr;
+	constexpr int ram_start_y = 490;
+	constexpr int ram_start_x = 10;
+
+	// the written bits only cover the frame since the snapshot before; with
+	//	one dropped in between, what it wrote is only in the memory
+	const bool missed = !state->Follows(old_sequence);
+	old_sequence = state->sequence;
 
 	// set rendering context to ram texture
-	SDL_SetRenderTarget(prend, TM::Instance()->Get_Texture_Info(ram_texture_id).ptexture);
-	if (first_draw || old_addr != start_addr)
+	SDL_SetRenderTarget(prend, ptm->Get_Texture_Info(ram_texture_id).ptexture);
+	if (first_draw || missed || old_addr != start_addr)
 	{
 		int x = 0, y = 0;
-		if (old_addr + 16 == start_addr)
+		if (!missed && old_addr + 16 == start_addr)
 		{
 			// scroll down
-			TM::Instance()->Scroll_Texture_Down(x, glyph_info.h * 2,
+			ptm->Scroll_Texture_Down(x, glyph_info.h * 2,
 				glyph_info.h, ram_texture_id, prend);
 
 			// draw the last line
@@ -163,19 +167,19 @@ void IV::Draw_RAM()
 
 			// the address label
 			Draw_Hex16(start, x, y, 1);
-			TM::Instance()->Draw(colon_texture_id, prend, x, y);
+			ptm->Draw(colon_texture_id, prend, x, y);
 			
 			x += (glyph_info.w << 1);
 			for (int i = 0; i < 16; i++)
 			{
-				Draw_Hex8(pnes->ram[start + i], x, y);
+				Draw_Hex8(state->Peek(start + i), x, y);
 				x += glyph_info.w;
 			} // end for draw line
 		} // end if scrolling down
-		else if (start_addr == old_addr - 16)
+		else if (!missed && start_addr == old_addr - 16)
 		{
 			// scroll up
-			TM::Instance()->Scroll_Texture_Up(x, glyph_info.h, glyph_info.h,
+			ptm->Scroll_Texture_Up(x, glyph_info.h, glyph_info.h,
 				ram_texture_id, prend);
 
 			// draw the first line
@@ -183,20 +187,20 @@ void IV::Draw_RAM()
 
 			// the address label
 			Draw_Hex16(start_addr, x, y, 1);
-			TM::Instance()->Draw(colon_texture_id, prend, x, y);
+			ptm->Draw(colon_texture_id, prend, x, y);
 
 			x += (glyph_info.w << 1);
 			for (int i = 0; i < 16; i++)
 			{
-				Draw_Hex8(pnes->ram[start_addr + i], x, y);
+				Draw_Hex8(state->Peek(start_addr + i), x, y);
 				x += glyph_info.w;
 			} // end for draw line
 		} // end else if scrolling up
 		else
 		{
 			// draw everything regardless
-			int w = TM::Instance()->Get_Texture_Info(hex_texture_id).w;
-			int h = TM::Instance()->Get_Texture_Info(hex_texture_id).h;
+			int w = ptm->Get_Texture_Info(hex_texture_id).w;
+			int h = ptm->Get_Texture_Info(hex_texture_id).h;
 
 			y += h;
 			for (u16 row = 0; row < 16; row++)
@@ -204,13 +208,13 @@ void IV::Draw_RAM()
 				u16 addr = start_addr + (row << 4);
 
 				Draw_Hex16(addr, x, y, 1);
-				TM::Instance()->Draw(colon_texture_id, prend, x, y);
-				x += TM::Instance()->Get_Texture_Info(colon_texture_id).w + (w);
+				ptm->Draw(colon_texture_id, prend, x, y);
+				x += ptm->Get_Texture_Info(colon_texture_id).w + (w);
 
 				// hit columns
 				for (u16 col = 0; col < 16; col++)
 				{
-					Draw_Hex8(pnes->Read(col + addr), x, y);
+					Draw_Hex8(state->Peek(col + addr), x, y);
 					x += w;
 				} // end for
 
@@ -223,9 +227,8 @@ void IV::Draw_RAM()
 	} // end if needs to draw
 
 	// draw written address only if it falls within range
-	while (!pnes->addr_written.empty())
+	state->Drain_Written([this](const u16 a)
 	{
-		u16 a = pnes->addr_written.back();
 		if (a >= start_addr && a < start_addr + 256)
 		{
 			// compute the position based on address
@@ -233,15 +236,13 @@ void IV::Draw_RAM()
 			int y = ((diff / 16) + 1) * glyph_info.h;
 
 			int x = (diff % 16) * (glyph_info.w * 3) + (6 * glyph_info.w);
-			Draw_Hex8(pnes->Read(a), x, y);
+			Draw_Hex8(state->Peek(a), x, y);
 		} // end if drawing em
-
-		pnes->addr_written.pop_back();
-	} // end while
+	});
 
 	// finally  draw to main default texture
 	SDL_SetRenderTarget(prend, nullptr);
-	TM::Instance()->Draw(ram_texture_id, prend, ram_start_x, ram_start_y);
+	ptm->Draw(ram_texture_id, prend, ram_start_x, ram_start_y);
 } // end Draw_RAM
 
 //=====================================================================|
@@ -252,29 +253,27 @@ void IV::Draw_RAM()
  */ 
 void IV::Draw_Disasm()
 {
-	const static int dis_start_x = GAME_WIDTH + 10;
-	const static int dis_start_y = (glyph_info.h + 15) * 2;
-	const static int TOP_LINES = 10;	// 10 above, 10 below, PC middle
-	const static int BOT_LINES = 10;
+	constexpr int dis_start_x = GAME_WIDTH + 10;
+	constexpr int TOP_LINES = 10;	// 10 above, 10 below, PC middle
+	constexpr int BOT_LINES = 10;
+	const int dis_start_y = (glyph_info.h + 15) * 2;
 
-	static TextureInfo dasm_texture = TM::Instance()->Get_Texture_Info(
-		disasm_texture_id);
-	static u16 old_pc = pnes->cpu.pc;
+	const TextureInfo dasm_texture = ptm->Get_Texture_Info(disasm_texture_id);
 
-	if (first_draw || old_pc != pnes->cpu.pc)
+	if (first_draw || old_pc != state->pc)
 	{
 		SDL_SetRenderTarget(prend, dasm_texture.ptexture);
 
 		int x = 0;
 		int y = 0;
 
-		auto start = disasm_addr.find(pnes->cpu.pc);
+		auto start = disasm_addr.find(state->pc);
 		if (start != disasm_addr.end())
 		{
 			// test if we simply scroll or redraw the entire deal
-			if (old_pc + 1 <= pnes->cpu.pc && old_pc + 3 >= pnes->cpu.pc)
+			if (!first_draw && old_pc + 1 <= state->pc && old_pc + 3 >= state->pc)
 			{
-				TM::Instance()->Scroll_Texture_Down(0, glyph_info.h, glyph_info.h,
+				ptm->Scroll_Texture_Down(0, glyph_info.h, glyph_info.h,
 					disasm_texture_id, prend);
 
 				// draw the last line
@@ -317,11 +316,12 @@ void IV::Draw_Disasm()
 			} // end else redraw all
 		} // if found the address
 
+		old_pc = state->pc;
 		SDL_SetRenderTarget(prend, nullptr);
 	} // end if need to draw
 
 	// draw it
-	TM::Instance()->Draw(disasm_texture_id, prend, dis_start_x, dis_start_y);
+	ptm->Draw(disasm_texture_id, prend, dis_start_x, dis_start_y);
 
 	// highlight the pc
 	SDL_Rect hl = { dis_start_x, dis_start_y + glyph_info.h * 10, 
@@ -350,7 +350,7 @@ void IV::Create_Numeric_Textures()
 	const static std::string hex_digits[]{ "0", "1", "2", "3", "4", "5", 
 		"6", "7", "8", "9", "A", "B", "C", "D", "E", "F" };
 
-	hex_texture_id = TextureManager::Instance()->Get_Next_ID();
+	hex_texture_id = ptm->Get_Next_ID();
 	int count = 0;
 	SDL_Color color[] = { text_color, label_color, off_color };
 	
@@ -358,7 +358,7 @@ void IV::Create_Numeric_Textures()
 	{
 		for (auto& hex : hex_digits)
 		{
-			TextureManager::Instance()->Create_Text_Texture(
+			ptm->Create_Text_Texture(
 				hex, color[count], prend);
 		} // end for
 
@@ -380,18 +380,18 @@ void IV::Create_Cpu_Flags_Texture()
 	//	"I", "Z", "C" };
 	const static std::string flags{ "N  V  U  B  D  I  Z  C" };
 
-	status_texture_id = TM::Instance()->Get_Next_ID();
-	TM::Instance()->Create_Text_Texture(flags, off_color, prend);
+	status_texture_id = ptm->Get_Next_ID();
+	ptm->Create_Text_Texture(flags, off_color, prend);
 
 	// now hit the template
-	flags_texture_id = TM::Instance()->Get_Next_ID();
+	flags_texture_id = ptm->Get_Next_ID();
 	for (int i = 0; i < flags.length(); i+=3)
 	{
 		std::string flag{ flags[i] };
-		TM::Instance()->
+		ptm->
 			Create_Text_Texture(flag, off_color, prend);
 
-		TM::Instance()->
+		ptm->
 			Create_Text_Texture(flag, on_color, prend);
 	} // end for
 } // end Make_Cpu_Flags_Texture
@@ -404,7 +404,7 @@ void IV::Create_Cpu_Flags_Texture()
 void IV::Create_Cpu_Registers_Textures()
 {
 	const static std::string registers{ "A:     X:     Y:     SP:     PC:     " };
-	registers_texture_id = TM::Instance()->Create_Text_Texture(registers, 
+	registers_texture_id = ptm->Create_Text_Texture(registers, 
 		register_color, prend);
 } // end Make_Cpu_Flags_Texture
 
@@ -419,11 +419,11 @@ void IV::Create_Ram_Texture()
 	const int ram_height = glyph_info.h * 17;
 
 	// create a texture
-	ram_texture_id = TM::Instance()->Create_Texture(ram_width, ram_height,
+	ram_texture_id = ptm->Create_Texture(ram_width, ram_height,
 		prend, SDL_TEXTUREACCESS_TARGET);
 
 	// draw some static stuff to it, the header
-	SDL_SetRenderTarget(prend, TM::Instance()->Get_Texture_Info(ram_texture_id).ptexture);
+	SDL_SetRenderTarget(prend, ptm->Get_Texture_Info(ram_texture_id).ptexture);
 	int x = glyph_info.w * 6;
 	int y = 0;
 	
@@ -444,30 +444,30 @@ void IV::Create_Ram_Texture()
  */
 void IV::Create_Symbol_Textures()
 {
-	dollar$_texture_id = TM::Instance()->Create_Text_Texture(
+	dollar$_texture_id = ptm->Create_Text_Texture(
 		"$", text_color, prend);
-	pound_texture_id = TM::Instance()->Create_Text_Texture(
+	pound_texture_id = ptm->Create_Text_Texture(
 		"#", text_color, prend);
-	colon_texture_id = TM::Instance()->Create_Text_Texture(
+	colon_texture_id = ptm->Create_Text_Texture(
 		":", label_color, prend);
-	comma_texture_id = TM::Instance()->Create_Text_Texture(
+	comma_texture_id = ptm->Create_Text_Texture(
 		",", text_color, prend);
 
 	// do the braket pair
-	bracket_texture_id = TM::Instance()->Create_Text_Texture(
+	bracket_texture_id = ptm->Create_Text_Texture(
 		"(", text_color, prend);
-	TM::Instance()->Create_Text_Texture(
+	ptm->Create_Text_Texture(
 		")", text_color, prend);	// +1
 
 	// and square version
-	squareb_texture_id = TM::Instance()->Create_Text_Texture(
+	squareb_texture_id = ptm->Create_Text_Texture(
 		"[", text_color, prend);
-	TM::Instance()->Create_Text_Texture(
+	ptm->Create_Text_Texture(
 		"]", text_color, prend);	// +1
 
-	a_texture_id = TM::Instance()->Create_Text_Texture("A", text_color, prend);
-	x_texture_id = TM::Instance()->Create_Text_Texture("X", text_color, prend);
-	y_texture_id = TM::Instance()->Create_Text_Texture("Y", text_color, prend);
+	a_texture_id = ptm->Create_Text_Texture("A", text_color, prend);
+	x_texture_id = ptm->Create_Text_Texture("X", text_color, prend);
+	y_texture_id = ptm->Create_Text_Texture("Y", text_color, prend);
 } // end Create_Glpyh_Table_Textures
 
 //=====================================================================|
@@ -477,10 +477,10 @@ void IV::Create_Symbol_Textures()
  */
 void IV::Create_Disasm_Texture()
 {
-	const static int dasm_width = glyph_info.w * 36;
-	const static int dasm_height = glyph_info.h * 21;	// 21-lines
+	const int dasm_width = glyph_info.w * 36;
+	const int dasm_height = glyph_info.h * 21;	// 21-lines
 
-	disasm_texture_id = TM::Instance()->Create_Texture(dasm_width, dasm_height,
+	disasm_texture_id = ptm->Create_Texture(dasm_width, dasm_height,
 		prend, SDL_TEXTUREACCESS_TARGET);
 
 	// now create all textures for mneuonics
@@ -489,7 +489,7 @@ void IV::Create_Disasm_Texture()
 	{
 		if (seen[m.second.mnemonic]++ < 1)
 		{
-			TM::Instance()->Create_Mneumonic_Texture(m.second.mnemonic,
+			ptm->Create_Mneumonic_Texture(m.second.mnemonic,
 				mnemonic_color, prend);
 		}
 	} // end for 
@@ -501,7 +501,7 @@ void IV::Create_Disasm_Texture()
 		ADDR_ABY, ADDR_IND, ADDR_REL };
 	for (auto& s : addr_modes)
 	{
-		TM::Instance()->Create_Mneumonic_Texture(s,
+		ptm->Create_Mneumonic_Texture(s,
 			addr_mode_color, prend);
 	} // end for
 } // end Create_Disasm_Texture
@@ -514,42 +514,41 @@ void IV::Create_Disasm_Texture()
  */
 void IV::Draw_CPU_Flags()
 {
-	const static int flag_x = GAME_WIDTH + 147;		// x starting point
-	const static int flag_y = 10;					// y starting point
-	const static int flag_x_gap = 15;				// gap between flags
-
-	const static u8 status = pnes->cpu.status;		// keep a copy of the old status states
-	const static TextureInfo status_texture = TM::Instance()->Get_Texture_Info(status_texture_id);
+	constexpr int flag_x = GAME_WIDTH + 147;		// x starting point
+	constexpr int flag_y = 10;					// y starting point
+	constexpr int flag_x_gap = 15;				// gap between flags
 
 	// helper to make loops easy
-	const static u8 registers[]{ N, V, U, B, D, I, Z, C };
-	SDL_SetRenderTarget(prend, status_texture.ptexture);
+	static const u8 registers[]{ N, V, U, B, D, I, Z, C };
+	SDL_SetRenderTarget(prend, ptm->Get_Texture_Info(status_texture_id).ptexture);
 
 	// check if we need to update anything
-	if (status != pnes->cpu.status)
+	if (first_draw || shadow_status != state->status)
 	{
 		int x = 0;
 		int y = 0;
 
 		// alright redraw only the difference
-		u8 s = pnes->cpu.status;	// shorten
+		u8 s = state->status;	// shorten
 		for (int i = 0; i < 8; i++)
 		{
 			u8 fv = GET_FLAG(s, registers[i]);
-			if (fv != GET_FLAG(status, registers[i]))
+			if (first_draw || fv != GET_FLAG(shadow_status, registers[i]))
 			{
 				if (fv)
-					TM::Instance()->Draw(flags_texture_id + (i << 1) + 1, prend, x, y);
+					ptm->Draw(flags_texture_id + (i << 1) + 1, prend, x, y);
 				else
-					TM::Instance()->Draw(flags_texture_id + (i << 1), prend, x, y);
+					ptm->Draw(flags_texture_id + (i << 1), prend, x, y);
 			} // end if
 
 			x += glyph_info.w * 3;
 		} // end for
+
+		shadow_status = s;
 	} // end if difference
 
 	SDL_SetRenderTarget(prend, nullptr);
-	TM::Instance()->Draw(status_texture_id, prend, flag_x, flag_y);
+	ptm->Draw(status_texture_id, prend, flag_x, flag_y);
 } // end draw_flags
 
 //=====================================================================|
@@ -560,17 +559,13 @@ void IV::Draw_CPU_Flags()
  */
 void IV::Draw_Registers()
 {
-	const static int register_x = GAME_WIDTH + 10;
-	const static int register_y = glyph_info.h + 15;
-
-	// make local copy, and draw only on change
-	static u8 shadows[]{ pnes->cpu.a, pnes->cpu.x, pnes->cpu.y, pnes->cpu.sp };
-	static u16 shadow_pc = pnes->cpu.pc;
+	constexpr int register_x = GAME_WIDTH + 10;
+	const int register_y = glyph_info.h + 15;
 
 	// flatten registers into array for easy access
-	u8 registers[]{ pnes->cpu.a, pnes->cpu.x, pnes->cpu.y, pnes->cpu.sp };
+	u8 registers[]{ state->a, state->x, state->y, state->sp };
 
-	SDL_SetRenderTarget(prend, TM::Instance()->Get_Texture_Info(registers_texture_id).ptexture);
+	SDL_SetRenderTarget(prend, ptm->Get_Texture_Info(registers_texture_id).ptexture);
 	int x = glyph_info.w * 3;
 	int y = 0;
 
@@ -594,14 +589,14 @@ void IV::Draw_Registers()
 
 	// finally draw pc
 	x += glyph_info.w;	// offset by one
-	if (first_draw || pnes->cpu.pc != shadow_pc)
+	if (first_draw || state->pc != shadow_pc)
 	{
-		Draw_Hex16(pnes->cpu.pc, x, y);
-		shadow_pc = pnes->cpu.pc;
+		Draw_Hex16(state->pc, x, y);
+		shadow_pc = state->pc;
 	} // end if pc
 
 	SDL_SetRenderTarget(prend, nullptr);
-	TM::Instance()->Draw(registers_texture_id, prend, register_x, register_y);
+	ptm->Draw(registers_texture_id, prend, register_x, register_y);
 } // end Draw_Registers
 
 //=====================================================================|
@@ -615,160 +610,160 @@ void IV::Draw_Registers()
  */
 void IV::Draw_Disasm_Line(u16 addr, int x, int y)
 {
-	u8 opcode = pnes->cpu.Read(addr++);
+	u8 opcode = state->Peek(addr++);
 
 	// draw the address label
 	Draw_Hex16(addr++, x, y, 1);
-	TM::Instance()->Draw(colon_texture_id, prend, x, y);
+	ptm->Draw(colon_texture_id, prend, x, y);
 
 	// draw the op-codes
 	x = glyph_info.w * 6;
 	int count = 0;
 	while (count++ < pnes->cpu.lookup[opcode].bytes)
 	{
-		Draw_Hex8(pnes->Read(addr), x, y, 2);
+		Draw_Hex8(state->Peek(addr), x, y, 2);
 		x += glyph_info.w;	// space
 	} // end while
 
 	// now draw the menonic
 	x = glyph_info.w * 15;
-	int id = TM::Instance()->Get_Texture_ID(pnes->cpu.lookup[opcode].name);
-	TM::Instance()->Draw(id, prend, x, y);
+	int id = ptm->Get_Texture_ID(pnes->cpu.mnemonics[opcode]);
+	ptm->Draw(id, prend, x, y);
 
 	// draw the operands
 	x = glyph_info.w * 21;
-	if (pnes->cpu.lookup[opcode].Addrmode == &CPU6502::IMP)
+	if (pnes->cpu.lookup[opcode].mode == CPU6502::AM_IMP)
 	{
 		// just draw the addressing mode
 		x = glyph_info.w * 31;
-		id = TM::Instance()->Get_Texture_ID(ADDR_IMP);
-		TM::Instance()->Draw(id, prend, x, y);
+		id = ptm->Get_Texture_ID(ADDR_IMP);
+		ptm->Draw(id, prend, x, y);
 	} // end if implied
-	else if (pnes->cpu.lookup[opcode].Addrmode == &CPU6502::IMM)
+	else if (pnes->cpu.lookup[opcode].mode == CPU6502::AM_IMM)
 	{
-		u8 value = pnes->cpu.Read(addr++);
+		u8 value = state->Peek(addr++);
 
-		TM::Instance()->Draw(pound_texture_id, prend, x, y);
+		ptm->Draw(pound_texture_id, prend, x, y);
 		x += glyph_info.w;
 
-		TM::Instance()->Draw(dollar$_texture_id, prend, x, y);
+		ptm->Draw(dollar$_texture_id, prend, x, y);
 		x += glyph_info.w;
 
 		Draw_Hex8(value, x, y);
 
 		// draw the addressing mode
 		x = glyph_info.w * 31;
-		id = TM::Instance()->Get_Texture_ID(ADDR_IMM);
-		TM::Instance()->Draw(id, prend, x, y);
+		id = ptm->Get_Texture_ID(ADDR_IMM);
+		ptm->Draw(id, prend, x, y);
 	} // end else immediate
-	else if (pnes->cpu.lookup[opcode].Addrmode == &CPU6502::ZP0)
+	else if (pnes->cpu.lookup[opcode].mode == CPU6502::AM_ZP0)
 	{
-		u8 lo = pnes->Read(addr++);
+		u8 lo = state->Peek(addr++);
 
-		TM::Instance()->Draw(dollar$_texture_id, prend, x, y);
+		ptm->Draw(dollar$_texture_id, prend, x, y);
 		x += glyph_info.w;
 
 		Draw_Hex8(lo, x, y);
 
 		// draw the addressing mode
 		x = glyph_info.w * 31;
-		id = TM::Instance()->Get_Texture_ID(ADDR_ZP0);
-		TM::Instance()->Draw(id, prend, x, y);
+		id = ptm->Get_Texture_ID(ADDR_ZP0);
+		ptm->Draw(id, prend, x, y);
 	} // end else zero page 0
-	else if (pnes->cpu.lookup[opcode].Addrmode == &CPU6502::ZPX)
+	else if (pnes->cpu.lookup[opcode].mode == CPU6502::AM_ZPX)
 	{
-		u8 lo = pnes->Read(addr++);
+		u8 lo = state->Peek(addr++);
 
-		TM::Instance()->Draw(dollar$_texture_id, prend, x, y);
+		ptm->Draw(dollar$_texture_id, prend, x, y);
 		x += glyph_info.w;
 
 		Draw_Hex8(lo, x, y);
 
-		TM::Instance()->Draw(comma_texture_id, prend, x, y);
+		ptm->Draw(comma_texture_id, prend, x, y);
 		x += glyph_info.w * 2;
 
-		TM::Instance()->Draw(x_texture_id, prend, x, y);
+		ptm->Draw(x_texture_id, prend, x, y);
 
 		// draw the addressing mode
 		x = glyph_info.w * 31;
-		id = TM::Instance()->Get_Texture_ID(ADDR_ZPX);
-		TM::Instance()->Draw(id, prend, x, y);
+		id = ptm->Get_Texture_ID(ADDR_ZPX);
+		ptm->Draw(id, prend, x, y);
 	} // end else zero page x
-	else if (pnes->cpu.lookup[opcode].Addrmode == &CPU6502::ZPY)
+	else if (pnes->cpu.lookup[opcode].mode == CPU6502::AM_ZPY)
 	{
-		u8 lo = pnes->Read(addr++);
+		u8 lo = state->Peek(addr++);
 
-		TM::Instance()->Draw(dollar$_texture_id, prend, x, y);
+		ptm->Draw(dollar$_texture_id, prend, x, y);
 		x += glyph_info.w;
 
 		Draw_Hex8(lo, x, y);
 
-		TM::Instance()->Draw(comma_texture_id, prend, x, y);
+		ptm->Draw(comma_texture_id, prend, x, y);
 		x += glyph_info.w * 2;
 
-		TM::Instance()->Draw(y_texture_id, prend, x, y);
+		ptm->Draw(y_texture_id, prend, x, y);
 
 		// draw the addressing mode
 		x = glyph_info.w * 31;
-		id = TM::Instance()->Get_Texture_ID(ADDR_ZPY);
-		TM::Instance()->Draw(id, prend, x, y);
+		id = ptm->Get_Texture_ID(ADDR_ZPY);
+		ptm->Draw(id, prend, x, y);
 	} // end else zero page y
-	else if (pnes->cpu.lookup[opcode].Addrmode == &CPU6502::IZX)
+	else if (pnes->cpu.lookup[opcode].mode == CPU6502::AM_IZX)
 	{
-		u8 lo = pnes->Read(addr++);
+		u8 lo = state->Peek(addr++);
 
-		TM::Instance()->Draw(bracket_texture_id, prend, x, y);
+		ptm->Draw(bracket_texture_id, prend, x, y);
 		x += glyph_info.w;
 
-		TM::Instance()->Draw(dollar$_texture_id, prend, x, y);
+		ptm->Draw(dollar$_texture_id, prend, x, y);
 		x += glyph_info.w;
 
 		Draw_Hex8(lo, x, y);
 
-		TM::Instance()->Draw(comma_texture_id, prend, x, y);
+		ptm->Draw(comma_texture_id, prend, x, y);
 		x += glyph_info.w * 2;
 
-		TM::Instance()->Draw(x_texture_id, prend, x, y);
+		ptm->Draw(x_texture_id, prend, x, y);
 		x += glyph_info.w;
 
-		TM::Instance()->Draw(bracket_texture_id + 1, prend, x, y);
+		ptm->Draw(bracket_texture_id + 1, prend, x, y);
 
 		// draw the addressing mode
 		x = glyph_info.w * 31;
-		id = TM::Instance()->Get_Texture_ID(ADDR_IZX);
-		TM::Instance()->Draw(id, prend, x, y);
+		id = ptm->Get_Texture_ID(ADDR_IZX);
+		ptm->Draw(id, prend, x, y);
 	} // end indirect x addressing
-	else if (pnes->cpu.lookup[opcode].Addrmode == &CPU6502::IZY)
+	else if (pnes->cpu.lookup[opcode].mode == CPU6502::AM_IZY)
 	{
-		u8 lo = pnes->Read(addr++);
+		u8 lo = state->Peek(addr++);
 
-		TM::Instance()->Draw(bracket_texture_id, prend, x, y);
+		ptm->Draw(bracket_texture_id, prend, x, y);
 		x += glyph_info.w;
 
-		TM::Instance()->Draw(dollar$_texture_id, prend, x, y);
+		ptm->Draw(dollar$_texture_id, prend, x, y);
 		x += glyph_info.w;
 
 		Draw_Hex8(lo, x, y);
 
-		TM::Instance()->Draw(comma_texture_id, prend, x, y);
+		ptm->Draw(comma_texture_id, prend, x, y);
 		x += glyph_info.w * 2;
 
-		TM::Instance()->Draw(y_texture_id, prend, x, y);
+		ptm->Draw(y_texture_id, prend, x, y);
 		x += glyph_info.w;
 
-		TM::Instance()->Draw(bracket_texture_id + 1, prend, x, y);
+		ptm->Draw(bracket_texture_id + 1, prend, x, y);
 
 		// draw the addressing mode
 		x = glyph_info.w * 31;
-		id = TM::Instance()->Get_Texture_ID(ADDR_IZY);
-		TM::Instance()->Draw(id, prend, x, y);
+		id = ptm->Get_Texture_ID(ADDR_IZY);
+		ptm->Draw(id, prend, x, y);
 	} // end else indirect y addressing
-	else if (pnes->cpu.lookup[opcode].Addrmode == &CPU6502::ABS)
+	else if (pnes->cpu.lookup[opcode].mode == CPU6502::AM_ABS)
 	{
-		u8 lo = pnes->Read(addr++);
-		u8 hi = pnes->Read(addr++);
+		u8 lo = state->Peek(addr++);
+		u8 hi = state->Peek(addr++);
 
-		TM::Instance()->Draw(dollar$_texture_id, prend, x, y);
+		ptm->Draw(dollar$_texture_id, prend, x, y);
 		x += glyph_info.w;
 
 		Draw_Hex8(hi, x, y);
@@ -776,91 +771,91 @@ void IV::Draw_Disasm_Line(u16 addr, int x, int y)
 
 		// draw the addressing mode
 		x = glyph_info.w * 31;
-		id = TM::Instance()->Get_Texture_ID(ADDR_ABS);
-		TM::Instance()->Draw(id, prend, x, y);
+		id = ptm->Get_Texture_ID(ADDR_ABS);
+		ptm->Draw(id, prend, x, y);
 	} // end else absolute addressing
-	else if (pnes->cpu.lookup[opcode].Addrmode == &CPU6502::ABX)
+	else if (pnes->cpu.lookup[opcode].mode == CPU6502::AM_ABX)
 	{
-		u8 lo = pnes->Read(addr++);
-		u8 hi = pnes->Read(addr++);
+		u8 lo = state->Peek(addr++);
+		u8 hi = state->Peek(addr++);
 
-		TM::Instance()->Draw(dollar$_texture_id, prend, x, y);
+		ptm->Draw(dollar$_texture_id, prend, x, y);
 		x += glyph_info.w;
 
 		Draw_Hex8(hi, x, y);
 		Draw_Hex8(lo, x, y);
 
-		TM::Instance()->Draw(comma_texture_id, prend, x, y);
+		ptm->Draw(comma_texture_id, prend, x, y);
 		x += glyph_info.w * 2;
 
-		TM::Instance()->Draw(x_texture_id, prend, x, y);
+		ptm->Draw(x_texture_id, prend, x, y);
 
 		// draw the addressing mode
 		x = glyph_info.w * 31;
-		id = TM::Instance()->Get_Texture_ID(ADDR_ABX);
-		TM::Instance()->Draw(id, prend, x, y);
+		id = ptm->Get_Texture_ID(ADDR_ABX);
+		ptm->Draw(id, prend, x, y);
 	} // end else absoulte x indexing
-	else if (pnes->cpu.lookup[opcode].Addrmode == &CPU6502::ABY)
+	else if (pnes->cpu.lookup[opcode].mode == CPU6502::AM_ABY)
 	{
-		u8 lo = pnes->Read(addr++);
-		u8 hi = pnes->Read(addr++);
+		u8 lo = state->Peek(addr++);
+		u8 hi = state->Peek(addr++);
 
-		TM::Instance()->Draw(dollar$_texture_id, prend, x, y);
+		ptm->Draw(dollar$_texture_id, prend, x, y);
 		x += glyph_info.w;
 
 		Draw_Hex8(hi, x, y);
 		Draw_Hex8(lo, x, y);
 
-		TM::Instance()->Draw(comma_texture_id, prend, x, y);
+		ptm->Draw(comma_texture_id, prend, x, y);
 		x += glyph_info.w * 2;
 
-		TM::Instance()->Draw(y_texture_id, prend, x, y);
+		ptm->Draw(y_texture_id, prend, x, y);
 
 		// draw the addressing mode
 		x = glyph_info.w * 31;
-		id = TM::Instance()->Get_Texture_ID(ADDR_ABY);
-		TM::Instance()->Draw(id, prend, x, y);
+		id = ptm->Get_Texture_ID(ADDR_ABY);
+		ptm->Draw(id, prend, x, y);
 	} // end else absolute y
-	else if (pnes->cpu.lookup[opcode].Addrmode == &CPU6502::IND)
+	else if (pnes->cpu.lookup[opcode].mode == CPU6502::AM_IND)
 	{
-		u8 lo = pnes->Read(addr++); 
-		u8 hi = pnes->Read(addr++); 
+		u8 lo = state->Peek(addr++); 
+		u8 hi = state->Peek(addr++); 
 
-		TM::Instance()->Draw(bracket_texture_id, prend, x, y);
+		ptm->Draw(bracket_texture_id, prend, x, y);
 		x += glyph_info.w;
 
-		TM::Instance()->Draw(dollar$_texture_id, prend, x, y);
+		ptm->Draw(dollar$_texture_id, prend, x, y);
 		x += glyph_info.w;
 
 		Draw_Hex8(hi, x, y);
 		Draw_Hex8(lo, x, y);
 
-		TM::Instance()->Draw(bracket_texture_id + 1, prend, x, y);
+		ptm->Draw(bracket_texture_id + 1, prend, x, y);
 		
 		// draw the addressing mode
 		x = glyph_info.w * 31;
-		id = TM::Instance()->Get_Texture_ID(ADDR_IND);
-		TM::Instance()->Draw(id, prend, x, y);
+		id = ptm->Get_Texture_ID(ADDR_IND);
+		ptm->Draw(id, prend, x, y);
 	} // end else indirect
 	else
 	{
 		// presume REL
-		u8 value = pnes->Read(addr++);
+		u8 value = state->Peek(addr++);
 
-		TM::Instance()->Draw(squareb_texture_id, prend, x, y);
+		ptm->Draw(squareb_texture_id, prend, x, y);
 		x += glyph_info.w;
 
-		TM::Instance()->Draw(dollar$_texture_id, prend, x, y);
+		ptm->Draw(dollar$_texture_id, prend, x, y);
 		x += glyph_info.w;
 
 		Draw_Hex16(addr + value, x, y);
 
-		TM::Instance()->Draw(squareb_texture_id + 1, prend, x, y);
+		ptm->Draw(squareb_texture_id + 1, prend, x, y);
 		
 		// draw the addressing mode
 		x = glyph_info.w * 31;
-		id = TM::Instance()->Get_Texture_ID(ADDR_REL);
-		TM::Instance()->Draw(id, prend, x, y);
+		id = ptm->Get_Texture_ID(ADDR_REL);
+		ptm->Draw(id, prend, x, y);
 	} // end at last relative
 } // end Draw_Disasm_Line
 
@@ -878,8 +873,7 @@ void IV::Draw_Disasm_Line(u16 addr, int x, int y)
 inline void IV::Draw_Hex8(const u8 num, int& x, int& y, const u8 color_index)
 {
 	// since all hex textures are monospaced fonts; i.e. consola
-	static const int num_text_width = TM::Instance()->
-		Get_Texture_Info(hex_texture_id).w;	
+	const int num_text_width = glyph_info.w;
 
 	// split num into 2 nibbles
 	u8 hi = (num & 0xf0) >> 4;
@@ -888,8 +882,8 @@ inline void IV::Draw_Hex8(const u8 num, int& x, int& y, const u8 color_index)
 	int hi_texture_id = ((0x03 & color_index) << 4) + hex_texture_id + hi;
 	int lo_texture_id = ((0x03 & color_index) << 4) + hex_texture_id + lo;
 
-	TM::Instance()->Draw(hi_texture_id, prend, x, y); x += num_text_width;
-	TM::Instance()->Draw(lo_texture_id, prend, x, y); x += num_text_width;
+	ptm->Draw(hi_texture_id, prend, x, y); x += num_text_width;
+	ptm->Draw(lo_texture_id, prend, x, y); x += num_text_width;
 } // end Draw_Hex8
 
 //=====================================================================|
@@ -930,9 +924,9 @@ void IV::Build_Disasm(const u16 start, const u16 end)
 		line_addr = addr;
 		Disasm_Mnemonic dm;
 
-		uint8_t opcode = pnes->Read(addr);
+		uint8_t opcode = pnes->Peek(addr);
 
-		dm.mnemonic += pnes->cpu.lookup[opcode].name;
+		dm.mnemonic += pnes->cpu.mnemonics[opcode];
 		addr += pnes->cpu.lookup[opcode].bytes;
 
 		// Add the formed string to a std::map, using the instruction's
@@ -30,9 +30,10 @@ class IV
 {
 public:
 
-	IV(NES* pnes);
+	IV(NES* pnes, TextureManager* ptm);
 
 	void Init(SDL_Renderer* pr);
+	void Show(NES_Snapshot* snap) { state = snap; }
 	void Draw_CPU();
 	void Draw_RAM();
 	void Draw_Disasm();
@@ -44,6 +45,8 @@ private:
 
 	SDL_Renderer* prend;		// sdl renderer object
 	NES* pnes;					// pointer to nes object
+	TextureManager* ptm;		// where its textures live
+	NES_Snapshot* state;		// what the views draw, as of the last frame
 	std::map<u16, Disasm_Mnemonic> disasm_addr;		// full disassembly text
 
 	int hex_texture_id;			// id for hex numerics texture
@@ -67,6 +70,14 @@ private:
 	u16 start_addr = 0x0000;	// starting address for ram
 	bool first_draw = true;		// indicates if this is a first time drawing
 
+	// what the views show as of the last draw; only the changes get redrawn
+	u64 old_sequence = 0;		// the snapshot drawn
+	u16 old_addr = 0x0000;		// start_addr of the RAM view
+	u16 old_pc = 0x0000;		// pc the disassembly is centered on
+	u8 shadow_status = 0;		// the flags
+	u8 shadows[4]{};			// A, X, Y and SP
+	u16 shadow_pc = 0x0000;
+
 
 	// utils
 	void Create_Numeric_Textures();
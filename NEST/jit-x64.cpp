@@ -0,0 +1,1179 @@
+/**
+ * @brief The implementation of the x86-64 recompiler and its emitter.
+ *
+ * @author Rediet Worku
+ * @date 26th of October 2021, Sunday
+ */
+
+//=====================================================================|
+#include "jit-x64.hpp"
+#include "cpu6502.hpp"
+#include "nes.hpp"
+
+#include <cstring>
+
+static_assert(sizeof(Bus_Page) == 32, "the recompiler indexes the page table by page << 5");
+
+#if NEST_JIT
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+#endif
+
+
+
+//=====================================================================|
+// the first three integer arguments; Win64 and SysV disagree on these
+#ifdef _WIN32
+static constexpr u8 ARG0 = X64Emitter::RCX;
+static constexpr u8 ARG1 = X64Emitter::RDX;
+static constexpr u8 ARG2 = X64Emitter::R8;
+#else
+static constexpr u8 ARG0 = X64Emitter::RDI;
+static constexpr u8 ARG1 = X64Emitter::RSI;
+static constexpr u8 ARG2 = X64Emitter::RDX;
+#endif
+
+// where the 6502 lives while a block runs
+static constexpr u8 REG_CPU = X64Emitter::RBX;
+static constexpr u8 REG_RAM = X64Emitter::RBP;
+static constexpr u8 REG_A = X64Emitter::R12;
+static constexpr u8 REG_X = X64Emitter::R13;
+static constexpr u8 REG_Y = X64Emitter::R14;
+static constexpr u8 REG_PAGES = X64Emitter::R15;
+
+// six pushes plus this keeps the stack 16 byte aligned for calls; the
+//	bottom 32 bytes are the Win64 shadow space, the qword above it holds
+//	the cycle count a self loop may run up to
+static constexpr u8 FRAME_SIZE = 40;
+static constexpr s32 LOOP_LIMIT = 32;
+
+
+
+//=====================================================================|
+// X64Emitter
+//=====================================================================|
+/**
+ * @brief Emits a REX prefix when one is needed; force is for the byte
+ *	registers spl, bpl, sil and dil which are only reachable with one.
+ */
+void X64Emitter::Rex(const bool w, const u8 reg, const u8 index, const u8 base, const bool force)
+{
+	u8 rex = 0x40 | (w << 3) | ((reg & 8) >> 1) | ((index & 8) >> 2) | ((base & 8) >> 3);
+	if (rex != 0x40 || force)
+		Emit8(rex);
+} // end Rex
+
+
+//=====================================================================|
+/**
+ * @brief A register to register ModRM byte.
+ */
+void X64Emitter::Reg_Reg(const u8 reg, const u8 rm)
+{
+	Emit8(0xC0 | ((reg & 7) << 3) | (rm & 7));
+} // end Reg_Reg
+
+
+//=====================================================================|
+/**
+ * @brief A ModRM for [base + disp32]; rsp and r12 need a SIB byte.
+ */
+void X64Emitter::Mem(const u8 reg, const u8 base, const s32 disp)
+{
+	Emit8(0x80 | ((reg & 7) << 3) | (base & 7));
+	if ((base & 7) == RSP)
+		Emit8(0x24);
+	Emit32((u32)disp);
+} // end Mem
+
+
+//=====================================================================|
+void X64Emitter::Mov(const u8 dst, const u8 src)
+{
+	Rex(false, src, 0, dst);
+	Emit8(0x89);
+	Reg_Reg(src, dst);
+} // end Mov
+
+
+//=====================================================================|
+void X64Emitter::Mov_Imm(const u8 dst, const u32 imm)
+{
+	Rex(false, 0, 0, dst);
+	Emit8(0xB8 + (dst & 7));
+	Emit32(imm);
+} // end Mov_Imm
+
+
+//=====================================================================|
+void X64Emitter::Alu(const u8 op, const u8 dst, const u8 src)
+{
+	Rex(false, src, 0, dst);
+	Emit8((op << 3) | 1);
+	Reg_Reg(src, dst);
+} // end Alu
+
+
+//=====================================================================|
+void X64Emitter::Alu_Imm(const u8 op, const u8 dst, const s32 imm)
+{
+	Rex(false, 0, 0, dst);
+	if (imm >= -128 && imm <= 127)
+	{
+		Emit8(0x83);
+		Reg_Reg(op, dst);
+		Emit8((u8)imm);
+	} // end if short form
+	else
+	{
+		Emit8(0x81);
+		Reg_Reg(op, dst);
+		Emit32((u32)imm);
+	} // end else
+} // end Alu_Imm
+
+
+//=====================================================================|
+void X64Emitter::Test_Imm(const u8 dst, const u32 imm)
+{
+	Rex(false, 0, 0, dst);
+	Emit8(0xF7);
+	Reg_Reg(0, dst);
+	Emit32(imm);
+} // end Test_Imm
+
+
+//=====================================================================|
+void X64Emitter::Lea(const u8 dst, const u8 base, const s32 disp)
+{
+	Rex(false, dst, 0, base);
+	Emit8(0x8D);
+	Mem(dst, base, disp);
+} // end Lea
+
+
+//=====================================================================|
+void X64Emitter::Movzx8(const u8 dst, const u8 src)
+{
+	Rex(false, dst, 0, src, src >= RSP && src <= RDI);
+	Emit8(0x0F);
+	Emit8(0xB6);
+	Reg_Reg(dst, src);
+} // end Movzx8
+
+
+//=====================================================================|
+void X64Emitter::Movzx16(const u8 dst, const u8 src)
+{
+	Rex(false, dst, 0, src);
+	Emit8(0x0F);
+	Emit8(0xB7);
+	Reg_Reg(dst, src);
+} // end Movzx16
+
+
+//=====================================================================|
+void X64Emitter::Shl(const u8 dst, const u8 imm)
+{
+	Rex(false, 0, 0, dst);
+	Emit8(0xC1);
+	Reg_Reg(4, dst);
+	Emit8(imm);
+} // end Shl
+
+
+//=====================================================================|
+void X64Emitter::Shr(const u8 dst, const u8 imm)
+{
+	Rex(false, 0, 0, dst);
+	Emit8(0xC1);
+	Reg_Reg(5, dst);
+	Emit8(imm);
+} // end Shr
+
+
+//=====================================================================|
+void X64Emitter::Inc(const u8 dst)
+{
+	Rex(false, 0, 0, dst);
+	Emit8(0xFF);
+	Reg_Reg(0, dst);
+} // end Inc
+
+
+//=====================================================================|
+void X64Emitter::Dec(const u8 dst)
+{
+	Rex(false, 0, 0, dst);
+	Emit8(0xFF);
+	Reg_Reg(1, dst);
+} // end Dec
+
+
+//=====================================================================|
+void X64Emitter::Setcc(const u8 cc, const u8 dst)
+{
+	Rex(false, 0, 0, dst, dst >= RSP && dst <= RDI);
+	Emit8(0x0F);
+	Emit8(0x90 + cc);
+	Reg_Reg(0, dst);
+} // end Setcc
+
+
+//=====================================================================|
+void X64Emitter::Load_Byte(const u8 dst, const u8 base, const s32 disp)
+{
+	Rex(false, dst, 0, base);
+	Emit8(0x0F);
+	Emit8(0xB6);
+	Mem(dst, base, disp);
+} // end Load_Byte
+
+
+//=====================================================================|
+/**
+ * @brief movzx dst, byte [base + index]; written with a zero disp8 so
+ *	that rbp and r13 work as a base.
+ */
+void X64Emitter::Load_Byte_Index(const u8 dst, const u8 base, const u8 index)
+{
+	Rex(false, dst, index, base);
+	Emit8(0x0F);
+	Emit8(0xB6);
+	Emit8(0x44 | ((dst & 7) << 3));
+	Emit8(((index & 7) << 3) | (base & 7));
+	Emit8(0);
+} // end Load_Byte_Index
+
+
+//=====================================================================|
+void X64Emitter::Store_Byte(const u8 base, const s32 disp, const u8 src)
+{
+	Rex(false, src, 0, base, src >= RSP && src <= RDI);
+	Emit8(0x88);
+	Mem(src, base, disp);
+} // end Store_Byte
+
+
+//=====================================================================|
+void X64Emitter::Store_Byte_Imm(const u8 base, const s32 disp, const u8 imm)
+{
+	Rex(false, 0, 0, base);
+	Emit8(0xC6);
+	Mem(0, base, disp);
+	Emit8(imm);
+} // end Store_Byte_Imm
+
+
+//=====================================================================|
+void X64Emitter::Store_Word_Imm(const u8 base, const s32 disp, const u16 imm)
+{
+	Emit8(0x66);
+	Rex(false, 0, 0, base);
+	Emit8(0xC7);
+	Mem(0, base, disp);
+	Emit16(imm);
+} // end Store_Word_Imm
+
+
+//=====================================================================|
+/**
+ * @brief One of the group 1 ALU ops on a byte in memory, with an 8-bit
+ *	immediate.
+ */
+void X64Emitter::Alu_Byte_Mem_Imm(const u8 op, const u8 base, const s32 disp, const u8 imm)
+{
+	Rex(false, 0, 0, base);
+	Emit8(0x80);
+	Mem(op, base, disp);
+	Emit8(imm);
+} // end Alu_Byte_Mem_Imm
+
+
+//=====================================================================|
+void X64Emitter::Mov64(const u8 dst, const u8 src)
+{
+	Rex(true, src, 0, dst);
+	Emit8(0x89);
+	Reg_Reg(src, dst);
+} // end Mov64
+
+
+//=====================================================================|
+void X64Emitter::Mov64_Imm(const u8 dst, const u64 imm)
+{
+	Rex(true, 0, 0, dst);
+	Emit8(0xB8 + (dst & 7));
+	Emit64(imm);
+} // end Mov64_Imm
+
+
+//=====================================================================|
+void X64Emitter::Load64(const u8 dst, const u8 base, const s32 disp)
+{
+	Rex(true, dst, 0, base);
+	Emit8(0x8B);
+	Mem(dst, base, disp);
+} // end Load64
+
+
+//=====================================================================|
+/**
+ * @brief mov dst, [base + index]; the same zero disp8 trick as
+ *	Load_Byte_Index.
+ */
+void X64Emitter::Load64_Index(const u8 dst, const u8 base, const u8 index)
+{
+	Rex(true, dst, index, base);
+	Emit8(0x8B);
+	Emit8(0x44 | ((dst & 7) << 3));
+	Emit8(((index & 7) << 3) | (base & 7));
+	Emit8(0);
+} // end Load64_Index
+
+
+//=====================================================================|
+void X64Emitter::Store64(const u8 base, const s32 disp, const u8 src)
+{
+	Rex(true, src, 0, base);
+	Emit8(0x89);
+	Mem(src, base, disp);
+} // end Store64
+
+
+//=====================================================================|
+void X64Emitter::Add64_Mem_Imm(const u8 base, const s32 disp, const s32 imm)
+{
+	Rex(true, 0, 0, base);
+	Emit8(0x81);
+	Mem(0, base, disp);
+	Emit32((u32)imm);
+} // end Add64_Mem_Imm
+
+
+//=====================================================================|
+void X64Emitter::Add64_Mem_Reg(const u8 base, const s32 disp, const u8 src)
+{
+	Rex(true, src, 0, base);
+	Emit8(0x01);
+	Mem(src, base, disp);
+} // end Add64_Mem_Reg
+
+
+//=====================================================================|
+void X64Emitter::Cmp64_Reg_Mem(const u8 reg, const u8 base, const s32 disp)
+{
+	Rex(true, reg, 0, base);
+	Emit8(0x3B);
+	Mem(reg, base, disp);
+} // end Cmp64_Reg_Mem
+
+
+//=====================================================================|
+void X64Emitter::Test64(const u8 dst, const u8 src)
+{
+	Rex(true, src, 0, dst);
+	Emit8(0x85);
+	Reg_Reg(src, dst);
+} // end Test64
+
+
+//=====================================================================|
+void X64Emitter::Sub_Rsp(const u8 imm)
+{
+	Emit8(0x48);
+	Emit8(0x83);
+	Emit8(0xEC);
+	Emit8(imm);
+} // end Sub_Rsp
+
+
+//=====================================================================|
+void X64Emitter::Add_Rsp(const u8 imm)
+{
+	Emit8(0x48);
+	Emit8(0x83);
+	Emit8(0xC4);
+	Emit8(imm);
+} // end Add_Rsp
+
+
+//=====================================================================|
+void X64Emitter::Push(const u8 reg)
+{
+	Rex(false, 0, 0, reg);
+	Emit8(0x50 + (reg & 7));
+} // end Push
+
+
+//=====================================================================|
+void X64Emitter::Pop(const u8 reg)
+{
+	Rex(false, 0, 0, reg);
+	Emit8(0x58 + (reg & 7));
+} // end Pop
+
+
+//=====================================================================|
+void X64Emitter::Call(const u8 reg)
+{
+	Rex(false, 0, 0, reg);
+	Emit8(0xFF);
+	Reg_Reg(2, reg);
+} // end Call
+
+
+//=====================================================================|
+void X64Emitter::Ret()
+{
+	Emit8(0xC3);
+} // end Ret
+
+
+//=====================================================================|
+/**
+ * @brief A forward conditional jump; returns where its rel32 sits so
+ *	that Patch() can point it at the target once that is known.
+ */
+size_t X64Emitter::Jcc(const u8 cc)
+{
+	Emit8(0x0F);
+	Emit8(0x80 + cc);
+	size_t at = pos;
+	Emit32(0);
+	return at;
+} // end Jcc
+
+
+//=====================================================================|
+/**
+ * @brief A forward jump; see Jcc().
+ */
+size_t X64Emitter::Jmp()
+{
+	Emit8(0xE9);
+	size_t at = pos;
+	Emit32(0);
+	return at;
+} // end Jmp
+
+
+//=====================================================================|
+/**
+ * @brief A backward conditional jump to a position already emitted.
+ */
+void X64Emitter::Jcc_To(const u8 cc, const size_t target)
+{
+	Emit8(0x0F);
+	Emit8(0x80 + cc);
+	Emit32((u32)(s32)(target - (pos + 4)));
+} // end Jcc_To
+
+
+//=====================================================================|
+/**
+ * @brief Points the forward jump whose rel32 is at 'at' here.
+ */
+void X64Emitter::Patch(const size_t at)
+{
+	u32 rel = (u32)(s32)(pos - (at + 4));
+	if (at + 4 <= limit)
+		memcpy(buf + at, &rel, 4);
+} // end Patch
+
+
+
+//=====================================================================|
+// JitX64
+//=====================================================================|
+/**
+ * constructor; grabs the executable buffer. Without one (not x86-64, or
+ *	the OS said no) Is_Available() is false and the CPU keeps to the
+ *	block engine.
+ */
+JitX64::JitX64(CPU6502& c)
+	:cpu{ c }, code{ nullptr }, code_used{ 0 }, block_start{ 0 }, loop_top{ 0 },
+	mem_base{ 0 }, mem_index{ 0 }
+{
+	const u8* base = reinterpret_cast<const u8*>(&cpu);
+	off_a = (s32)(reinterpret_cast<const u8*>(&cpu.a) - base);
+	off_x = (s32)(reinterpret_cast<const u8*>(&cpu.x) - base);
+	off_y = (s32)(reinterpret_cast<const u8*>(&cpu.y) - base);
+	off_sp = (s32)(reinterpret_cast<const u8*>(&cpu.sp) - base);
+	off_status = (s32)(reinterpret_cast<const u8*>(&cpu.status) - base);
+	off_pc = (s32)(reinterpret_cast<const u8*>(&cpu.pc) - base);
+	off_total = (s32)(reinterpret_cast<const u8*>(&cpu.total_cycles) - base);
+	off_n = (s32)(reinterpret_cast<const u8*>(&cpu.flag_n) - base);
+	off_z = (s32)(reinterpret_cast<const u8*>(&cpu.flag_z) - base);
+	off_c = (s32)(reinterpret_cast<const u8*>(&cpu.flag_c) - base);
+	off_v = (s32)(reinterpret_cast<const u8*>(&cpu.flag_v) - base);
+
+#if NEST_JIT
+#ifdef _WIN32
+	code = (u8*)VirtualAlloc(nullptr, CODE_SIZE, MEM_COMMIT | MEM_RESERVE, PAGE_EXECUTE_READWRITE);
+#else
+	void* p = mmap(nullptr, CODE_SIZE, PROT_READ | PROT_WRITE | PROT_EXEC,
+		MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (p != MAP_FAILED)
+		code = (u8*)p;
+#endif
+#endif
+} // end constructor
+
+
+//=====================================================================|
+/**
+ * Destructor
+ */
+JitX64::~JitX64()
+{
+#if NEST_JIT
+	if (code)
+	{
+#ifdef _WIN32
+		VirtualFree(code, 0, MEM_RELEASE);
+#else
+		munmap(code, CODE_SIZE);
+#endif
+	} // end if
+#endif
+} // end Destructor
+
+
+//=====================================================================|
+/**
+ * @brief Translates a block into native code and hangs it off the block.
+ *	The decoded ops are copied in ahead of the code, since the handler
+ *	calls need them long after the block cache's pool may have moved on.
+ *
+ * @param blk the block to compile
+ * @param ops its decoded instructions
+ *
+ * @return false when there is no room left (or no buffer at all)
+ */
+bool JitX64::Compile(Code_Block& blk, const Decoded_Op* ops)
+{
+	if (!code || Is_Full())
+		return false;
+
+	code_used = (code_used + 15) & ~(size_t)15;
+	Decoded_Op* data = reinterpret_cast<Decoded_Op*>(code + code_used);
+	memcpy(data, ops, blk.count * sizeof(Decoded_Op));
+	code_used += blk.count * sizeof(Decoded_Op);
+
+	x64.Reset(code + code_used, CODE_SIZE - code_used);
+	exits.clear();
+	block_start = (blk.key - 1) & 0xFFFF;
+
+	Emit_Prologue();
+	loop_top = x64.Here();
+
+	u32 pending = 0;
+	for (u8 i = 0; i < blk.count; ++i)
+	{
+		if (!Emit_Native(ops[i], pending))
+			Emit_Handler(ops[i], &data[i], pending);
+	} // end for
+
+	// ran off the end of its page, or out of ops
+	if (!CPU6502::Ends_Block(ops[blk.count - 1].opcode))
+		Emit_Exit(ops[blk.count - 1].next_pc, pending, EXIT_NORMAL);
+
+	Emit_Epilogue();
+
+	blk.native = code + code_used;
+	code_used += x64.Here();
+	return true;
+} // end Compile
+
+
+//=====================================================================|
+/**
+ * @brief Runs a compiled block. The caller makes sure the whole block fits
+ *	before target_cycle; a block that loops on itself goes round for as
+ *	long as another whole pass still fits.
+ *
+ * @return one of EXIT
+ */
+u32 JitX64::Run(const Code_Block& blk, const u64 target_cycle)
+{
+	Native_Fn fn = reinterpret_cast<Native_Fn>(blk.native);
+	return fn(&cpu, cpu.nes->ram, target_cycle - blk.max_cycles);
+} // end Run
+
+
+//=====================================================================|
+/**
+ * @brief Saves the callee saved registers we borrow and loads the 6502
+ *	into them.
+ */
+void JitX64::Emit_Prologue()
+{
+	x64.Push(X64Emitter::RBX);
+	x64.Push(X64Emitter::RBP);
+	x64.Push(X64Emitter::R12);
+	x64.Push(X64Emitter::R13);
+	x64.Push(X64Emitter::R14);
+	x64.Push(X64Emitter::R15);
+	x64.Sub_Rsp(FRAME_SIZE);
+
+	x64.Mov64(REG_CPU, ARG0);
+	x64.Mov64(REG_RAM, ARG1);
+	x64.Mov64_Imm(REG_PAGES, reinterpret_cast<u64>(cpu.nes->Page_Table()));
+	x64.Store64(X64Emitter::RSP, LOOP_LIMIT, ARG2);
+
+	x64.Load_Byte(REG_A, REG_CPU, off_a);
+	x64.Load_Byte(REG_X, REG_CPU, off_x);
+	x64.Load_Byte(REG_Y, REG_CPU, off_y);
+} // end Emit_Prologue
+
+
+//=====================================================================|
+/**
+ * @brief Every exit of the block lands here; puts the registers back into
+ *	the CPU6502 and returns the exit status left in eax.
+ */
+void JitX64::Emit_Epilogue()
+{
+	for (size_t at : exits)
+		x64.Patch(at);
+
+	x64.Store_Byte(REG_CPU, off_a, REG_A);
+	x64.Store_Byte(REG_CPU, off_x, REG_X);
+	x64.Store_Byte(REG_CPU, off_y, REG_Y);
+
+	x64.Add_Rsp(FRAME_SIZE);
+	x64.Pop(X64Emitter::R15);
+	x64.Pop(X64Emitter::R14);
+	x64.Pop(X64Emitter::R13);
+	x64.Pop(X64Emitter::R12);
+	x64.Pop(X64Emitter::RBP);
+	x64.Pop(X64Emitter::RBX);
+	x64.Ret();
+} // end Emit_Epilogue
+
+
+//=====================================================================|
+/**
+ * @brief Leaves the block.
+ *
+ * @param pc where the 6502 carries on, or -1 when a handler already set it
+ * @param pending cycles run since the last time they were added up
+ * @param status one of EXIT
+ */
+void JitX64::Emit_Exit(const s32 pc, const u32 pending, const u32 status)
+{
+	if (pc >= 0)
+		x64.Store_Word_Imm(REG_CPU, off_pc, (u16)pc);
+	if (pending)
+		x64.Add64_Mem_Imm(REG_CPU, off_total, (s32)pending);
+	x64.Mov_Imm(X64Emitter::RAX, status);
+	exits.push_back(x64.Jmp());
+} // end Emit_Exit
+
+
+//=====================================================================|
+/**
+ * @brief Adds the cycles run so far to total_cycles, so that whatever a
+ *	call back into C++ gets to see is up to date.
+ */
+void JitX64::Emit_Flush(u32& pending)
+{
+	if (pending)
+		x64.Add64_Mem_Imm(REG_CPU, off_total, (s32)pending);
+	pending = 0;
+} // end Emit_Flush
+
+
+//=====================================================================|
+/**
+ * @brief Sets N and Z from the byte in reg, the way Set_NZ does it in
+ *	the interpreter; the result is kept, not the flags.
+ */
+void JitX64::Emit_NZ(const u8 reg)
+{
+	x64.Store_Byte(REG_CPU, off_n, reg);
+	x64.Store_Byte(REG_CPU, off_z, reg);
+} // end Emit_NZ
+
+
+//=====================================================================|
+/**
+ * @brief Works out the effective address of a memory operand into eax.
+ *	An absolute address in I/O space is refused outright; an indexed one
+ *	that may land there gets checked at run time and bails out to the
+ *	interpreter when it does, before anything of the instruction happens.
+ *	For a load it also finds the byte, leaving it at [mem_base + mem_index].
+ *
+ * @param op the instruction
+ * @param pending cycles the ops before this one have run
+ * @param penalty whether crossing a page costs this instruction a cycle
+ * @param load whether the instruction reads the operand
+ *
+ * @return false for the modes the recompiler leaves to the handlers
+ */
+bool JitX64::Emit_Address(const Decoded_Op& op, const u32 pending, const bool penalty, const bool load)
+{
+	const u8 mode = CPU6502::lookup[op.opcode].mode;
+	const u16 here = op.next_pc - CPU6502::lookup[op.opcode].bytes;
+
+	mem_base = REG_RAM;
+	mem_index = X64Emitter::RAX;
+
+	switch (mode)
+	{
+	case CPU6502::AM_ZP0:
+	case CPU6502::AM_ABS:
+		if (Is_IO(op.operand))
+			return false;
+
+		// the internal RAM never moves, so its mirrors fold at compile time
+		if (op.operand < 0x2000)
+			x64.Mov_Imm(X64Emitter::RAX, op.operand & 0x07FF);
+		else
+		{
+			x64.Mov_Imm(X64Emitter::RAX, op.operand);
+			if (load)
+				Emit_Page(here, pending);
+		} // end else cartridge space
+		return true;
+
+	case CPU6502::AM_ZPX:
+	case CPU6502::AM_ZPY:
+		x64.Lea(X64Emitter::RAX, mode == CPU6502::AM_ZPX ? REG_X : REG_Y, op.operand);
+		x64.Movzx8(X64Emitter::RAX, X64Emitter::RAX);
+		return true;
+
+	case CPU6502::AM_ABX:
+	case CPU6502::AM_ABY:
+	{
+		x64.Lea(X64Emitter::RAX, mode == CPU6502::AM_ABX ? REG_X : REG_Y, op.operand);
+		x64.Movzx16(X64Emitter::RAX, X64Emitter::RAX);
+
+		if (op.operand <= 0x401F && op.operand + 0xFF >= 0x2000)
+		{
+			x64.Lea(X64Emitter::RCX, X64Emitter::RAX, -0x2000);
+			x64.Alu_Imm(X64Emitter::ALU_CMP, X64Emitter::RCX, 0x2020);
+			size_t ok = x64.Jcc(X64Emitter::CC_AE);
+			Emit_Exit(here, pending, EXIT_BAIL);
+			x64.Patch(ok);
+		} // end if may touch I/O
+
+		if (load)
+			Emit_Page(here, pending);
+
+		// r8, as rcx and rdx may hold where the page lookup found the byte
+		if (penalty)
+		{
+			x64.Mov(X64Emitter::R8, X64Emitter::RAX);
+			x64.Alu_Imm(X64Emitter::ALU_XOR, X64Emitter::R8, op.operand);
+			x64.Test_Imm(X64Emitter::R8, 0xFF00);
+			x64.Setcc(X64Emitter::CC_NE, X64Emitter::R8);
+			x64.Movzx8(X64Emitter::R8, X64Emitter::R8);
+			x64.Add64_Mem_Reg(REG_CPU, off_total, X64Emitter::R8);
+		} // end if page crossing costs
+		return true;
+	} // end case indexed absolute
+
+	default:
+		return false;
+	} // end switch
+} // end Emit_Address
+
+
+//=====================================================================|
+/**
+ * @brief Looks the page of the address in eax up in the NES page table,
+ *	since what is there may be switched at any time; a page without memory
+ *	behind it is a device's, and the instruction bails out to the
+ *	interpreter. Leaves the byte at [rcx + rdx].
+ *
+ * @param here the instruction's address
+ * @param pending cycles the ops before this one have run
+ */
+void JitX64::Emit_Page(const u16 here, const u32 pending)
+{
+	x64.Mov(X64Emitter::RCX, X64Emitter::RAX);
+	x64.Shr(X64Emitter::RCX, 8);
+	x64.Shl(X64Emitter::RCX, 5);
+	x64.Load64_Index(X64Emitter::RCX, REG_PAGES, X64Emitter::RCX);
+
+	x64.Test64(X64Emitter::RCX, X64Emitter::RCX);
+	size_t ok = x64.Jcc(X64Emitter::CC_NE);
+	Emit_Exit(here, pending, EXIT_BAIL);
+	x64.Patch(ok);
+
+	x64.Movzx8(X64Emitter::RDX, X64Emitter::RAX);
+	mem_base = X64Emitter::RCX;
+	mem_index = X64Emitter::RDX;
+} // end Emit_Page
+
+
+//=====================================================================|
+/**
+ * @brief Writes value to the address in eax through the bus, leaving the
+ *	block if the write landed on code. The cycles up to and including the
+ *	storing instruction's must be added up already: the interpreters have
+ *	the op's cost in cycles while it runs, and a device the write syncs
+ *	has to be caught up to that same cycle.
+ *
+ * @param value the register holding the byte to store
+ * @param next_pc where to carry on if the block has to be left
+ */
+void JitX64::Emit_Write(const u8 value, const u16 next_pc)
+{
+	x64.Mov(ARG2, value);
+	x64.Mov(ARG1, X64Emitter::RAX);
+	x64.Mov64(ARG0, REG_CPU);
+	x64.Mov64_Imm(X64Emitter::RAX, reinterpret_cast<u64>(&JitX64::Write_Helper));
+	x64.Call(X64Emitter::RAX);
+
+	x64.Alu_Imm(X64Emitter::ALU_CMP, X64Emitter::RAX, 0);
+	size_t ok = x64.Jcc(X64Emitter::CC_E);
+	Emit_Exit(next_pc, 0, EXIT_NORMAL);
+	x64.Patch(ok);
+} // end Emit_Write
+
+
+//=====================================================================|
+/**
+ * @brief LDA, LDX and LDY.
+ */
+bool JitX64::Emit_Load(const Decoded_Op& op, const u8 reg, u32& pending)
+{
+	if (CPU6502::lookup[op.opcode].mode == CPU6502::AM_IMM)
+		x64.Mov_Imm(reg, op.operand & 0xFF);
+	else
+	{
+		if (!Emit_Address(op, pending, true, true))
+			return false;
+		x64.Load_Byte_Index(reg, mem_base, mem_index);
+	} // end else
+
+	Emit_NZ(reg);
+	pending += CPU6502::lookup[op.opcode].cycles;
+	return true;
+} // end Emit_Load
+
+
+//=====================================================================|
+/**
+ * @brief STA, STX and STY.
+ */
+bool JitX64::Emit_Store(const Decoded_Op& op, const u8 reg, u32& pending)
+{
+	if (!Emit_Address(op, pending, false, false))
+		return false;
+
+	pending += CPU6502::lookup[op.opcode].cycles;
+	Emit_Flush(pending);
+	Emit_Write(reg, op.next_pc);
+	return true;
+} // end Emit_Store
+
+
+//=====================================================================|
+/**
+ * @brief CMP, CPX and CPY.
+ */
+bool JitX64::Emit_Compare(const Decoded_Op& op, const u8 reg, u32& pending)
+{
+	if (CPU6502::lookup[op.opcode].mode == CPU6502::AM_IMM)
+		x64.Mov_Imm(X64Emitter::RAX, op.operand & 0xFF);
+	else
+	{
+		if (!Emit_Address(op, pending, true, true))
+			return false;
+		x64.Load_Byte_Index(X64Emitter::RAX, mem_base, mem_index);
+	} // end else
+
+	// C is reg >= operand, which is no borrow out of the subtraction
+	x64.Mov(X64Emitter::RCX, reg);
+	x64.Alu(X64Emitter::ALU_SUB, X64Emitter::RCX, X64Emitter::RAX);
+	x64.Setcc(X64Emitter::CC_AE, X64Emitter::RDX);
+	x64.Store_Byte(REG_CPU, off_c, X64Emitter::RDX);
+
+	x64.Movzx8(X64Emitter::RCX, X64Emitter::RCX);
+	Emit_NZ(X64Emitter::RCX);
+	pending += CPU6502::lookup[op.opcode].cycles;
+	return true;
+} // end Emit_Compare
+
+
+//=====================================================================|
+/**
+ * @brief BIT; N and V straight from the operand, Z from a & operand.
+ */
+bool JitX64::Emit_Bit(const Decoded_Op& op, u32& pending)
+{
+	if (!Emit_Address(op, pending, false, true))
+		return false;
+	x64.Load_Byte_Index(X64Emitter::RAX, mem_base, mem_index);
+
+	x64.Store_Byte(REG_CPU, off_n, X64Emitter::RAX);
+	x64.Mov(X64Emitter::RCX, X64Emitter::RAX);
+	x64.Alu_Imm(X64Emitter::ALU_AND, X64Emitter::RCX, V);
+	x64.Store_Byte(REG_CPU, off_v, X64Emitter::RCX);
+
+	x64.Alu(X64Emitter::ALU_AND, X64Emitter::RAX, REG_A);
+	x64.Store_Byte(REG_CPU, off_z, X64Emitter::RAX);
+
+	pending += CPU6502::lookup[op.opcode].cycles;
+	return true;
+} // end Emit_Bit
+
+
+//=====================================================================|
+/**
+ * @brief INC and DEC on memory.
+ */
+bool JitX64::Emit_Step(const Decoded_Op& op, const bool up, u32& pending)
+{
+	if (!Emit_Address(op, pending, false, true))
+		return false;
+
+	x64.Load_Byte_Index(X64Emitter::RCX, mem_base, mem_index);
+	if (up)
+		x64.Inc(X64Emitter::RCX);
+	else
+		x64.Dec(X64Emitter::RCX);
+	x64.Movzx8(X64Emitter::RCX, X64Emitter::RCX);
+	Emit_NZ(X64Emitter::RCX);
+
+	pending += CPU6502::lookup[op.opcode].cycles;
+	Emit_Flush(pending);
+	Emit_Write(X64Emitter::RCX, op.next_pc);
+	return true;
+} // end Emit_Step
+
+
+//=====================================================================|
+/**
+ * @brief Leaves for target, or when the block jumps back to its own start
+ *	goes round again for as long as another pass still fits the target.
+ */
+void JitX64::Emit_Goto(const u16 target, const u32 pending)
+{
+	if (target == block_start)
+	{
+		x64.Add64_Mem_Imm(REG_CPU, off_total, (s32)pending);
+		x64.Load64(X64Emitter::RAX, REG_CPU, off_total);
+		x64.Cmp64_Reg_Mem(X64Emitter::RAX, X64Emitter::RSP, LOOP_LIMIT);
+		x64.Jcc_To(X64Emitter::CC_BE, loop_top);
+		Emit_Exit(target, 0, EXIT_NORMAL);
+	} // end if self loop
+	else
+		Emit_Exit(target, pending, EXIT_NORMAL);
+} // end Emit_Goto
+
+
+//=====================================================================|
+/**
+ * @brief The eight conditional branches, always the last op of a block.
+ *	Both ways out are known at compile time, page crossing cycle and all.
+ *
+ * @param pending the cycles run including the branch's own two
+ */
+void JitX64::Emit_Branch(const Decoded_Op& op, const u32 pending)
+{
+	// opcode bits 7-6 pick the flag, bit 5 whether it has to be set; 
+	//	Z is the odd one out, being set when its byte is zero
+	const s32 offs[4] = { off_n, off_v, off_c, off_z };
+	static const u8 masks[4] = { N, 0xFF, 0xFF, 0xFF };
+	const u8 flag = op.opcode >> 6;
+	const bool if_nonzero = ((op.opcode & 0x20) != 0) != (flag == 3);
+
+	const u16 target = op.next_pc + op.operand;
+	const u32 extra = 1 + ((target & 0xFF00) != (op.next_pc & 0xFF00));
+
+	x64.Load_Byte(X64Emitter::RCX, REG_CPU, offs[flag]);
+	x64.Test_Imm(X64Emitter::RCX, masks[flag]);
+	size_t not_taken = x64.Jcc(if_nonzero ? X64Emitter::CC_E : X64Emitter::CC_NE);
+	Emit_Goto(target, pending + extra);
+
+	x64.Patch(not_taken);
+	Emit_Exit(op.next_pc, pending, EXIT_NORMAL);
+} // end Emit_Branch
+
+
+//=====================================================================|
+/**
+ * @brief Calls the block engine's handler for an op the recompiler does
+ *	not emit itself. The registers go back to the CPU6502 for the call and
+ *	are picked up again after; the handler has set pc.
+ */
+void JitX64::Emit_Handler(const Decoded_Op& op, const Decoded_Op* data, u32& pending)
+{
+	Emit_Flush(pending);
+
+	x64.Store_Byte(REG_CPU, off_a, REG_A);
+	x64.Store_Byte(REG_CPU, off_x, REG_X);
+	x64.Store_Byte(REG_CPU, off_y, REG_Y);
+
+	x64.Mov64(ARG0, REG_CPU);
+	x64.Mov64_Imm(ARG1, reinterpret_cast<u64>(data));
+	x64.Mov64_Imm(X64Emitter::RAX, reinterpret_cast<u64>(&JitX64::Handler_Helper));
+	x64.Call(X64Emitter::RAX);
+
+	x64.Load_Byte(REG_A, REG_CPU, off_a);
+	x64.Load_Byte(REG_X, REG_CPU, off_x);
+	x64.Load_Byte(REG_Y, REG_CPU, off_y);
+
+	if (CPU6502::Ends_Block(op.opcode))
+		Emit_Exit(-1, 0, EXIT_NORMAL);
+	else
+	{
+		x64.Alu_Imm(X64Emitter::ALU_CMP, X64Emitter::RAX, 0);
+		size_t ok = x64.Jcc(X64Emitter::CC_E);
+		Emit_Exit(-1, 0, EXIT_NORMAL);
+		x64.Patch(ok);
+	} // end else
+} // end Emit_Handler
+
+
+//=====================================================================|
+/**
+ * @brief Emits an op natively if it is one of those the recompiler knows.
+ *	The ones it does not are those that touch the stack or jump through
+ *	it, the indirect modes, and the ALU ops (ADC, SBC, AND, ORA, EOR, ROL,
+ *	ROR and the memory shifts) whose exact flag behaviour lives in the
+ *	interpreter.
+ *
+ * @param op the instruction
+ * @param pending cycles run since last added up; grows by this op's cost
+ *
+ * @return false when the op has to go to its handler
+ */
+bool JitX64::Emit_Native(const Decoded_Op& op, u32& pending)
+{
+	const u8 cycles = CPU6502::lookup[op.opcode].cycles;
+
+	switch (op.opcode)
+	{
+	case 0xA9: case 0xA5: case 0xB5: case 0xAD: case 0xBD: case 0xB9:
+		return Emit_Load(op, REG_A, pending);
+	case 0xA2: case 0xA6: case 0xB6: case 0xAE: case 0xBE:
+		return Emit_Load(op, REG_X, pending);
+	case 0xA0: case 0xA4: case 0xB4: case 0xAC: case 0xBC:
+		return Emit_Load(op, REG_Y, pending);
+
+	case 0x85: case 0x95: case 0x8D: case 0x9D: case 0x99:
+		return Emit_Store(op, REG_A, pending);
+	case 0x86: case 0x96: case 0x8E:
+		return Emit_Store(op, REG_X, pending);
+	case 0x84: case 0x94: case 0x8C:
+		return Emit_Store(op, REG_Y, pending);
+
+	case 0xC9: case 0xC5: case 0xD5: case 0xCD: case 0xDD: case 0xD9:
+		return Emit_Compare(op, REG_A, pending);
+	case 0xE0: case 0xE4: case 0xEC:
+		return Emit_Compare(op, REG_X, pending);
+	case 0xC0: case 0xC4: case 0xCC:
+		return Emit_Compare(op, REG_Y, pending);
+
+	case 0x24: case 0x2C:
+		return Emit_Bit(op, pending);
+
+	case 0xE6: case 0xF6: case 0xEE: case 0xFE:
+		return Emit_Step(op, true, pending);
+	case 0xC6: case 0xD6: case 0xCE: case 0xDE:
+		return Emit_Step(op, false, pending);
+
+	case 0xE8: case 0xCA: case 0xC8: case 0x88:		// INX DEX INY DEY
+	{
+		const u8 reg = (op.opcode == 0xE8 || op.opcode == 0xCA) ? REG_X : REG_Y;
+		if (op.opcode == 0xE8 || op.opcode == 0xC8)
+			x64.Inc(reg);
+		else
+			x64.Dec(reg);
+		x64.Movzx8(reg, reg);
+		Emit_NZ(reg);
+		break;
+	} // end case register steps
+
+	case 0xAA: x64.Mov(REG_X, REG_A); Emit_NZ(REG_X); break;	// TAX
+	case 0xA8: x64.Mov(REG_Y, REG_A); Emit_NZ(REG_Y); break;	// TAY
+	case 0x8A: x64.Mov(REG_A, REG_X); Emit_NZ(REG_A); break;	// TXA
+	case 0x98: x64.Mov(REG_A, REG_Y); Emit_NZ(REG_A); break;	// TYA
+	case 0xBA: x64.Load_Byte(REG_X, REG_CPU, off_sp); Emit_NZ(REG_X); break;	// TSX
+	case 0x9A: x64.Store_Byte(REG_CPU, off_sp, REG_X); break;	// TXS
+
+	case 0x18: x64.Store_Byte_Imm(REG_CPU, off_c, 0); break;	// CLC
+	case 0x38: x64.Store_Byte_Imm(REG_CPU, off_c, 1); break;	// SEC
+	case 0xB8: x64.Store_Byte_Imm(REG_CPU, off_v, 0); break;	// CLV
+	case 0x58: x64.Alu_Byte_Mem_Imm(X64Emitter::ALU_AND, REG_CPU, off_status, ~I & 0xFF); break;	// CLI
+	case 0x78: x64.Alu_Byte_Mem_Imm(X64Emitter::ALU_OR, REG_CPU, off_status, I); break;			// SEI
+	case 0xD8: x64.Alu_Byte_Mem_Imm(X64Emitter::ALU_AND, REG_CPU, off_status, ~D & 0xFF); break;	// CLD
+	case 0xF8: x64.Alu_Byte_Mem_Imm(X64Emitter::ALU_OR, REG_CPU, off_status, D); break;			// SED
+
+	case 0x0A:	// ASL A; C takes bit 7
+		x64.Mov(X64Emitter::RCX, REG_A);
+		x64.Shr(X64Emitter::RCX, 7);
+		x64.Store_Byte(REG_CPU, off_c, X64Emitter::RCX);
+		x64.Shl(REG_A, 1);
+		x64.Movzx8(REG_A, REG_A);
+		Emit_NZ(REG_A);
+		break;
+
+	case 0x4A:	// LSR A; C takes bit 0
+		x64.Mov(X64Emitter::RCX, REG_A);
+		x64.Alu_Imm(X64Emitter::ALU_AND, X64Emitter::RCX, C);
+		x64.Store_Byte(REG_CPU, off_c, X64Emitter::RCX);
+		x64.Shr(REG_A, 1);
+		Emit_NZ(REG_A);
+		break;
+
+	case 0xEA:	// NOP
+		break;
+
+	case 0x10: case 0x30: case 0x50: case 0x70:
+	case 0x90: case 0xB0: case 0xD0: case 0xF0:
+		Emit_Branch(op, pending + cycles);
+		return true;
+
+	case 0x4C:	// JMP abs
+		Emit_Goto(op.operand, pending + cycles);
+		return true;
+
+	default:
+		return false;
+	} // end switch
+
+	pending += cycles;
+	return true;
+} // end Emit_Native
+
+
+//=====================================================================|
+/**
+ * @brief What a native store calls; the write goes through the bus like
+ *	any other so the block cache sees it.
+ *
+ * @return non zero when the write threw away code, the running block included
+ */
+u32 JitX64::Write_Helper(CPU6502* cpu, u32 addr, u32 data)
+{
+	cpu->Write((u16)addr, (u8)data);
+	return cpu->blocks->Was_Invalidated();
+} // end Write_Helper
+
+
+//=====================================================================|
+/**
+ * @brief What native code calls for an op it leaves to the block engine.
+ *	Always the plain handler for the opcode, never a fused one; the
+ *	recompiler has its own ideas about the op that follows.
+ *
+ * @return non zero when the op threw away code, the running block included
+ */
+u32 JitX64::Handler_Helper(CPU6502* cpu, const Decoded_Op* op)
+{
+	CPU6502::decoded_handlers[op->opcode](*cpu, *op);
+	cpu->total_cycles += cpu->cycles;
+	cpu->cycles = 0;
+	return cpu->blocks->Was_Invalidated();
+} // end Handler_Helper
@@ -0,0 +1,218 @@
+/**
+ * @brief A dynamic recompiler for the 6502; hot basic blocks out of the
+ *	block cache get translated into x86-64 machine code by a little in-tree
+ *	emitter, no assembler library needed.
+ *
+ *	Inside a block the 6502 registers live in host registers that every
+ *	x86-64 ABI keeps across calls (rbx, rbp and r12-r15), so calling back
+ *	into C++ costs no spills:
+ *		rbx: the CPU6502		rbp: the NES ram		r15: the NES page table
+ *		r12: a		r13: x		r14: y
+ *	The flags stay in the CPU6502, where an op sets them with a plain byte
+ *	store the same way the interpreter does.
+ *
+ *	Loads, stores, compares, increments, transfers, flag ops, branches and
+ *	jumps are emitted natively. Everything else calls back into the block
+ *	engine's handler for that opcode, so the recompiled code behaves exactly
+ *	like the interpreter does. Cycles are counted per block, and a block
+ *	that touches I/O space ($2000-$401F) bails out to the interpreter for
+ *	that instruction. Zero page and other fixed RAM addresses load straight
+ *	out of the RAM; anything else looks its page up first, since a mapper
+ *	may move it, and bails out as well when the page is a device's.
+ *
+ * @author Rediet Worku
+ * @date 26th of October 2021, Sunday
+ */
+#pragma once
+
+
+//=====================================================================|
+#include "basics.hpp"
+#include "block-cache.hpp"
+
+
+// the recompiler only speaks x86-64; everyone else runs the block engine
+#ifndef NEST_JIT
+#if defined(__x86_64__) || defined(_M_X64)
+#define NEST_JIT 1
+#else
+#define NEST_JIT 0
+#endif
+#endif
+
+
+
+//=====================================================================|
+/**
+ * the bits of x86-64 the recompiler needs, written straight into a buffer
+ */
+class X64Emitter
+{
+public:
+
+	// register numbers as the encoding has them
+	enum REG : u8
+	{
+		RAX, RCX, RDX, RBX, RSP, RBP, RSI, RDI,
+		R8, R9, R10, R11, R12, R13, R14, R15
+	};
+
+	// condition codes for Jcc/SETcc
+	enum COND : u8
+	{
+		CC_B = 0x2, CC_AE = 0x3, CC_E = 0x4, CC_NE = 0x5, CC_BE = 0x6, CC_A = 0x7
+	};
+
+	// group 1 ALU operations; /digit for the immediate forms
+	enum ALU : u8
+	{
+		ALU_ADD = 0, ALU_OR = 1, ALU_ADC = 2, ALU_SBB = 3,
+		ALU_AND = 4, ALU_SUB = 5, ALU_XOR = 6, ALU_CMP = 7
+	};
+
+	void Reset(u8* at, const size_t size) { buf = at; pos = 0; limit = size; }
+	size_t Here() const { return pos; }
+	u8* Address(const size_t at) const { return buf + at; }
+
+	// 32-bit register forms
+	void Mov(const u8 dst, const u8 src);
+	void Mov_Imm(const u8 dst, const u32 imm);
+	void Alu(const u8 op, const u8 dst, const u8 src);
+	void Alu_Imm(const u8 op, const u8 dst, const s32 imm);
+	void Test_Imm(const u8 dst, const u32 imm);
+	void Lea(const u8 dst, const u8 base, const s32 disp);
+	void Movzx8(const u8 dst, const u8 src);
+	void Movzx16(const u8 dst, const u8 src);
+	void Shl(const u8 dst, const u8 imm);
+	void Shr(const u8 dst, const u8 imm);
+	void Inc(const u8 dst);
+	void Dec(const u8 dst);
+	void Setcc(const u8 cc, const u8 dst);
+
+	// memory forms
+	void Load_Byte(const u8 dst, const u8 base, const s32 disp);
+	void Load_Byte_Index(const u8 dst, const u8 base, const u8 index);
+	void Store_Byte(const u8 base, const s32 disp, const u8 src);
+	void Store_Byte_Imm(const u8 base, const s32 disp, const u8 imm);
+	void Store_Word_Imm(const u8 base, const s32 disp, const u16 imm);
+	void Alu_Byte_Mem_Imm(const u8 op, const u8 base, const s32 disp, const u8 imm);
+
+	// 64-bit forms
+	void Mov64(const u8 dst, const u8 src);
+	void Mov64_Imm(const u8 dst, const u64 imm);
+	void Load64(const u8 dst, const u8 base, const s32 disp);
+	void Load64_Index(const u8 dst, const u8 base, const u8 index);
+	void Store64(const u8 base, const s32 disp, const u8 src);
+	void Add64_Mem_Imm(const u8 base, const s32 disp, const s32 imm);
+	void Add64_Mem_Reg(const u8 base, const s32 disp, const u8 src);
+	void Cmp64_Reg_Mem(const u8 reg, const u8 base, const s32 disp);
+	void Test64(const u8 dst, const u8 src);
+	void Sub_Rsp(const u8 imm);
+	void Add_Rsp(const u8 imm);
+
+	// control flow
+	void Push(const u8 reg);
+	void Pop(const u8 reg);
+	void Call(const u8 reg);
+	void Ret();
+	size_t Jcc(const u8 cc);
+	size_t Jmp();
+	void Jcc_To(const u8 cc, const size_t target);
+	void Patch(const size_t at);
+
+private:
+
+	u8* buf = nullptr;
+	size_t pos = 0;
+	size_t limit = 0;
+
+	void Emit8(const u8 b) { if (pos < limit) buf[pos] = b; ++pos; }
+	void Emit16(const u16 w) { Emit8(w & 0xFF); Emit8(w >> 8); }
+	void Emit32(const u32 d) { Emit16(d & 0xFFFF); Emit16(d >> 16); }
+	void Emit64(const u64 q) { Emit32(q & 0xFFFFFFFF); Emit32(q >> 32); }
+
+	void Rex(const bool w, const u8 reg, const u8 index, const u8 base, const bool force = false);
+	void Reg_Reg(const u8 reg, const u8 rm);
+	void Mem(const u8 reg, const u8 base, const s32 disp);
+};
+
+
+
+//=====================================================================|
+class CPU6502;
+
+class JitX64
+{
+public:
+
+	static constexpr size_t CODE_SIZE = 4 << 20;		// executable memory
+	static constexpr size_t MAX_BLOCK_BYTES = 16384;	// worst case for one block
+	static constexpr u16 HOT_THRESHOLD = 8;			// runs before a block is compiled
+
+	// what a native block returns
+	enum EXIT : u32
+	{
+		EXIT_NORMAL = 0,	// pc is set, carry on
+		EXIT_BAIL = 1,		// pc is an I/O access the interpreter must run
+	};
+
+	JitX64(CPU6502& c);
+	~JitX64();
+
+	JitX64(const JitX64&) = delete;
+	JitX64& operator=(const JitX64&) = delete;
+
+	bool Is_Available() const { return code != nullptr; }
+	bool Is_Full() const { return CODE_SIZE - code_used < MAX_BLOCK_BYTES; }
+	void Reset() { code_used = 0; }
+
+	bool Compile(Code_Block& blk, const Decoded_Op* ops);
+	u32 Run(const Code_Block& blk, const u64 target_cycle);
+
+private:
+
+	typedef u32(*Native_Fn)(CPU6502* cpu, u8* ram, u64 loop_limit);
+
+	CPU6502& cpu;
+	X64Emitter x64;
+
+	u8* code;			// the executable buffer
+	size_t code_used;	// bytes handed out so far
+
+	// where the CPU6502 keeps what the native code touches
+	s32 off_a, off_x, off_y, off_sp, off_status, off_pc, off_total;
+	s32 off_n, off_z, off_c, off_v;
+
+	// per compile state
+	u16 block_start;
+	size_t loop_top;
+	std::vector<size_t> exits;
+	u8 mem_base, mem_index;		// where Emit_Address left a load's operand
+
+	static bool Is_IO(const u16 addr) { return addr >= 0x2000 && addr <= 0x401F; }
+
+	// instruction emitters; each returns false, having emitted nothing,
+	//	when the op has to go to its handler instead
+	bool Emit_Native(const Decoded_Op& op, u32& pending);
+	bool Emit_Load(const Decoded_Op& op, const u8 reg, u32& pending);
+	bool Emit_Store(const Decoded_Op& op, const u8 reg, u32& pending);
+	bool Emit_Compare(const Decoded_Op& op, const u8 reg, u32& pending);
+	bool Emit_Bit(const Decoded_Op& op, u32& pending);
+	bool Emit_Step(const Decoded_Op& op, const bool up, u32& pending);
+	void Emit_Handler(const Decoded_Op& op, const Decoded_Op* data, u32& pending);
+
+	// the pieces they are built from
+	bool Emit_Address(const Decoded_Op& op, const u32 pending, const bool penalty, const bool load);
+	void Emit_Page(const u16 here, const u32 pending);
+	void Emit_Write(const u8 value, const u16 next_pc);
+	void Emit_NZ(const u8 reg);
+	void Emit_Branch(const Decoded_Op& op, const u32 pending);
+	void Emit_Goto(const u16 target, const u32 pending);
+	void Emit_Exit(const s32 pc, const u32 pending, const u32 status);
+	void Emit_Flush(u32& pending);
+	void Emit_Prologue();
+	void Emit_Epilogue();
+
+	static u32 Write_Helper(CPU6502* cpu, u32 addr, u32 data);
+	static u32 Handler_Helper(CPU6502* cpu, const Decoded_Op* op);
+};
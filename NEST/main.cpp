@@ -9,6 +9,8 @@
 //=====================================================================|
 #include "NEST.hpp"
 
+#include <cstdio>
+
 
 
 //=====================================================================|
@@ -16,18 +18,28 @@ int main(int argc, char* argv[])
 {
 	NEST NEST;
 
+	// the ROM goes in first so the debug views start out showing it
+	if (argc > 1 && !NEST.Load_ROM(argv[1]))
+	{
+		fprintf(stderr, "NEST: %s\n", NEST.Get_Error_Message().c_str());
+		return 1;
+	} // end if
+
 	if (!NEST.Init("NEST"))
 		return 1;
 
+	// the console runs on a thread of its own from here on; this one takes
+	//	the input and presents each frame as it comes out, and waits a bit
+	//	when there is none yet
+	NEST.Start();
 	while (NEST.Is_Running())
 	{
-		if (NEST.Is_Paused())
-			continue;
-
-		NEST.Render();
-		NEST.Update();
 		NEST.Handle_Events();
+
+		if (!NEST.Render())
+			SDL_Delay(1);
 	} // end while 
 
+	NEST.Stop();
 	return 0;
 } // end main
\ No newline at end of file
@@ -0,0 +1,438 @@
+/**
+ * @brief The implementation of the mappers.
+ *
+ * @author Rediet Worku
+ * @date 26th of October 2021, Sunday
+ */
+
+//=====================================================================|
+#include "mapper.hpp"
+#include "nes.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+
+
+//=====================================================================|
+// Mapper
+//=====================================================================|
+/**
+ * constructor; CHR starts out as the first 8KB, or the board's RAM
+ */
+Mapper::Mapper(NES& n, const Cartridge& c)
+	: nes(n), cart(c), mirroring(c.Get_Mirroring()), irq_pending(false)
+{
+	if (cart.Has_Chr_Ram())
+	{
+		chr_ram.assign(8192, 0);
+		chr_base = chr_ram.data();
+		chr_size = (u32)chr_ram.size();
+	} // end if RAM
+	else
+	{
+		chr_base = cart.Chr().data;
+		chr_size = cart.Chr().size;
+	} // end else ROM
+
+	tiles.Build(chr_base, chr_size, !chr_ram.empty());
+	Map_Chr(0x0000, 8192, 0);
+} // end constructor
+
+
+//=====================================================================|
+/**
+ * @brief Puts PRG bank number bank of size bytes at addr; a negative bank
+ *	counts from the end, -1 being the last one. A bank bigger than all of
+ *	PRG, MMC1's 32KB mode on a 16KB game say, repeats it across the window.
+ */
+void Mapper::Map_Prg(const u16 addr, const u32 size, const s32 bank)
+{
+	const Rom_Span& prg = cart.Prg();
+	const s32 count = prg.size > size ? (s32)(prg.size / size) : 1;
+	const u32 index = bank < 0 ? (u32)(count + bank) : (u32)bank;
+
+	nes.Map_ROM(addr >> 8, size >> 8, prg.Bank(index, size), std::min(size, prg.size));
+} // end Map_Prg
+
+
+//=====================================================================|
+/**
+ * @brief Puts CHR bank number bank of size bytes (a multiple of 1KB) at
+ *	addr in the PPU's pattern tables.
+ */
+void Mapper::Map_Chr(const u16 addr, const u32 size, const s32 bank)
+{
+	const s32 count = (s32)(chr_size / size);
+	const u32 index = bank < 0 ? (u32)(count + bank) : (u32)bank;
+	const size_t offset = ((size_t)index * size) % chr_size;
+
+	for (u32 k = 0; k < (size >> 10); ++k)
+		chr[((addr >> 10) + k) & 7] = chr_base + ((offset + (k << 10)) % chr_size);
+} // end Map_Chr
+
+
+//=====================================================================|
+/**
+ * @brief CHR RAM takes the write, and its tile has to be decoded again;
+ *	CHR ROM ignores it.
+ */
+void Mapper::Write_Chr(const u16 addr, const u8 data)
+{
+	if (chr_ram.empty())
+		return;
+
+	const u32 offset = (u32)(chr[(addr >> 10) & 7] - chr_base) + (addr & 0x3FF);
+	chr_ram[offset] = data;
+	tiles.Mark_Dirty(offset);
+} // end Write_Chr
+
+
+
+//=====================================================================|
+// NROM, mapper 0
+//=====================================================================|
+class NROM : public Mapper
+{
+public:
+
+	NROM(NES& n, const Cartridge& c) : Mapper(n, c) {}
+
+	const char* Name() const override { return "NROM"; }
+
+	// 16KB boards show the one bank twice
+	void Reset() override
+	{
+		Map_Prg(0x8000, 16384, 0);
+		Map_Prg(0xC000, 16384, -1);
+	} // end Reset
+
+	void Write(const u16, const u8) override {}
+};
+
+
+
+//=====================================================================|
+// MMC1, mapper 1
+//=====================================================================|
+/**
+ * Registers are written a bit at a time, LSB first, through a shift
+ *	register; the fifth write lands the value in the register picked by
+ *	bits 13-14 of its address. A write with bit 7 set starts over.
+ */
+class MMC1 : public Mapper
+{
+public:
+
+	MMC1(NES& n, const Cartridge& c) : Mapper(n, c) {}
+
+	const char* Name() const override { return "MMC1"; }
+	void Reset() override;
+	void Write(const u16 addr, const u8 data) override;
+
+private:
+
+	u8 shift = 0x10;		// the 1 falls out the bottom on the fifth write
+	u8 control = 0x0C;		// mirroring, PRG mode, CHR mode
+	u8 chr_bank0 = 0, chr_bank1 = 0, prg_bank = 0;
+
+	void Update();
+};
+
+
+//=====================================================================|
+void MMC1::Reset()
+{
+	shift = 0x10;
+	control = 0x0C;		// last bank fixed at 0xC000
+	chr_bank0 = chr_bank1 = prg_bank = 0;
+	Update();
+} // end Reset
+
+
+//=====================================================================|
+void MMC1::Write(const u16 addr, const u8 data)
+{
+	if (data & 0x80)
+	{
+		shift = 0x10;
+		control |= 0x0C;
+		Update();
+		return;
+	} // end if reset
+
+	const bool full = shift & 1;
+	shift = (shift >> 1) | ((data & 1) << 4);
+	if (!full)
+		return;
+
+	switch ((addr >> 13) & 3)
+	{
+	case 0: control = shift; break;
+	case 1: chr_bank0 = shift; break;
+	case 2: chr_bank1 = shift; break;
+	case 3: prg_bank = shift & 0x0F; break;
+	} // end switch
+
+	shift = 0x10;
+	Update();
+} // end Write
+
+
+//=====================================================================|
+/**
+ * @brief Points the banks where the registers say. On the 512KB boards
+ *	(SUROM) bit 4 of the CHR bank picks which 256KB half PRG comes from.
+ */
+void MMC1::Update()
+{
+	static const Mirroring mirrorings[4] = {
+		Mirroring::Single_Lower, Mirroring::Single_Upper,
+		Mirroring::Vertical, Mirroring::Horizontal
+	};
+	mirroring = mirrorings[control & 3];
+
+	const s32 outer = cart.Prg().size > 262144 ? (chr_bank0 & 0x10) : 0;
+	switch ((control >> 2) & 3)
+	{
+	case 0:
+	case 1:
+		Map_Prg(0x8000, 32768, (outer | prg_bank) >> 1);
+		break;
+
+	case 2:
+		Map_Prg(0x8000, 16384, outer);
+		Map_Prg(0xC000, 16384, outer | prg_bank);
+		break;
+
+	case 3:
+		Map_Prg(0x8000, 16384, outer | prg_bank);
+		Map_Prg(0xC000, 16384, outer | 0x0F);
+		break;
+	} // end switch PRG mode
+
+	if (control & 0x10)
+	{
+		Map_Chr(0x0000, 4096, chr_bank0);
+		Map_Chr(0x1000, 4096, chr_bank1);
+	} // end if 4KB
+	else
+		Map_Chr(0x0000, 8192, chr_bank0 >> 1);
+} // end Update
+
+
+
+//=====================================================================|
+// UxROM, mapper 2
+//=====================================================================|
+class UxROM : public Mapper
+{
+public:
+
+	UxROM(NES& n, const Cartridge& c) : Mapper(n, c) {}
+
+	const char* Name() const override { return "UxROM"; }
+
+	void Reset() override
+	{
+		Map_Prg(0x8000, 16384, 0);
+		Map_Prg(0xC000, 16384, -1);
+	} // end Reset
+
+	void Write(const u16, const u8 data) override
+	{
+		Map_Prg(0x8000, 16384, data);
+	} // end Write
+};
+
+
+
+//=====================================================================|
+// CNROM, mapper 3
+//=====================================================================|
+class CNROM : public Mapper
+{
+public:
+
+	CNROM(NES& n, const Cartridge& c) : Mapper(n, c) {}
+
+	const char* Name() const override { return "CNROM"; }
+
+	void Reset() override
+	{
+		Map_Prg(0x8000, 16384, 0);
+		Map_Prg(0xC000, 16384, -1);
+		Map_Chr(0x0000, 8192, 0);
+	} // end Reset
+
+	void Write(const u16, const u8 data) override
+	{
+		Map_Chr(0x0000, 8192, data);
+	} // end Write
+};
+
+
+
+//=====================================================================|
+// MMC3, mapper 4
+//=====================================================================|
+/**
+ * Eight bank registers behind a select/data pair at 0x8000/0x8001; two
+ *	switchable 8KB PRG banks with the second to last bank fixed at either
+ *	0x8000 or 0xC000, two 2KB and four 1KB CHR banks with the halves
+ *	swappable, and a scanline counter that raises an IRQ when it runs out.
+ */
+class MMC3 : public Mapper
+{
+public:
+
+	MMC3(NES& n, const Cartridge& c) : Mapper(n, c) {}
+
+	const char* Name() const override { return "MMC3"; }
+	void Reset() override;
+	void Write(const u16 addr, const u8 data) override;
+	void Scanline() override;
+	u32 Lines_To_Irq() const override;
+
+private:
+
+	u8 select = 0;			// which register 0x8001 writes and the swap bits
+	u8 regs[8] = { 0, 2, 4, 5, 6, 7, 0, 1 };
+
+	u8 irq_latch = 0, irq_counter = 0;
+	bool irq_reload = false, irq_enabled = false;
+
+	void Update();
+};
+
+
+//=====================================================================|
+void MMC3::Reset()
+{
+	select = 0;
+	const u8 power_on[8] = { 0, 2, 4, 5, 6, 7, 0, 1 };
+	memcpy(regs, power_on, sizeof(regs));
+	irq_latch = irq_counter = 0;
+	irq_reload = irq_enabled = irq_pending = false;
+	Update();
+} // end Reset
+
+
+//=====================================================================|
+/**
+ * @brief The registers sit in pairs, even and odd addresses, every 8KB
+ *	from 0x8000.
+ */
+void MMC3::Write(const u16 addr, const u8 data)
+{
+	switch (addr & 0xE001)
+	{
+	case 0x8000:
+		{
+			// the register number alone doesn't move anything
+			const bool swap = ((select ^ data) & 0xC0) != 0;
+			select = data;
+			if (swap)
+				Update();
+		} // end case
+		break;
+	case 0x8001: regs[select & 7] = data; Update(); break;
+	case 0xA000:
+		if (cart.Get_Mirroring() != Mirroring::Four_Screen)
+			mirroring = (data & 1) ? Mirroring::Horizontal : Mirroring::Vertical;
+		break;
+	case 0xA001: break;		// PRG RAM protect; left always on
+	case 0xC000: irq_latch = data; break;
+	case 0xC001: irq_counter = 0; irq_reload = true; break;
+	case 0xE000: irq_enabled = false; irq_pending = false; break;
+	case 0xE001: irq_enabled = true; break;
+	} // end switch
+} // end Write
+
+
+//=====================================================================|
+/**
+ * @brief Clocks the IRQ counter; the PPU calls it once per scanline,
+ *	standing in for the rising edges of A12 the real chip counts.
+ */
+void MMC3::Scanline()
+{
+	if (irq_counter == 0 || irq_reload)
+	{
+		irq_counter = irq_latch;
+		irq_reload = false;
+	} // end if reload
+	else
+		--irq_counter;
+
+	if (irq_counter == 0 && irq_enabled)
+		irq_pending = true;
+} // end Scanline
+
+
+//=====================================================================|
+/**
+ * @brief What Scanline() does, counted ahead: a counter that is out or
+ *	told to reload takes the latch on the first line and runs out latch
+ *	lines later, at once for a latch of 0; any other counts itself down.
+ */
+u32 MMC3::Lines_To_Irq() const
+{
+	if (!irq_enabled)
+		return 0;
+
+	if (irq_counter == 0 || irq_reload)
+		return irq_latch + 1u;
+
+	return irq_counter;
+} // end Lines_To_Irq
+
+
+//=====================================================================|
+void MMC3::Update()
+{
+	// bit 6 swaps 0x8000 and 0xC000
+	if (select & 0x40)
+	{
+		Map_Prg(0x8000, 8192, -2);
+		Map_Prg(0xC000, 8192, regs[6] & 0x3F);
+	} // end if
+	else
+	{
+		Map_Prg(0x8000, 8192, regs[6] & 0x3F);
+		Map_Prg(0xC000, 8192, -2);
+	} // end else
+	Map_Prg(0xA000, 8192, regs[7] & 0x3F);
+	Map_Prg(0xE000, 8192, -1);
+
+	// bit 7 swaps the 2KB and 1KB halves
+	const u16 inv = (select & 0x80) ? 0x1000 : 0x0000;
+	Map_Chr(0x0000 ^ inv, 2048, regs[0] >> 1);
+	Map_Chr(0x0800 ^ inv, 2048, regs[1] >> 1);
+	Map_Chr(0x1000 ^ inv, 1024, regs[2]);
+	Map_Chr(0x1400 ^ inv, 1024, regs[3]);
+	Map_Chr(0x1800 ^ inv, 1024, regs[4]);
+	Map_Chr(0x1C00 ^ inv, 1024, regs[5]);
+} // end Update
+
+
+
+//=====================================================================|
+/**
+ * @brief Builds the mapper a cartridge's board needs.
+ *
+ * @return nullptr for a board that isn't supported
+ */
+std::unique_ptr<Mapper> Mapper::Create(NES& nes, const Cartridge& cart)
+{
+	switch (cart.Mapper())
+	{
+	case 0: return std::unique_ptr<Mapper>(new NROM(nes, cart));
+	case 1: return std::unique_ptr<Mapper>(new MMC1(nes, cart));
+	case 2: return std::unique_ptr<Mapper>(new UxROM(nes, cart));
+	case 3: return std::unique_ptr<Mapper>(new CNROM(nes, cart));
+	case 4: return std::unique_ptr<Mapper>(new MMC3(nes, cart));
+	} // end switch
+
+	return nullptr;
+} // end Create
@@ -0,0 +1,88 @@
+/**
+ * @brief The mappers; the chips on the cartridge board that decide which
+ *	bank of PRG ROM the CPU sees where, and which CHR the PPU sees. A bank
+ *	switch never copies anything, it just points the NES page table (and
+ *	the CHR windows) at another piece of the cartridge's mapping; the cost
+ *	is a pointer store per 256 byte page.
+ *
+ *	Every write to 0x8000 - 0xFFFF lands in Write, which is where the
+ *	boards differ. Supported so far:
+ *		0	NROM		no switching at all
+ *		1	MMC1		serial 5-bit registers; 16/32KB PRG, 4/8KB CHR
+ *		2	UxROM		16KB PRG at 0x8000, last bank fixed
+ *		3	CNROM		8KB CHR
+ *		4	MMC3		8KB PRG, 1/2KB CHR, scanline IRQ
+ *
+ * @author Rediet Worku
+ * @date 26th of October 2021, Sunday
+ */
+#pragma once
+
+
+//=====================================================================|
+#include "basics.hpp"
+#include "cartridge.hpp"
+#include "tile-cache.hpp"
+
+#include <memory>
+
+
+
+//=====================================================================|
+class NES;
+
+class Mapper
+{
+public:
+
+	static std::unique_ptr<Mapper> Create(NES& nes, const Cartridge& cart);
+	virtual ~Mapper() {}
+
+	Mapper(const Mapper&) = delete;
+	Mapper& operator=(const Mapper&) = delete;
+
+	virtual const char* Name() const = 0;
+	virtual void Reset() = 0;
+	virtual void Write(const u16 addr, const u8 data) = 0;
+
+	// the PPU side; called once every visible scanline, for the mappers
+	//	that count them
+	virtual void Scanline() {}
+	bool Irq_Pending() const { return irq_pending; }
+
+	// how many more Scanline() calls before the IRQ comes out, 0 for none
+	//	coming; the NES books the line that lands on rather than stopping
+	//	the CPU at every one
+	virtual u32 Lines_To_Irq() const { return 0; }
+
+	// the pattern tables through eight 1KB windows
+	u8 Read_Chr(const u16 addr) const { return chr[(addr >> 10) & 7][addr & 0x3FF]; }
+	void Write_Chr(const u16 addr, const u8 data);
+
+	// the same, decoded; the 8 pixels of the tile row whose low plane
+	//	byte is at addr
+	const u8* Tile_Row(const u16 addr, const bool flip)
+	{
+		return tiles.Row((u32)(chr[(addr >> 10) & 7] - chr_base) + (addr & 0x3FF), flip);
+	} // end Tile_Row
+
+	Mirroring Get_Mirroring() const { return mirroring; }
+
+protected:
+
+	Mapper(NES& nes, const Cartridge& cart);
+
+	NES& nes;
+	const Cartridge& cart;
+
+	const u8* chr[8];			// what the PPU sees at each 1KB of 0x0000 - 0x1FFF
+	std::vector<u8> chr_ram;	// boards without CHR ROM have 8KB of RAM there
+	const u8* chr_base;			// all of the CHR, ROM or RAM
+	u32 chr_size;
+	TileCache tiles;			// chr_base decoded
+	Mirroring mirroring;
+	bool irq_pending;
+
+	void Map_Prg(const u16 addr, const u32 size, const s32 bank);
+	void Map_Chr(const u16 addr, const u32 size, const s32 bank);
+};
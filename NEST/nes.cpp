@@ -12,12 +12,29 @@
 
 //=====================================================================|
 /**
- * @brief
+ * @brief Lays out the memory map; see the top of nes.hpp.
  */
 NES::NES()
 {
 	iZero(ram, RAM_SIZE);
+	iZero(prg_ram, PRG_RAM_SIZE);
+	iZero(prg_rom, PRG_ROM_SIZE);
+	iZero(apu_regs, sizeof(apu_regs));
+	iZero(dirty, sizeof(dirty));
+	iZero(dirty_pages, sizeof(dirty_pages));
+	iZero(page_bank, sizeof(page_bank));
+	track_writes = false;
+	snapshots = 0;
+
+	Map_RAM(0x00, 0x20, ram, RAM_SIZE);
+	Map_IO(0x20, 0x20, &NES::Read_PPU, &NES::Write_PPU);
+	Map_IO(0x40, 0x01, &NES::Read_APU, &NES::Write_APU);
+	Map_IO(0x41, 0x1F, &NES::Read_Open_Bus, nullptr);
+	Map_RAM(0x60, 0x20, prg_ram, PRG_RAM_SIZE);
+	Map_ROM(0x80, 0x80, prg_rom, PRG_ROM_SIZE);
+
 	cpu.Connect_NES(this);
+	ppu.Connect_NES(this);
 } // end NES
 
 
@@ -30,35 +47,345 @@ NES::~NES() { }
 
 //=====================================================================|
 /**
- * @brief writes an 8-bit data to the address specified. This function
- *	in a sense acts like a bus that connects all devices that are connected
- *	to NES.
- * 
- * @param address the 16-bit address
- * @param data the 8-bit value to write
+ * @brief Turns write tracking on or off; off by default, the debug views
+ *	turn it on. Turning it off forgets what was tracked.
+ */
+void NES::Track_Writes(const bool on)
+{
+	track_writes = on && NEST_TRACK_WRITES;
+	iZero(dirty, sizeof(dirty));
+	iZero(dirty_pages, sizeof(dirty_pages));
+} // end Track_Writes
+
+
+//=====================================================================|
+/**
+ * @brief Copies the CPU and the whole address space into snap, page by
+ *	page off the page table, along with the addresses written since the
+ *	last one and its number in sequence. Whatever snap held before is
+ *	gone, written bits and all; should nobody have looked at it, the next
+ *	snapshot seen doesn't follow the last one drawn and says so.
+ *
+ * @param snap where it goes
+ */
+void NES::Take_Snapshot(NES_Snapshot& snap)
+{
+	snap.sequence = ++snapshots;
+	snap.a = cpu.a;
+	snap.x = cpu.x;
+	snap.y = cpu.y;
+	snap.sp = cpu.sp;
+	snap.status = cpu.Get_Status();
+	snap.pc = cpu.pc;
+
+	for (u32 page = 0; page < 256; ++page)
+	{
+		if (pages[page].read)
+			memcpy(snap.memory + (page << 8), pages[page].read, 256);
+		else
+			memset(snap.memory + (page << 8), page, 256);
+	} // end for
+
+	iZero(snap.written, sizeof(snap.written));
+	Drain_Written([&snap](const u16 address)
+	{
+		snap.written[address >> 6] |= 1ull << (address & 63);
+	});
+} // end Take_Snapshot
+
+
+//=====================================================================|
+/**
+ * @brief Runs the console for one frame. The CPU runs in batches, each up
+ *	to the next event booked with the scheduler: the vblank line when it
+ *	raises the NMI, the line the mapper's counter runs out on, and the
+ *	pre-render line that ends the frame. The PPU catches up at the end of
+ *	each batch, or sooner when the CPU touches it, and whatever interrupt
+ *	that raised goes to the CPU. Three dots go to a CPU cycle, so the
+ *	89341.5 dots of an average frame are the 29780.5 cycles of one.
+ *
+ * @param draw false to skip the frame's pixels; the game can't tell
+ */
+void NES::Run_Frame(const bool draw)
+{
+	ppu.Skip_Pixels(!draw);
+
+	const u64 frame = ppu.Get_Frame();
+	while (ppu.Get_Frame() == frame)
+	{
+		Schedule_Events();
+		cpu.Run_Until(scheduler.Next());
+		ppu.Catch_Up(cpu.Get_Cycles());
+
+		if (ppu.Poll_NMI())
+			cpu.NMI();
+		if (mapper && mapper->Irq_Pending())
+			cpu.IRQ();
+	} // end while
+
+	// the pre-render line has run; its cycles are the frame's last
+	cpu.Run_Until(ppu.Get_Dots() / 3);
+} // end Run_Frame
+
+
+//=====================================================================|
+/**
+ * @brief Books what the PPU and the mapper have coming next. Called before
+ *	every batch, and in the middle of one by the writes that can move an
+ *	event, the PPUCTRL NMI bit, PPUMASK and the mapper's registers; should
+ *	that bring the next event closer the running batch stops there.
  */
-void NES::Write(const u16 address, const u8 data)
+void NES::Schedule_Events()
 {
-	if (address >= 0 && address <= 0xFFFF)
+	scheduler.Schedule(Scheduler::Event::Nmi, ppu.Next_NMI());
+	scheduler.Schedule(Scheduler::Event::Mapper_Irq, ppu.Next_Mapper_Irq());
+	scheduler.Schedule(Scheduler::Event::Frame_End, ppu.Line_Cycle(PPU::PRERENDER_SCANLINE));
+	cpu.Stop_At(scheduler.Next());
+} // end Schedule_Events
+
+
+//=====================================================================|
+/**
+ * @brief Loads the ROM at path and plugs it in: the board's mapper puts
+ *	its power on banks into the page table, right out of the cartridge's 
+ *	mapping, the trainer if any goes into PRG RAM at 0x7000, then the CPU
+ *	resets off the cartridge's vector.
+ *
+ * @param path the .nes file
+ *
+ * @return false when it won't load or its mapper isn't one we have; 
+ *	Get_Error_Message() says why
+ */
+bool NES::Insert_Cartridge(const std::string& path)
+{
+	error_string.clear();
+	mapper.reset();
+
+	if (!cart.Load(path))
 	{
-		ram[address] = data;
-		addr_written.push_back(address);
-	} // end if addr written to
-} // end Write
+		error_string = cart.Get_Error_Message();
+		Map_ROM(0x80, 0x80, prg_rom, PRG_ROM_SIZE);
+		return false;
+	} // end if
+
+	mapper = Mapper::Create(*this, cart);
+	if (!mapper)
+	{
+		error_string = "mapper " + std::to_string(cart.Mapper()) + " isn't supported";
+		cart.Unload();
+		Map_ROM(0x80, 0x80, prg_rom, PRG_ROM_SIZE);
+		return false;
+	} // end if
+
+	mapper->Reset();
+
+	iZero(prg_ram, PRG_RAM_SIZE);
+	if (cart.Trainer().size)
+		memcpy(prg_ram + 0x1000, cart.Trainer().data, cart.Trainer().size);
+
+	// a program to pick only in builds with some linked in; without, the
+	//	crc isn't worth going over all of PRG for
+	if (CPU6502::Has_Programs())
+		cpu.Select_Program(cart.Prg_Crc());
+	else
+		cpu.Select_Program(0);
+	cpu.Reset();
+	ppu.Reset();
+	scheduler.Reset();
+	return true;
+} // end Insert_Cartridge
 
 
 //=====================================================================|
 /**
- * brief reads the 16-bit address provided it's valid and returns the 
- *	8-bit value stored at that address. Togther the Read/Write functions
- *	form the heart of NES bus.
+ * @brief Puts memory behind a run of pages, repeating it as often as it
+ *	fits; the 2KB RAM fills its 8KB four times.
  *
- * @param address the 16-bit address to read data from
+ * @param first_page the high byte of the first address
+ * @param pages how many pages
+ * @param mem the memory, at least size bytes
+ * @param size how much of it there is, a multiple of 256
+ */
+void NES::Map_RAM(const u8 first_page, const u32 pages, u8* mem, const u32 size)
+{
+	u32 offset = 0;
+	for (u32 i = 0; i < pages; ++i)
+	{
+		Bus_Page& page = this->pages[(first_page + i) & 0xFF];
+		page.read = page.write = mem + offset;
+		offset = offset + 256 < size ? offset + 256 : 0;
+		page.read_io = nullptr;
+		page.write_io = nullptr;
+		page_bank[(first_page + i) & 0xFF] = 0;
+	} // end for
+
+	cpu.Note_Remap();
+} // end Map_RAM
+
+
+//=====================================================================|
+/**
+ * @brief Same as Map_RAM for memory that can't be written; writes to it
+ *	go to the mapper, or nowhere without one. A 16KB ROM fills 32KB twice.
+ *	This is all a bank switch is, a pointer store a page, so mappers call 
+ *	it as often as they like.
  */
-u8 NES::Read(const u16 address) const
+void NES::Map_ROM(const u8 first_page, const u32 pages, const u8* mem, const u32 size)
 {
-	if (address >= 0x0000 && address <= 0xFFFF)
-		return ram[address];
+	const Rom_Span& prg = cart.Prg();
+	u32 offset = 0;
+	for (u32 i = 0; i < pages; ++i)
+	{
+		Bus_Page& page = this->pages[(first_page + i) & 0xFF];
+		page.read = mem + offset;
+		offset = offset + 256 < size ? offset + 256 : 0;
+		page.write = nullptr;
+		page.read_io = nullptr;
+		page.write_io = mapper ? &NES::Write_Mapper : nullptr;
+
+		u16& bank = page_bank[(first_page + i) & 0xFF];
+		if (page.read >= prg.data && page.read < prg.data + prg.size)
+			bank = (u16)(1 + ((page.read - prg.data) >> 13));
+		else
+			bank = 0;
+	} // end for
 
-	return 0;
-} // end Read
\ No newline at end of file
+	cpu.Note_Remap();
+} // end Map_ROM
+
+
+//=====================================================================|
+/**
+ * @brief Hands every read and write of a run of pages to a device.
+ *
+ * @param first_page the high byte of the first address
+ * @param pages how many pages
+ * @param read_io answers the reads
+ * @param write_io takes the writes; nullptr drops them
+ */
+void NES::Map_IO(const u8 first_page, const u32 pages, Bus_Read read_io, Bus_Write write_io)
+{
+	for (u32 i = 0; i < pages; ++i)
+	{
+		Bus_Page& page = this->pages[(first_page + i) & 0xFF];
+		page.read = nullptr;
+		page.write = nullptr;
+		page.read_io = read_io;
+		page.write_io = write_io;
+		page_bank[(first_page + i) & 0xFF] = 0;
+	} // end for
+
+	cpu.Note_Remap();
+} // end Map_IO
+
+
+//=====================================================================|
+/**
+ * @brief Hands a read of a page without memory behind it to its device.
+ */
+u8 NES::Read_IO(const u16 address)
+{
+	return pages[address >> 8].read_io(*this, address);
+} // end Read_IO
+
+
+//=====================================================================|
+/**
+ * @brief Hands a write to a page's device; writes to ROM go nowhere.
+ */
+void NES::Write_IO(const u16 address, const u8 data)
+{
+	if (Bus_Write write_io = pages[address >> 8].write_io)
+		write_io(*this, address, data);
+} // end Write_IO
+
+
+//=====================================================================|
+/**
+ * @brief The eight PPU registers, repeated every 8 bytes up to 0x3FFF.
+ */
+u8 NES::Read_PPU(NES& nes, const u16 addr)
+{
+	// a PPUSTATUS poll only needs the lines run once its flags change
+	if ((addr & 0x07) != 2 || nes.cpu.Get_Bus_Cycle() >= nes.ppu.Next_Status_Change())
+		nes.Sync_PPU();
+
+	return nes.ppu.Read_Register(addr);
+} // end Read_PPU
+
+
+//=====================================================================|
+void NES::Write_PPU(NES& nes, const u16 addr, const u8 data)
+{
+	nes.Sync_PPU();
+	nes.ppu.Write_Register(addr, data);
+
+	// PPUCTRL has the NMI bit, PPUMASK whether the mapper's lines count
+	if ((addr & 0x07) < 2)
+		nes.Schedule_Events();
+} // end Write_PPU
+
+
+//=====================================================================|
+/**
+ * @brief 0x4000 - 0x401F; the rest of the page belongs to the cartridge.
+ */
+u8 NES::Read_APU(NES& nes, const u16 addr)
+{
+	if (addr >= 0x4020)
+		return Read_Open_Bus(nes, addr);
+
+	return nes.apu_regs[addr & 0x1F];
+} // end Read_APU
+
+
+//=====================================================================|
+void NES::Write_APU(NES& nes, const u16 addr, const u8 data)
+{
+	if (addr == 0x4014)
+	{
+		// OAM DMA; the CPU stops for 513 cycles, 514 when it starts on an
+		//	odd one, while a page of its memory goes to the sprites. It
+		//	starts on the cycle after the write, which is the bus cycle and
+		//	not where the instruction began
+		nes.Sync_PPU();
+
+		u8 page[256];
+		for (u32 i = 0; i < 256; ++i)
+			page[i] = nes.Read((u16)(data << 8) | i);
+
+		nes.ppu.Write_OAM_DMA(page);
+		nes.cpu.Stall(513 + (nes.cpu.Get_Bus_Cycle() & 1));
+	} // end if
+
+	if (addr < 0x4020)
+		nes.apu_regs[addr & 0x1F] = data;
+} // end Write_APU
+
+
+//=====================================================================|
+/**
+ * @brief Nothing drives the bus, so the last byte on it is read back;
+ *	that's the high byte of the address more often than not, as it was
+ *	the last operand byte fetched.
+ */
+u8 NES::Read_Open_Bus(NES&, const u16 addr)
+{
+	return addr >> 8;
+} // end Read_Open_Bus
+
+
+//=====================================================================|
+/**
+ * @brief Writes to ROM are the mapper's registers. Plenty of them move
+ *	CHR or the mirroring, so the lines before the write are drawn first;
+ *	for the ones that don't the PPU only does sooner what it had to do
+ *	anyway.
+ */
+void NES::Write_Mapper(NES& nes, const u16 addr, const u8 data)
+{
+	nes.Sync_PPU();
+	nes.mapper->Write(addr, data);
+	nes.ppu.Forget_Prediction();
+	nes.Schedule_Events();
+} // end Write_Mapper
@@ -5,6 +5,20 @@
  *	NES conists of the following devices which we emulate:
  *		1. An 8-bit CPU with 16-bit address range, 6502 with Decimal mode disallowed
  *		2. A 2KB physical RAM that is mirrored every 8KB
+ *		3. The 2C02 PPU, run a scanline at a time and only when the CPU
+ *		   looks at it
+ *	The CPU runs from one event of the scheduler to the next, the vblank
+ *	NMI, the mapper's IRQ line or the end of the frame.
+ *
+ *	The CPU sees them all through a page table, one entry for each of the 256
+ *	pages of its address space:
+ *		0x0000 - 0x1FFF	the 2KB RAM, four times over
+ *		0x2000 - 0x3FFF	the eight PPU registers, mirrored all the way
+ *		0x4000 - 0x401F	APU and I/O registers
+ *		0x4020 - 0x5FFF	cartridge expansion, open bus unless a mapper says otherwise
+ *		0x6000 - 0x7FFF	8KB PRG RAM
+ *		0x8000 - 0xFFFF	PRG ROM, straight out of the cartridge's mapping; the
+ *						mapper moves its banks around and takes the writes
  *
  * @author Rediet Worku
  * @date 26th of October 2021, Sunday
@@ -15,11 +29,73 @@
 //=====================================================================|
 #include "basics.hpp"
 #include "cpu6502.hpp"
+#include "ppu.hpp"
+#include "cartridge.hpp"
+#include "mapper.hpp"
+#include "scheduler.hpp"
 
 
 
 //=====================================================================|
-constexpr u32 RAM_SIZE = 65'536;		// the size of NES RAM
+constexpr u32 RAM_SIZE = 2'048;			// the size of NES internal RAM
+constexpr u32 PRG_RAM_SIZE = 8'192;		// cartridge RAM at 0x6000
+constexpr u32 PRG_ROM_SIZE = 32'768;	// what's at 0x8000 with no cartridge in
+
+// NTSC timing; the 2C02 draws 262 scanlines of 341 dots at 3 dots per
+//	CPU cycle, which works out to 29780.5 CPU cycles every 60.0988 Hz frame
+constexpr u32 CPU_CLOCK_NTSC = 1'789'773;		// CPU cycles per second
+constexpr double FRAME_RATE_NTSC = 60.0988;		// frames per second
+constexpr double CPU_CYCLES_PER_FRAME = CPU_CLOCK_NTSC / FRAME_RATE_NTSC;
+
+// write tracking for the debug views; builds without a debugger can leave
+//	it out altogether, and even built in it costs a store only when on
+#ifndef NEST_TRACK_WRITES
+#define NEST_TRACK_WRITES 1
+#endif
+
+
+
+//=====================================================================|
+class NES;
+
+// a read or write a page hands to a device instead of memory
+typedef u8(*Bus_Read)(NES& nes, const u16 addr);
+typedef void(*Bus_Write)(NES& nes, const u16 addr, const u8 data);
+
+struct Bus_Page
+{
+	const u8* read;		// the page's 256 bytes when reading is plain memory
+	u8* write;			// same for writes; nullptr for ROM and I/O
+	Bus_Read read_io;	// answers a read when read is nullptr
+	Bus_Write write_io;	// takes a write when write is nullptr; nullptr drops it
+};
+
+
+
+//=====================================================================|
+/**
+ * @brief The console as the debug views see it, copied out whole between
+ *	frames so another thread can look at it while the next one runs: the
+ *	CPU's registers, all 64KB the way Peek reads them, and one bit for
+ *	every address written since the snapshot before it.
+ *
+ *	Snapshots are numbered as they're taken. A view that gets one whose
+ *	number isn't one past the last it drew missed the writes of those in
+ *	between, and has to redraw whatever it shows in full.
+ */
+struct NES_Snapshot
+{
+	u8 a, x, y, sp, status;
+	u16 pc;
+	u64 sequence;
+
+	u8 memory[65536];
+	u64 written[65536 / 64];
+
+	u8 Peek(const u16 address) const { return memory[address]; }
+	bool Follows(const u64 last) const { return sequence == last + 1; }
+	template <typename Fn> void Drain_Written(Fn&& fn);
+};
 
 
 
@@ -27,30 +103,206 @@ constexpr u32 RAM_SIZE = 65'536;		// the size of NES RAM
 class NES
 {
 public:
-	
-	// singleton accessor (only one nes console, makes sense, aye :)?
-	static NES* Instance()
-	{
-		static NES* pnes;
-		if (!pnes)
-			pnes = new NES();
-
-		return pnes;
-	} // end NES
 
+	// as many consoles as anyone cares to make, each on its own; none of
+	//	them can be copied or moved since the bus, CPU, PPU and mapper all
+	//	point into the console they sit in
+	NES();
 	~NES();
+	NES(const NES&) = delete;
+	NES& operator=(const NES&) = delete;
 
 	void Write(const u16 address, const u8 data);
-	u8 Read(const u16 address) const;
+	u8 Read(const u16 address);
+	u8 Peek(const u16 address) const;
+
+	void Run_Frame(const bool draw = true);
+
+	bool Insert_Cartridge(const std::string& path);
+	const Cartridge& Get_Cartridge() const { return cart; }
+	std::string Get_Error_Message() const { return error_string; }
+
+	void Map_RAM(const u8 first_page, const u32 pages, u8* mem, const u32 size);
+	void Map_ROM(const u8 first_page, const u32 pages, const u8* mem, const u32 size);
+	void Map_IO(const u8 first_page, const u32 pages, Bus_Read read_io, Bus_Write write_io);
+	const Bus_Page* Page_Table() const { return pages; }
+	bool Is_Memory(const u8 page) const { return pages[page].read != nullptr; }
+
+	// which 8KB of PRG ROM a page shows, plus one; 0 for everything that
+	//	isn't banked. Decoded blocks are filed under it along with the pc
+	u16 Bank_Of(const u8 page) const { return page_bank[page]; }
 
 	// connected devices
 	CPU6502 cpu;
+	PPU ppu;
 	u8 ram[RAM_SIZE];
+	u8 prg_ram[PRG_RAM_SIZE];
+	u8 prg_rom[PRG_ROM_SIZE];
+	Cartridge cart;
+	std::unique_ptr<Mapper> mapper;		// the cartridge's board; nullptr with none in
+	Scheduler scheduler;				// when the CPU next has to stop
 
-	// little helpers, records when bus is read and written from
-	std::vector<u16> addr_written;
+	// little helpers, records which addresses the bus wrote to since the
+	//	last time someone asked
+	void Track_Writes(const bool on);
+	template <typename Fn> void Drain_Written(Fn&& fn);
+	void Take_Snapshot(NES_Snapshot& snap);
 
 private:
 
-	NES();
-};
\ No newline at end of file
+	Bus_Page pages[256];	// the memory map, by the high byte of the address
+	u16 page_bank[256];		// Bank_Of each page; kept apart so a Bus_Page stays 32 bytes
+
+	// one bit per address written, and one per page with any bit set, so
+	//	draining only looks at the pages that saw a write
+	bool track_writes;
+	u64 dirty[65536 / 64];
+	u64 dirty_pages[256 / 64];
+	u64 snapshots;			// taken so far; numbers the next
+	void Mark_Written(const u16 address);
+
+	// the registers of devices not emulated yet; they hold what was last
+	//	written so a program reading one back sees something sane
+	u8 apu_regs[0x20];
+
+	// the slow half of Read and Write, kept out of line
+	u8 Read_IO(const u16 address);
+	void Write_IO(const u16 address, const u8 data);
+
+	// brings the PPU up to the bus access the CPU is making
+	void Sync_PPU() { ppu.Catch_Up(cpu.Get_Bus_Cycle()); }
+	void Schedule_Events();
+
+	static u8 Read_PPU(NES& nes, const u16 addr);
+	static void Write_PPU(NES& nes, const u16 addr, const u8 data);
+	static u8 Read_APU(NES& nes, const u16 addr);
+	static void Write_APU(NES& nes, const u16 addr, const u8 data);
+	static u8 Read_Open_Bus(NES& nes, const u16 addr);
+	static void Write_Mapper(NES& nes, const u16 addr, const u8 data);
+
+	std::string error_string;
+};
+
+
+
+//=====================================================================|
+/**
+ * @brief writes an 8-bit data to the address specified. This function
+ *	in a sense acts like a bus that connects all devices that are connected
+ *	to NES; memory pages take the byte directly, I/O pages hand it to
+ *	their device and ROM drops it.
+ * 
+ * @param address the 16-bit address
+ * @param data the 8-bit value to write
+ */
+inline void NES::Write(const u16 address, const u8 data)
+{
+	if (u8* mem = pages[address >> 8].write)
+		mem[address & 0xFF] = data;
+	else
+		Write_IO(address, data);
+
+#if NEST_TRACK_WRITES
+	if (track_writes)
+		Mark_Written(address);
+#endif
+} // end Write
+
+
+//=====================================================================|
+/**
+ * brief reads the 8-bit value at the 16-bit address provided. Togther the
+ *	Read/Write functions form the heart of NES bus; RAM and ROM are a 
+ *	single load, only I/O pages call out.
+ *
+ * @param address the 16-bit address to read data from
+ */
+inline u8 NES::Read(const u16 address)
+{
+	if (const u8* mem = pages[address >> 8].read)
+		return mem[address & 0xFF];
+
+	return Read_IO(address);
+} // end Read
+
+
+//=====================================================================|
+/**
+ * @brief reads the byte at address without any of the side effects a 
+ *	Read may have on the devices behind the bus; for the block decoder and
+ *	the debug views. I/O pages read as open bus.
+ *
+ * @param address the 16-bit address to peek at
+ */
+inline u8 NES::Peek(const u16 address) const
+{
+	const Bus_Page& page = pages[address >> 8];
+	if (page.read)
+		return page.read[address & 0xFF];
+
+	return address >> 8;
+} // end Peek
+
+
+//=====================================================================|
+/**
+ * @brief Sets the address's bit, and its page's.
+ */
+inline void NES::Mark_Written(const u16 address)
+{
+	dirty[address >> 6] |= 1ull << (address & 63);
+	dirty_pages[address >> 14] |= 1ull << ((address >> 8) & 63);
+} // end Mark_Written
+
+
+//=====================================================================|
+/**
+ * @brief Calls fn with every address written since the last drain, in
+ *	ascending order, clearing them as it goes. Whole words of the bitmap
+ *	are skipped with a count of trailing zeros, first over the page
+ *	summary then over the four words of each dirty page.
+ *
+ * @param fn called as fn(u16 address)
+ */
+template <typename Fn>
+void NES::Drain_Written(Fn&& fn)
+{
+	for (u32 i = 0; i < 256 / 64; ++i)
+	{
+		while (dirty_pages[i])
+		{
+			const u32 page = (i << 6) | Ctz64(dirty_pages[i]);
+			dirty_pages[i] &= dirty_pages[i] - 1;
+
+			for (u32 w = page << 2; w < (page + 1) << 2; ++w)
+			{
+				while (dirty[w])
+				{
+					fn((u16)((w << 6) | Ctz64(dirty[w])));
+					dirty[w] &= dirty[w] - 1;
+				} // end while bits
+			} // end for words
+		} // end while pages
+	} // end for
+} // end Drain_Written
+
+
+//=====================================================================|
+/**
+ * @brief Calls fn with every address written, in ascending order, and
+ *	clears them.
+ *
+ * @param fn called as fn(u16 address)
+ */
+template <typename Fn>
+void NES_Snapshot::Drain_Written(Fn&& fn)
+{
+	for (u32 w = 0; w < 65536 / 64; ++w)
+	{
+		while (written[w])
+		{
+			fn((u16)((w << 6) | Ctz64(written[w])));
+			written[w] &= written[w] - 1;
+		} // end while
+	} // end for
+} // end Drain_Written
@@ -0,0 +1,350 @@
+/**
+ * @brief nest-batch, many consoles at once. Runs a batch of ROMs, each
+ *	for so many frames, across every core, and writes one report with what
+ *	each ended on: the Crc32 of its last frame and of its RAM, the cycles
+ *	it ran and the time it took.
+ *
+ *		nest-batch jobs.txt -t 8 -o report.txt
+ *		nest-batch a.nes b.nes -f 3600 -r 100 -bench
+ *
+ *	A job list has one job a line, the ROM then optionally frames, a
+ *	backend and no-idle to run it without skipping idle loops; # starts a
+ *	comment:
+ *
+ *		smb.nes 3600 jit
+ *		tests/nmi.nes 120 switch no-idle
+ *
+ *	-bench runs the batch again with 1, 2, 4 ... threads up to one per
+ *	core, and reports instances a second for each and whether every run
+ *	ended on the same results as the one thread run.
+ *
+ * @author Rediet Worku
+ * @date 26th of October 2021, Sunday
+ */
+
+
+//=====================================================================|
+#include "batch-runner.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+
+
+//=====================================================================|
+struct Batch_Options
+{
+	std::vector<Batch_Job> jobs;
+	u64 frames = 600;				// for jobs that don't say
+	CPU6502::Backend backend = CPU6502::Backend::Jit;
+	bool idle_skip = true;			// for jobs that don't say
+	u32 repeat = 1;					// times the whole list goes in
+	u32 threads = 0;				// one per physical core
+	bool pin = true;
+	bool ram = false;				// the whole RAM in the report, in hex
+	bool bench = false;
+	const char* report_path = nullptr;	// stdout when not given
+};
+
+
+
+//=====================================================================|
+/**
+ * @brief Prints how to use it
+ */
+static void Usage()
+{
+	fprintf(stderr,
+		"usage: nest-batch <jobs.txt | rom.nes> ... [options]\n"
+		"\t-f <n>        frames for jobs that don't say (600)\n"
+		"\t-b <backend>  switch, lookup, blocks, jit or static, for jobs\n"
+		"\t              that don't say (jit)\n"
+		"\t-no-idle      don't skip idle loops, for jobs that don't say\n"
+		"\t-r <n>        put the whole batch in n times\n"
+		"\t-t <n>        worker threads (one per physical core)\n"
+		"\t-no-pin       let the workers move between cores\n"
+		"\t-ram          write each job's RAM into the report\n"
+		"\t-o <file>     write the report there\n"
+		"\t-bench        compare 1, 2, 4 ... threads\n");
+} // end Usage
+
+
+//=====================================================================|
+/**
+ * @brief Adds the jobs in a job list; frames and backend are 0 and the
+ *	default until the command line is all read, and so is idle skipping
+ *	unless the line says no-idle.
+ *
+ * @return false when the file can't be read or a line makes no sense
+ */
+static bool Load_Jobs(const char* path, std::vector<Batch_Job>& jobs, const CPU6502::Backend backend,
+	const bool idle_skip)
+{
+	std::ifstream file(path);
+	if (!file)
+	{
+		fprintf(stderr, "nest-batch: can't open %s\n", path);
+		return false;
+	} // end if
+
+	std::string line;
+	for (u32 n = 1; std::getline(file, line); n++)
+	{
+		line = line.substr(0, line.find('#'));
+		std::istringstream fields(line);
+
+		Batch_Job job;
+		job.frames = 0;
+		job.backend = backend;
+		job.idle_skip = idle_skip;
+		if (!(fields >> job.rom))
+			continue;
+
+		std::string frames, name, idle;
+		if (fields >> frames)
+			job.frames = strtoull(frames.c_str(), nullptr, 10);
+		if (fields >> name && !CPU6502::Find_Backend(name, job.backend))
+		{
+			fprintf(stderr, "nest-batch: %s:%u: no backend %s\n", path, n, name.c_str());
+			return false;
+		} // end if
+		if (fields >> idle)
+		{
+			if (idle != "no-idle")
+			{
+				fprintf(stderr, "nest-batch: %s:%u: %s, not no-idle\n", path, n, idle.c_str());
+				return false;
+			} // end if
+			job.idle_skip = false;
+		} // end if
+
+		jobs.push_back(job);
+	} // end for
+
+	return true;
+} // end Load_Jobs
+
+
+//=====================================================================|
+/**
+ * @brief Reads the command line into opts; every argument that isn't an
+ *	option is a ROM, when it ends in .nes, or else a job list.
+ *
+ * @return false on anything it doesn't understand
+ */
+static bool Parse_Options(int argc, char* argv[], Batch_Options& opts)
+{
+	std::vector<const char*> inputs;
+	for (int i = 1; i < argc; i++)
+	{
+		const std::string arg = argv[i];
+		const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+
+		if (arg == "-no-pin")
+			opts.pin = false;
+		else if (arg == "-ram")
+			opts.ram = true;
+		else if (arg == "-no-idle")
+			opts.idle_skip = false;
+		else if (arg == "-bench")
+			opts.bench = true;
+		else if (arg[0] != '-')
+			inputs.push_back(argv[i]);
+		else if (!value)
+			return false;
+		else
+		{
+			i++;
+			if (arg == "-f")
+				opts.frames = strtoull(value, nullptr, 10);
+			else if (arg == "-r")
+				opts.repeat = (u32)strtoul(value, nullptr, 10);
+			else if (arg == "-t")
+				opts.threads = (u32)strtoul(value, nullptr, 10);
+			else if (arg == "-o")
+				opts.report_path = value;
+			else if (arg == "-b")
+			{
+				if (!CPU6502::Find_Backend(value, opts.backend))
+					return false;
+			} // end else if
+			else
+				return false;
+		} // end else
+	} // end for
+
+	std::vector<Batch_Job> batch;
+	for (const char* input : inputs)
+	{
+		const std::string name = input;
+		if (name.size() > 4 && name.compare(name.size() - 4, 4, ".nes") == 0)
+		{
+			Batch_Job job;
+			job.rom = name;
+			job.frames = 0;
+			job.backend = opts.backend;
+			job.idle_skip = opts.idle_skip;
+			batch.push_back(job);
+		} // end if
+		else if (!Load_Jobs(input, batch, opts.backend, opts.idle_skip))
+			return false;
+	} // end for
+
+	for (Batch_Job& job : batch)
+	{
+		if (!job.frames)
+			job.frames = opts.frames;
+	} // end for
+
+	for (u32 i = 0; i < opts.repeat; i++)
+		opts.jobs.insert(opts.jobs.end(), batch.begin(), batch.end());
+
+	return !opts.jobs.empty();
+} // end Parse_Options
+
+
+//=====================================================================|
+/**
+ * @brief Writes a line for each job and a summary at the end. The lines
+ *	are tab separated: ROM, frames, cycles, seconds, frame and RAM Crc32,
+ *	worker, then the RAM in hex with -ram; a job that didn't load has its
+ *	error after the ROM instead.
+ */
+static void Write_Report(FILE* fp, const Batch_Options& opts, const std::vector<Batch_Result>& results,
+	const double seconds, const u32 threads, const u64 steals)
+{
+	fprintf(fp, "# rom\tframes\tcycles\tseconds\tframe_crc\tram_crc\tworker%s\n", opts.ram ? "\tram" : "");
+
+	u64 cycles = 0;
+	for (size_t i = 0; i < results.size(); i++)
+	{
+		const Batch_Result& r = results[i];
+		if (!r.ok)
+		{
+			fprintf(fp, "%s\terror: %s\n", opts.jobs[i].rom.c_str(), r.error.c_str());
+			continue;
+		} // end if
+
+		fprintf(fp, "%s\t%llu\t%llu\t%.6f\t%08x\t%08x\t%u", opts.jobs[i].rom.c_str(),
+			(unsigned long long)r.frames, (unsigned long long)r.cycles, r.seconds,
+			r.frame_crc, Crc32(r.ram, RAM_SIZE), r.worker);
+
+		if (opts.ram)
+		{
+			fputc('\t', fp);
+			for (u32 a = 0; a < RAM_SIZE; a++)
+				fprintf(fp, "%02x", r.ram[a]);
+		} // end if
+
+		fputc('\n', fp);
+		cycles += r.cycles;
+	} // end for
+
+	fprintf(fp, "# %zu instances on %u threads in %.3f s: %.1f instances/s, %.2f M cycles/s, %llu steals\n",
+		results.size(), threads, seconds, results.size() / seconds, cycles / seconds / 1e6,
+		(unsigned long long)steals);
+} // end Write_Report
+
+
+//=====================================================================|
+/**
+ * @brief Says so when some of the runner's workers couldn't be pinned;
+ *	they still ran, only free to move between cores.
+ */
+static void Warn_Pinning(const BatchRunner& runner)
+{
+	if (runner.Get_Pin_Failures())
+		fprintf(stderr, "nest-batch: %u of %u workers couldn't be pinned to a core\n",
+			runner.Get_Pin_Failures(), runner.Get_Threads());
+} // end Warn_Pinning
+
+
+//=====================================================================|
+/**
+ * @brief Runs the batch on 1, 2, 4 ... threads up to one per core, the
+ *	core count last if it isn't a power of two, and prints instances a
+ *	second and the speed up over one thread for each; a run whose results
+ *	differ from the one thread run is flagged.
+ *
+ * @return false when any run disagreed
+ */
+static bool Bench(const Batch_Options& opts)
+{
+	const u32 cores = BatchRunner().Get_Threads();
+
+	std::vector<u32> counts;
+	for (u32 t = 1; t < cores; t <<= 1)
+		counts.push_back(t);
+	counts.push_back(cores);
+
+	printf("threads\tinstances/s\tspeedup\tsteals\n");
+
+	std::vector<Batch_Result> first;
+	double base = 0;
+	bool same = true;
+	for (const u32 t : counts)
+	{
+		BatchRunner runner(t, opts.pin);
+
+		std::vector<Batch_Result> results;
+		const double rate = opts.jobs.size() / runner.Run(opts.jobs, results);
+		Warn_Pinning(runner);
+		if (first.empty())
+		{
+			first = results;
+			base = rate;
+		} // end if
+
+		bool agree = true;
+		for (size_t i = 0; i < results.size(); i++)
+		{
+			agree &= results[i].ok == first[i].ok && results[i].frame_crc == first[i].frame_crc
+				&& memcmp(results[i].ram, first[i].ram, RAM_SIZE) == 0;
+		} // end for
+
+		printf("%u\t%.1f\t%.2fx\t%llu%s\n", t, rate, rate / base,
+			(unsigned long long)runner.Get_Steals(), agree ? "" : "\tresults differ");
+		same &= agree;
+	} // end for
+
+	return same;
+} // end Bench
+
+
+//=====================================================================|
+int main(int argc, char* argv[])
+{
+	Batch_Options opts;
+	if (!Parse_Options(argc, argv, opts))
+	{
+		Usage();
+		return 1;
+	} // end if
+
+	if (opts.bench)
+		return Bench(opts) ? 0 : 1;
+
+	BatchRunner runner(opts.threads, opts.pin);
+
+	std::vector<Batch_Result> results;
+	const double seconds = runner.Run(opts.jobs, results);
+	Warn_Pinning(runner);
+
+	FILE* fp = opts.report_path ? fopen(opts.report_path, "w") : stdout;
+	if (!fp)
+	{
+		fprintf(stderr, "nest-batch: can't write %s\n", opts.report_path);
+		return 1;
+	} // end if
+
+	Write_Report(fp, opts, results, seconds, runner.Get_Threads(), runner.Get_Steals());
+	if (fp != stdout)
+		fclose(fp);
+
+	bool ok = true;
+	for (const Batch_Result& r : results)
+		ok &= r.ok;
+	return ok ? 0 : 1;
+} // end main
@@ -0,0 +1,353 @@
+/**
+ * @brief nest-bench, how fast each CPU backend runs a handful of tight
+ *	loops. Every case is a made up cartridge, written out as an iNES image
+ *	to the temp directory and thrown away after: a loop at 0xE000 that
+ *	ends in JMP 0xE000, the rest of the ROM filled with its 8KB bank
+ *	number. The loop is stepped through for a while to count how many
+ *	cycles an instruction takes, then run a whole number of frames on each
+ *	backend, best of a few tries, with idle loop skipping off:
+ *
+ *		nest-bench -f 600 -r 3 alu branch flags
+ *
+ *	The uxrom, mmc1 and mmc3 cases switch a bank in and read from it every
+ *	time round, what a game's bank switching comes down to on the bus.
+ *
+ *	Lookup is the original dispatch through the member pointers in lookup,
+ *	Switch the templated one that replaced it, so the two side by side are
+ *	the before and after.
+ *
+ * @author Rediet Worku
+ * @date 26th of October 2021, Sunday
+ */
+
+
+//=====================================================================|
+#include "nes.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+
+
+
+//=====================================================================|
+struct Bench_Case
+{
+	const char* name;
+	const char* about;
+	u8 mapper;
+	u8 prg_banks;				// of 16KB
+	std::vector<u8> code;		// at 0xE000; JMP 0xE000 is added on the end
+};
+
+
+static const Bench_Case cases[] = {
+	{ "alu", "zero page add and store, indexed", 0, 2, {
+		0xB5, 0x10,				// LDA $10,X
+		0x18,					// CLC
+		0x69, 0x01,				// ADC #1
+		0x95, 0x10,				// STA $10,X
+		0xE8,					// INX
+	} },
+	{ "branch", "a count down, all branches", 0, 2, {
+		0xA2, 0x10,				// LDX #$10
+		0xCA,					// DEX
+		0xD0, 0xFD,				// BNE -3
+	} },
+	{ "flags", "arithmetic, each flag it sets read back", 0, 2, {
+		0xA5, 0x10,				// LDA $10
+		0x69, 0x37,				// ADC #$37
+		0xE9, 0x11,				// SBC #$11
+		0x2A,					// ROL
+		0x45, 0x11,				// EOR $11
+		0xC9, 0x80,				// CMP #$80
+		0x90, 0x00,				// BCC +0
+		0x85, 0x10,				// STA $10
+		0x24, 0x10,				// BIT $10
+		0x30, 0x00,				// BMI +0
+		0xE6, 0x11,				// INC $11
+		0x70, 0x00,				// BVS +0
+	} },
+	{ "uxrom", "a 16KB bank switched in and read, every time round", 2, 8, {
+		0xE8,					// INX
+		0x8A,					// TXA
+		0x29, 0x07,				// AND #7
+		0x8D, 0x00, 0x80,		// STA $8000
+		0xAD, 0x00, 0x80,		// LDA $8000
+		0x85, 0x10,				// STA $10
+	} },
+	{ "mmc1", "the same through MMC1's shift register, five writes", 1, 8, {
+		0xE8,					// INX
+		0x8A,					// TXA
+		0x29, 0x07,				// AND #7
+		0x8D, 0x00, 0xE0,		// STA $E000
+		0x4A,					// LSR
+		0x8D, 0x00, 0xE0,		// STA $E000
+		0x4A,					// LSR
+		0x8D, 0x00, 0xE0,		// STA $E000
+		0x4A,					// LSR
+		0x8D, 0x00, 0xE0,		// STA $E000
+		0x4A,					// LSR
+		0x8D, 0x00, 0xE0,		// STA $E000
+		0xAD, 0x00, 0x80,		// LDA $8000
+		0x85, 0x10,				// STA $10
+	} },
+	{ "mmc3", "both of MMC3's 8KB PRG banks switched and read", 4, 8, {
+		0xA9, 0x06,				// LDA #6
+		0x8D, 0x00, 0x80,		// STA $8000
+		0xE8,					// INX
+		0x8A,					// TXA
+		0x29, 0x0F,				// AND #$0F
+		0x8D, 0x01, 0x80,		// STA $8001
+		0xAD, 0x00, 0x80,		// LDA $8000
+		0x85, 0x10,				// STA $10
+		0xA9, 0x07,				// LDA #7
+		0x8D, 0x00, 0x80,		// STA $8000
+		0x8A,					// TXA
+		0x49, 0x0F,				// EOR #$0F
+		0x8D, 0x01, 0x80,		// STA $8001
+		0xAD, 0x00, 0xA0,		// LDA $A000
+		0x85, 0x11,				// STA $11
+	} },
+};
+
+
+static const CPU6502::Backend backends[] = {
+	CPU6502::Backend::Lookup, CPU6502::Backend::Switch,
+	CPU6502::Backend::Blocks, CPU6502::Backend::Jit
+};
+
+
+struct Bench_Options
+{
+	u64 frames = 600;
+	u32 tries = 3;
+	std::vector<const Bench_Case*> run;		// all of them when empty
+};
+
+
+
+//=====================================================================|
+/**
+ * @brief Prints how to use it
+ */
+static void Usage()
+{
+	fprintf(stderr,
+		"usage: nest-bench [options] [case ...]\n"
+		"\t-f <n>  run n frames a try (600)\n"
+		"\t-r <n>  best of n tries (3)\n"
+		"cases:\n");
+	for (const Bench_Case& c : cases)
+		fprintf(stderr, "\t%-8s%s\n", c.name, c.about);
+} // end Usage
+
+
+//=====================================================================|
+/**
+ * @brief Reads the command line into opts
+ *
+ * @return false on anything it doesn't understand
+ */
+static bool Parse_Options(int argc, char* argv[], Bench_Options& opts)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		const std::string arg = argv[i];
+		if (arg[0] != '-')
+		{
+			const Bench_Case* found = nullptr;
+			for (const Bench_Case& c : cases)
+			{
+				if (arg == c.name)
+					found = &c;
+			} // end for
+
+			if (!found)
+				return false;
+			opts.run.push_back(found);
+			continue;
+		} // end if
+
+		if (i + 1 >= argc)
+			return false;
+		const char* value = argv[++i];
+		if (arg == "-f")
+			opts.frames = strtoull(value, nullptr, 10);
+		else if (arg == "-r")
+			opts.tries = (u32)strtoul(value, nullptr, 10);
+		else
+			return false;
+	} // end for
+
+	if (opts.run.empty())
+	{
+		for (const Bench_Case& c : cases)
+			opts.run.push_back(&c);
+	} // end if
+
+	return opts.frames && opts.tries;
+} // end Parse_Options
+
+
+//=====================================================================|
+/**
+ * @brief Writes a case's cartridge out as an iNES image. 0xE000 - 0xFFFF
+ *	is the last 8KB of PRG on every mapper here, so that's where the code
+ *	goes, and the vectors: reset on the code, NMI and IRQ on an RTI just
+ *	below them. CHR is 8KB of RAM.
+ *
+ * @return false when the file can't be written
+ */
+static bool Write_Rom(const Bench_Case& c, const std::string& path)
+{
+	const u32 prg_size = c.prg_banks * 16384;
+	std::vector<u8> image(16 + prg_size);
+
+	u8* header = image.data();
+	memcpy(header, "NES\x1A", 4);
+	header[4] = c.prg_banks;
+	header[6] = (u8)((c.mapper & 0x0F) << 4);
+	header[7] = c.mapper & 0xF0;
+
+	u8* prg = image.data() + 16;
+	for (u32 i = 0; i < prg_size; i++)
+		prg[i] = (u8)(i / 8192);
+
+	u8* last = prg + prg_size - 8192;
+	memcpy(last, c.code.data(), c.code.size());
+	const u8 jmp[3] = { 0x4C, 0x00, 0xE0 };
+	memcpy(last + c.code.size(), jmp, 3);
+
+	last[0x1FF9] = 0x40;	// RTI at 0xFFF9
+	const u16 vectors[3] = { 0xFFF9, 0xE000, 0xFFF9 };
+	for (u32 i = 0; i < 3; i++)
+	{
+		last[0x1FFA + i * 2] = vectors[i] & 0xFF;
+		last[0x1FFB + i * 2] = vectors[i] >> 8;
+	} // end for
+
+	FILE* fp = fopen(path.c_str(), "wb");
+	if (!fp)
+		return false;
+	const bool ok = fwrite(image.data(), 1, image.size(), fp) == image.size();
+	fclose(fp);
+	return ok;
+} // end Write_Rom
+
+
+//=====================================================================|
+/**
+ * @brief Steps round the loop, from 0xE000 back to it, until it has run
+ *	MEASURE_CYCLES; a loop whose branches go either way takes a different
+ *	time each round, so it's the average that counts. The first time
+ *	round is left out, in case it does anything the rest don't.
+ *
+ * @param instructions gets how many instructions that was
+ *
+ * @return how many cycles that was
+ */
+static u64 Measure_Loop(NES& nes, u64& instructions)
+{
+	constexpr u64 MEASURE_CYCLES = 100000;
+
+	u64 cycles = 0;
+	instructions = 0;
+	for (u32 round = 0; cycles < MEASURE_CYCLES; round++)
+	{
+		if (round == 1)
+			cycles = instructions = 0;
+		do
+		{
+			cycles += nes.cpu.Step_Instruction();
+			instructions++;
+		} while (nes.cpu.Get_PC() != 0xE000);
+	} // end for
+
+	return cycles;
+} // end Measure_Loop
+
+
+//=====================================================================|
+/**
+ * @brief Runs one case on every backend and prints how fast each was.
+ *
+ * @return false when the cartridge doesn't go in
+ */
+static bool Run_Case(const Bench_Case& c, const Bench_Options& opts)
+{
+	const std::string path = (std::filesystem::temp_directory_path() /
+		("nest-bench-" + std::string(c.name) + ".nes")).string();
+	if (!Write_Rom(c, path))
+	{
+		fprintf(stderr, "nest-bench: can't write %s\n", path.c_str());
+		return false;
+	} // end if
+
+	std::unique_ptr<NES> nes = std::make_unique<NES>();
+	bool ok = nes->Insert_Cartridge(path);
+	if (!ok)
+		fprintf(stderr, "nest-bench: %s: %s\n", c.name, nes->Get_Error_Message().c_str());
+
+	u64 instructions = 0, loop_cycles = 0;
+	if (ok)
+		loop_cycles = Measure_Loop(*nes, instructions);
+	printf("%s: %.2f cycles an instruction\n", c.name, ok ? (double)loop_cycles / instructions : 0.0);
+
+	for (const CPU6502::Backend backend : backends)
+	{
+		if (!ok)
+			break;
+
+		double best = 0;
+		u64 cycles = 0;
+		for (u32 i = 0; i < opts.tries; i++)
+		{
+			nes = std::make_unique<NES>();
+			nes->Insert_Cartridge(path);
+			nes->cpu.Set_Backend(backend);
+			nes->cpu.Set_Idle_Skip(false);
+
+			const u64 start_cycles = nes->cpu.Get_Cycles();
+			const auto start = std::chrono::steady_clock::now();
+			for (u64 frame = 0; frame < opts.frames; frame++)
+				nes->Run_Frame(false);
+			const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+			cycles = nes->cpu.Get_Cycles() - start_cycles;
+			const double seconds = elapsed.count() > 0 ? elapsed.count() : 1e-9;
+			if (!best || seconds < best)
+				best = seconds;
+		} // end for
+
+		// the loop is all there is, so its mix of instructions is the run's
+		const double rate = cycles / best;
+		printf("  %-8s%8.2f M cycles/s %8.2f MIPS\n", CPU6502::Backend_Name(backend),
+			rate / 1e6, rate * instructions / loop_cycles / 1e6);
+	} // end for
+
+	std::error_code ignored;
+	std::filesystem::remove(path, ignored);
+	return ok;
+} // end Run_Case
+
+
+//=====================================================================|
+int main(int argc, char* argv[])
+{
+	Bench_Options opts;
+	if (!Parse_Options(argc, argv, opts))
+	{
+		Usage();
+		return 1;
+	} // end if
+
+	printf("nest-bench: %llu frames, best of %u\n", (unsigned long long)opts.frames, opts.tries);
+
+	bool ok = true;
+	for (const Bench_Case* c : opts.run)
+		ok &= Run_Case(*c, opts);
+
+	return ok ? 0 : 1;
+} // end main
@@ -0,0 +1,215 @@
+/**
+ * @brief nest-headless, the console without a screen. Loads an iNES ROM
+ *	and runs it flat out for so many frames, or CPU cycles, then says how
+ *	fast that went. Needs nothing but the core; no SDL, no window and no
+ *	fonts, so it runs on machines that have neither:
+ *
+ *		nest-headless game.nes -f 3600 -b jit -ram ram.bin -ppm last.ppm
+ *
+ *	Cycle counts are rounded up to whole frames; a frame is where the
+ *	picture and the interrupts line up, and stopping half way through one
+ *	leaves nothing worth dumping.
+ *
+ * @author Rediet Worku
+ * @date 26th of October 2021, Sunday
+ */
+
+
+//=====================================================================|
+#include "nes.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+
+
+//=====================================================================|
+struct Headless_Options
+{
+	const char* rom = nullptr;
+	u64 frames = 600;				// ten seconds of NTSC
+	u64 cycles = 0;					// run by cycles instead when not 0
+	CPU6502::Backend backend = CPU6502::Backend::Jit;
+	bool draw = true;				// false skips drawing the pixels
+	bool idle_skip = true;
+	const char* ram_path = nullptr;	// where to dump the 2KB of RAM
+	const char* ppm_path = nullptr;	// where to dump the last frame
+};
+
+
+
+//=====================================================================|
+/**
+ * @brief Prints how to use it
+ */
+static void Usage()
+{
+	fprintf(stderr,
+		"usage: nest-headless <rom.nes> [options]\n"
+		"\t-f <n>        run n frames (600)\n"
+		"\t-c <n>        run at least n CPU cycles instead\n"
+		"\t-b <backend>  switch, lookup, blocks, jit or static (jit)\n"
+		"\t-no-draw      don't draw the pixels; the game runs the same\n"
+		"\t-no-idle      don't skip idle loops\n"
+		"\t-ram <file>   dump the 2KB of RAM at the end\n"
+		"\t-ppm <file>   dump the last frame drawn as a PPM\n");
+} // end Usage
+
+
+//=====================================================================|
+/**
+ * @brief Reads the command line into opts
+ *
+ * @param argc count of arguments
+ * @param argv the arguments
+ * @param opts gets filled in
+ *
+ * @return false on anything it doesn't understand
+ */
+static bool Parse_Options(int argc, char* argv[], Headless_Options& opts)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		const std::string arg = argv[i];
+		const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+
+		if (arg == "-no-draw")
+			opts.draw = false;
+		else if (arg == "-no-idle")
+			opts.idle_skip = false;
+		else if (arg[0] != '-')
+		{
+			if (opts.rom)
+				return false;
+			opts.rom = argv[i];
+		} // end else if
+		else if (!value)
+			return false;
+		else
+		{
+			i++;
+			if (arg == "-f")
+				opts.frames = strtoull(value, nullptr, 10);
+			else if (arg == "-c")
+				opts.cycles = strtoull(value, nullptr, 10);
+			else if (arg == "-ram")
+				opts.ram_path = value;
+			else if (arg == "-ppm")
+				opts.ppm_path = value;
+			else if (arg == "-b")
+			{
+				if (!CPU6502::Find_Backend(value, opts.backend))
+					return false;
+			} // end else if
+			else
+				return false;
+		} // end else
+	} // end for
+
+	return opts.rom != nullptr;
+} // end Parse_Options
+
+
+//=====================================================================|
+/**
+ * @brief Writes count bytes from data to a file at path
+ *
+ * @return false when the file can't be written
+ */
+static bool Dump(const char* path, const void* data, const size_t count, const char* header = nullptr)
+{
+	FILE* fp = fopen(path, "wb");
+	if (!fp)
+	{
+		fprintf(stderr, "nest-headless: can't write %s\n", path);
+		return false;
+	} // end if
+
+	if (header)
+		fputs(header, fp);
+	const bool ok = fwrite(data, 1, count, fp) == count;
+	fclose(fp);
+
+	if (!ok)
+		fprintf(stderr, "nest-headless: short write to %s\n", path);
+	return ok;
+} // end Dump
+
+
+//=====================================================================|
+/**
+ * @brief Writes the PPU's last frame out as a binary PPM. The colors are
+ *	ABGR8888, so in memory each pixel is R, G, B, A; dropping the A is all
+ *	it takes.
+ *
+ * @param path the file to write
+ * @param ppu whose frame it is
+ *
+ * @return false when the file can't be written
+ */
+static bool Dump_PPM(const char* path, const PPU& ppu)
+{
+	std::vector<u8> rgb(SCREEN_WIDTH * SCREEN_HEIGHT * 3);
+
+	const u8* rgba = (const u8*)ppu.Get_Frame_RGBA();
+	for (u32 i = 0; i < SCREEN_WIDTH * SCREEN_HEIGHT; i++)
+		memcpy(&rgb[i * 3], rgba + i * 4, 3);
+
+	char header[32];
+	snprintf(header, sizeof(header), "P6\n%u %u\n255\n", SCREEN_WIDTH, SCREEN_HEIGHT);
+	return Dump(path, rgb.data(), rgb.size(), header);
+} // end Dump_PPM
+
+
+//=====================================================================|
+int main(int argc, char* argv[])
+{
+	Headless_Options opts;
+	if (!Parse_Options(argc, argv, opts))
+	{
+		Usage();
+		return 1;
+	} // end if
+
+	std::unique_ptr<NES> nes = std::make_unique<NES>();
+	if (!nes->Insert_Cartridge(opts.rom))
+	{
+		fprintf(stderr, "nest-headless: %s\n", nes->Get_Error_Message().c_str());
+		return 1;
+	} // end if
+
+	nes->cpu.Set_Backend(opts.backend);
+	nes->cpu.Set_Idle_Skip(opts.idle_skip);
+
+	const u64 start_cycles = nes->cpu.Get_Cycles();
+	const auto start = std::chrono::steady_clock::now();
+
+	u64 frames = 0;
+	while (opts.cycles ? nes->cpu.Get_Cycles() - start_cycles < opts.cycles : frames < opts.frames)
+	{
+		nes->Run_Frame(opts.draw);
+		frames++;
+	} // end while
+
+	const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+	const u64 cycles = nes->cpu.Get_Cycles() - start_cycles;
+	const double seconds = elapsed.count() > 0 ? elapsed.count() : 1e-9;
+
+	// the NTSC CPU runs at 1.789773 MHz
+	printf("nest-headless: %llu frames, %llu cycles in %.3f s\n",
+		(unsigned long long)frames, (unsigned long long)cycles, seconds);
+	printf("nest-headless: %.2f M cycles/s, %.1f fps, %.1fx real time\n",
+		cycles / seconds / 1e6, frames / seconds, cycles / seconds / 1789773.0);
+	if (nes->cpu.Get_Idle_Loops())
+		printf("nest-headless: %llu idle loops skipped, %llu cycles\n",
+			(unsigned long long)nes->cpu.Get_Idle_Loops(), (unsigned long long)nes->cpu.Get_Idle_Cycles());
+
+	bool ok = true;
+	if (opts.ram_path)
+		ok &= Dump(opts.ram_path, nes->ram, RAM_SIZE);
+	if (opts.ppm_path)
+		ok &= Dump_PPM(opts.ppm_path, nes->ppu);
+
+	return ok ? 0 : 1;
+} // end main
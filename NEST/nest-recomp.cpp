@@ -0,0 +1,340 @@
+/**
+ * @brief nest-recomp, the static recompiler. Reads an iNES ROM, finds its
+ *	code by recursive descent from the reset, NMI and IRQ vectors and
+ *	writes it back out as a C++ module with one function per basic block.
+ *	Built into NEST, the module registers itself and the CPU6502 runs it
+ *	with Backend::Static once the ROM is selected:
+ *
+ *		nest-recomp game.nes game-recompiled.cpp
+ *
+ *	Every instruction becomes a NEST_STATIC_OP, which runs the very same
+ *	operation template the interpreters use, with its operand a compile
+ *	time constant; the generated code can't disagree with the interpreter.
+ *	Code only reached through JMP (ind), an RTS trick or from RAM is never
+ *	found, which is fine; CPU6502 interprets any pc without a block.
+ *
+ *	Only NROM (mapper 0) PRG is fixed in place; bank switched ROMs need
+ *	the mapper to say which bank is where and are refused for now.
+ *
+ * @author Rediet Worku
+ * @date 26th of October 2021, Sunday
+ */
+
+
+//=====================================================================|
+#include "cpu6502.hpp"
+#include "cartridge.hpp"
+
+#include <cstdio>
+
+
+
+//=====================================================================|
+// the operation and addressing mode of each opcode as named in the source
+#define RECOMP_NAMES(opc, name, op, mode, cyc, len) { #op, #mode },
+static const char* const op_names[256][2] = { CPU6502_OPCODES(RECOMP_NAMES) };
+#undef RECOMP_NAMES
+
+
+
+//=====================================================================|
+class Recompiler
+{
+public:
+
+	static constexpr u32 MAX_BLOCK_OPS = 64;	// longest function written out
+
+	bool Load(const char* path);
+	void Discover();
+	bool Write(const char* path) const;
+
+	u32 Block_Count() const { return (u32)starts.size(); }
+
+private:
+
+	std::vector<u8> prg;		// the PRG ROM as it sits from 0x8000
+	std::string rom_name;		// file name only
+	u32 crc = 0;				// crc32 of prg
+
+	std::vector<u8> is_code;	// 1 for every address holding an opcode
+	std::vector<u8> is_start;	// 1 for every address a block starts at
+	std::vector<u16> starts;	// the same, sorted
+
+	u8 Peek(const u16 addr) const { return prg[(addr - 0x8000) % prg.size()]; }
+	u16 Peek16(const u16 addr) const { return Peek(addr) | ((u16)Peek(addr + 1) << 8); }
+	u16 Operand(const u16 addr) const;
+
+	bool Is_End(const u8 opc) const;
+	void Mark(std::vector<u16>& work, const u32 addr);
+	void Write_Block(FILE* fp, const u16 start, u16& max_cycles) const;
+};
+
+
+
+//=====================================================================|
+/**
+ * @brief Loads the PRG ROM out of an iNES file.
+ *
+ * @param path the .nes file
+ *
+ * @return false when it can't be read, isn't iNES or isn't NROM
+ */
+bool Recompiler::Load(const char* path)
+{
+	Cartridge cart;
+	if (!cart.Load(path))
+	{
+		fprintf(stderr, "nest-recomp: %s: %s\n", path, cart.Get_Error_Message().c_str());
+		return false;
+	} // end if
+
+	const u32 prg_size = cart.Prg().size;
+	if (cart.Mapper() != 0 || (prg_size != 16384 && prg_size != 32768))
+	{
+		fprintf(stderr, "nest-recomp: %s uses mapper %d; only NROM is supported\n", path, cart.Mapper());
+		return false;
+	} // end if
+
+	prg.assign(cart.Prg().data, cart.Prg().data + prg_size);
+	rom_name = path;
+	const size_t slash = rom_name.find_last_of("/\\");
+	if (slash != std::string::npos)
+		rom_name.erase(0, slash + 1);
+
+	crc = cart.Prg_Crc();
+	return true;
+} // end Load
+
+
+//=====================================================================|
+/**
+ * @brief Reads the operand bytes of the instruction at addr, sign
+ *	extending branch offsets just like the block decoder does.
+ */
+u16 Recompiler::Operand(const u16 addr) const
+{
+	const CPU6502::INSTRUCTION& ins = CPU6502::lookup[Peek(addr)];
+
+	u16 operand = 0;
+	if (ins.bytes >= 2)
+		operand = Peek(addr + 1);
+	if (ins.bytes == 3)
+		operand |= (u16)Peek(addr + 2) << 8;
+	if (ins.mode == CPU6502::AM_REL && (operand & 0x80))
+		operand |= 0xFF00;
+
+	return operand;
+} // end Operand
+
+
+//=====================================================================|
+/**
+ * @brief Tells whether an opcode leaves straight line code; the same
+ *	list the block engine ends its blocks at.
+ */
+bool Recompiler::Is_End(const u8 opc) const
+{
+	switch (opc)
+	{
+	case 0x00:	// BRK
+	case 0x20:	// JSR
+	case 0x40:	// RTI
+	case 0x4C:	// JMP abs
+	case 0x60:	// RTS
+	case 0x6C:	// JMP ind
+		return true;
+	} // end switch
+
+	return CPU6502::lookup[opc].mode == CPU6502::AM_REL;
+} // end Is_End
+
+
+//=====================================================================|
+/**
+ * @brief Marks addr as the start of a block and queues it for tracing,
+ *	unless it lies outside the PRG ROM.
+ */
+void Recompiler::Mark(std::vector<u16>& work, const u32 addr)
+{
+	if (addr < 0x8000 || addr > 0xFFFF || is_start[addr])
+		return;
+
+	is_start[addr] = 1;
+	work.push_back((u16)addr);
+} // end Mark
+
+
+//=====================================================================|
+/**
+ * @brief Recursive descent from the three vectors. Every branch target,
+ *	jump target, subroutine and the return point after each JSR starts a
+ *	block; tracing follows each until it leaves straight line code.
+ *	JMP (ind), RTS and RTI go wherever the running program says, so they
+ *	end a trace without adding anything.
+ */
+void Recompiler::Discover()
+{
+	is_code.assign(0x10000, 0);
+	is_start.assign(0x10000, 0);
+
+	std::vector<u16> work;
+	Mark(work, Peek16(0xFFFC));		// reset
+	Mark(work, Peek16(0xFFFA));		// NMI
+	Mark(work, Peek16(0xFFFE));		// IRQ/BRK
+
+	while (!work.empty())
+	{
+		u32 addr = work.back();
+		work.pop_back();
+
+		while (addr <= 0xFFFF && !is_code[addr])
+		{
+			const u8 opc = Peek((u16)addr);
+			const CPU6502::INSTRUCTION& ins = CPU6502::lookup[opc];
+			const u16 operand = Operand((u16)addr);
+			const u32 next = addr + ins.bytes;
+			is_code[addr] = 1;
+
+			if (ins.mode == CPU6502::AM_REL)
+			{
+				Mark(work, (u16)(next + operand));
+				Mark(work, next);
+			} // end if branch
+			else if (opc == 0x4C)
+				Mark(work, operand);
+			else if (opc == 0x20)
+			{
+				Mark(work, operand);
+				Mark(work, next);
+			} // end else if JSR
+
+			if (Is_End(opc))
+				break;
+
+			addr = next;
+		} // end while
+	} // end while
+
+	starts.clear();
+	for (u32 addr = 0x8000; addr <= 0xFFFF; ++addr)
+	{
+		if (is_start[addr])
+			starts.push_back((u16)addr);
+	} // end for
+} // end Discover
+
+
+//=====================================================================|
+/**
+ * @brief Writes the function for the block at start. It runs to the
+ *	first instruction that leaves straight line code, or falls through
+ *	into the next block's start, which must stay an entry of its own.
+ *
+ * @param fp where to write
+ * @param start the first instruction
+ * @param max_cycles gets the most cycles one pass can take
+ */
+void Recompiler::Write_Block(FILE* fp, const u16 start, u16& max_cycles) const
+{
+	fprintf(fp, "\tstatic void Block_%04X(CPU6502& cpu)\n\t{\n", start);
+
+	u32 addr = start;
+	max_cycles = 0;
+
+	for (u32 count = 0; count < MAX_BLOCK_OPS; ++count)
+	{
+		const u8 opc = Peek((u16)addr);
+		const CPU6502::INSTRUCTION& ins = CPU6502::lookup[opc];
+		const u32 next = addr + ins.bytes;
+
+		fprintf(fp, "\t\tNEST_STATIC_OP(%s, %s, 0x%02X, 0x%04X, 0x%04X, %d)\t// $%04X %s\n",
+			op_names[opc][1], op_names[opc][0], opc, Operand((u16)addr), next & 0xFFFF,
+			ins.cycles, addr, CPU6502::mnemonics[opc]);
+
+		// a taken branch can cost two more, a page crossing one
+		max_cycles += ins.cycles;
+		if (ins.mode == CPU6502::AM_REL)
+			max_cycles += 2;
+		else if (ins.mode == CPU6502::AM_ABX || ins.mode == CPU6502::AM_ABY ||
+			ins.mode == CPU6502::AM_IZY)
+			max_cycles += 1;
+
+		if (Is_End(opc) || next > 0xFFFF || is_start[next])
+			break;
+
+		addr = next;
+	} // end for
+
+	fprintf(fp, "\t} // end Block_%04X\n\n", start);
+} // end Write_Block
+
+
+//=====================================================================|
+/**
+ * @brief Writes out the generated module.
+ *
+ * @param path the .cpp to write
+ *
+ * @return false when it couldn't be written
+ */
+bool Recompiler::Write(const char* path) const
+{
+	FILE* fp = fopen(path, "w");
+	if (!fp)
+	{
+		fprintf(stderr, "nest-recomp: can't write %s\n", path);
+		return false;
+	} // end if
+
+	fprintf(fp,
+		"/**\n"
+		" * @brief %s recompiled by nest-recomp; %u blocks. Generated, don't edit.\n"
+		" */\n\n"
+		"#include \"cpu6502-ops.hpp\"\n\n\n"
+		"template <>\n"
+		"struct Recompiled<0x%08X>\n"
+		"{\n",
+		rom_name.c_str(), Block_Count(), crc);
+
+	std::vector<u16> max_cycles(starts.size());
+	for (size_t i = 0; i < starts.size(); ++i)
+		Write_Block(fp, starts[i], max_cycles[i]);
+
+	fprintf(fp, "\tstatic constexpr Static_Block blocks[] = {\n");
+	for (size_t i = 0; i < starts.size(); ++i)
+		fprintf(fp, "\t\t{ 0x%04X, %u, &Block_%04X },\n", starts[i], max_cycles[i], starts[i]);
+	fprintf(fp, "\t};\n");
+
+	fprintf(fp, "\n\tstatic constexpr Static_Program program = {\n"
+		"\t\t0x%08X, \"%s\", blocks, sizeof(blocks) / sizeof(blocks[0])\n\t};\n"
+		"};\n\n"
+		"static const bool registered_%08X = CPU6502::Register_Program(Recompiled<0x%08X>::program);\n",
+		crc, rom_name.c_str(), crc, crc);
+
+	const bool ok = !ferror(fp);
+	fclose(fp);
+	return ok;
+} // end Write
+
+
+
+//=====================================================================|
+int main(int argc, char* argv[])
+{
+	if (argc != 3)
+	{
+		fprintf(stderr, "usage: nest-recomp <rom.nes> <out.cpp>\n");
+		return 1;
+	} // end if
+
+	Recompiler recomp;
+	if (!recomp.Load(argv[1]))
+		return 1;
+
+	recomp.Discover();
+	if (!recomp.Write(argv[2]))
+		return 1;
+
+	printf("nest-recomp: %u blocks written to %s\n", recomp.Block_Count(), argv[2]);
+	return 0;
+} // end main
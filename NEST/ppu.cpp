@@ -0,0 +1,764 @@
+/**
+ * @brief The implementation of the 2C02 PPU.
+ *
+ * @author Rediet Worku
+ * @date 26th of October 2021, Sunday
+ */
+
+//=====================================================================|
+#include "ppu.hpp"
+#include "nes.hpp"
+
+#include <algorithm>
+
+
+
+//=====================================================================|
+#define NES_COLOR(r, g, b)	(0xFF000000u | ((b) << 16) | ((g) << 8) | (r))
+
+const u32 PPU::colors[64] = {
+	NES_COLOR( 84,  84,  84), NES_COLOR(  0,  30, 116), NES_COLOR(  8,  16, 144), NES_COLOR( 48,   0, 136),
+	NES_COLOR( 68,   0, 100), NES_COLOR( 92,   0,  48), NES_COLOR( 84,   4,   0), NES_COLOR( 60,  24,   0),
+	NES_COLOR( 32,  42,   0), NES_COLOR(  8,  58,   0), NES_COLOR(  0,  64,   0), NES_COLOR(  0,  60,   0),
+	NES_COLOR(  0,  50,  60), NES_COLOR(  0,   0,   0), NES_COLOR(  0,   0,   0), NES_COLOR(  0,   0,   0),
+	NES_COLOR(152, 150, 152), NES_COLOR(  8,  76, 196), NES_COLOR( 48,  50, 236), NES_COLOR( 92,  30, 228),
+	NES_COLOR(136,  20, 176), NES_COLOR(160,  20, 100), NES_COLOR(152,  34,  32), NES_COLOR(120,  60,   0),
+	NES_COLOR( 84,  90,   0), NES_COLOR( 40, 114,   0), NES_COLOR(  8, 124,   0), NES_COLOR(  0, 118,  40),
+	NES_COLOR(  0, 102, 120), NES_COLOR(  0,   0,   0), NES_COLOR(  0,   0,   0), NES_COLOR(  0,   0,   0),
+	NES_COLOR(236, 238, 236), NES_COLOR( 76, 154, 236), NES_COLOR(120, 124, 236), NES_COLOR(176,  98, 236),
+	NES_COLOR(228,  84, 236), NES_COLOR(236,  88, 180), NES_COLOR(236, 106, 100), NES_COLOR(212, 136,  32),
+	NES_COLOR(160, 170,   0), NES_COLOR(116, 196,   0), NES_COLOR( 76, 208,  32), NES_COLOR( 56, 204, 108),
+	NES_COLOR( 56, 180, 204), NES_COLOR( 60,  60,  60), NES_COLOR(  0,   0,   0), NES_COLOR(  0,   0,   0),
+	NES_COLOR(236, 238, 236), NES_COLOR(168, 204, 236), NES_COLOR(188, 188, 236), NES_COLOR(212, 178, 236),
+	NES_COLOR(236, 174, 236), NES_COLOR(236, 174, 212), NES_COLOR(236, 180, 176), NES_COLOR(228, 196, 144),
+	NES_COLOR(204, 210, 120), NES_COLOR(180, 222, 120), NES_COLOR(168, 226, 144), NES_COLOR(152, 226, 180),
+	NES_COLOR(160, 214, 228), NES_COLOR(160, 162, 160), NES_COLOR(  0,   0,   0), NES_COLOR(  0,   0,   0),
+};
+
+#undef NES_COLOR
+
+
+
+//=====================================================================|
+/**
+ * @brief The palette entry an address in 0x3F00 - 0x3FFF lands on; the
+ *	backdrop entries of the sprite palettes are the background's.
+ */
+static inline u8 Palette_Index(const u16 addr)
+{
+	u8 index = addr & 0x1F;
+	if ((index & 0x13) == 0x10)
+		index &= 0x0F;
+
+	return index;
+} // end Palette_Index
+
+
+//=====================================================================|
+/**
+ * constructor
+ */
+PPU::PPU()
+	: nes(nullptr), skip_pixels(false), predict_status(true)
+{
+	Reset();
+} // end constructor
+
+
+//=====================================================================|
+/**
+ * @brief Connects the PPU to the NES it draws for; CHR and mirroring come
+ *	from its mapper.
+ */
+void PPU::Connect_NES(NES* n)
+{
+	nes = n;
+} // end Connect_NES
+
+
+//=====================================================================|
+/**
+ * @brief Power up state; the first frame starts at scanline 0 in step
+ *	with the CPU.
+ */
+void PPU::Reset()
+{
+	ctrl = mask = status = oam_addr = 0;
+	data_buffer = open_bus = 0;
+	v = t = 0;
+	fine_x = 0;
+	w = false;
+
+	scanline = 0;
+	frame_count = 0;
+	dots = nes ? nes->cpu.Get_Cycles() * 3 : 0;
+	nmi_pending = false;
+	skipping = skip_pixels;
+	predicted = false;
+
+	iZero(vram, sizeof(vram));
+	iZero(palette, sizeof(palette));
+	iZero(oam, sizeof(oam));
+	iZero(frame, sizeof(frame));
+	std::fill(frame_rgba, frame_rgba + SCREEN_WIDTH * SCREEN_HEIGHT, colors[0]);
+	iZero(bg_line, sizeof(bg_line));
+	iZero(sprite_line, sizeof(sprite_line));
+} // end Reset
+
+
+//=====================================================================|
+/**
+ * @brief A CPU read of 0x2000 - 0x3FFF. The write only registers read
+ *	back the last byte written to any register.
+ */
+u8 PPU::Read_Register(const u16 addr)
+{
+	switch (addr & 0x07)
+	{
+	case 2:
+		{
+			const u8 data = (status & 0xE0) | (open_bus & 0x1F);
+			status &= ~0x80;
+			w = false;
+			return data;
+		} // end case PPUSTATUS
+
+	case 4:
+		return oam[oam_addr];
+
+	case 7:
+		{
+			// a read lands in the buffer and comes out on the next one; the
+			//	palette answers straight away and buffers the nametable under it
+			u8 data;
+			if ((v & 0x3FFF) >= 0x3F00)
+			{
+				data = (Read_Memory(v) & ((mask & 0x01) ? 0x30 : 0x3F)) | (open_bus & 0xC0);
+				data_buffer = Read_Memory(v - 0x1000);
+			} // end if palette
+			else
+			{
+				data = data_buffer;
+				data_buffer = Read_Memory(v);
+			} // end else
+
+			v = (v + ((ctrl & 0x04) ? 32 : 1)) & 0x7FFF;
+			return data;
+		} // end case PPUDATA
+	} // end switch
+
+	return open_bus;
+} // end Read_Register
+
+
+//=====================================================================|
+/**
+ * @brief A CPU write of 0x2000 - 0x3FFF.
+ */
+void PPU::Write_Register(const u16 addr, const u8 data)
+{
+	open_bus = data;
+	predicted = false;
+
+	switch (addr & 0x07)
+	{
+	case 0:
+		{
+			// turning NMI on in the middle of vblank raises one right away
+			const bool was_on = (ctrl & 0x80) != 0;
+			ctrl = data;
+			t = (t & 0xF3FF) | ((data & 0x03) << 10);
+			if (!was_on && (ctrl & 0x80) && (status & 0x80))
+				nmi_pending = true;
+		} // end case PPUCTRL
+		break;
+
+	case 1:
+		mask = data;
+		break;
+
+	case 3:
+		oam_addr = data;
+		break;
+
+	case 4:
+		oam[oam_addr++] = data;
+		break;
+
+	case 5:
+		if (!w)
+		{
+			t = (t & 0xFFE0) | (data >> 3);
+			fine_x = data & 0x07;
+		} // end if x
+		else
+			t = (t & 0x8C1F) | ((data & 0x07) << 12) | ((data & 0xF8) << 2);
+		w = !w;
+		break;
+
+	case 6:
+		if (!w)
+			t = (t & 0x00FF) | ((data & 0x3F) << 8);
+		else
+		{
+			t = (t & 0xFF00) | data;
+			v = t;
+		} // end else low byte
+		w = !w;
+		break;
+
+	case 7:
+		Write_Memory(v, data);
+		v = (v + ((ctrl & 0x04) ? 32 : 1)) & 0x7FFF;
+		break;
+	} // end switch
+} // end Write_Register
+
+
+//=====================================================================|
+/**
+ * @brief The 256 bytes a write to 0x4014 copies in, starting at OAMADDR.
+ */
+void PPU::Write_OAM_DMA(const u8* page)
+{
+	predicted = false;
+	for (u32 i = 0; i < 256; ++i)
+		oam[(oam_addr + i) & 0xFF] = page[i];
+} // end Write_OAM_DMA
+
+
+//=====================================================================|
+/**
+ * @brief Draws the line it is on, or sets and clears the vblank flags,
+ *	then moves on to the next line.
+ *
+ * @return the dots the line lasts
+ */
+u32 PPU::Run_Scanline()
+{
+	u32 length = DOTS_PER_SCANLINE;
+
+	// a frame is drawn or not as a whole
+	if (scanline == 0)
+		skipping = skip_pixels;
+
+	if (predicted && dots / 3 >= status_change)
+		predicted = false;
+
+	if (scanline < SCREEN_HEIGHT)
+		Render_Scanline();
+	else if (scanline == VBLANK_SCANLINE)
+	{
+		status |= 0x80;
+		if (ctrl & 0x80)
+			nmi_pending = true;
+	} // end else if vblank
+	else if (scanline == PRERENDER_SCANLINE)
+	{
+		status &= ~0xE0;
+		if (Rendering())
+		{
+			// dot 257 takes the horizontal bits of t and dots 280 - 304 the
+			//	vertical ones, and the odd frames skip their last dot
+			v = (v & ~0x041F) | (t & 0x041F);
+			v = (v & ~0x7BE0) | (t & 0x7BE0);
+			if (frame_count & 1)
+				length = DOTS_PER_SCANLINE - 1;
+		} // end if
+	} // end else if pre-render
+
+	// the MMC3 counts the change of pattern table between the background
+	//	and the sprite fetches, which is once a line while rendering
+	if (Rendering() && (scanline < SCREEN_HEIGHT || scanline == PRERENDER_SCANLINE) && nes->mapper)
+		nes->mapper->Scanline();
+
+	dots += length;
+	if (++scanline == SCANLINES)
+	{
+		scanline = 0;
+		++frame_count;
+	} // end if new frame
+
+	return length;
+} // end Run_Scanline
+
+
+//=====================================================================|
+/**
+ * @brief Runs every line that has started by cpu_cycle and not been run
+ *	yet; a line starts at CPU cycle dots / 3. It stops at the end of the
+ *	frame though, leaving the next one's first line for Run_Frame to start.
+ *	Cheap when there is nothing to do, which is most of the time.
+ *
+ * @param cpu_cycle the CPU's cycle count, Get_Bus_Cycle() mid instruction
+ */
+void PPU::Catch_Up(const u64 cpu_cycle)
+{
+	while (dots / 3 <= cpu_cycle)
+	{
+		Run_Scanline();
+		if (scanline == 0)
+			break;
+	} // end while
+} // end Catch_Up
+
+
+//=====================================================================|
+/**
+ * @brief The CPU cycle the next NMI comes at: the vblank line while NMI is
+ *	on and it hasn't run yet, or right away when turning NMI on in vblank
+ *	raised one. Scheduler::NEVER when there is none coming this frame.
+ */
+u64 PPU::Next_NMI() const
+{
+	if (nmi_pending)
+		return 0;
+
+	if ((ctrl & 0x80) && scanline <= VBLANK_SCANLINE)
+		return Line_Cycle(VBLANK_SCANLINE);
+
+	return Scheduler::NEVER;
+} // end Next_NMI
+
+
+//=====================================================================|
+/**
+ * @brief The CPU cycle of the line the mapper's IRQ comes out on, counting
+ *	the lines that clock it as they go by while rendering stays as it is;
+ *	a PPUMASK write books it again. One raised and not taken yet, with the
+ *	CPU masking it, is offered again at every line until it unmasks.
+ *	Scheduler::NEVER for none this frame.
+ */
+u64 PPU::Next_Mapper_Irq() const
+{
+	if (!nes->mapper)
+		return Scheduler::NEVER;
+
+	if (nes->mapper->Irq_Pending())
+		return Line_Cycle(scanline);
+
+	u32 lines = nes->mapper->Lines_To_Irq();
+	if (!lines || !Rendering())
+		return Scheduler::NEVER;
+
+	for (u16 line = scanline; line < SCANLINES; ++line)
+	{
+		if ((line < SCREEN_HEIGHT || line == PRERENDER_SCANLINE) && !--lines)
+			return Line_Cycle(line);
+	} // end for
+
+	return Scheduler::NEVER;
+} // end Next_Mapper_Irq
+
+
+//=====================================================================|
+/**
+ * @brief Hands over an NMI raised since the last call, clearing it.
+ */
+bool PPU::Poll_NMI()
+{
+	const bool pending = nmi_pending;
+	nmi_pending = false;
+	return pending;
+} // end Poll_NMI
+
+
+//=====================================================================|
+/**
+ * @brief A byte of the pattern tables; no cartridge, no CHR.
+ */
+inline u8 PPU::Read_Chr(const u16 addr) const
+{
+	return nes->mapper ? nes->mapper->Read_Chr(addr) : 0;
+} // end Read_Chr
+
+
+//=====================================================================|
+/**
+ * @brief A row of a tile out of the mapper's tile cache, 8 pixels of
+ *	0 - 3, flipped left to right if asked; all blank with no cartridge.
+ *
+ * @param addr the pattern table address of the row's low plane byte
+ */
+inline const u8* PPU::Tile_Row(const u16 addr, const bool flip) const
+{
+	static const u8 blank[8] = { 0 };
+	return nes->mapper ? nes->mapper->Tile_Row(addr, flip) : blank;
+} // end Tile_Row
+
+
+//=====================================================================|
+/**
+ * @brief Reads the PPU's own address space.
+ */
+u8 PPU::Read_Memory(const u16 addr)
+{
+	const u16 a = addr & 0x3FFF;
+	if (a < 0x2000)
+		return Read_Chr(a);
+	if (a < 0x3F00)
+		return vram[Nametable_Offset(a)];
+
+	return palette[Palette_Index(a)];
+} // end Read_Memory
+
+
+//=====================================================================|
+/**
+ * @brief Writes the PPU's own address space; CHR ROM ignores it.
+ */
+void PPU::Write_Memory(const u16 addr, const u8 data)
+{
+	const u16 a = addr & 0x3FFF;
+	if (a < 0x2000)
+	{
+		if (nes->mapper)
+			nes->mapper->Write_Chr(a, data);
+	} // end if CHR
+	else if (a < 0x3F00)
+		vram[Nametable_Offset(a)] = data;
+	else
+		palette[Palette_Index(a)] = data & 0x3F;
+} // end Write_Memory
+
+
+//=====================================================================|
+/**
+ * @brief Where in vram a nametable address is, going by the mirroring
+ *	the cartridge has right now.
+ */
+u16 PPU::Nametable_Offset(const u16 addr) const
+{
+	const u16 table = (addr >> 10) & 0x03;
+	const Mirroring mirroring = nes->mapper ? nes->mapper->Get_Mirroring() : Mirroring::Horizontal;
+
+	u16 page;
+	switch (mirroring)
+	{
+	case Mirroring::Vertical: page = table & 1; break;
+	case Mirroring::Horizontal: page = table >> 1; break;
+	case Mirroring::Single_Lower: page = 0; break;
+	case Mirroring::Single_Upper: page = 1; break;
+	default: page = table; break;
+	} // end switch
+
+	return (page << 10) | (addr & 0x03FF);
+} // end Nametable_Offset
+
+
+//=====================================================================|
+/**
+ * @brief Draws the scanline it is on into the frame: background and
+ *	sprites each into their own line, then the compositor puts the two
+ *	together, palette indices and colors both, and says whether sprite 0
+ *	hit. Afterwards v moves down a row and back to the left edge. In a
+ *	frame that skips its pixels only the flags are worked out.
+ */
+void PPU::Render_Scanline()
+{
+	u8* out = frame + scanline * SCREEN_WIDTH;
+	u32* out_rgba = frame_rgba + scanline * SCREEN_WIDTH;
+
+	if (skipping)
+	{
+		if (Rendering())
+		{
+			if (mask & 0x10)
+				status |= Sprite_Flags(scanline, status);
+
+			Increment_Y();
+			v = (v & ~0x041F) | (t & 0x041F);
+		} // end if
+		return;
+	} // end if no pixels
+
+	if (!Rendering())
+	{
+		const u8 backdrop = palette[0] & ((mask & 0x01) ? 0x30 : 0x3F);
+		memset(out, backdrop, SCREEN_WIDTH);
+		std::fill(out_rgba, out_rgba + SCREEN_WIDTH, colors[backdrop]);
+		return;
+	} // end if off
+
+	if (mask & 0x08)
+		Render_Background();
+	else
+		iZero(bg_line, sizeof(bg_line));
+
+	if (mask & 0x10)
+		Render_Sprites();
+	else
+		iZero(sprite_line, sizeof(sprite_line));
+
+	if (compositor.Compose(bg_line, sprite_line, palette, mask, colors, out, out_rgba))
+		status |= 0x40;
+
+	Increment_Y();
+	v = (v & ~0x041F) | (t & 0x041F);
+} // end Render_Scanline
+
+
+//=====================================================================|
+/**
+ * @brief Fetches the tiles under pixels from to to - 1 of the line, 33 of
+ *	them for the whole line starting fine_x pixels into the first, and lays
+ *	out those pixels in bg_line.
+ */
+void PPU::Render_Background(const u32 from, const u32 to)
+{
+	const u16 base = (ctrl & 0x10) ? 0x1000 : 0x0000;
+	const u16 fine_y = (v >> 12) & 0x07;
+	const u32 first = (from + fine_x) >> 3;
+	const u32 last = (to - 1 + fine_x) >> 3;
+
+	// coarse x of the first tile, into the next nametable across past 31
+	u16 addr = v & ~0x001F;
+	const u32 coarse = (v & 0x001F) + first;
+	addr = coarse < 32 ? addr | coarse : (addr ^ 0x0400) | (coarse - 32);
+	s32 px = (s32)(first * 8) - (s32)fine_x;
+
+	for (u32 tile = first; tile <= last; ++tile)
+	{
+		const u8 name = vram[Nametable_Offset(0x2000 | (addr & 0x0FFF))];
+		const u8 attr = vram[Nametable_Offset(0x23C0 | (addr & 0x0C00) |
+			((addr >> 4) & 0x38) | ((addr >> 2) & 0x07))];
+		const u8 pal = ((attr >> (((addr >> 4) & 0x04) | (addr & 0x02))) & 0x03) << 2;
+
+		const u8* row = Tile_Row(base + name * 16 + fine_y, false);
+		for (u32 i = 0; i < 8; ++i, ++px)
+		{
+			if (px < (s32)from || px >= (s32)to)
+				continue;
+
+			bg_line[px] = row[i] ? pal | row[i] : 0;
+		} // end for pixels
+
+		if ((addr & 0x001F) == 31)
+			addr = (addr & ~0x001F) ^ 0x0400;
+		else
+			++addr;
+	} // end for tiles
+} // end Render_Background
+
+
+//=====================================================================|
+/**
+ * @brief The pixels of one row of a sprite, flips and all.
+ *
+ * @param sprite its four bytes of OAM
+ * @param row which row of it, counted from the top as it is stored
+ * @param height 8 or 16
+ */
+const u8* PPU::Sprite_Row(const u8* sprite, const u32 row, const u32 height) const
+{
+	const u8 tile = sprite[1], attr = sprite[2];
+	const u32 r = (attr & 0x80) ? height - 1 - row : row;
+
+	// 8x16 sprites take their pattern table from bit 0 of the tile
+	u16 pattern;
+	if (height == 16)
+		pattern = ((tile & 0x01) << 12) | ((tile & 0xFE) << 4) | ((r & 0x08) << 1) | (r & 0x07);
+	else
+		pattern = ((ctrl & 0x08) << 9) | (tile << 4) | r;
+
+	return Tile_Row(pattern, (attr & 0x40) != 0);
+} // end Sprite_Row
+
+
+//=====================================================================|
+/**
+ * @brief Finds the first eight sprites on the line and lays out their
+ *	pixels in sprite_line; where two overlap the lower numbered one wins,
+ *	whatever its priority. A ninth sets the overflow flag. A sprite shows
+ *	one line below its y, which is why nothing ever shows on line 0.
+ */
+void PPU::Render_Sprites()
+{
+	iZero(sprite_line, sizeof(sprite_line));
+
+	const s32 height = (ctrl & 0x20) ? 16 : 8;
+	u32 found = 0;
+
+	for (u32 i = 0; i < 64; ++i)
+	{
+		const u8* sprite = oam + i * 4;
+		const s32 row = (s32)scanline - 1 - sprite[0];
+		if (row < 0 || row >= height)
+			continue;
+
+		if (++found > 8)
+		{
+			status |= 0x20;
+			break;
+		} // end if overflow
+
+		const u8* pixels = Sprite_Row(sprite, row, height);
+		const u8 attr = sprite[2], x = sprite[3];
+		const u8 flags = 0x10 | ((attr & 0x03) << 2) | ((attr & 0x20) << 1) | (i == 0 ? 0x80 : 0);
+
+		for (u32 b = 0; b < 8 && x + b < SCREEN_WIDTH; ++b)
+		{
+			if (pixels[b] && !sprite_line[x + b])
+				sprite_line[x + b] = flags | pixels[b];
+		} // end for pixels
+	} // end for sprites
+} // end Render_Sprites
+
+
+//=====================================================================|
+/**
+ * @brief What a line does to the status flags, without its pixels: the
+ *	sprite count for overflow, and whether sprite 0 hits. They come out as
+ *	Render_Scanline sets them.
+ *
+ * @param line the scanline
+ * @param set the flags already set; a hit that has been is not looked for
+ *
+ * @return 0x20 for overflow and 0x40 for a hit
+ */
+u8 PPU::Sprite_Flags(const u16 line, const u8 set)
+{
+	const s32 height = (ctrl & 0x20) ? 16 : 8;
+	u32 found = 0;
+	u8 flags = 0;
+
+	for (u32 i = 0; i < 64 && found <= 8; ++i)
+	{
+		const s32 row = (s32)line - 1 - oam[i * 4];
+		if (row >= 0 && row < height)
+			++found;
+	} // end for
+	if (found > 8)
+		flags |= 0x20;
+
+	if (!(set & 0x40) && Sprite_Zero_Hits(line))
+		flags |= 0x40;
+
+	return flags;
+} // end Sprite_Flags
+
+
+//=====================================================================|
+/**
+ * @brief Whether sprite 0 hits on a line, looking at only the background
+ *	under it, which is a tile or two. Sprite 0 always makes the first
+ *	eight, and the others in front of it don't stop it hitting. The
+ *	background is wherever v points.
+ */
+bool PPU::Sprite_Zero_Hits(const u16 line)
+{
+	const s32 height = (ctrl & 0x20) ? 16 : 8;
+	const s32 row = (s32)line - 1 - oam[0];
+	if (!(mask & 0x08) || !(mask & 0x10) || row < 0 || row >= height)
+		return false;
+
+	const u32 x = oam[3];
+	const u32 end = std::min(x + 8, SCREEN_WIDTH);
+	const u8* pixels = Sprite_Row(oam, row, height);
+	Render_Background(x, end);
+
+	// the left column needs both background and sprites shown there
+	const u32 left = (mask & 0x06) == 0x06 ? 0 : 8;
+	for (u32 px = std::max(x, left); px < end && px < SCREEN_WIDTH - 1; ++px)
+	{
+		if (pixels[px - x] && bg_line[px])
+			return true;
+	} // end for
+
+	return false;
+} // end Sprite_Zero_Hits
+
+
+//=====================================================================|
+/**
+ * @brief The CPU cycle PPUSTATUS next changes at, as things stand: the
+ *	first line left this frame that sets sprite 0 hit or overflow, else
+ *	vblank, else the pre-render line that clears them. Until then a read
+ *	of it sees what it would after a catch up, so polling needn't run
+ *	lines. The lines in between are played through for their flags alone,
+ *	the way a frame that skips its pixels does, and the answer is kept
+ *	until a register, OAM or mapper write, or running past it, changes it;
+ *	Next_Status_Change only comes here then.
+ */
+u64 PPU::Predict_Status()
+{
+	// how many sprites each line has, for overflow; adding them up a
+	//	sprite at a time beats looking through all 64 on every line
+	u8 count[SCREEN_HEIGHT] = {};
+	if (mask & 0x10)
+	{
+		const u32 height = (ctrl & 0x20) ? 16 : 8;
+		for (u32 i = 0; i < 64; ++i)
+		{
+			for (u32 r = oam[i * 4] + 1; r <= oam[i * 4] + height && r < SCREEN_HEIGHT; ++r)
+				++count[r];
+		} // end for
+	} // end if
+
+	const u16 saved_v = v;
+	u16 line = scanline;
+	u8 set = status;
+
+	for (; line < SCREEN_HEIGHT; ++line)
+	{
+		if (!Rendering())
+		{
+			line = VBLANK_SCANLINE;
+			break;
+		} // end if
+
+		if (mask & 0x10)
+		{
+			u8 flags = count[line] > 8 ? 0x20 : 0;
+			if (!(set & 0x40) && Sprite_Zero_Hits(line))
+				flags |= 0x40;
+
+			if (flags & ~set)
+				break;
+			set |= flags;
+		} // end if
+
+		Increment_Y();
+		v = (v & ~0x041F) | (t & 0x041F);
+	} // end for
+
+	v = saved_v;
+	if (line == SCREEN_HEIGHT)
+		line = VBLANK_SCANLINE;
+	else if (line > VBLANK_SCANLINE)
+		line = PRERENDER_SCANLINE;
+
+	status_change = (dots + (u64)(line - scanline) * DOTS_PER_SCANLINE) / 3;
+	predicted = true;
+	return status_change;
+} // end Predict_Status
+
+
+//=====================================================================|
+/**
+ * @brief Moves v down one pixel row: fine y, then coarse y, wrapping into
+ *	the nametable below after row 29. Rows 30 and 31 are attributes and
+ *	wrap without switching.
+ */
+void PPU::Increment_Y()
+{
+	if ((v & 0x7000) != 0x7000)
+	{
+		v += 0x1000;
+		return;
+	} // end if fine y
+
+	v &= ~0x7000;
+	u16 y = (v & 0x03E0) >> 5;
+	if (y == 29)
+	{
+		y = 0;
+		v ^= 0x0800;
+	} // end if
+	else if (y == 31)
+		y = 0;
+	else
+		++y;
+
+	v = (v & ~0x03E0) | (y << 5);
+} // end Increment_Y
@@ -0,0 +1,173 @@
+/**
+ * @brief The 2C02 Picture Processing Unit. It is stepped a whole scanline
+ *	at a time rather than a dot at a time: at the start of each line the
+ *	background and sprites for it are drawn in one go from whatever the
+ *	registers hold then. That is enough for scroll splits and sprite 0
+ *	polling, which only ever look at whole lines.
+ *
+ *	Nor is it stepped along with the CPU. It lags behind, and only catches
+ *	up to the CPU's cycle count when something could tell the difference:
+ *	the CPU touching its registers, OAM DMA, a mapper write that may move
+ *	CHR or the mirroring, and the lines that raise interrupts. Each line
+ *	still runs off the registers as they were when it started, so raster
+ *	effects land where they did, and between accesses it costs nothing.
+ *
+ *	What the CPU sees, at 0x2000 - 0x2007 mirrored up to 0x3FFF:
+ *		0x2000	PPUCTRL		nametable, increment, pattern tables, sprite size, NMI
+ *		0x2001	PPUMASK		grayscale, left column, show background/sprites
+ *		0x2002	PPUSTATUS	overflow, sprite 0 hit, vblank; reading clears vblank
+ *		0x2003	OAMADDR
+ *		0x2004	OAMDATA
+ *		0x2005	PPUSCROLL	x then y
+ *		0x2006	PPUADDR		high byte then low
+ *		0x2007	PPUDATA		reads are a byte late, except from the palette
+ *	plus 0x4014, OAM DMA, which the NES forwards.
+ *
+ *	Its own 16KB address space:
+ *		0x0000 - 0x1FFF	the pattern tables; CHR, wherever the mapper has it
+ *		0x2000 - 0x2FFF	four nametables in 2KB (4KB for four screen boards)
+ *		0x3F00 - 0x3F1F	the palette
+ *
+ *	The picture comes out twice: as a 256x240 frame of palette indices,
+ *	0 - 63, and as the colors[] those stand for, ready for a screen.
+ *
+ * @author Rediet Worku
+ * @date 26th of October 2021, Sunday
+ */
+#pragma once
+
+
+//=====================================================================|
+#include "basics.hpp"
+#include "compositor.hpp"
+
+
+
+//=====================================================================|
+constexpr u32 SCREEN_WIDTH = 256;
+constexpr u32 SCREEN_HEIGHT = 240;
+
+
+
+//=====================================================================|
+class NES;
+
+class PPU
+{
+public:
+
+	static constexpr u32 DOTS_PER_SCANLINE = 341;
+	static constexpr u32 SCANLINES = 262;		// 240 drawn, 1 idle, 20 of vblank, the pre-render line
+	static constexpr u32 VBLANK_SCANLINE = 241;
+	static constexpr u32 PRERENDER_SCANLINE = 261;
+
+	// the 64 colors the palette indices stand for, as ABGR8888
+	static const u32 colors[64];
+
+	PPU();
+
+	void Connect_NES(NES* n);
+	void Reset();
+
+	// the CPU's side
+	u8 Read_Register(const u16 addr);
+	void Write_Register(const u16 addr, const u8 data);
+	void Write_OAM_DMA(const u8* page);
+
+	// does the work of the scanline it is on and moves to the next one;
+	//	returns how many dots that line lasts, 340 for the pre-render line
+	//	of every other frame while rendering is on, else 341
+	u32 Run_Scanline();
+	void Catch_Up(const u64 cpu_cycle);
+	// the CPU cycle a line of this frame not run yet starts at; all but
+	//	the last are the same length, so it is exact
+	u64 Line_Cycle(const u16 line) const { return (dots + (u64)(line - scanline) * DOTS_PER_SCANLINE) / 3; }
+	u64 Next_NMI() const;
+	u64 Next_Mapper_Irq() const;
+	u64 Next_Status_Change() { return !predict_status ? 0 : predicted ? status_change : Predict_Status(); }
+	void Forget_Prediction() { predicted = false; }
+	// off, every PPUSTATUS read runs the lines first, the way it was before
+	//	the prediction; what a poll sees has to come out the same either way
+	void Set_Status_Prediction(const bool on) { predict_status = on; predicted = false; }
+	bool Poll_NMI();
+
+	u16 Get_Scanline() const { return scanline; }
+	u64 Get_Frame() const { return frame_count; }
+	u64 Get_Dots() const { return dots; }
+	// frames that start from now on don't draw their pixels, for fast
+	//	forward and runs nobody watches; the game sees the same flags and
+	//	timing, and the frame buffers keep the last frame drawn
+	void Skip_Pixels(const bool skip) { skip_pixels = skip; }
+	bool Is_Skipping_Pixels() const { return skipping; }
+
+	const u8* Get_Frame_Buffer() const { return frame; }
+	const u32* Get_Frame_RGBA() const { return frame_rgba; }
+	Compositor& Get_Compositor() { return compositor; }
+
+private:
+
+	NES* nes;
+
+	// registers
+	u8 ctrl;			// PPUCTRL
+	u8 mask;			// PPUMASK
+	u8 status;			// PPUSTATUS; only the top three bits mean anything
+	u8 oam_addr;		// OAMADDR
+	u8 data_buffer;		// what the next PPUDATA read returns
+	u8 open_bus;		// the last byte written to any of them
+
+	// the scroll registers as the 2C02 keeps them: v is the current VRAM
+	//	address, t the one the next frame or line starts from, both laid out
+	//	yyy NN YYYYY XXXXX; fine_x is the pixel within the tile, and w picks
+	//	which half of PPUSCROLL/PPUADDR the next write goes to
+	u16 v, t;
+	u8 fine_x;
+	bool w;
+
+	// timing
+	u16 scanline;		// 0 - 239 drawn, 261 pre-render
+	u64 frame_count;
+	u64 dots;			// dots since power up, at the start of the current line
+	bool nmi_pending;
+
+	bool skip_pixels;	// what the next frame does
+	bool skipping;		// what this one does
+
+	// the CPU cycle PPUSTATUS next changes at, while predicted
+	u64 status_change;
+	bool predicted;
+	bool predict_status;	// whether to at all
+
+	// memory
+	u8 vram[4096];		// nametables; only four screen boards use the second 2KB
+	u8 palette[32];
+	u8 oam[256];		// 64 sprites of y, tile, attributes, x
+
+	u8 frame[SCREEN_WIDTH * SCREEN_HEIGHT];		// palette indices
+	u32 frame_rgba[SCREEN_WIDTH * SCREEN_HEIGHT];	// the same as colors[]
+
+	// one scanline before it is composed; background pixels are the
+	//	palette entry 0x00 - 0x0F (0 for transparent), sprite pixels the entry
+	//	0x10 - 0x1F with bit 6 set when behind the background and bit 7 when
+	//	it came from sprite 0 (0 for no sprite)
+	u8 bg_line[SCREEN_WIDTH];
+	u8 sprite_line[SCREEN_WIDTH];
+	Compositor compositor;
+
+	bool Rendering() const { return (mask & 0x18) != 0; }
+
+	u8 Read_Chr(const u16 addr) const;
+	const u8* Tile_Row(const u16 addr, const bool flip) const;
+	u8 Read_Memory(const u16 addr);
+	void Write_Memory(const u16 addr, const u8 data);
+	u16 Nametable_Offset(const u16 addr) const;
+
+	void Render_Scanline();
+	void Render_Background(const u32 from = 0, const u32 to = SCREEN_WIDTH);
+	void Render_Sprites();
+	const u8* Sprite_Row(const u8* sprite, const u32 row, const u32 height) const;
+	u8 Sprite_Flags(const u16 line, const u8 set);
+	bool Sprite_Zero_Hits(const u16 line);
+	u64 Predict_Status();
+	void Increment_Y();
+};
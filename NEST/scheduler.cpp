@@ -0,0 +1,66 @@
+/**
+ * @brief The implementation of the event scheduler.
+ *
+ * @author Rediet Worku
+ * @date 26th of October 2021, Sunday
+ */
+
+//=====================================================================|
+#include "scheduler.hpp"
+
+
+
+//=====================================================================|
+/**
+ * constructor; nothing booked
+ */
+Scheduler::Scheduler()
+{
+	Reset();
+} // end constructor
+
+
+//=====================================================================|
+/**
+ * @brief Cancels every event.
+ */
+void Scheduler::Reset()
+{
+	for (u64& d : deadline)
+		d = NEVER;
+
+	next = NEVER;
+	first = Event::Nmi;
+} // end Reset
+
+
+//=====================================================================|
+/**
+ * @brief Books e for cycle, in place of whatever it had. Only when the
+ *	earliest event moves later does the rest need looking at again.
+ *
+ * @param e the event
+ * @param cycle the CPU cycle it happens at; NEVER to cancel it
+ */
+void Scheduler::Schedule(const Event e, const u64 cycle)
+{
+	deadline[(u32)e] = cycle;
+
+	if (cycle <= next)
+	{
+		next = cycle;
+		first = e;
+	} // end if sooner
+	else if (e == first)
+	{
+		next = NEVER;
+		for (u32 i = 0; i < (u32)Event::Count; ++i)
+		{
+			if (deadline[i] < next)
+			{
+				next = deadline[i];
+				first = (Event)i;
+			} // end if
+		} // end for
+	} // end else if the earliest moved
+} // end Schedule
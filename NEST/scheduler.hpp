@@ -0,0 +1,54 @@
+/**
+ * @brief The master clock's diary, keyed on the CPU's cycle count. Each
+ *	thing that needs the CPU stopped, an interrupt coming or the end of
+ *	the frame, books the cycle it next does under its own event; the CPU
+ *	then runs straight through to the earliest, and nothing looks at the
+ *	devices in between. An event that moves is booked again, sooner or
+ *	later, and one with nothing coming goes back to NEVER.
+ *
+ *	There are only a handful of events, each with its one slot, so the
+ *	queue is a plain array with the earliest kept to hand; booking rescans
+ *	it only when the earliest moves later, which for this few beats any
+ *	heap.
+ *
+ * @author Rediet Worku
+ * @date 26th of October 2021, Sunday
+ */
+#pragma once
+
+
+//=====================================================================|
+#include "basics.hpp"
+
+
+
+//=====================================================================|
+class Scheduler
+{
+public:
+
+	// the vblank NMI, the mapper's scanline IRQ and the pre-render line,
+	//	which ends the frame
+	enum class Event : u8 { Nmi, Mapper_Irq, Frame_End, Count };
+
+	static constexpr u64 NEVER = ~0ull;
+
+	Scheduler();
+
+	void Reset();
+	void Schedule(const Event e, const u64 cycle);
+	void Cancel(const Event e) { Schedule(e, NEVER); }
+
+	u64 When(const Event e) const { return deadline[(u32)e]; }
+	bool Is_Due(const Event e, const u64 cycle) const { return deadline[(u32)e] <= cycle; }
+
+	// the earliest booking, and whose it is
+	u64 Next() const { return next; }
+	Event Next_Event() const { return first; }
+
+private:
+
+	u64 deadline[(u32)Event::Count];
+	u64 next;
+	Event first;
+};
@@ -0,0 +1,65 @@
+/**
+ * @brief A fixed size ring for one thread to push into and one other to
+ *	pop from, with no locks: each side only ever stores its own index and
+ *	reads the other's, and the release/acquire pair on them is what makes
+ *	an item visible before its slot is counted. Full and empty are told
+ *	apart by the indices running freely and only being wrapped to look a
+ *	slot up, so SIZE has to be a power of two.
+ *
+ * @author Rediet Worku
+ * @date 26th of October 2021, Sunday
+ */
+#pragma once
+
+
+//=====================================================================|
+#include "basics.hpp"
+#include <atomic>
+
+
+
+//=====================================================================|
+template <typename T, u32 SIZE>
+class SpscQueue
+{
+	static_assert((SIZE & (SIZE - 1)) == 0, "SpscQueue needs a power of two");
+
+public:
+
+	SpscQueue() : head(0), tail(0) {}
+
+	SpscQueue(const SpscQueue&) = delete;
+	SpscQueue& operator=(const SpscQueue&) = delete;
+
+	// the producer's side; false when full
+	bool Push(const T& item)
+	{
+		const u32 t = tail.load(std::memory_order_relaxed);
+		if (t - head.load(std::memory_order_acquire) == SIZE)
+			return false;
+
+		items[t & (SIZE - 1)] = item;
+		tail.store(t + 1, std::memory_order_release);
+		return true;
+	} // end Push
+
+	// the consumer's side; false when empty
+	bool Pop(T& item)
+	{
+		const u32 h = head.load(std::memory_order_relaxed);
+		if (h == tail.load(std::memory_order_acquire))
+			return false;
+
+		item = items[h & (SIZE - 1)];
+		head.store(h + 1, std::memory_order_release);
+		return true;
+	} // end Pop
+
+private:
+
+	T items[SIZE];
+
+	// apart, so the two sides don't share a cache line
+	alignas(64) std::atomic<u32> head;
+	alignas(64) std::atomic<u32> tail;
+};
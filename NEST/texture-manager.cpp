@@ -184,6 +184,84 @@ void TextureManager::Plot_Pixel(const int x, const int y, const u32 c)
 	buffer[x + y * pitch] = c;
 } // end Plot_Pixel
 
+//=====================================================================|
+/**
+ * @brief Colors a whole frame of palette indices into the texture. Each
+ *	row is looked up straight into the locked texture, pitch and all, 8
+ *	pixels a gather where the CPU has AVX2; with Use_Update_Texture on it
+ *	is colored into staging and handed to SDL_UpdateTexture in one go.
+ *	Emphasis is the caller's: with a 512 entry table pass the 64 entries
+ *	for the emphasis bits, colors + emphasis * 64.
+ *
+ * @param id a streaming texture
+ * @param indices w x h palette indices, 0 - 63, a row after the other
+ * @param colors what each index looks like
+ *
+ * @return true if successful
+ */
+bool TextureManager::Upload_Frame(const int id, const u8* indices, const u32* colors)
+{
+	if (id < 0 || id >= textures.size())
+		return false;
+
+	const u32 w = textures[id].w;
+	const u32 h = textures[id].h;
+	if (update_texture)
+	{
+		staging.resize((size_t)w * h);
+		compositor.Colorize(indices, colors, staging.data(), w * h);
+		return SDL_UpdateTexture(textures[id].ptexture, nullptr, staging.data(), w * 4) == 0;
+	} // end if
+
+	if (!Lock(id))
+		return false;
+
+	if ((u32)pitch == w)
+		compositor.Colorize(indices, colors, buffer, w * h);
+	else
+	{
+		for (u32 y = 0; y < h; ++y)
+			compositor.Colorize(indices + y * w, colors, buffer + y * pitch, w);
+	} // end else
+
+	return Unlock(id);
+} // end Upload_Frame
+
+//=====================================================================|
+/**
+ * @brief Copies a whole frame that is already in color into the texture,
+ *	a row at a time into the locked texture or, with Use_Update_Texture
+ *	on, straight out of rgba by SDL_UpdateTexture with no copy of our own.
+ *
+ * @param id a streaming texture
+ * @param rgba w x h ABGR8888 pixels, a row after the other
+ *
+ * @return true if successful
+ */
+bool TextureManager::Upload_Pixels(const int id, const u32* rgba)
+{
+	if (id < 0 || id >= textures.size())
+		return false;
+
+	const u32 w = textures[id].w;
+	const u32 h = textures[id].h;
+	if (update_texture)
+		return SDL_UpdateTexture(textures[id].ptexture, nullptr, rgba, w * 4) == 0;
+
+	if (!Lock(id))
+		return false;
+
+	if ((u32)pitch == w)
+		memcpy(buffer, rgba, (size_t)w * h * 4);
+	else
+	{
+		for (u32 y = 0; y < h; ++y)
+			memcpy(buffer + y * pitch, rgba + y * w, w * 4);
+	} // end else
+
+	return Unlock(id);
+} // end Upload_Pixels
+
 //=====================================================================|
 /**
  * @brief blast's whatever is contained within the source texture to 
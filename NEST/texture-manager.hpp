@@ -9,6 +9,7 @@
 
 //=====================================================================|
 #include "basics.hpp"
+#include "compositor.hpp"
 #include <SDL.h>
 #include <SDL_ttf.h>
 
@@ -39,18 +40,11 @@ class TextureManager
 {
 public:
 
-	// singlton; we don't want making instances of this baby in our
-	//	implementations
-	static TextureManager* Instance()
-	{
-		static TextureManager* ptext = nullptr;
-		if (!ptext)
-			ptext = new TextureManager();
+	// one for each renderer; the textures it hands out belong to that one
+	TextureManager() : pfont(nullptr), pitch(0), buffer(nullptr), update_texture(false) {}
+	TextureManager(const TextureManager&) = delete;
+	TextureManager& operator=(const TextureManager&) = delete;
 
-		return ptext;
-	} // end Instance
-
-	
 	bool Load_Font(const std::string& file_path, const int font_size = 16);
 	int Create_Texture(const int width, const int height, SDL_Renderer* prend,
 		const int access = SDL_TEXTUREACCESS_STREAMING);
@@ -62,6 +56,11 @@ public:
 	bool Lock(const int id);
 	bool Unlock(const int id);
 	void Plot_Pixel(const int x, const int y, const u32 c);
+
+	// whole frames at once, the texture's width and height of them
+	bool Upload_Frame(const int id, const u8* indices, const u32* colors);
+	bool Upload_Pixels(const int id, const u32* rgba);
+	void Use_Update_Texture(const bool on) { update_texture = on; }
 	void Draw(const int id, SDL_Renderer* prend, const int x, const int y,
 		const int width = -1, const int height = -1);
 
@@ -79,8 +78,6 @@ public:
 
 private:
 
-	TextureManager() : pfont(nullptr), pitch(0), buffer(nullptr) {}
-
 	std::vector<TextureInfo> textures;		// holds all sdl textures here
 	std::map<std::string, int> mneumonics;	// mneumonics mapper for emulator iv
 
@@ -88,4 +85,10 @@ private:
 
 	int pitch;		// horizontal strides in pixels (deals with 32-bit color mode only)
 	u32* buffer;	// used on locked surfaces, pointer to that surface/texture
+
+	// uploads go through SDL_UpdateTexture instead of a lock, for renderers
+	//	that are slow to lock; frames of indices are colored into staging
+	bool update_texture;
+	std::vector<u32> staging;
+	Compositor compositor;		// for Colorize, the fastest the CPU has
 };
\ No newline at end of file
@@ -0,0 +1,72 @@
+/**
+ * @brief The implementation of the CHR tile cache.
+ *
+ * @author Rediet Worku
+ * @date 26th of October 2021, Sunday
+ */
+
+//=====================================================================|
+#include "tile-cache.hpp"
+
+
+
+//=====================================================================|
+/**
+ * constructor
+ */
+TileCache::TileCache()
+	: chr(nullptr)
+{ }
+
+
+//=====================================================================|
+/**
+ * @brief Sizes the cache for size bytes of CHR at chr. ROM is decoded
+ *	right away; RAM is left dirty for the first use of each tile to
+ *	decode, as it changes under the cache anyway.
+ *
+ * @param chr the CHR, which has to stay put for as long as the cache is used
+ * @param size its size in bytes, a multiple of 16
+ * @param writable true for CHR RAM
+ */
+void TileCache::Build(const u8* chr, const u32 size, const bool writable)
+{
+	const u32 tiles = size / TILE_BYTES;
+	this->chr = chr;
+	pixels.assign((size_t)tiles * TILE_PIXELS * 2, 0);
+	dirty.assign(tiles, writable ? 1 : 0);
+
+	if (!writable)
+	{
+		for (u32 tile = 0; tile < tiles; ++tile)
+			Decode(tile);
+	} // end if ROM
+} // end Build
+
+
+//=====================================================================|
+/**
+ * @brief Decodes a tile both ways round: bit 7 of each plane is the
+ *	leftmost pixel, the low plane gives bit 0 of the pixel, the high one
+ *	bit 1.
+ */
+void TileCache::Decode(const u32 tile)
+{
+	const u8* src = chr + tile * TILE_BYTES;
+	u8* out = &pixels[tile * TILE_PIXELS * 2];
+	u8* flipped = out + TILE_PIXELS;
+
+	for (u32 row = 0; row < 8; ++row)
+	{
+		const u8 lo = src[row];
+		const u8 hi = src[row + 8];
+		for (u32 x = 0; x < 8; ++x)
+		{
+			const u8 pixel = ((lo >> (7 - x)) & 1) | (((hi >> (7 - x)) & 1) << 1);
+			out[row * 8 + x] = pixel;
+			flipped[row * 8 + 7 - x] = pixel;
+		} // end for pixels
+	} // end for rows
+
+	dirty[tile] = 0;
+} // end Decode
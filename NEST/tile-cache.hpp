@@ -0,0 +1,56 @@
+/**
+ * @brief A cache of decoded CHR tiles. A tile is 16 bytes of CHR, two
+ *	bitplanes of 8 rows each, and every pixel the PPU draws needs a bit out
+ *	of both; decoding them once into a byte a pixel, 0 - 3, leaves the
+ *	fetch paths a plain load. Each tile is kept twice, as is and flipped
+ *	left to right for the sprites that ask for it; vertical flips only pick
+ *	another row.
+ *
+ *	CHR ROM is decoded in full when the cache is built. CHR RAM starts out
+ *	dirty, and every write marks the tile it lands in dirty again; a dirty
+ *	tile is decoded the next time one of its rows is asked for.
+ *
+ * @author Rediet Worku
+ * @date 26th of October 2021, Sunday
+ */
+#pragma once
+
+
+//=====================================================================|
+#include "basics.hpp"
+
+
+
+//=====================================================================|
+class TileCache
+{
+public:
+
+	static constexpr u32 TILE_BYTES = 16;		// CHR bytes a tile
+	static constexpr u32 TILE_PIXELS = 64;		// decoded bytes a tile, each way
+
+	TileCache();
+
+	void Build(const u8* chr, const u32 size, const bool writable);
+
+	// offset of any byte of a tile in CHR
+	void Mark_Dirty(const u32 offset) { dirty[offset / TILE_BYTES] = 1; }
+
+	// the 8 pixels of the row whose low plane byte is at offset
+	const u8* Row(const u32 offset, const bool flip)
+	{
+		const u32 tile = offset / TILE_BYTES;
+		if (dirty[tile])
+			Decode(tile);
+
+		return &pixels[tile * TILE_PIXELS * 2 + (flip ? TILE_PIXELS : 0) + (offset & 7) * 8];
+	} // end Row
+
+private:
+
+	const u8* chr;				// where the tiles come from
+	std::vector<u8> pixels;		// per tile, 64 as is then 64 flipped
+	std::vector<u8> dirty;		// non zero for tiles to decode before use
+
+	void Decode(const u32 tile);
+};
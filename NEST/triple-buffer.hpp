@@ -0,0 +1,68 @@
+/**
+ * @brief Three copies of something, for one thread to fill while another
+ *	looks at the last one finished, with neither ever waiting on the other.
+ *	The writer has one slot to itself, the reader another, and the third is
+ *	the one in between; publishing swaps the writer's slot with it, and the
+ *	reader swaps its own for it whenever it holds something newer. The swap
+ *	is a single atomic exchange of the slot index, plus a bit for whether
+ *	the one in between was published since the reader last took it.
+ *
+ *	A writer that publishes twice before the reader looks drops the first;
+ *	Publish tells it so, for anything that has to carry over.
+ *
+ * @author Rediet Worku
+ * @date 26th of October 2021, Sunday
+ */
+#pragma once
+
+
+//=====================================================================|
+#include "basics.hpp"
+#include <atomic>
+
+
+
+//=====================================================================|
+template <typename T>
+class TripleBuffer
+{
+public:
+
+	TripleBuffer() : slots(3), back(0), front(1), middle(2) {}
+
+	TripleBuffer(const TripleBuffer&) = delete;
+	TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+	// the writer's side; the slot to fill, then hands it over. Returns
+	//	false when the slot it gets back in exchange was never read
+	T& Back() { return slots[back]; }
+	bool Publish()
+	{
+		const u8 old = middle.exchange(back | FRESH, std::memory_order_acq_rel);
+		back = old & SLOT;
+		return (old & FRESH) == 0;
+	} // end Publish
+
+	// the reader's side; takes the newest slot published, if there is one
+	//	newer than what it has, and Front is it until the next time
+	bool Acquire()
+	{
+		if (!(middle.load(std::memory_order_relaxed) & FRESH))
+			return false;
+
+		front = middle.exchange(front, std::memory_order_acq_rel) & SLOT;
+		return true;
+	} // end Acquire
+
+	T& Front() { return slots[front]; }
+
+private:
+
+	static constexpr u8 SLOT = 0x03;
+	static constexpr u8 FRESH = 0x04;
+
+	std::vector<T> slots;		// on the heap; frames are big
+	u8 back;					// the writer's
+	u8 front;					// the reader's
+	std::atomic<u8> middle;		// the one in between, and FRESH
+};
@@ -0,0 +1,215 @@
+/**
+ * @brief Cartridge headers, good and bad. Each case is a small image made
+ *	up here and written to the temp directory: iNES and NES 2.0 headers,
+ *	with and without a trainer, NES 2.0's long and exponent sizes, and
+ *	files cut short or with sizes no board could have.
+ *
+ *	The good ones have to come out with the mapper, mirroring and RAM the
+ *	header says and PRG, CHR and the trainer spanning exactly their bytes
+ *	of the file; the bad ones have to be turned down with a reason and
+ *	leave nothing loaded.
+ *
+ * @author Rediet Worku
+ * @date 26th of October 2021, Sunday
+ */
+
+
+//=====================================================================|
+#include "test.hpp"
+
+
+
+//=====================================================================|
+// what a good image has to load as
+struct Parse_Case
+{
+	const char* name;
+	u8 header[16];
+	u32 prg_size, chr_size;		// the bytes that follow the header
+	bool trainer;
+
+	u16 mapper;
+	u8 submapper;
+	bool nes2;
+	Mirroring mirroring;
+	bool battery;
+	u32 prg_ram_size;
+};
+
+
+static const Parse_Case good[] = {
+	{ "iNES NROM", { 'N', 'E', 'S', 0x1A, 2, 1, 0x01, 0x00 }, 32768, 8192, false,
+		0, 0, false, Mirroring::Vertical, false, 8192 },
+	{ "iNES NROM 16KB", { 'N', 'E', 'S', 0x1A, 1, 1, 0x00, 0x00 }, 16384, 8192, false,
+		0, 0, false, Mirroring::Horizontal, false, 8192 },
+	{ "iNES CHR RAM, battery, high mapper nibble", { 'N', 'E', 'S', 0x1A, 8, 0, 0x12, 0x40 }, 131072, 0, false,
+		0x41, 0, false, Mirroring::Horizontal, true, 8192 },
+	{ "iNES trainer", { 'N', 'E', 'S', 0x1A, 2, 2, 0x44, 0x00 }, 32768, 16384, true,
+		4, 0, false, Mirroring::Horizontal, false, 8192 },
+	{ "iNES four screen", { 'N', 'E', 'S', 0x1A, 2, 1, 0x49, 0x00 }, 32768, 8192, false,
+		4, 0, false, Mirroring::Four_Screen, false, 8192 },
+	{ "iNES with bytes left over", { 'N', 'E', 'S', 0x1A, 1, 1, 0x00, 0x00 }, 16384, 8192 + 100, false,
+		0, 0, false, Mirroring::Horizontal, false, 8192 },
+	{ "NES 2.0 mapper 260, submapper 2", { 'N', 'E', 'S', 0x1A, 2, 1, 0x40, 0x08, 0x21, 0x00, 0x07 }, 32768, 8192, false,
+		0x104, 2, true, Mirroring::Horizontal, false, 8192 },
+	{ "NES 2.0 RAM and NVRAM", { 'N', 'E', 'S', 0x1A, 2, 0, 0x13, 0x08, 0x00, 0x00, 0x97 }, 32768, 0, false,
+		1, 0, true, Mirroring::Vertical, true, 8192 + 32768 },
+	{ "NES 2.0 trainer", { 'N', 'E', 'S', 0x1A, 1, 1, 0x04, 0x08, 0x00, 0x00, 0x00 }, 16384, 8192, true,
+		0, 0, true, Mirroring::Horizontal, false, 0 },
+	{ "NES 2.0 exponent sizes", { 'N', 'E', 'S', 0x1A, 0x39, 0x35, 0x20, 0x08, 0x00, 0xFF, 0x00 }, 49152, 24576, false,
+		2, 0, true, Mirroring::Horizontal, false, 0 },
+	{ "NES 2.0 size MSB", { 'N', 'E', 'S', 0x1A, 0x00, 0x00, 0x00, 0x08, 0x00, 0x01, 0x00 }, 4194304, 0, false,
+		0, 0, true, Mirroring::Horizontal, false, 0 },
+};
+
+
+// an image that has to be turned down: the header, and how many bytes
+//	follow it
+struct Reject_Case
+{
+	const char* name;
+	u8 header[16];
+	u32 size;
+};
+
+
+static const Reject_Case bad[] = {
+	{ "not iNES", { 'N', 'E', 'S', 0x1B, 2, 1 }, 40960 },
+	{ "no PRG", { 'N', 'E', 'S', 0x1A, 0, 1 }, 8192 },
+	{ "CHR cut short", { 'N', 'E', 'S', 0x1A, 2, 1 }, 40959 },
+	{ "PRG cut short", { 'N', 'E', 'S', 0x1A, 2, 0 }, 16384 },
+	{ "trainer cut short", { 'N', 'E', 'S', 0x1A, 1, 1, 0x04 }, 24576 },
+	{ "header alone", { 'N', 'E', 'S', 0x1A, 1, 1 }, 0 },
+	{ "NES 2.0 PRG of 4KB", { 'N', 'E', 'S', 0x1A, 0x30, 0x00, 0x00, 0x08, 0x00, 0x0F }, 4096 },
+	{ "NES 2.0 exponent too big", { 'N', 'E', 'S', 0x1A, 0xFC, 0x00, 0x00, 0x08, 0x00, 0x0F }, 16384 },
+	{ "NES 2.0 size MSB past the file", { 'N', 'E', 'S', 0x1A, 0x02, 0x01, 0x00, 0x08, 0x00, 0x10 }, 32768 + 8192 },
+};
+
+
+
+//=====================================================================|
+/**
+ * @brief The header, then size bytes nothing else has.
+ */
+static std::vector<u8> Build(const u8 (&header)[16], const u32 size)
+{
+	std::vector<u8> image(header, header + 16);
+	u32 state = 0x2545F491 ^ size;
+	for (u32 i = 0; i < size; i++)
+		image.push_back((u8)Random(state));
+
+	return image;
+} // end Build
+
+
+//=====================================================================|
+/**
+ * @brief Writes image out to the temp directory as name and loads it,
+ *	deleting the file again; the mapping keeps it.
+ *
+ * @return what Load says
+ */
+static bool Load(Cartridge& cart, const std::vector<u8>& image, const char* name)
+{
+	const std::string path = (std::filesystem::temp_directory_path() / name).string();
+	FILE* fp = fopen(path.c_str(), "wb");
+	if (!fp)
+		return Check(false, "can't write %s", path.c_str());
+	const bool written = image.empty() || fwrite(image.data(), 1, image.size(), fp) == image.size();
+	fclose(fp);
+
+	const bool ok = written && cart.Load(path);
+	std::error_code ignored;
+	std::filesystem::remove(path, ignored);
+	return ok;
+} // end Load
+
+
+//=====================================================================|
+/**
+ * @brief Checks a span is exactly size bytes of image from offset on.
+ */
+static bool Check_Span(const Rom_Span& span, const std::vector<u8>& image, const size_t offset,
+	const u32 size, const char* name, const char* part)
+{
+	if (!size)
+		return Check(span.data == nullptr && span.size == 0, "%s: %u bytes of %s, not none", name, span.size, part);
+
+	return Check(span.data && span.size == size && memcmp(span.data, &image[offset], size) == 0,
+		"%s: %s isn't the %u bytes from %zu, it's %u bytes", name, part, size, offset, span.size);
+} // end Check_Span
+
+
+//=====================================================================|
+static void Test_Good(const Parse_Case& c)
+{
+	const u32 trainer = c.trainer ? 512 : 0;
+	const std::vector<u8> image = Build(c.header, trainer + c.prg_size + c.chr_size);
+
+	Cartridge cart;
+	if (!Check(Load(cart, image, "cartridge-parse.nes"), "%s: turned down, %s", c.name, cart.Get_Error_Message().c_str()))
+		return;
+
+	Check(cart.Mapper() == c.mapper && cart.Submapper() == c.submapper, "%s: mapper %u.%u, not %u.%u",
+		c.name, cart.Mapper(), cart.Submapper(), c.mapper, c.submapper);
+	Check(cart.Is_NES2() == c.nes2, "%s: %s NES 2.0", c.name, c.nes2 ? "not" : "taken for");
+	Check(cart.Get_Mirroring() == c.mirroring, "%s: mirroring %u, not %u",
+		c.name, (u32)cart.Get_Mirroring(), (u32)c.mirroring);
+	Check(cart.Has_Battery() == c.battery, "%s: battery %u, not %u", c.name, cart.Has_Battery(), c.battery);
+	Check(cart.Prg_Ram_Size() == c.prg_ram_size, "%s: %u bytes of PRG RAM, not %u",
+		c.name, cart.Prg_Ram_Size(), c.prg_ram_size);
+
+	// left over bytes after CHR belong to nothing
+	const u32 chr_size = c.chr_size & ~8191u;
+	Check_Span(cart.Trainer(), image, 16, trainer, c.name, "the trainer");
+	Check_Span(cart.Prg(), image, 16 + trainer, c.prg_size, c.name, "PRG");
+	Check_Span(cart.Chr(), image, 16 + trainer + c.prg_size, chr_size, c.name, "CHR");
+	Check(cart.Has_Chr_Ram() == !chr_size, "%s: CHR RAM %u", c.name, cart.Has_Chr_Ram());
+} // end Test_Good
+
+
+//=====================================================================|
+static void Test_Bad(const Reject_Case& c)
+{
+	const std::vector<u8> image = Build(c.header, c.size);
+
+	// something good in first, so turning this down has to let it go
+	Cartridge cart;
+	const u8 nrom[16] = { 'N', 'E', 'S', 0x1A, 1, 1 };
+	if (!Check(Load(cart, Build(nrom, 16384 + 8192), "cartridge-parse.nes"), "%s: NROM turned down", c.name))
+		return;
+
+	if (!Check(!Load(cart, image, "cartridge-parse.nes"), "%s: taken", c.name))
+		return;
+	Check(!cart.Get_Error_Message().empty(), "%s: turned down with no reason", c.name);
+	Check(!cart.Is_Loaded() && !cart.Prg().data && !cart.Chr().data && !cart.Trainer().data,
+		"%s: left loaded", c.name);
+} // end Test_Bad
+
+
+//=====================================================================|
+int main()
+{
+	for (const Parse_Case& c : good)
+		Test_Good(c);
+	for (const Reject_Case& c : bad)
+		Test_Bad(c);
+
+	// shorter than a header, and nothing at all
+	for (const u32 size : { 15u, 0u })
+	{
+		Cartridge cart;
+		const std::vector<u8> image(good[0].header, good[0].header + size);
+		Check(!Load(cart, image, "cartridge-parse.nes") && !cart.Is_Loaded(), "a file of %u bytes taken", size);
+	} // end for
+
+	// and no file
+	Cartridge cart;
+	Check(!cart.Load((std::filesystem::temp_directory_path() / "cartridge-parse-missing.nes").string()) &&
+		!cart.Get_Error_Message().empty(), "a missing file taken");
+
+	if (!failures)
+		printf("cartridge-parse: %zu images taken, %zu turned down\n",
+			sizeof(good) / sizeof(good[0]), sizeof(bad) / sizeof(bad[0]) + 3);
+	return failures ? 1 : 0;
+} // end main
@@ -0,0 +1,280 @@
+/**
+ * @brief CHR RAM rewritten after its tiles are decoded. The program puts
+ *	a tile into CHR RAM through PPUADDR and PPUDATA, shows it once as
+ *	background and twice as a sprite, as is and flipped left to right,
+ *	then a few frames on writes a different tile over it from the NMI.
+ *
+ *	The tile cache's rows, as is and flipped, have to be the tile that is
+ *	in CHR RAM after every frame, and so do the pictures: the first tile
+ *	before the write and the second after it, never a stale decode.
+ *
+ * @author Rediet Worku
+ * @date 26th of October 2021, Sunday
+ */
+
+
+//=====================================================================|
+#include "test.hpp"
+
+
+
+//=====================================================================|
+constexpr u32 FRAMES = 10;
+constexpr u32 SETTLED = 3;				// the frames before it is all up
+constexpr u8 REWRITE = 4;				// the NMI rewrites the tile on this frame
+
+constexpr u8 TILE = 5;
+constexpr u16 TILE_ADDR = TILE * 16;	// in the pattern tables
+
+// where the program keeps things
+constexpr u16 FRAME = 0x0030;			// counted by the NMI
+constexpr u16 SPRITES = 0x0200;			// copied to OAM before rendering goes on
+constexpr u16 TILES = 0xF000;			// the two tiles' 16 bytes each, in PRG
+
+// two tiles, plane 0 then plane 1, neither the same flipped
+constexpr u8 tiles[2][16] = {
+	{ 0x80, 0xC0, 0xE0, 0xF0, 0x0F, 0x07, 0x03, 0x01, 0x00, 0x11, 0x22, 0x44, 0x88, 0x99, 0xAA, 0xFF },
+	{ 0x01, 0x3C, 0x42, 0x81, 0x6D, 0x00, 0xF8, 0x1F, 0xC1, 0x0E, 0x55, 0x24, 0x00, 0x7F, 0x90, 0x31 }
+};
+
+constexpr u8 palette[8] = { 0x0F, 0x01, 0x02, 0x03, 0x0F, 0x11, 0x12, 0x13 };
+
+// where the tile shows: the background's, then the sprites as is and flipped
+constexpr u32 BG_X = 16, BG_Y = 16;
+constexpr u8 SPRITE_Y = 40, SPRITE_X = 40, FLIPPED_X = 80;
+
+static const CPU6502::Backend backends[] = {
+	CPU6502::Backend::Switch, CPU6502::Backend::Lookup,
+	CPU6502::Backend::Blocks, CPU6502::Backend::Jit
+};
+
+
+
+//=====================================================================|
+/**
+ * @brief Writes one of the tiles into CHR RAM through PPUADDR and PPUDATA.
+ *	Uses A and X.
+ */
+static void Write_Tile(Assembler& as, const u32 which)
+{
+	as.Op(0xA9, TILE_ADDR >> 8); as.Op16(0x8D, 0x2006);
+	as.Op(0xA9, TILE_ADDR & 0xFF); as.Op16(0x8D, 0x2006);
+	as.Op(0xA2, 0x00);									// LDX #0
+	const u16 copy = as.pc;
+	as.Op16(0xBD, TILES + which * 16);					// LDA tile,X
+	as.Op16(0x8D, 0x2007);								// STA $2007
+	as.Op(0xE8);										// INX
+	as.Op(0xE0, 16);									// CPX #16
+	as.Branch(0xD0, copy);								// BNE copy
+} // end Write_Tile
+
+
+//=====================================================================|
+/**
+ * @brief The cartridge: NROM, the program in 32KB of PRG, and no CHR, so
+ *	8KB of CHR RAM.
+ */
+static std::vector<u8> Build()
+{
+	Assembler as;
+	as.Op(0x78);										// SEI
+	as.Op(0xD8);										// CLD
+	as.Op(0xA2, 0xFF); as.Op(0x9A);						// LDX #$FF; TXS
+	for (u32 i = 0; i < 2; i++)
+	{
+		const u16 vblank = as.pc;
+		as.Op16(0x2C, 0x2002);							// BIT $2002
+		as.Branch(0x10, vblank);						// BPL vblank
+	} // end for
+
+	// background palette 0, then sprite palette 0
+	for (u32 half = 0; half < 2; half++)
+	{
+		as.Op(0xA9, 0x3F); as.Op16(0x8D, 0x2006);
+		as.Op(0xA9, (u8)(half * 0x10)); as.Op16(0x8D, 0x2006);
+		for (u32 i = 0; i < 4; i++)
+		{
+			as.Op(0xA9, palette[half * 4 + i]);			// LDA #color
+			as.Op16(0x8D, 0x2007);						// STA $2007
+		} // end for
+	} // end for
+
+	// nametable 0 all tile 0 and attribute 0, but the one tile
+	as.Op(0xA9, 0x20); as.Op16(0x8D, 0x2006);
+	as.Op(0xA9, 0x00); as.Op16(0x8D, 0x2006);
+	as.Op(0xA9, 0x00);									// LDA #0
+	as.Op(0xA2, 0x00);									// LDX #0
+	const u16 fill = as.pc;
+	for (u32 i = 0; i < 4; i++)
+		as.Op16(0x8D, 0x2007);							// STA $2007, 4 times
+	as.Op(0xCA);										// DEX
+	as.Branch(0xD0, fill);								// BNE fill
+	const u16 cell = 0x2000 + (BG_Y / 8) * 32 + BG_X / 8;
+	as.Op(0xA9, cell >> 8); as.Op16(0x8D, 0x2006);
+	as.Op(0xA9, cell & 0xFF); as.Op16(0x8D, 0x2006);
+	as.Op(0xA9, TILE); as.Op16(0x8D, 0x2007);
+
+	Write_Tile(as, 0);
+
+	// every sprite off the screen but the two
+	as.Op(0xA9, 0xFF);
+	as.Op(0xA2, 0x00);									// LDX #0
+	const u16 hide = as.pc;
+	as.Op16(0x9D, SPRITES);								// STA sprites,X
+	as.Op(0xE8);										// INX
+	as.Branch(0xD0, hide);								// BNE hide
+	const u8 sprites[8] = { SPRITE_Y, TILE, 0x00, SPRITE_X, SPRITE_Y, TILE, 0x40, FLIPPED_X };
+	for (u32 i = 0; i < 8; i++)
+	{
+		as.Op(0xA9, sprites[i]);
+		as.Op16(0x8D, SPRITES + i);
+	} // end for
+	as.Op(0xA9, 0x00); as.Op16(0x8D, 0x2003);			// OAMADDR 0
+	as.Op(0xA9, SPRITES >> 8); as.Op16(0x8D, 0x4014);	// OAM DMA
+
+	as.Op(0xA9, 0x00);
+	as.Op16(0x8D, 0x2005); as.Op16(0x8D, 0x2005);		// no scroll
+	as.Op(0xA9, 0x80); as.Op16(0x8D, 0x2000);			// NMI on, tables at 0
+	as.Op(0xA9, 0x1E); as.Op16(0x8D, 0x2001);			// everything on, left column too
+	const u16 idle = as.pc;
+	as.Op16(0x4C, idle);								// JMP idle
+
+	// NMI: count it, and on the frame to, write the other tile over it
+	const u16 nmi = as.pc;
+	as.Op(0x48); as.Op(0x8A); as.Op(0x48);				// PHA; TXA; PHA
+	as.Op(0xE6, FRAME);									// INC frame
+	as.Op(0xA5, FRAME); as.Op(0xC9, REWRITE);			// LDA frame; CMP #rewrite
+	const u16 done = as.Branch(0xD0);					// BNE done
+	Write_Tile(as, 1);
+	as.Op(0xA9, 0x00);
+	as.Op16(0x8D, 0x2005); as.Op16(0x8D, 0x2005);		// no scroll again
+	as.Op(0xA9, 0x80); as.Op16(0x8D, 0x2000);
+	as.Land(done);
+	as.Op(0x68); as.Op(0xAA); as.Op(0x68);				// PLA; TAX; PLA
+	as.Op(0x40);										// RTI
+
+	for (u32 i = 0; i < 2; i++)
+	{
+		for (u32 j = 0; j < 16; j++)
+			as.Poke(TILES + i * 16 + j, tiles[i][j]);
+	} // end for
+
+	const u16 vectors[3] = { nmi, 0x8000, nmi };
+	for (u32 i = 0; i < 3; i++)
+	{
+		as.Poke(0xFFFA + i * 2, vectors[i] & 0xFF);
+		as.Poke(0xFFFB + i * 2, vectors[i] >> 8);
+	} // end for
+
+	return Ines_Image(0, as.rom, {});
+} // end Build
+
+
+//=====================================================================|
+/**
+ * @brief Pixel x of a tile's row, 0 - 3, decoded straight from its bytes.
+ */
+static u8 Pixel(const u8* tile, const u32 row, const u32 x)
+{
+	return (u8)(((tile[row] >> (7 - x)) & 1) | (((tile[row + 8] >> (7 - x)) & 1) << 1));
+} // end Pixel
+
+
+//=====================================================================|
+/**
+ * @brief The palette index the picture must have at x, y with tile in CHR
+ *	RAM: the backdrop but where the tile shows.
+ */
+static u8 Expected(const u8* tile, const u32 x, const u32 y)
+{
+	if (x - BG_X < 8 && y - BG_Y < 8)
+	{
+		const u8 color = Pixel(tile, y - BG_Y, x - BG_X);
+		return color ? palette[color] : palette[0];
+	} // end if
+
+	const u32 row = y - (SPRITE_Y + 1u);
+	if (row < 8 && (x - SPRITE_X < 8 || x - FLIPPED_X < 8))
+	{
+		const u8 color = x - SPRITE_X < 8 ? Pixel(tile, row, x - SPRITE_X) : Pixel(tile, row, 7 - (x - FLIPPED_X));
+		return color ? palette[4 + color] : palette[0];
+	} // end if
+
+	return palette[0];
+} // end Expected
+
+
+//=====================================================================|
+/**
+ * @brief Runs the program on a backend, checking the cached rows after
+ *	every frame and the pictures once they are all up.
+ */
+static void Test_Backend(const std::vector<u8>& image, const CPU6502::Backend backend)
+{
+	const char* name = CPU6502::Backend_Name(backend);
+
+	std::unique_ptr<NES> nes = std::make_unique<NES>();
+	if (!Check(Insert_Image(*nes, image, "chr-ram-tiles.nes"), "the cartridge won't go in"))
+		return;
+	nes->cpu.Set_Backend(backend);
+
+	u32 pictures = 0;
+	for (u32 frame = 0; frame < FRAMES; frame++)
+	{
+		const u8 before = nes->ram[FRAME];
+		nes->Run_Frame(true);
+		const u8 after = nes->ram[FRAME];
+		if (frame < SETTLED)
+			continue;
+
+		// the rows first, as is and flipped, for whatever tile is in now
+		const u8* tile = tiles[after >= REWRITE ? 1 : 0];
+		for (u32 row = 0; row < 8; row++)
+		{
+			const u8* as_is = nes->mapper->Tile_Row(TILE_ADDR + row, false);
+			const u8* flipped = nes->mapper->Tile_Row(TILE_ADDR + row, true);
+			for (u32 x = 0; x < 8; x++)
+			{
+				if (!Check(as_is[x] == Pixel(tile, row, x) && flipped[x] == Pixel(tile, row, 7 - x),
+					"%s, frame %u: row %u, pixel %u of the cached tile is %u and %u flipped, not %u and %u",
+					name, frame, row, x, as_is[x], flipped[x], Pixel(tile, row, x), Pixel(tile, row, 7 - x)))
+					return;
+			} // end for
+		} // end for
+
+		// then the picture, unless the tile changed somewhere in the frame
+		if (before < REWRITE && after >= REWRITE)
+			continue;
+
+		const u8* pixels = nes->ppu.Get_Frame_Buffer();
+		for (u32 y = 0; y < SCREEN_HEIGHT; y++)
+		{
+			for (u32 x = 0; x < SCREEN_WIDTH; x++)
+			{
+				const u8 want = Expected(tile, x, y);
+				if (!Check(pixels[y * SCREEN_WIDTH + x] == want, "%s, frame %u: the pixel at %u, %u is %02X, not %02X",
+					name, frame, x, y, pixels[y * SCREEN_WIDTH + x], want))
+					return;
+			} // end for
+		} // end for
+		pictures++;
+	} // end for
+
+	// or the rewrite never came, and this tested nothing; every frame but
+	//	the one it came in
+	Check(nes->ram[FRAME] > REWRITE + 1 && pictures == FRAMES - SETTLED - 1,
+		"%s: %u frames counted, %u pictures checked", name, nes->ram[FRAME], pictures);
+
+	printf("chr-ram-tiles: %s, %u pictures right\n", name, pictures);
+} // end Test_Backend
+
+
+//=====================================================================|
+int main()
+{
+	const std::vector<u8> image = Build();
+	for (const CPU6502::Backend backend : backends)
+		Test_Backend(image, backend);
+
+	return failures ? 1 : 0;
+} // end main
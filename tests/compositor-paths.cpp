@@ -0,0 +1,237 @@
+/**
+ * @brief Every compositor path this CPU has against the scalar one, over
+ *	random scanlines under every PPUMASK. A path has to give the same
+ *	palette indices, colors and sprite 0 hit, and write nothing past the
+ *	end of its 256 pixels.
+ *
+ *	Random pixels hit sprite 0 on nearly every line, so sprite 0 only
+ *	covers a few columns of each, often at the two ends where the rules
+ *	are: the left 8 columns PPUMASK can blank, and column 255 that never
+ *	hits. Some lines have their only chance of a hit in column 255.
+ *
+ *	Colorize goes through the same, for counts that do and don't fill a
+ *	pass of the vector loop.
+ *
+ * @author Rediet Worku
+ * @date 26th of October 2021, Sunday
+ */
+
+
+//=====================================================================|
+#include "test.hpp"
+#include "compositor.hpp"
+
+
+
+//=====================================================================|
+constexpr u32 LINES = 4000;			// per path and mask
+constexpr u32 GUARD = 32;			// bytes past the end that must stay put
+constexpr u8 UNTOUCHED = 0xA5;
+
+static const char* path_names[] = { "scalar", "sse2", "avx2" };
+
+
+//=====================================================================|
+/**
+ * @brief One scanline's worth of input, starting one byte in so the
+ *	vector paths see them unaligned.
+ */
+struct Scanline
+{
+	u8 bg_data[256 + 1];
+	u8 sprite_data[256 + 1];
+	u8 palette[32];
+
+	const u8* Bg() const { return bg_data + 1; }
+	const u8* Sprite() const { return sprite_data + 1; }
+};
+
+
+//=====================================================================|
+/**
+ * @brief Fills a scanline. About half of either layer is transparent;
+ *	sprites are in front or behind at random, and sprite 0 covers a run
+ *	of 1 to 8 columns, at either end of the line half the time. Every
+ *	eighth line has sprite 0 only in column 255, over opaque background.
+ */
+static void Fill(Scanline& line, u32& rng)
+{
+	u8* bg = line.bg_data + 1;
+	u8* sprite = line.sprite_data + 1;
+
+	for (u32 x = 0; x < 256; x++)
+	{
+		const u32 r = Random(rng);
+		bg[x] = (r & 1) ? (r >> 1) & 0x0F : 0;
+		sprite[x] = (r & 0x100) ? 0x10 | ((r >> 9) & 0x0F) | ((r >> 13) & 0x40) : 0;
+	} // end for
+
+	for (u32 i = 0; i < 32; i++)
+		line.palette[i] = Random(rng) & 0x3F;
+
+	const u32 r = Random(rng);
+	if ((r & 7) == 0)
+	{
+		bg[255] |= 1;
+		sprite[255] = 0x91;
+		return;
+	} // end if
+
+	const u32 width = 1 + ((r >> 3) & 7);
+	u32 start;
+	switch ((r >> 6) & 3)
+	{
+	case 0: start = 0; break;
+	case 1: start = 256 - width; break;
+	default: start = (r >> 8) % (256 - width); break;
+	} // end switch
+
+	for (u32 x = start; x < start + width; x++)
+	{
+		if (sprite[x])
+			sprite[x] |= 0x80;
+	} // end for
+} // end Fill
+
+
+//=====================================================================|
+/**
+ * @brief Whether count bytes past out are all still UNTOUCHED.
+ */
+static bool Untouched(const void* out, const u32 count)
+{
+	const u8* p = (const u8*)out;
+	for (u32 i = 0; i < count; i++)
+	{
+		if (p[i] != UNTOUCHED)
+			return false;
+	} // end for
+	return true;
+} // end Untouched
+
+
+//=====================================================================|
+/**
+ * @brief Composes LINES random scanlines on path under every mask, and
+ *	compares each with the scalar path.
+ *
+ * @return how many lines hit sprite 0, to show the test got to both
+ */
+static u32 Test_Compose(const Compositor& path, const Compositor& scalar,
+	const char* name, const u32* colors)
+{
+	u32 rng = 0x2C02;
+	u32 hits = 0;
+
+	Scanline line;
+	u8 want_indices[256];
+	u32 want_rgba[256];
+	u8 indices[256 + GUARD];
+	u32 rgba[256 + GUARD];
+
+	for (u32 mask = 0; mask < 8; mask++)
+	{
+		for (u32 i = 0; i < LINES; i++)
+		{
+			Fill(line, rng);
+
+			// the bits the compositor doesn't look at are set at random
+			const u8 bits = (u8)(mask | (Random(rng) & 0xF8));
+
+			memset(indices, UNTOUCHED, sizeof(indices));
+			memset(rgba, UNTOUCHED, sizeof(rgba));
+
+			const bool want = scalar.Compose(line.Bg(), line.Sprite(), line.palette,
+				bits, colors, want_indices, want_rgba);
+			const bool hit = path.Compose(line.Bg(), line.Sprite(), line.palette,
+				bits, colors, indices, rgba);
+			hits += want;
+
+			u32 x = 0;
+			while (x < 256 && indices[x] == want_indices[x] && rgba[x] == want_rgba[x])
+				x++;
+
+			if (!Check(hit == want, "%s, mask %02X, line %u: sprite 0 %s", name, bits, i,
+					want ? "didn't hit" : "hit") ||
+				!Check(x == 256, "%s, mask %02X, line %u: column %u is %02X %08X, not %02X %08X",
+					name, bits, i, x, x < 256 ? indices[x] : 0, x < 256 ? rgba[x] : 0,
+					x < 256 ? want_indices[x] : 0, x < 256 ? want_rgba[x] : 0) ||
+				!Check(Untouched(indices + 256, GUARD) && Untouched(rgba + 256, GUARD * 4),
+					"%s, mask %02X, line %u: wrote past the end", name, bits, i))
+				return hits;
+		} // end for
+	} // end for
+
+	return hits;
+} // end Test_Compose
+
+
+//=====================================================================|
+/**
+ * @brief Colorizes random indices on path, every count up to a few
+ *	passes and a whole frame, and compares with the scalar path.
+ */
+static void Test_Colorize(const Compositor& path, const Compositor& scalar,
+	const char* name, const u32* colors)
+{
+	const u32 frame = SCREEN_WIDTH * SCREEN_HEIGHT;
+
+	u32 rng = 0x4E45;
+	std::vector<u8> indices(frame + 1);
+	for (u8& index : indices)
+		index = Random(rng) & 0x3F;
+
+	std::vector<u32> want(frame + GUARD);
+	std::vector<u32> rgba(frame + GUARD);
+
+	std::vector<u32> counts;
+	for (u32 count = 0; count <= 130; count++)
+		counts.push_back(count);
+	counts.push_back(frame);
+
+	for (const u32 count : counts)
+	{
+		// from the second index, so the loads aren't aligned either
+		memset(want.data(), UNTOUCHED, want.size() * 4);
+		memset(rgba.data(), UNTOUCHED, rgba.size() * 4);
+		scalar.Colorize(indices.data() + 1, colors, want.data(), count);
+		path.Colorize(indices.data() + 1, colors, rgba.data(), count);
+
+		if (!Check(memcmp(want.data(), rgba.data(), rgba.size() * 4) == 0,
+			"%s: colorizing %u pixels differs", name, count))
+			return;
+	} // end for
+} // end Test_Colorize
+
+
+//=====================================================================|
+int main()
+{
+	u32 rng = 0x1F;
+	u32 colors[64];
+	for (u32& color : colors)
+		color = Random(rng);
+
+	Compositor scalar;
+	Check(scalar.Set_Path(Compositor::Path::Scalar), "there's no scalar path");
+
+	const Compositor::Path best = Compositor::Best_Path();
+	for (u32 p = 0; p <= (u32)best; p++)
+	{
+		Compositor path;
+		if (!Check(path.Set_Path((Compositor::Path)p), "%s is the best path but won't set", path_names[p]))
+			continue;
+
+		const u32 hits = Test_Compose(path, scalar, path_names[p], colors);
+		Check(hits > 0 && hits < LINES * 8, "%s: %u lines of %u hit sprite 0, the test is no good",
+			path_names[p], hits, LINES * 8);
+		Test_Colorize(path, scalar, path_names[p], colors);
+
+		printf("compositor-paths: %s, %u lines, %u hit sprite 0\n", path_names[p], LINES * 8, hits);
+	} // end for
+
+	if (best != Compositor::Path::AVX2)
+		printf("compositor-paths: %s is the best this CPU has; the rest went untested\n", path_names[(u32)best]);
+
+	return failures ? 1 : 0;
+} // end main
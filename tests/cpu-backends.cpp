@@ -0,0 +1,501 @@
+/**
+ * @brief Every opcode through every interpreter and the recompiler, each
+ *	against the switch interpreter. One program per opcode runs it 32
+ *	times over, from registers, flags, stack pointer and memory out of a
+ *	table of random ones, and logs what it left behind; often enough for
+ *	the block engine and the JIT to have the loop compiled long before it
+ *	ends. The consoles are stopped every few hundred cycles and have to
+ *	agree on the registers, pc and all of RAM each time; an op costing a
+ *	cycle more on one of them puts it on another instruction sooner or
+ *	later.
+ *
+ *	Opcodes that take memory run once with it in RAM, page crossings and
+ *	all, and once more with it in the PPU's registers where they can reach
+ *	them, which the JIT has to bail out on.
+ *
+ *	Last, a cartridge whose CHR bank is switched while the picture is
+ *	drawn; every backend has to catch the PPU up to the same cycle of a
+ *	mapper write, or the picture comes out different.
+ *
+ * @author Rediet Worku
+ * @date 26th of October 2021, Sunday
+ */
+
+
+//=====================================================================|
+#include "test.hpp"
+
+
+
+//=====================================================================|
+// where the program keeps things
+constexpr u16 ITER = 0x00F0;			// the run it's on
+constexpr u16 SOURCE = 0x00F2;			// pointer to the run's memory
+constexpr u16 SAVED = 0x00E0;			// A, X, Y, P and SP after the op
+constexpr u16 LOG = 0x0600;				// SAVED and a sum of the memory, 32 runs each
+constexpr u16 TABLES = 0x9000;			// the runs' registers, 32 each
+constexpr u16 MEMORY = 0x9100;			// the runs' memory, 16 bytes each
+constexpr u16 SUBROUTINE = 0x8F00;		// an RTS for JSR
+constexpr u16 HANDLER = 0x8F01;			// an RTI for BRK
+
+constexpr u32 RUNS = 32;
+constexpr u32 CHECK_EVERY = 347;		// cycles between comparisons
+
+// the memory an op can reach, 16 bytes each, all filled before every run
+//	from MEMORY; an index register is never more than 15
+constexpr u16 ZERO_PAGE = 0x0050;
+constexpr u16 ABSOLUTE = 0x0400;
+constexpr u16 CROSSING = 0x04F8;		// indexed, crosses into page 5
+constexpr u16 IZX_TABLE = 0x0030;		// pointer bytes for (zp,X), 17 of them
+constexpr u16 IZY_POINTER = 0x0060;
+
+enum TABLE : u16 { T_A, T_X, T_Y, T_P, T_SP, T_P2, T_LO, T_HI };
+
+
+
+//=====================================================================|
+/**
+ * @brief One program: the op, where its memory is, and the random runs.
+ */
+struct Test_Case
+{
+	u8 opcode;
+	bool io;			// memory in the PPU's registers instead of RAM
+	u32 seed;
+};
+
+
+//=====================================================================|
+/**
+ * @brief Whether an opcode's addressing mode can reach I/O space.
+ */
+static bool Reaches_IO(const u8 opcode)
+{
+	switch (CPU6502::lookup[opcode].mode)
+	{
+	case CPU6502::AM_ABS:
+	case CPU6502::AM_ABX:
+	case CPU6502::AM_ABY:
+	case CPU6502::AM_IZX:
+	case CPU6502::AM_IZY:
+		// not JSR or JMP; they'd run the registers as code
+		return opcode != 0x20 && opcode != 0x4C;
+	default:
+		return false;
+	} // end switch
+} // end Reaches_IO
+
+
+//=====================================================================|
+/**
+ * @brief Writes the op under test with its operand, and whatever it needs
+ *	around it to come back to the instruction after.
+ */
+static void Emit_Op(Assembler& as, const Test_Case& test)
+{
+	const u8 opc = test.opcode;
+	const CPU6502::INSTRUCTION& ins = CPU6502::lookup[opc];
+
+	switch (opc)
+	{
+	case 0x00:		// BRK; the handler returns past the byte after it
+		as.Op(opc);
+		as.Op(0xEA);
+		return;
+	case 0x20:		// JSR to an RTS
+		as.Op16(opc, SUBROUTINE);
+		return;
+	case 0x4C:		// JMP to the next instruction
+		as.Op16(opc, as.pc + 3);
+		return;
+	case 0x6C:		// JMP (ind) through the page wrap; the pointer goes in before
+		as.Op16(opc, CROSSING + 7);
+		return;
+	} // end switch
+
+	switch (ins.mode)
+	{
+	case CPU6502::AM_IMM:
+		as.Op(opc, (u8)test.seed);
+		break;
+	case CPU6502::AM_ZP0:
+	case CPU6502::AM_ZPX:
+	case CPU6502::AM_ZPY:
+		as.Op(opc, ZERO_PAGE);
+		break;
+	case CPU6502::AM_ABS:
+		as.Op16(opc, test.io ? 0x2007 : ABSOLUTE);
+		break;
+	case CPU6502::AM_ABX:
+	case CPU6502::AM_ABY:
+		as.Op16(opc, test.io ? 0x2000 : CROSSING);
+		break;
+	case CPU6502::AM_IZX:
+		as.Op(opc, IZX_TABLE);
+		break;
+	case CPU6502::AM_IZY:
+		as.Op(opc, IZY_POINTER);
+		break;
+	case CPU6502::AM_REL:
+	{
+		// taken, it skips a load of A
+		as.Op(opc, 2);
+		as.Op(0xA9, 0xEE);
+		break;
+	} // end case
+	default:
+		for (u32 i = 0; i < ins.bytes; i++)
+			as.Byte(i ? 0xEA : opc);
+		break;
+	} // end switch
+} // end Emit_Op
+
+
+//=====================================================================|
+/**
+ * @brief Assembles the program for one test case, tables and all.
+ *
+ * @param test the case
+ * @param spin gets where the program ends up once all runs are done
+ *
+ * @return the 32KB at 0x8000
+ */
+static std::vector<u8> Build(const Test_Case& test, u16& spin)
+{
+	Assembler as;
+	u32 rng = test.seed | 1;
+
+	// the runs' registers, flags and memory
+	for (u32 i = 0; i < RUNS; i++)
+	{
+		as.Poke(TABLES + T_A * RUNS + i, (u8)Random(rng));
+		as.Poke(TABLES + T_X * RUNS + i, Random(rng) & 0x0F);
+		as.Poke(TABLES + T_Y * RUNS + i, Random(rng) & 0x0F);
+		as.Poke(TABLES + T_P * RUNS + i, (u8)Random(rng));
+		as.Poke(TABLES + T_SP * RUNS + i, 0xC0 | (Random(rng) & 0x3F));
+		as.Poke(TABLES + T_P2 * RUNS + i, (u8)Random(rng));
+		as.Poke(TABLES + T_LO * RUNS + i, (u8)(MEMORY + i * 16));
+		as.Poke(TABLES + T_HI * RUNS + i, (MEMORY + i * 16) >> 8);
+		for (u32 k = 0; k < 16; k++)
+			as.Poke(MEMORY + i * 16 + k, (u8)Random(rng));
+	} // end for
+
+	as.Poke(SUBROUTINE, 0x60);
+	as.Poke(HANDLER, 0x40);
+
+	// reset; (zp,X) and (zp),Y pointers. In RAM (zp,X) lands on $0504 or,
+	//	through an odd X, $0405; in I/O on PPUDATA or $0720
+	as.Op(0xA9, 0);						// LDA #0
+	as.Op(0x85, ITER);					// STA iter
+	as.Op(0xA2, 16);					// LDX #16
+	const u16 pointers = as.pc;
+	as.Op(0xA9, test.io ? 0x07 : 0x04);	// LDA #lo
+	as.Op(0x95, IZX_TABLE);				// STA table,X
+	as.Op(0xCA);						// DEX
+	as.Op(0xA9, test.io ? 0x20 : 0x05);	// LDA #hi
+	as.Op(0x95, IZX_TABLE);				// STA table,X
+	as.Op(0xCA);						// DEX
+	as.Branch(0x10, pointers);			// BPL
+	as.Op(0xA9, test.io ? 0x00 : (u8)CROSSING);
+	as.Op(0x85, IZY_POINTER);
+	as.Op(0xA9, test.io ? 0x20 : CROSSING >> 8);
+	as.Op(0x85, IZY_POINTER + 1);
+
+	// a run: the stack pointer, then the memory
+	const u16 loop = as.pc;
+	as.Op(0xA4, ITER);									// LDY iter
+	as.Op16(0xBE, TABLES + T_SP * RUNS);				// LDX sp,Y
+	as.Op(0x9A);										// TXS
+	as.Op16(0xB9, TABLES + T_LO * RUNS);				// LDA lo,Y
+	as.Op(0x85, SOURCE);
+	as.Op16(0xB9, TABLES + T_HI * RUNS);				// LDA hi,Y
+	as.Op(0x85, SOURCE + 1);
+	as.Op(0xA0, 15);									// LDY #15
+	const u16 copy = as.pc;
+	as.Op(0xB1, SOURCE);								// LDA (source),Y
+	as.Op16(0x99, ZERO_PAGE);							// STA zp,Y
+	as.Op16(0x99, ABSOLUTE);
+	as.Op16(0x99, CROSSING);
+	as.Op(0x88);										// DEY
+	as.Branch(0x10, copy);								// BPL
+
+	// JMP (ind) reads its pointer from $04FF and $0400
+	u16 after_jump = 0;
+	if (test.opcode == 0x6C)
+	{
+		as.Op(0xA9, 0);									// patched below
+		after_jump = as.pc - 1;
+		as.Op16(0x8D, CROSSING + 7);
+		as.Op(0xA9, 0);
+		as.Op16(0x8D, ABSOLUTE);
+	} // end if
+
+	// what RTS and RTI pull
+	as.Op(0xA4, ITER);									// LDY iter
+	u16 ret_lo = 0, ret_hi = 0;
+	if (test.opcode == 0x60 || test.opcode == 0x40)
+	{
+		as.Op(0xA9, 0);									// LDA #hi
+		ret_hi = as.pc - 1;
+		as.Op(0x48);									// PHA
+		as.Op(0xA9, 0);									// LDA #lo
+		ret_lo = as.pc - 1;
+		as.Op(0x48);
+		if (test.opcode == 0x40)
+		{
+			as.Op16(0xB9, TABLES + T_P2 * RUNS);		// LDA p2,Y
+			as.Op(0x48);
+		} // end if
+	} // end if
+
+	// the registers and flags
+	as.Op16(0xB9, TABLES + T_P * RUNS);					// LDA p,Y
+	as.Op(0x48);										// PHA
+	as.Op16(0xB9, TABLES + T_A * RUNS);					// LDA a,Y
+	as.Op(0x48);										// PHA
+	as.Op16(0xBE, TABLES + T_X * RUNS);					// LDX x,Y
+	as.Op16(0xB9, TABLES + T_Y * RUNS);					// LDA y,Y
+	as.Op(0xA8);										// TAY
+	as.Op(0x68);										// PLA
+	as.Op(0x28);										// PLP
+
+	Emit_Op(as, test);
+	const u16 next = as.pc;
+
+	// RTS comes back to one past what it pulls, RTI to what it pulls
+	const u16 ret = test.opcode == 0x60 ? next - 1 : next;
+	if (ret_lo)
+	{
+		as.Poke(ret_lo, ret & 0xFF);
+		as.Poke(ret_hi, ret >> 8);
+	} // end if
+	if (after_jump)
+	{
+		as.Poke(after_jump, next & 0xFF);
+		as.Poke(after_jump + 5, next >> 8);
+	} // end if
+
+	// save what the op left, then log it
+	as.Op(0x08);										// PHP
+	as.Op(0x85, SAVED + 0);								// STA
+	as.Op(0x86, SAVED + 1);								// STX
+	as.Op(0x84, SAVED + 2);								// STY
+	as.Op(0x68);										// PLA
+	as.Op(0x85, SAVED + 3);
+	as.Op(0xBA);										// TSX
+	as.Op(0x86, SAVED + 4);
+	as.Op(0xA4, ITER);									// LDY iter
+	for (u32 i = 0; i < 5; i++)
+	{
+		as.Op(0xA5, SAVED + i);							// LDA saved
+		as.Op16(0x99, LOG + i * RUNS);					// STA log,Y
+	} // end for
+
+	// and a sum over the memory it could have reached
+	as.Op(0xA2, 15);									// LDX #15
+	as.Op(0xA9, 0);										// LDA #0
+	const u16 sum = as.pc;
+	as.Op(0x18);										// CLC
+	as.Op(0x75, ZERO_PAGE);								// ADC zp,X
+	as.Op16(0x5D, ABSOLUTE);							// EOR abs,X
+	as.Op(0x2A);										// ROL A
+	as.Op16(0x7D, CROSSING);							// ADC abs,X
+	as.Op(0xCA);										// DEX
+	as.Branch(0x10, sum);								// BPL
+	as.Op16(0x99, LOG + 5 * RUNS);						// STA log,Y
+
+	// next run, or spin
+	as.Op(0xE6, ITER);									// INC iter
+	as.Op(0xA5, ITER);									// LDA iter
+	as.Op(0xC9, RUNS);									// CMP #RUNS
+	const u16 done = as.Branch(0xF0);					// BEQ done
+	as.Op16(0x4C, loop);								// JMP loop
+	as.Land(done);
+	spin = as.pc;
+	as.Op16(0x4C, spin);								// JMP *
+	return as.rom;
+} // end Build
+
+
+//=====================================================================|
+/**
+ * @brief Runs one case on every backend side by side, stopping them all
+ *	every CHECK_EVERY cycles to compare, until the switch interpreter is
+ *	through with the runs.
+ *
+ * @return false on the first difference, which it reports
+ */
+static bool Run_Case(const Test_Case& test)
+{
+	static const CPU6502::Backend backends[] = {
+		CPU6502::Backend::Switch, CPU6502::Backend::Lookup,
+		CPU6502::Backend::Blocks, CPU6502::Backend::Jit
+	};
+	constexpr u32 COUNT = sizeof(backends) / sizeof(backends[0]);
+
+	u16 spin;
+	const std::vector<u8> rom = Build(test, spin);
+
+	std::unique_ptr<NES> nes[COUNT];
+	std::vector<NES_Snapshot> snaps(COUNT);
+	for (u32 i = 0; i < COUNT; i++)
+	{
+		nes[i] = std::make_unique<NES>();
+		Load_Program(*nes[i], rom, HANDLER, HANDLER);
+		nes[i]->cpu.Set_Backend(backends[i]);
+	} // end for
+
+	const char* where = test.io ? "I/O" : "RAM";
+	for (u64 target = CHECK_EVERY; target < 100000; target += CHECK_EVERY)
+	{
+		for (u32 i = 0; i < COUNT; i++)
+		{
+			while (nes[i]->cpu.Get_Cycles() < target)
+				nes[i]->cpu.Run_Until(target);
+			nes[i]->Take_Snapshot(snaps[i]);
+		} // end for
+
+		const NES_Snapshot& ref = snaps[0];
+		for (u32 i = 1; i < COUNT; i++)
+		{
+			const NES_Snapshot& snap = snaps[i];
+			const bool same = snap.pc == ref.pc && snap.a == ref.a && snap.x == ref.x &&
+				snap.y == ref.y && snap.sp == ref.sp && snap.status == ref.status &&
+				nes[i]->cpu.Get_Cycles() == nes[0]->cpu.Get_Cycles() &&
+				memcmp(snap.memory, ref.memory, RAM_SIZE) == 0;
+
+			if (!Check(same, "$%02X %s, memory in %s: %s and switch part by cycle %llu; "
+				"pc %04X/%04X A %02X/%02X X %02X/%02X Y %02X/%02X SP %02X/%02X P %02X/%02X%s",
+				test.opcode, CPU6502::mnemonics[test.opcode], where,
+				CPU6502::Backend_Name(backends[i]), (unsigned long long)target,
+				snap.pc, ref.pc, snap.a, ref.a, snap.x, ref.x, snap.y, ref.y,
+				snap.sp, ref.sp, snap.status, ref.status,
+				memcmp(snap.memory, ref.memory, RAM_SIZE) ? ", RAM differs" : ""))
+				return false;
+		} // end for
+
+		if (ref.pc == spin)
+			return true;
+	} // end for
+
+	return Check(false, "$%02X %s, memory in %s: never got through its runs",
+		test.opcode, CPU6502::mnemonics[test.opcode], where);
+} // end Run_Case
+
+
+//=====================================================================|
+/**
+ * @brief A CNROM cartridge switching its CHR bank back and forth while the
+ *	background is drawn, with STA and with INC, 17 cycles round the loop.
+ *	The PPU is caught up to the cycle of each write before the bank moves,
+ *	so which bank every tile fetch sees depends on that cycle alone; a
+ *	backend whose writes land a cycle out draws other stripes than the
+ *	switch interpreter. Bank 0 draws color 1 all over, bank 1 color 2.
+ */
+static void Test_Mapper_Timing()
+{
+	static const CPU6502::Backend backends[] = {
+		CPU6502::Backend::Switch, CPU6502::Backend::Lookup,
+		CPU6502::Backend::Blocks, CPU6502::Backend::Jit
+	};
+	constexpr u32 COUNT = sizeof(backends) / sizeof(backends[0]);
+
+	Assembler as;
+	as.Op(0x78);										// SEI
+	const u16 wait = as.pc;
+	as.Op16(0x2C, 0x2002);								// BIT $2002
+	as.Branch(0x10, wait);								// BPL wait
+	as.Op(0xA9, 0x3F); as.Op16(0x8D, 0x2006);			// palette at 0x3F00
+	as.Op(0xA9, 0x00); as.Op16(0x8D, 0x2006);
+	const u8 palette[4] = { 0x0F, 0x16, 0x2A, 0x12 };
+	for (const u8 color : palette)
+	{
+		as.Op(0xA9, color);								// LDA #color
+		as.Op16(0x8D, 0x2007);							// STA $2007
+	} // end for
+	as.Op(0xA9, 0x00);
+	as.Op16(0x8D, 0x2005); as.Op16(0x8D, 0x2005);		// no scroll
+	as.Op(0xA9, 0x0A); as.Op16(0x8D, 0x2001);			// background, left column too
+	const u16 loop = as.pc;
+	as.Op(0xA9, 0x00);									// LDA #0
+	as.Op16(0x8D, 0x8000);								// STA $8000, bank 0
+	as.Op(0xEA);										// NOP
+	as.Op16(0xEE, 0xC000);								// INC $C000, bank 1
+	as.Op16(0x4C, loop);								// JMP loop
+	as.Poke(0xFFFC, 0x00); as.Poke(0xFFFD, 0x80);
+
+	std::vector<u8> chr(16384, 0);
+	for (u32 i = 0; i < 8192; i++)
+	{
+		const bool high = (i & 8) != 0;
+		chr[i] = high ? 0x00 : 0xFF;				// bank 0, plane 0 set
+		chr[8192 + i] = high ? 0xFF : 0x00;			// bank 1, plane 1 set
+	} // end for
+	const std::vector<u8> image = Ines_Image(3, as.rom, chr);
+
+	std::unique_ptr<NES> nes[COUNT];
+	for (u32 i = 0; i < COUNT; i++)
+	{
+		nes[i] = std::make_unique<NES>();
+		if (!Check(Insert_Image(*nes[i], image, "cpu-backends.nes"), "the CNROM cartridge won't go in"))
+			return;
+		nes[i]->cpu.Set_Backend(backends[i]);
+	} // end for
+
+	for (u32 frame = 0; frame < 10; frame++)
+	{
+		for (u32 i = 0; i < COUNT; i++)
+			nes[i]->Run_Frame(true);
+
+		const u8* ref = nes[0]->ppu.Get_Frame_Buffer();
+		for (u32 i = 1; i < COUNT; i++)
+		{
+			const u8* pixels = nes[i]->ppu.Get_Frame_Buffer();
+			u32 at = 0;
+			while (at < SCREEN_WIDTH * SCREEN_HEIGHT && pixels[at] == ref[at])
+				at++;
+
+			if (!Check(at == SCREEN_WIDTH * SCREEN_HEIGHT && nes[i]->cpu.Get_Cycles() == nes[0]->cpu.Get_Cycles(),
+				"CHR bank writes: %s and switch part in frame %u, line %u dot %u",
+				CPU6502::Backend_Name(backends[i]), frame, at / SCREEN_WIDTH, at % SCREEN_WIDTH))
+				return;
+		} // end for
+	} // end for
+
+	// or the writes never landed while anything was drawn
+	const u8* pixels = nes[0]->ppu.Get_Frame_Buffer();
+	u32 seen[2] = {};
+	for (u32 at = 0; at < SCREEN_WIDTH * SCREEN_HEIGHT; at++)
+	{
+		seen[0] += pixels[at] == palette[1];
+		seen[1] += pixels[at] == palette[2];
+	} // end for
+	Check(seen[0] && seen[1], "CHR bank writes: the frame has %u pixels of bank 0 and %u of bank 1",
+		seen[0], seen[1]);
+} // end Test_Mapper_Timing
+
+
+//=====================================================================|
+int main()
+{
+	u32 cases = 0;
+	u32 rng = 0x6502;
+	for (u32 opcode = 0; opcode < 256; opcode++)
+	{
+		for (u32 pass = 0; pass < 3; pass++)
+		{
+			const Test_Case test = { (u8)opcode, pass == 2, Random(rng) };
+			if (test.io && !Reaches_IO(test.opcode))
+				continue;
+
+			Run_Case(test);
+			cases++;
+		} // end for
+	} // end for
+
+	Test_Mapper_Timing();
+	cases++;
+
+	printf("cpu-backends: %u cases, %u failed\n", cases, failures);
+	return failures ? 1 : 0;
+} // end main
@@ -0,0 +1,259 @@
+/**
+ * @brief Idle loop skipping on and off, on every backend. The program
+ *	waits in each kind of loop there is to skip: on a flag the NMI sets,
+ *	read straight and indexed, on PPUSTATUS for sprite 0 hit to clear and
+ *	to come, which moves down the screen a little every frame, and on it
+ *	for vblank. A console skipping has to end every frame on the same RAM,
+ *	registers and cycle count as one that doesn't.
+ *
+ *	The same goes for the batch runner's jobs, with idle skipping on and
+ *	off job by job; the ones with it off mustn't skip a loop.
+ *
+ * @author Rediet Worku
+ * @date 26th of October 2021, Sunday
+ */
+
+
+//=====================================================================|
+#include "test.hpp"
+#include "batch-runner.hpp"
+
+
+
+//=====================================================================|
+constexpr u32 FRAMES = 30;
+
+// where the program keeps things
+constexpr u16 FLAG = 0x0030;			// set by the NMI
+constexpr u16 FRAME = 0x0031;			// counted by it
+constexpr u16 HITS = 0x0032;			// frames that got to sprite 0 hit
+constexpr u16 SPRITES = 0x0200;			// copied to OAM by the NMI
+
+static const CPU6502::Backend backends[] = {
+	CPU6502::Backend::Switch, CPU6502::Backend::Lookup,
+	CPU6502::Backend::Blocks, CPU6502::Backend::Jit
+};
+constexpr u32 BACKENDS = sizeof(backends) / sizeof(backends[0]);
+
+
+
+//=====================================================================|
+/**
+ * @brief The cartridge: NROM, the program in 32KB of PRG, and CHR with
+ *	tile 1 solid, which the background is all of and sprite 0 is.
+ */
+static std::vector<u8> Build()
+{
+	Assembler as;
+	as.Op(0x78);										// SEI
+	as.Op(0xD8);										// CLD
+	as.Op(0xA2, 0xFF); as.Op(0x9A);						// LDX #$FF; TXS
+	for (u32 i = 0; i < 2; i++)
+	{
+		const u16 vblank = as.pc;
+		as.Op16(0x2C, 0x2002);							// BIT $2002
+		as.Branch(0x10, vblank);						// BPL vblank
+	} // end for
+
+	// nametable 0 all tile 1, attributes all 0
+	as.Op(0xA9, 0x20); as.Op16(0x8D, 0x2006);
+	as.Op(0xA9, 0x00); as.Op16(0x8D, 0x2006);
+	as.Op(0xA9, 0x01);									// LDA #1
+	as.Op(0xA2, 240);									// LDX #240
+	const u16 fill = as.pc;
+	for (u32 i = 0; i < 4; i++)
+		as.Op16(0x8D, 0x2007);							// STA $2007, 4 times
+	as.Op(0xCA);										// DEX
+	as.Branch(0xD0, fill);								// BNE fill
+	as.Op(0xA9, 0x00);
+	as.Op(0xA2, 64);									// LDX #64
+	const u16 attributes = as.pc;
+	as.Op16(0x8D, 0x2007);								// STA $2007
+	as.Op(0xCA);										// DEX
+	as.Branch(0xD0, attributes);						// BNE attributes
+	as.Op16(0x8D, 0x2005); as.Op16(0x8D, 0x2005);		// no scroll
+
+	// every sprite off the screen but sprite 0, tile 1 at x 128
+	as.Op(0xA9, 0xFF);
+	as.Op(0xA2, 0x00);									// LDX #0
+	const u16 hide = as.pc;
+	as.Op16(0x9D, SPRITES);								// STA sprites,X
+	as.Op(0xE8);										// INX
+	as.Branch(0xD0, hide);								// BNE hide
+	as.Op(0xA9, 0x01); as.Op16(0x8D, SPRITES + 1);
+	as.Op(0xA9, 0x00); as.Op16(0x8D, SPRITES + 2);
+	as.Op(0xA9, 0x80); as.Op16(0x8D, SPRITES + 3);
+
+	as.Op(0xA9, 0x80); as.Op16(0x8D, 0x2000);			// NMI on
+	as.Op(0xA9, 0x1E); as.Op16(0x8D, 0x2001);			// everything on
+
+	// the NMI's flag, read straight
+	const u16 main = as.pc;
+	as.Op(0xA5, FLAG);									// LDA flag
+	as.Branch(0xF0, main);								// BEQ main
+	as.Op(0xA9, 0x00); as.Op(0x85, FLAG);
+	const u16 frame = as.pc;
+
+	// sprite 0 hit, clearing on the pre-render line then coming
+	const u16 clear = as.pc;
+	as.Op16(0x2C, 0x2002);								// BIT $2002
+	as.Branch(0x70, clear);								// BVS clear
+	const u16 hit = as.pc;
+	as.Op16(0x2C, 0x2002);								// BIT $2002
+	as.Branch(0x50, hit);								// BVC hit
+	as.Op(0xE6, HITS);									// INC hits
+
+	// vblank, reading it into A
+	const u16 vblank = as.pc;
+	as.Op16(0xAD, 0x2002);								// LDA $2002
+	as.Op(0x29, 0x80);									// AND #$80
+	as.Branch(0xF0, vblank);							// BEQ vblank
+
+	// the NMI's flag again, indexed, and round
+	as.Op(0xA2, 0x02);									// LDX #2
+	const u16 indexed = as.pc;
+	as.Op(0xB5, FLAG - 2);								// LDA flag - 2,X
+	as.Branch(0xF0, indexed);							// BEQ indexed
+	as.Op(0xA9, 0x00); as.Op(0x85, FLAG);
+	as.Op16(0x4C, frame);								// JMP frame
+
+	// NMI: sprite 0 down 7 lines a frame, in the top 128
+	const u16 nmi = as.pc;
+	as.Op(0x48);										// PHA
+	as.Op(0xE6, FLAG); as.Op(0xE6, FRAME);				// INC flag; INC frame
+	as.Op(0xA5, FRAME); as.Op(0x0A); as.Op(0x0A);		// LDA frame; ASL; ASL
+	as.Op(0x0A); as.Op(0x38); as.Op(0xE5, FRAME);		// ASL; SEC; SBC frame
+	as.Op(0x29, 0x7F);									// AND #$7F
+	as.Op16(0x8D, SPRITES);								// sprite 0's y
+	as.Op(0xA9, 0x00); as.Op16(0x8D, 0x2003);			// OAMADDR 0
+	as.Op(0xA9, SPRITES >> 8); as.Op16(0x8D, 0x4014);	// OAM DMA
+	as.Op(0x68);										// PLA
+	as.Op(0x40);										// RTI
+
+	const u16 vectors[3] = { nmi, 0x8000, nmi };
+	for (u32 i = 0; i < 3; i++)
+	{
+		as.Poke(0xFFFA + i * 2, vectors[i] & 0xFF);
+		as.Poke(0xFFFB + i * 2, vectors[i] >> 8);
+	} // end for
+
+	std::vector<u8> chr(8192, 0);
+	memset(&chr[1 * 16], 0xFF, 8);						// tile 1, plane 0
+
+	return Ines_Image(0, as.rom, chr);
+} // end Build
+
+
+//=====================================================================|
+/**
+ * @brief Runs the program on a backend with idle skipping on and off,
+ *	side by side, comparing them after every frame.
+ */
+static void Test_Consoles(const std::vector<u8>& image, const CPU6502::Backend backend)
+{
+	const char* name = CPU6502::Backend_Name(backend);
+
+	std::unique_ptr<NES> skipping = std::make_unique<NES>(), running = std::make_unique<NES>();
+	if (!Check(Insert_Image(*skipping, image, "idle-skip.nes") &&
+		Insert_Image(*running, image, "idle-skip.nes"), "the cartridge won't go in"))
+		return;
+	skipping->cpu.Set_Backend(backend);
+	running->cpu.Set_Backend(backend);
+	skipping->cpu.Set_Idle_Skip(true);
+	running->cpu.Set_Idle_Skip(false);
+
+	NES_Snapshot want, got;
+	for (u32 frame = 0; frame < FRAMES; frame++)
+	{
+		running->Run_Frame(false);
+		skipping->Run_Frame(false);
+		running->Take_Snapshot(want);
+		skipping->Take_Snapshot(got);
+
+		const bool same = got.pc == want.pc && got.a == want.a && got.x == want.x &&
+			got.y == want.y && got.sp == want.sp && got.status == want.status &&
+			skipping->cpu.Get_Cycles() == running->cpu.Get_Cycles() &&
+			memcmp(got.memory, want.memory, RAM_SIZE) == 0;
+		if (!Check(same, "%s, frame %u: skipping left the CPU at %04X after %llu cycles, not %04X after %llu",
+			name, frame, got.pc, (unsigned long long)skipping->cpu.Get_Cycles(),
+			want.pc, (unsigned long long)running->cpu.Get_Cycles()))
+			return;
+	} // end for
+
+	// or nothing was skipped, and this tested nothing; four loops a frame
+	//	once the first two have set up
+	Check(want.memory[HITS] >= FRAMES - 3, "%s: sprite 0 hit in %u frames of %u", name, want.memory[HITS], FRAMES);
+	Check(skipping->cpu.Get_Idle_Loops() >= (FRAMES - 2) * 4, "%s: %llu idle loops skipped in %u frames",
+		name, (unsigned long long)skipping->cpu.Get_Idle_Loops(), FRAMES);
+	Check(running->cpu.Get_Idle_Loops() == 0, "%s: skipped idle loops with skipping off", name);
+
+	printf("idle-skip: %s, %u frames, %llu idle loops skipped, %llu cycles\n", name, FRAMES,
+		(unsigned long long)skipping->cpu.Get_Idle_Loops(), (unsigned long long)skipping->cpu.Get_Idle_Cycles());
+} // end Test_Consoles
+
+
+//=====================================================================|
+/**
+ * @brief The program as a batch, a job on and a job off for every backend,
+ *	on two workers; each pair has to end the same.
+ */
+static void Test_Batch(const std::vector<u8>& image)
+{
+	const std::string path = (std::filesystem::temp_directory_path() / "idle-skip-batch.nes").string();
+	FILE* fp = fopen(path.c_str(), "wb");
+	if (!Check(fp != nullptr, "can't write %s", path.c_str()))
+		return;
+	const bool written = fwrite(image.data(), 1, image.size(), fp) == image.size();
+	fclose(fp);
+	if (!Check(written, "can't write %s", path.c_str()))
+		return;
+
+	std::vector<Batch_Job> jobs;
+	for (const CPU6502::Backend backend : backends)
+	{
+		for (const bool idle_skip : { true, false })
+		{
+			Batch_Job job;
+			job.rom = path;
+			job.frames = FRAMES;
+			job.backend = backend;
+			job.idle_skip = idle_skip;
+			jobs.push_back(job);
+		} // end for
+	} // end for
+
+	BatchRunner runner(2, false);
+	std::vector<Batch_Result> results;
+	runner.Run(jobs, results);
+
+	std::error_code ignored;
+	std::filesystem::remove(path, ignored);
+
+	for (u32 i = 0; i < BACKENDS; i++)
+	{
+		const char* name = CPU6502::Backend_Name(backends[i]);
+		const Batch_Result& on = results[i * 2];
+		const Batch_Result& off = results[i * 2 + 1];
+		if (!Check(on.ok && off.ok, "%s: the batch didn't run, %s", name, (on.ok ? off : on).error.c_str()))
+			continue;
+
+		Check(on.cycles == off.cycles && on.frame_crc == off.frame_crc &&
+			memcmp(on.ram, off.ram, RAM_SIZE) == 0, "%s: the batch jobs with idle skipping on and off differ", name);
+		Check(on.idle_loops > 0 && off.idle_loops == 0, "%s: the batch jobs skipped %llu and %llu idle loops",
+			name, (unsigned long long)on.idle_loops, (unsigned long long)off.idle_loops);
+	} // end for
+
+	printf("idle-skip: %zu batch jobs\n", jobs.size());
+} // end Test_Batch
+
+
+//=====================================================================|
+int main()
+{
+	const std::vector<u8> image = Build();
+	for (const CPU6502::Backend backend : backends)
+		Test_Consoles(image, backend);
+	Test_Batch(image);
+
+	return failures ? 1 : 0;
+} // end main
@@ -0,0 +1,324 @@
+/**
+ * @brief Bank switching on every board there is, seen through the bus.
+ *	Every 8KB bank of PRG is filled with its number and every 1KB of CHR
+ *	with its, so whatever the CPU reads at 0x8000 - 0xFFFF, or the PPU
+ *	hands back through PPUADDR and PPUDATA, says which bank it came from.
+ *
+ *	Each board gets its registers written the way a game would and every
+ *	page of PRG and each end of every 1KB of CHR is read back: NROM at 16KB
+ *	and 32KB, UxROM's switchable 16KB and its CHR RAM, CNROM's CHR, MMC1's
+ *	PRG and CHR modes through the five writes of its shift register, with
+ *	the register left alone until the fifth and a write with bit 7 set
+ *	starting it over, and MMC3's eight registers with both swap bits.
+ *
+ * @author Rediet Worku
+ * @date 26th of October 2021, Sunday
+ */
+
+
+//=====================================================================|
+#include "test.hpp"
+
+
+
+//=====================================================================|
+/**
+ * @brief A cartridge whose bytes say where they are: each 8KB of PRG its
+ *	number, each 1KB of CHR its; no CHR for CHR RAM.
+ */
+static std::vector<u8> Build(const u8 mapper, const u32 prg_size, const u32 chr_size)
+{
+	std::vector<u8> prg(prg_size), chr(chr_size);
+	for (u32 i = 0; i < prg_size; i++)
+		prg[i] = (u8)(i >> 13);
+	for (u32 i = 0; i < chr_size; i++)
+		chr[i] = (u8)(i >> 10);
+
+	return Ines_Image(mapper, prg, chr);
+} // end Build
+
+
+//=====================================================================|
+/**
+ * @brief Reads a byte of the pattern tables the way a program does: the
+ *	address into PPUADDR, then PPUDATA twice since the first read only
+ *	fills its buffer.
+ */
+static u8 Read_Chr(NES& nes, const u16 addr)
+{
+	nes.Read(0x2002);
+	nes.Write(0x2006, addr >> 8);
+	nes.Write(0x2006, addr & 0xFF);
+	nes.Read(0x2007);
+	return nes.Read(0x2007);
+} // end Read_Chr
+
+
+//=====================================================================|
+/**
+ * @brief Checks the 8KB PRG banks at 0x8000, 0xA000, 0xC000 and 0xE000 are
+ *	banks, at both ends of every page.
+ */
+static bool Check_Prg(NES& nes, const u8 (&banks)[4], const char* what)
+{
+	for (u32 page = 0x80; page <= 0xFF; page++)
+	{
+		const u8 want = banks[(page - 0x80) >> 5];
+		for (const u16 addr : { (u16)(page << 8), (u16)((page << 8) | 0xFF) })
+		{
+			const u8 got = nes.Read(addr);
+			if (!Check(got == want, "%s: %04X reads PRG bank %u, not %u", what, addr, got, want))
+				return false;
+		} // end for
+	} // end for
+
+	return true;
+} // end Check_Prg
+
+
+//=====================================================================|
+/**
+ * @brief Checks the 1KB CHR banks at 0x0000 - 0x1FFF are banks, at both
+ *	ends of each.
+ */
+static bool Check_Chr(NES& nes, const u8 (&banks)[8], const char* what)
+{
+	for (u32 k = 0; k < 8; k++)
+	{
+		for (const u16 addr : { (u16)(k << 10), (u16)((k << 10) | 0x3FF) })
+		{
+			const u8 got = Read_Chr(nes, addr);
+			if (!Check(got == banks[k], "%s: PPU %04X reads CHR bank %u, not %u", what, addr, got, banks[k]))
+				return false;
+		} // end for
+	} // end for
+
+	return true;
+} // end Check_Chr
+
+
+//=====================================================================|
+/**
+ * @brief Puts a cartridge in a console of its own, checking it got the
+ *	board it asked for.
+ */
+static std::unique_ptr<NES> Insert(const std::vector<u8>& image, const char* board)
+{
+	std::unique_ptr<NES> nes = std::make_unique<NES>();
+	if (!Check(Insert_Image(*nes, image, "mapper-banks.nes"), "%s: the cartridge won't go in, %s",
+		board, nes->Get_Error_Message().c_str()))
+		return nullptr;
+	if (!Check(strcmp(nes->mapper->Name(), board) == 0, "%s: got %s", board, nes->mapper->Name()))
+		return nullptr;
+
+	return nes;
+} // end Insert
+
+
+//=====================================================================|
+static void Test_Nrom()
+{
+	const u8 chr[8] = { 0, 1, 2, 3, 4, 5, 6, 7 };
+
+	// 16KB shows twice, and writes go nowhere
+	if (std::unique_ptr<NES> nes = Insert(Build(0, 16384, 8192), "NROM"))
+	{
+		Check_Prg(*nes, { 0, 1, 0, 1 }, "NROM 16KB");
+		nes->Write(0x8000, 0x01);
+		nes->Write(0xC000, 0x01);
+		Check_Prg(*nes, { 0, 1, 0, 1 }, "NROM 16KB, written to");
+		Check_Chr(*nes, chr, "NROM 16KB");
+	} // end if
+
+	if (std::unique_ptr<NES> nes = Insert(Build(0, 32768, 8192), "NROM"))
+	{
+		Check_Prg(*nes, { 0, 1, 2, 3 }, "NROM 32KB");
+		Check_Chr(*nes, chr, "NROM 32KB");
+	} // end if
+} // end Test_Nrom
+
+
+//=====================================================================|
+/**
+ * @brief 128KB of PRG, the last 16KB fixed at 0xC000, and CHR RAM, which
+ *	takes writes through PPUDATA.
+ */
+static void Test_Uxrom()
+{
+	std::unique_ptr<NES> nes = Insert(Build(2, 131072, 0), "UxROM");
+	if (!nes)
+		return;
+
+	Check_Prg(*nes, { 0, 1, 14, 15 }, "UxROM at power on");
+	for (const u8 bank : { 3, 6, 0, 7 })
+	{
+		char what[64];
+		snprintf(what, sizeof(what), "UxROM bank %u", bank);
+		nes->Write(0x8000 + bank * 0x1111, bank);
+		Check_Prg(*nes, { (u8)(bank * 2), (u8)(bank * 2 + 1), 14, 15 }, what);
+	} // end for
+
+	// both ends of every 1KB, as Check_Chr reads them
+	nes->Read(0x2002);
+	for (u32 k = 0; k < 8; k++)
+	{
+		for (const u16 addr : { (u16)(k << 10), (u16)((k << 10) | 0x3FF) })
+		{
+			nes->Write(0x2006, addr >> 8);
+			nes->Write(0x2006, addr & 0xFF);
+			nes->Write(0x2007, (u8)(0xA0 + k));
+		} // end for
+	} // end for
+	Check_Chr(*nes, { 0xA0, 0xA1, 0xA2, 0xA3, 0xA4, 0xA5, 0xA6, 0xA7 }, "UxROM CHR RAM");
+} // end Test_Uxrom
+
+
+//=====================================================================|
+/**
+ * @brief 32KB of CHR as four 8KB banks; PRG doesn't move.
+ */
+static void Test_Cnrom()
+{
+	std::unique_ptr<NES> nes = Insert(Build(3, 32768, 32768), "CNROM");
+	if (!nes)
+		return;
+
+	Check_Chr(*nes, { 0, 1, 2, 3, 4, 5, 6, 7 }, "CNROM at power on");
+	for (const u8 bank : { 2, 1, 3, 0 })
+	{
+		char what[64];
+		snprintf(what, sizeof(what), "CNROM bank %u", bank);
+		nes->Write(0x8000, bank);
+		u8 chr[8];
+		for (u32 k = 0; k < 8; k++)
+			chr[k] = (u8)(bank * 8 + k);
+		Check_Chr(*nes, chr, what);
+		Check_Prg(*nes, { 0, 1, 2, 3 }, what);
+	} // end for
+} // end Test_Cnrom
+
+
+//=====================================================================|
+/**
+ * @brief Writes value to one of MMC1's registers the way it takes them, a
+ *	bit at a time, LSB first, over five writes; fewer leave it part way.
+ */
+static void Mmc1_Write(NES& nes, const u16 addr, const u8 value, const u32 writes = 5)
+{
+	for (u32 i = 0; i < writes; i++)
+		nes.Write(addr, (value >> i) & 1);
+} // end Mmc1_Write
+
+
+//=====================================================================|
+/**
+ * @brief 256KB of PRG in 16KB banks and 128KB of CHR in 4KB ones.
+ */
+static void Test_Mmc1()
+{
+	std::unique_ptr<NES> nes = Insert(Build(1, 262144, 131072), "MMC1");
+	if (!nes)
+		return;
+
+	// mode 3, the last bank fixed at 0xC000
+	Check_Prg(*nes, { 0, 1, 30, 31 }, "MMC1 at power on");
+	Mmc1_Write(*nes, 0xE000, 5);
+	Check_Prg(*nes, { 10, 11, 30, 31 }, "MMC1 PRG bank 5");
+
+	// the first four writes leave the register alone
+	Mmc1_Write(*nes, 0xE000, 9, 4);
+	Check_Prg(*nes, { 10, 11, 30, 31 }, "MMC1 four writes in");
+	nes->Write(0xE000, 0);
+	Check_Prg(*nes, { 18, 19, 30, 31 }, "MMC1 PRG bank 9");
+
+	// mode 2, the first bank fixed at 0x8000
+	Mmc1_Write(*nes, 0x8000, 0x08);
+	Check_Prg(*nes, { 0, 1, 18, 19 }, "MMC1 PRG mode 2");
+
+	// mode 0, 32KB with the low bit of the bank ignored
+	Mmc1_Write(*nes, 0x8000, 0x00);
+	Check_Prg(*nes, { 16, 17, 18, 19 }, "MMC1 PRG mode 0");
+
+	// bit 7 starts the shift register over and puts mode 3 back; the
+	//	three writes before it mustn't land anywhere
+	Mmc1_Write(*nes, 0xE000, 0x1F, 3);
+	nes->Write(0x8000, 0x80);
+	Check_Prg(*nes, { 18, 19, 30, 31 }, "MMC1 reset by bit 7");
+	Mmc1_Write(*nes, 0xE000, 2);
+	Check_Prg(*nes, { 4, 5, 30, 31 }, "MMC1 PRG bank 2 after the reset");
+
+	// CHR in 8KB, the low bit of the bank ignored
+	Mmc1_Write(*nes, 0xA000, 3);
+	Check_Chr(*nes, { 8, 9, 10, 11, 12, 13, 14, 15 }, "MMC1 CHR 8KB bank 1");
+
+	// and in two 4KB banks
+	Mmc1_Write(*nes, 0x8000, 0x1C);
+	Mmc1_Write(*nes, 0xC000, 7);
+	Check_Chr(*nes, { 12, 13, 14, 15, 28, 29, 30, 31 }, "MMC1 CHR 4KB banks 3 and 7");
+	Mmc1_Write(*nes, 0xA000, 30);
+	Check_Chr(*nes, { 120, 121, 122, 123, 28, 29, 30, 31 }, "MMC1 CHR 4KB banks 30 and 7");
+	Check_Prg(*nes, { 4, 5, 30, 31 }, "MMC1 after the CHR");
+} // end Test_Mmc1
+
+
+//=====================================================================|
+/**
+ * @brief Writes value to one of MMC3's bank registers, with the swap bits
+ *	in mode.
+ */
+static void Mmc3_Bank(NES& nes, const u8 mode, const u8 reg, const u8 value)
+{
+	nes.Write(0x8000, mode | reg);
+	nes.Write(0x8001, value);
+} // end Mmc3_Bank
+
+
+//=====================================================================|
+/**
+ * @brief 256KB of PRG in 8KB banks and 256KB of CHR in 1KB ones.
+ */
+static void Test_Mmc3()
+{
+	std::unique_ptr<NES> nes = Insert(Build(4, 262144, 262144), "MMC3");
+	if (!nes)
+		return;
+
+	// R6 and R7 with the second to last bank at 0xC000, then at 0x8000
+	Mmc3_Bank(*nes, 0x00, 6, 5);
+	Mmc3_Bank(*nes, 0x00, 7, 9);
+	Check_Prg(*nes, { 5, 9, 30, 31 }, "MMC3 R6 5, R7 9");
+	nes->Write(0x8000, 0x40);
+	Check_Prg(*nes, { 30, 9, 5, 31 }, "MMC3 R6 5, R7 9 swapped");
+	Mmc3_Bank(*nes, 0x40, 6, 12);
+	Check_Prg(*nes, { 30, 9, 12, 31 }, "MMC3 R6 12 swapped");
+	Mmc3_Bank(*nes, 0x40, 7, 0);
+	Check_Prg(*nes, { 30, 0, 12, 31 }, "MMC3 R7 0 swapped");
+	nes->Write(0x8000, 0x06);
+	Check_Prg(*nes, { 12, 0, 30, 31 }, "MMC3 unswapped");
+
+	// R0 and R1 are 2KB and ignore their low bit; R2 - R5 are 1KB
+	const u8 values[6] = { 11, 20, 40, 51, 62, 73 };
+	for (u8 reg = 0; reg < 6; reg++)
+		Mmc3_Bank(*nes, 0x00, reg, values[reg]);
+	Check_Chr(*nes, { 10, 11, 20, 21, 40, 51, 62, 73 }, "MMC3 CHR");
+	nes->Write(0x8000, 0x80);
+	Check_Chr(*nes, { 40, 51, 62, 73, 10, 11, 20, 21 }, "MMC3 CHR swapped");
+	Mmc3_Bank(*nes, 0x80, 1, 255);
+	Check_Chr(*nes, { 40, 51, 62, 73, 10, 11, 254, 255 }, "MMC3 R1 255 swapped");
+	Check_Prg(*nes, { 12, 0, 30, 31 }, "MMC3 after the CHR");
+} // end Test_Mmc3
+
+
+//=====================================================================|
+int main()
+{
+	Test_Nrom();
+	Test_Uxrom();
+	Test_Cnrom();
+	Test_Mmc1();
+	Test_Mmc3();
+
+	if (!failures)
+		printf("mapper-banks: NROM, UxROM, CNROM, MMC1 and MMC3 switched\n");
+	return failures ? 1 : 0;
+} // end main
@@ -0,0 +1,283 @@
+/**
+ * @brief A split screen on the MMC3. Some way into each frame the main loop
+ *	switches the background to the next CHR bank, each a color of its own,
+ *	tells the IRQ counter to reload with a latch of 44 and turns IRQs on;
+ *	each IRQ then moves the background on a bank again, so the frame comes
+ *	out in stripes 45 lines apart from there down. The NMI handler counts
+ *	the frame's IRQs, turns them off and goes back to the first bank.
+ *
+ *	The lines the IRQs land on come from the PPU's prediction of the
+ *	counter, and the CPU is only ever stopped at the booked events; the
+ *	first IRQ of a frame is counted ahead from the reload, with nothing in
+ *	between to stop at, the rest from the count the last IRQ's line left.
+ *	Every backend, with idle loop skipping on and off, has to give the
+ *	switch interpreter's picture, RAM, registers and cycle count, each
+ *	frame; once with a main loop that counts while it waits for the NMI,
+ *	which puts every interrupt's cycle into RAM, and once with one that
+ *	only waits, which idle skipping jumps over.
+ *
+ *	Both handlers keep the status their interrupt pushed. The I flag has
+ *	to be clear in it, or the RTI leaves interrupts masked and there is
+ *	one IRQ a frame at most.
+ *
+ * @author Rediet Worku
+ * @date 26th of October 2021, Sunday
+ */
+
+
+//=====================================================================|
+#include "test.hpp"
+
+
+
+//=====================================================================|
+constexpr u8 LATCH = 44;				// an IRQ every 45 lines
+constexpr u8 DELAY = 4;					// 1280 cycles each, after the NMI
+constexpr u32 FRAMES = 8;
+
+// where the program keeps things
+constexpr u16 BANK = 0x0030;			// the last CHR bank switched to, 0 - 3
+constexpr u16 COUNT = 0x0031;			// IRQs so far this frame
+constexpr u16 FLAG = 0x0032;			// set by the NMI
+constexpr u16 LAST_COUNT = 0x0033;		// the last frame's IRQs
+constexpr u16 IRQ_STATUS = 0x0034;		// the status an IRQ pushed
+constexpr u16 NMI_STATUS = 0x0035;		// the status an NMI pushed
+constexpr u16 COUNTER = 0x0040;			// the busy main loop's, 16 bits
+
+constexpr u8 palette[4] = { 0x0F, 0x16, 0x2A, 0x12 };
+
+
+
+//=====================================================================|
+/**
+ * @brief The cartridge: 32KB of PRG, which the MMC3 maps straight from
+ *	0x8000 as it powers on, and 8KB of CHR, four 2KB banks drawing colors
+ *	0 - 3 of the background palette all over.
+ *
+ * @param busy whether the main loop counts while it waits
+ */
+static std::vector<u8> Build(const bool busy)
+{
+	Assembler as;
+	as.Op(0x78);										// SEI
+	as.Op(0xD8);										// CLD
+	as.Op(0xA2, 0xFF); as.Op(0x9A);						// LDX #$FF; TXS
+	const u16 vblank = as.pc;
+	as.Op16(0x2C, 0x2002);								// BIT $2002
+	as.Branch(0x10, vblank);							// BPL vblank
+
+	as.Op(0xA9, 0x3F); as.Op16(0x8D, 0x2006);			// palette at 0x3F00
+	as.Op(0xA9, 0x00); as.Op16(0x8D, 0x2006);
+	for (const u8 color : palette)
+	{
+		as.Op(0xA9, color);								// LDA #color
+		as.Op16(0x8D, 0x2007);							// STA $2007
+	} // end for
+	as.Op(0xA9, 0x00);
+	as.Op16(0x8D, 0x2005); as.Op16(0x8D, 0x2005);		// no scroll
+	as.Op16(0x8D, 0x8000); as.Op16(0x8D, 0x8001);		// R0, CHR bank 0
+	as.Op16(0x8D, 0xE000);								// IRQs off
+	as.Op(0xA9, LATCH); as.Op16(0x8D, 0xC000);			// the latch
+	as.Op(0xA9, 0x80); as.Op16(0x8D, 0x2000);			// NMI on
+	as.Op(0xA9, 0x0A); as.Op16(0x8D, 0x2001);			// background, left column too
+	as.Op(0x58);										// CLI
+
+	// wait for the NMI
+	const u16 loop = as.pc;
+	if (busy)
+	{
+		as.Op(0xE6, COUNTER);							// INC counter
+		const u16 skip = as.Branch(0xD0);				// BNE skip
+		as.Op(0xE6, COUNTER + 1);						// INC counter + 1
+		as.Land(skip);
+	} // end if
+	as.Op(0xA5, FLAG);									// LDA flag
+	as.Branch(0xF0, loop);								// BEQ loop
+	as.Op(0xA9, 0x00); as.Op(0x85, FLAG);				// LDA #0; STA flag
+
+	// some way into the frame, the first stripe and the counter from it
+	as.Op(0xA0, DELAY);									// LDY #DELAY
+	const u16 outer = as.pc;
+	as.Op(0xA2, 0x00);									// LDX #0
+	const u16 inner = as.pc;
+	as.Op(0xCA);										// DEX
+	as.Branch(0xD0, inner);								// BNE inner
+	as.Op(0x88);										// DEY
+	as.Branch(0xD0, outer);								// BNE outer
+
+	as.Op(0xA9, 0x00); as.Op16(0x8D, 0x8000);			// R0
+	as.Op(0xA9, 0x01); as.Op(0x85, BANK);				// bank 1
+	as.Op(0x0A);										// ASL, 2KB banks
+	as.Op16(0x8D, 0xC001);								// reload
+	as.Op16(0x8D, 0x8001);								// STA $8001
+	as.Op16(0x8D, 0xE001);								// IRQs on
+	as.Op16(0x4C, loop);								// JMP loop
+
+	// IRQ: acknowledge, count, next bank
+	const u16 irq = as.pc;
+	as.Op(0x48);										// PHA
+	as.Op(0x8A); as.Op(0x48);							// TXA; PHA
+	as.Op(0xBA);										// TSX
+	as.Op16(0xBD, 0x0103);								// LDA $0103,X, the pushed status
+	as.Op(0x85, IRQ_STATUS);							// STA status
+	as.Op16(0x8D, 0xE000);								// IRQ off, and acknowledged
+	as.Op16(0x8D, 0xE001);								// and on again
+	as.Op(0xE6, COUNT);									// INC count
+	as.Op(0xA9, 0x00); as.Op16(0x8D, 0x8000);			// R0
+	as.Op(0xE6, BANK);									// INC bank
+	as.Op(0xA5, BANK);									// LDA bank
+	as.Op(0x29, 0x03);									// AND #3
+	as.Op(0x0A);										// ASL, 2KB banks
+	as.Op16(0x8D, 0x8001);								// STA $8001
+	as.Op(0x68); as.Op(0xAA);							// PLA; TAX
+	as.Op(0x68);										// PLA
+	as.Op(0x40);										// RTI
+
+	// NMI: keep the count, IRQs off, back to bank 0, tell the main loop
+	const u16 nmi = as.pc;
+	as.Op(0x48);										// PHA
+	as.Op(0x8A); as.Op(0x48);							// TXA; PHA
+	as.Op(0xBA);										// TSX
+	as.Op16(0xBD, 0x0103);								// LDA $0103,X
+	as.Op(0x85, NMI_STATUS);							// STA status
+	as.Op16(0x8D, 0xE000);								// IRQs off
+	as.Op(0xA5, COUNT); as.Op(0x85, LAST_COUNT);		// the frame's count
+	as.Op(0xA9, 0x00);
+	as.Op(0x85, COUNT); as.Op(0x85, BANK);
+	as.Op16(0x8D, 0x8000); as.Op16(0x8D, 0x8001);		// R0, CHR bank 0
+	as.Op(0xE6, FLAG);									// INC flag
+	as.Op(0x68); as.Op(0xAA);							// PLA; TAX
+	as.Op(0x68);										// PLA
+	as.Op(0x40);										// RTI
+
+	const u16 vectors[3] = { nmi, 0x8000, irq };
+	for (u32 i = 0; i < 3; i++)
+	{
+		as.Poke(0xFFFA + i * 2, vectors[i] & 0xFF);
+		as.Poke(0xFFFB + i * 2, vectors[i] >> 8);
+	} // end for
+
+	std::vector<u8> chr(8192, 0);
+	for (u32 i = 0; i < 8192; i++)
+	{
+		const u32 color = i / 2048;
+		const bool high = (i & 8) != 0;
+		chr[i] = (color >> (high ? 1 : 0)) & 1 ? 0xFF : 0x00;
+	} // end for
+
+	return Ines_Image(4, as.rom, chr);
+} // end Build
+
+
+//=====================================================================|
+/**
+ * @brief Checks the stripes of a frame. The first comes from the main
+ *	loop's bank switch, on the line after the one it was written in; the
+ *	reload in the same line has the counter take the latch on the next
+ *	and run out LATCH lines later. The IRQ is taken as that line starts
+ *	for the CPU, since the PPU draws a line all at once, so the bank the
+ *	handler switches to shows from the line after, LATCH + 1 rows below
+ *	the first stripe; and so on down, with one IRQ for every stripe after
+ *	the first.
+ *
+ * @param irqs how many IRQs the program counted in the frame
+ */
+static void Check_Stripes(const u8* pixels, const u32 irqs, const char* what, const u32 frame)
+{
+	std::vector<u32> changes;
+	for (u32 row = 1; row < SCREEN_HEIGHT; row++)
+	{
+		if (pixels[row * SCREEN_WIDTH] != pixels[(row - 1) * SCREEN_WIDTH])
+			changes.push_back(row);
+	} // end for
+
+	const u32 first = changes.empty() ? 0 : changes[0];
+	const u32 want = first ? 1 + (SCREEN_HEIGHT - 1 - first) / (LATCH + 1u) : 0;
+	bool right = want > 2 && changes.size() == want && irqs == want - 1;
+	for (size_t i = 1; right && i < changes.size(); i++)
+		right = changes[i] - changes[i - 1] == LATCH + 1u;
+
+	Check(right, "%s, frame %u: %zu stripes from row %u and %u IRQs, not %u of them %u rows apart",
+		what, frame, changes.size(), first, irqs, want, LATCH + 1);
+} // end Check_Stripes
+
+
+//=====================================================================|
+/**
+ * @brief Runs one program on every backend with idle skipping on and
+ *	off, side by side, against the switch interpreter without skipping.
+ */
+static void Run(const bool busy)
+{
+	static const CPU6502::Backend backends[] = {
+		CPU6502::Backend::Switch, CPU6502::Backend::Lookup,
+		CPU6502::Backend::Blocks, CPU6502::Backend::Jit
+	};
+	constexpr u32 BACKENDS = sizeof(backends) / sizeof(backends[0]);
+	constexpr u32 COUNT_NES = BACKENDS * 2;
+
+	const char* loop = busy ? "busy loop" : "idle loop";
+	const std::vector<u8> image = Build(busy);
+
+	std::unique_ptr<NES> nes[COUNT_NES];
+	for (u32 i = 0; i < COUNT_NES; i++)
+	{
+		nes[i] = std::make_unique<NES>();
+		if (!Check(Insert_Image(*nes[i], image, "mmc3-irq.nes"), "the MMC3 cartridge won't go in"))
+			return;
+		nes[i]->cpu.Set_Backend(backends[i % BACKENDS]);
+		nes[i]->cpu.Set_Idle_Skip(i >= BACKENDS);
+	} // end for
+
+	std::vector<NES_Snapshot> snaps(COUNT_NES);
+	for (u32 frame = 0; frame < FRAMES; frame++)
+	{
+		for (u32 i = 0; i < COUNT_NES; i++)
+		{
+			nes[i]->Run_Frame(true);
+			nes[i]->Take_Snapshot(snaps[i]);
+		} // end for
+
+		// the program sets up in the first frame, and arms the IRQs from the
+		// second one's NMI on
+		const NES_Snapshot& ref = snaps[0];
+		if (frame > 1)
+			Check_Stripes(nes[0]->ppu.Get_Frame_Buffer(), ref.memory[LAST_COUNT], loop, frame);
+
+		for (u32 i = 1; i < COUNT_NES; i++)
+		{
+			const NES_Snapshot& snap = snaps[i];
+			const bool same = snap.pc == ref.pc && snap.a == ref.a && snap.x == ref.x &&
+				snap.y == ref.y && snap.sp == ref.sp && snap.status == ref.status &&
+				nes[i]->cpu.Get_Cycles() == nes[0]->cpu.Get_Cycles() &&
+				memcmp(snap.memory, ref.memory, RAM_SIZE) == 0 &&
+				memcmp(nes[i]->ppu.Get_Frame_Buffer(), nes[0]->ppu.Get_Frame_Buffer(),
+					SCREEN_WIDTH * SCREEN_HEIGHT) == 0;
+
+			if (!Check(same, "%s, frame %u: %s with idle skip %s and switch part",
+				loop, frame, CPU6502::Backend_Name(backends[i % BACKENDS]), i >= BACKENDS ? "on" : "off"))
+				return;
+		} // end for
+	} // end for
+
+	// or the waiting loop was never skipped, and this tested nothing of it
+	if (!busy)
+		Check(nes[BACKENDS]->cpu.Get_Idle_Loops() > 0, "idle loop: never skipped");
+
+	const NES_Snapshot& ref = snaps[0];
+	Check(!(ref.memory[IRQ_STATUS] & 0x04), "%s: the IRQ pushed a status with I set, %02X",
+		loop, ref.memory[IRQ_STATUS]);
+	Check(!(ref.memory[NMI_STATUS] & 0x04), "%s: the NMI pushed a status with I set, %02X",
+		loop, ref.memory[NMI_STATUS]);
+
+	printf("mmc3-irq: %s, %u frames of %u IRQs on %u consoles\n", loop, FRAMES, ref.memory[LAST_COUNT], COUNT_NES);
+} // end Run
+
+
+//=====================================================================|
+int main()
+{
+	Run(true);
+	Run(false);
+	return failures ? 1 : 0;
+} // end main
@@ -0,0 +1,114 @@
+/**
+ * @brief Turning the NMI on in the middle of vblank. The NMI has to come
+ *	right after the store to PPUCTRL on every backend, not wherever the
+ *	block or batch the store sits in would have ended; the program counts
+ *	the instructions that ran in between.
+ *
+ *	For Backend::Static the block is written out the way nest-recomp
+ *	writes one, under a crc of its own that no ROM has.
+ *
+ * @author Rediet Worku
+ * @date 26th of October 2021, Sunday
+ */
+
+
+//=====================================================================|
+#include "test.hpp"
+#include "cpu6502-ops.hpp"
+
+
+
+//=====================================================================|
+static const std::vector<u8> code = {
+	0x78,					// $8000	SEI
+	0xA9, 0x00,				// $8001	LDA #0
+	0x8D, 0x00, 0x20,		// $8003	STA $2000		NMI off
+	0x85, 0x20,				// $8006	STA $20			INCs run
+	0xA9, 0xFF,				// $8008	LDA #$FF
+	0x85, 0x21,				// $800A	STA $21			INCs run before the NMI
+	0x2C, 0x02, 0x20,		// $800C	BIT $2002
+	0x10, 0xFB,				// $800F	BPL $800C		wait for vblank
+	0xA2, 0x18,				// $8011	LDX #24
+	0xA0, 0x00,				// $8013	LDY #0
+	0x88,					// $8015	DEY
+	0xD0, 0xFD,				// $8016	BNE $8015
+	0xCA,					// $8018	DEX
+	0xD0, 0xFA,				// $8019	BNE $8015		a frame and 1000 cycles; the
+	0xA9, 0x80,				// $801B	LDA #$80		next vblank's flag is still up
+	0x8D, 0x00, 0x20,		// $801D	STA $2000		NMI on, and it's due
+	0xE6, 0x20,				// $8020	INC $20
+	0xE6, 0x20,				// $8022	INC $20
+	0xE6, 0x20,				// $8024	INC $20
+	0xE6, 0x20,				// $8026	INC $20
+	0x4C, 0x2B, 0x80,		// $8028	JMP $802B
+	0x4C, 0x2B, 0x80,		// $802B	JMP $802B
+	0xA5, 0x21,				// $802E	LDA $21			nmi: the first one only
+	0x10, 0x04,				// $8030	BPL $8036
+	0xA5, 0x20,				// $8032	LDA $20
+	0x85, 0x21,				// $8034	STA $21
+	0x40,					// $8036	RTI
+};
+
+static constexpr u16 NMI_HANDLER = 0x802E;
+static constexpr u32 PROGRAM_CRC = 0x4E4D4931;
+
+
+
+//=====================================================================|
+// the block from $801B to the JMP, as nest-recomp would write it
+template <>
+struct Recompiled<PROGRAM_CRC>
+{
+	static void Block_801B(CPU6502& cpu)
+	{
+		NEST_STATIC_OP(IMM, LDA, 0xA9, 0x0080, 0x801D, 2)	// $801B LDA
+		NEST_STATIC_OP(ABS, STA, 0x8D, 0x2000, 0x8020, 4)	// $801D STA
+		NEST_STATIC_OP(ZP0, INC, 0xE6, 0x0020, 0x8022, 5)	// $8020 INC
+		NEST_STATIC_OP(ZP0, INC, 0xE6, 0x0020, 0x8024, 5)	// $8022 INC
+		NEST_STATIC_OP(ZP0, INC, 0xE6, 0x0020, 0x8026, 5)	// $8024 INC
+		NEST_STATIC_OP(ZP0, INC, 0xE6, 0x0020, 0x8028, 5)	// $8026 INC
+		NEST_STATIC_OP(ABS, JMP, 0x4C, 0x802B, 0x802B, 3)	// $8028 JMP
+	} // end Block_801B
+
+	static constexpr Static_Block blocks[] = {
+		{ 0x801B, 29, &Block_801B },
+	};
+
+	static constexpr Static_Program program = {
+		PROGRAM_CRC, "nmi-mid-vblank", blocks, sizeof(blocks) / sizeof(blocks[0])
+	};
+};
+
+static const bool registered = CPU6502::Register_Program(Recompiled<PROGRAM_CRC>::program);
+
+
+
+//=====================================================================|
+int main()
+{
+	const CPU6502::Backend backends[] = {
+		CPU6502::Backend::Switch, CPU6502::Backend::Lookup, CPU6502::Backend::Blocks,
+		CPU6502::Backend::Jit, CPU6502::Backend::Static
+	};
+
+	Check(registered, "the static program didn't register");
+
+	for (const CPU6502::Backend backend : backends)
+	{
+		const char* name = CPU6502::Backend_Name(backend);
+
+		std::unique_ptr<NES> nes = std::make_unique<NES>();
+		Load_Program(*nes, code, NMI_HANDLER);
+		nes->cpu.Set_Backend(backend);
+		if (backend == CPU6502::Backend::Static)
+			Check(nes->cpu.Select_Program(PROGRAM_CRC), "%s: no program for the crc", name);
+
+		for (u32 frame = 0; frame < 4; frame++)
+			nes->Run_Frame(false);
+
+		Check(nes->ram[0x20] == 4, "%s: the INCs ran %u times, not 4", name, nes->ram[0x20]);
+		Check(nes->ram[0x21] == 0, "%s: the NMI came %d instructions late", name, (s8)nes->ram[0x21]);
+	} // end for
+
+	return failures ? 1 : 0;
+} // end main
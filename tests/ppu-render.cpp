@@ -0,0 +1,229 @@
+/**
+ * @brief The picture, pixel by pixel. The program loads all 32 palette
+ *	entries, fills the nametable with one tile whose columns are colors
+ *	3, 3, 1, 1, 2, 2, 0, 0, sets the attributes so each 16x16 block of a
+ *	32x32 one has a palette of its own, and puts up two sprites: one in
+ *	front of the background and one behind it, which only shows through
+ *	the background's color 0 columns. The NMI counts the frames.
+ *
+ *	Every frame after the first few has to come out as the palette says
+ *	it must, palette index for palette index and in color, on every
+ *	backend, with one NMI a frame.
+ *
+ * @author Rediet Worku
+ * @date 26th of October 2021, Sunday
+ */
+
+
+//=====================================================================|
+#include "test.hpp"
+
+
+
+//=====================================================================|
+constexpr u32 FRAMES = 12;
+constexpr u32 SETTLED = 3;				// the frames before it is all up
+
+// where the program keeps things
+constexpr u16 NMIS = 0x0030;			// counted by the NMI
+constexpr u16 SPRITES = 0x0200;			// copied to OAM before rendering goes on
+
+// the background's four palettes then the sprites'; 0x3F10 mirrors 0x3F00
+constexpr u8 palette[32] = {
+	0x0F, 0x01, 0x02, 0x03, 0x0F, 0x11, 0x12, 0x13,
+	0x0F, 0x21, 0x22, 0x23, 0x0F, 0x15, 0x16, 0x17,
+	0x0F, 0x27, 0x28, 0x29, 0x0F, 0x30, 0x31, 0x32,
+	0x0F, 0x05, 0x06, 0x07, 0x0F, 0x08, 0x09, 0x0A
+};
+
+// tile 1's colors, column by column
+constexpr u8 columns[8] = { 3, 3, 1, 1, 2, 2, 0, 0 };
+
+// the sprites: y, tile, attributes, x; drawn a line below their y
+struct Test_Sprite { u8 y, tile, attributes, x; };
+constexpr Test_Sprite sprites[2] = {
+	{ 50, 2, 0x01, 100 },				// in front, sprite palette 1
+	{ 120, 2, 0x22, 163 },				// behind, sprite palette 2
+};
+
+static const CPU6502::Backend backends[] = {
+	CPU6502::Backend::Switch, CPU6502::Backend::Lookup,
+	CPU6502::Backend::Blocks, CPU6502::Backend::Jit
+};
+
+
+
+//=====================================================================|
+/**
+ * @brief The cartridge: NROM, the program in 32KB of PRG, and CHR with
+ *	tile 1 the background's and tile 2 solid color 1 for the sprites.
+ */
+static std::vector<u8> Build()
+{
+	Assembler as;
+	as.Op(0x78);										// SEI
+	as.Op(0xD8);										// CLD
+	as.Op(0xA2, 0xFF); as.Op(0x9A);						// LDX #$FF; TXS
+	for (u32 i = 0; i < 2; i++)
+	{
+		const u16 vblank = as.pc;
+		as.Op16(0x2C, 0x2002);							// BIT $2002
+		as.Branch(0x10, vblank);						// BPL vblank
+	} // end for
+
+	// the palette, all of it
+	as.Op(0xA9, 0x3F); as.Op16(0x8D, 0x2006);
+	as.Op(0xA9, 0x00); as.Op16(0x8D, 0x2006);
+	for (u32 i = 0; i < 32; i++)
+	{
+		as.Op(0xA9, palette[i]);						// LDA #color
+		as.Op16(0x8D, 0x2007);							// STA $2007
+	} // end for
+
+	// nametable 0 all tile 1, the attributes a palette a quadrant
+	as.Op(0xA9, 0x20); as.Op16(0x8D, 0x2006);
+	as.Op(0xA9, 0x00); as.Op16(0x8D, 0x2006);
+	as.Op(0xA9, 0x01);									// LDA #1
+	as.Op(0xA2, 240);									// LDX #240
+	const u16 fill = as.pc;
+	for (u32 i = 0; i < 4; i++)
+		as.Op16(0x8D, 0x2007);							// STA $2007, 4 times
+	as.Op(0xCA);										// DEX
+	as.Branch(0xD0, fill);								// BNE fill
+	as.Op(0xA9, 0xE4);									// 3, 2 below; 1, 0 above
+	as.Op(0xA2, 64);									// LDX #64
+	const u16 attributes = as.pc;
+	as.Op16(0x8D, 0x2007);								// STA $2007
+	as.Op(0xCA);										// DEX
+	as.Branch(0xD0, attributes);						// BNE attributes
+	as.Op(0xA9, 0x00);
+	as.Op16(0x8D, 0x2005); as.Op16(0x8D, 0x2005);		// no scroll
+
+	// every sprite off the screen but the two
+	as.Op(0xA9, 0xFF);
+	as.Op(0xA2, 0x00);									// LDX #0
+	const u16 hide = as.pc;
+	as.Op16(0x9D, SPRITES);								// STA sprites,X
+	as.Op(0xE8);										// INX
+	as.Branch(0xD0, hide);								// BNE hide
+	for (u32 i = 0; i < 2; i++)
+	{
+		const u8 bytes[4] = { sprites[i].y, sprites[i].tile, sprites[i].attributes, sprites[i].x };
+		for (u32 j = 0; j < 4; j++)
+		{
+			as.Op(0xA9, bytes[j]);
+			as.Op16(0x8D, SPRITES + i * 4 + j);
+		} // end for
+	} // end for
+	as.Op(0xA9, 0x00); as.Op16(0x8D, 0x2003);			// OAMADDR 0
+	as.Op(0xA9, SPRITES >> 8); as.Op16(0x8D, 0x4014);	// OAM DMA
+
+	as.Op(0xA9, 0x80); as.Op16(0x8D, 0x2000);			// NMI on, tables at 0
+	as.Op(0xA9, 0x1E); as.Op16(0x8D, 0x2001);			// everything on, left column too
+	const u16 idle = as.pc;
+	as.Op16(0x4C, idle);								// JMP idle
+
+	// NMI: count it
+	const u16 nmi = as.pc;
+	as.Op(0xE6, NMIS);									// INC nmis
+	as.Op(0x40);										// RTI
+
+	const u16 vectors[3] = { nmi, 0x8000, nmi };
+	for (u32 i = 0; i < 3; i++)
+	{
+		as.Poke(0xFFFA + i * 2, vectors[i] & 0xFF);
+		as.Poke(0xFFFB + i * 2, vectors[i] >> 8);
+	} // end for
+
+	// tile 1: plane 0 high on columns 0 - 3, plane 1 on 0, 1, 4, 5
+	std::vector<u8> chr(8192, 0);
+	memset(&chr[1 * 16], 0xF0, 8);
+	memset(&chr[1 * 16 + 8], 0xCC, 8);
+	memset(&chr[2 * 16], 0xFF, 8);						// tile 2, plane 0
+
+	return Ines_Image(0, as.rom, chr);
+} // end Build
+
+
+//=====================================================================|
+/**
+ * @brief The palette index the picture must have at x, y: the background's
+ *	color through its quadrant's palette, unless a sprite covers it and is
+ *	in front or the background there is color 0.
+ */
+static u8 Expected(const u32 x, const u32 y)
+{
+	const u8 color = columns[x & 7];
+	const u32 quadrant = ((y >> 4) & 1) * 2 + ((x >> 4) & 1);
+	const u8 index = color ? palette[quadrant * 4 + color] : palette[0];
+
+	for (const Test_Sprite& s : sprites)
+	{
+		const bool covers = x >= s.x && x < s.x + 8u && y > s.y && y <= s.y + 8u;
+		const bool behind = (s.attributes & 0x20) != 0;
+		if (covers && (!behind || !color))
+			return palette[0x10 + (s.attributes & 0x03) * 4 + 1];
+	} // end for
+
+	return index;
+} // end Expected
+
+
+//=====================================================================|
+/**
+ * @brief Runs the program on a backend and checks every pixel of every
+ *	frame once it is all up.
+ */
+static void Test_Backend(const std::vector<u8>& image, const CPU6502::Backend backend)
+{
+	const char* name = CPU6502::Backend_Name(backend);
+
+	std::unique_ptr<NES> nes = std::make_unique<NES>();
+	if (!Check(Insert_Image(*nes, image, "ppu-render.nes"), "the cartridge won't go in"))
+		return;
+	nes->cpu.Set_Backend(backend);
+
+	u32 pictures = 0, nmis = 0;
+	for (u32 frame = 0; frame < FRAMES; frame++)
+	{
+		nes->Run_Frame(true);
+		const u8 counted = nes->ram[NMIS];
+		if (frame < SETTLED)
+		{
+			nmis = counted;
+			continue;
+		} // end if
+
+		if (!Check(counted == (u8)(nmis + 1), "%s, frame %u: %u NMIs, not one", name, frame, (u8)(counted - nmis)))
+			return;
+		nmis = counted;
+
+		const u8* pixels = nes->ppu.Get_Frame_Buffer();
+		const u32* rgba = nes->ppu.Get_Frame_RGBA();
+		for (u32 y = 0; y < SCREEN_HEIGHT; y++)
+		{
+			for (u32 x = 0; x < SCREEN_WIDTH; x++)
+			{
+				const u32 at = y * SCREEN_WIDTH + x;
+				const u8 want = Expected(x, y);
+				if (!Check(pixels[at] == want && rgba[at] == PPU::colors[want],
+					"%s, frame %u: the pixel at %u, %u is %02X, not %02X", name, frame, x, y, pixels[at], want))
+					return;
+			} // end for
+		} // end for
+		pictures++;
+	} // end for
+
+	printf("ppu-render: %s, %u pictures right\n", name, pictures);
+} // end Test_Backend
+
+
+//=====================================================================|
+int main()
+{
+	const std::vector<u8> image = Build();
+	for (const CPU6502::Backend backend : backends)
+		Test_Backend(image, backend);
+
+	return failures ? 1 : 0;
+} // end main
@@ -0,0 +1,242 @@
+/**
+ * @brief A frame run without its pixels has to leave the CPU where a drawn
+ *	one does. The program moves sprite 0 and a row of eight more sprites a
+ *	little every frame, changes the sprite height and whether the left
+ *	column shows, and polls PPUSTATUS all frame for sprite 0 hit and
+ *	overflow, logging the count it got to when either changed; the frames
+ *	where the flags come, go or never come are all in there.
+ *
+ *	One console draws every frame and the other only every fourth; RAM,
+ *	registers and cycles have to match after every frame, and so do the
+ *	pictures when both drew, so the skipped frames leave nothing behind.
+ *
+ * @author Rediet Worku
+ * @date 26th of October 2021, Sunday
+ */
+
+
+//=====================================================================|
+#include "test.hpp"
+
+
+
+//=====================================================================|
+constexpr u32 FRAMES = 240;
+constexpr u32 DRAW_EVERY = 4;			// the skipping console's drawn frames
+constexpr u32 ROW = 8;					// the sprites after sprite 0; overflow needs it too
+
+// where the program keeps things
+constexpr u16 FRAME = 0x0030;			// counted by the NMI
+constexpr u16 LAST_FLAGS = 0x0031;		// hit and overflow as last read
+constexpr u16 RISING = 0x0032;
+constexpr u16 HITS = 0x0033;			// the times sprite 0 hit came up
+constexpr u16 OVERFLOWS = 0x0034;		// and overflow
+constexpr u16 COUNTER = 0x0040;			// the polling loop's, 16 bits
+constexpr u16 SPRITES = 0x0200;			// copied to OAM by the NMI
+constexpr u16 LOG = 0x0300;				// flags, counter and frame, 256 bytes round
+
+constexpr u8 palette[8] = { 0x0F, 0x16, 0x2A, 0x12, 0x0F, 0x30, 0x27, 0x17 };
+
+
+
+//=====================================================================|
+/**
+ * @brief The cartridge: NROM, the program in 32KB of PRG and four tiles
+ *	of CHR: 0 is empty, 1 solid color 1 for the bottom half of the
+ *	background, 2 and 3 solid color 3 for the sprites, 8x8 and 8x16.
+ */
+static std::vector<u8> Build()
+{
+	Assembler as;
+	as.Op(0x78);										// SEI
+	as.Op(0xD8);										// CLD
+	as.Op(0xA2, 0xFF); as.Op(0x9A);						// LDX #$FF; TXS
+	for (u32 i = 0; i < 2; i++)
+	{
+		const u16 vblank = as.pc;
+		as.Op16(0x2C, 0x2002);							// BIT $2002
+		as.Branch(0x10, vblank);						// BPL vblank
+	} // end for
+
+	// the background and sprite palettes
+	for (u32 half = 0; half < 2; half++)
+	{
+		as.Op(0xA9, 0x3F); as.Op16(0x8D, 0x2006);
+		as.Op(0xA9, (u8)(half * 0x10)); as.Op16(0x8D, 0x2006);
+		for (u32 i = 0; i < 4; i++)
+		{
+			as.Op(0xA9, palette[half * 4 + i]);			// LDA #color
+			as.Op16(0x8D, 0x2007);						// STA $2007
+		} // end for
+	} // end for
+
+	// nametable 0: 15 rows of tile 0, 15 of tile 1, attributes all 0
+	as.Op(0xA9, 0x20); as.Op16(0x8D, 0x2006);
+	as.Op(0xA9, 0x00); as.Op16(0x8D, 0x2006);
+	for (u8 tile = 0; tile < 2; tile++)
+	{
+		as.Op(0xA9, tile);								// LDA #tile
+		as.Op(0xA2, 240);								// LDX #240
+		const u16 fill = as.pc;
+		as.Op16(0x8D, 0x2007); as.Op16(0x8D, 0x2007);	// STA $2007, twice
+		as.Op(0xCA);									// DEX
+		as.Branch(0xD0, fill);							// BNE fill
+	} // end for
+	as.Op(0xA9, 0x00);
+	as.Op(0xA2, 64);									// LDX #64
+	const u16 attributes = as.pc;
+	as.Op16(0x8D, 0x2007);								// STA $2007
+	as.Op(0xCA);										// DEX
+	as.Branch(0xD0, attributes);						// BNE attributes
+	as.Op16(0x8D, 0x2005); as.Op16(0x8D, 0x2005);		// no scroll
+
+	// every sprite off the screen, then sprite 0 and the row
+	as.Op(0xA9, 0xFF);
+	as.Op(0xA2, 0x00);									// LDX #0
+	const u16 hide = as.pc;
+	as.Op16(0x9D, SPRITES);								// STA sprites,X
+	as.Op(0xE8);										// INX
+	as.Branch(0xD0, hide);								// BNE hide
+	for (u32 i = 0; i <= ROW; i++)
+	{
+		as.Op(0xA9, 0x02); as.Op16(0x8D, SPRITES + i * 4 + 1);			// tile 2
+		as.Op(0xA9, i ? 0x01 : 0x00); as.Op16(0x8D, SPRITES + i * 4 + 2);	// palette
+		as.Op(0xA9, (u8)(i * 24)); as.Op16(0x8D, SPRITES + i * 4 + 3);	// x
+	} // end for
+
+	as.Op(0xA9, 0x80); as.Op16(0x8D, 0x2000);			// NMI on
+	as.Op(0xA9, 0x1E); as.Op16(0x8D, 0x2001);			// everything on
+
+	// poll PPUSTATUS and log every change of hit or overflow
+	as.Op(0xA2, 0x00);									// LDX #0
+	const u16 poll = as.pc;
+	as.Op(0xE6, COUNTER);								// INC counter
+	const u16 carry = as.Branch(0xD0);					// BNE carry
+	as.Op(0xE6, COUNTER + 1);							// INC counter + 1
+	as.Land(carry);
+	as.Op16(0xAD, 0x2002);								// LDA $2002
+	as.Op(0x29, 0x60);									// AND #$60
+	as.Op(0xC5, LAST_FLAGS);							// CMP last
+	as.Branch(0xF0, poll);								// BEQ poll
+
+	as.Op(0xA8);										// TAY
+	as.Op(0xA5, LAST_FLAGS); as.Op(0x49, 0xFF);			// LDA last; EOR #$FF
+	as.Op(0x84, LAST_FLAGS);							// STY last
+	as.Op(0x85, RISING);								// STA rising
+	as.Op(0x98); as.Op(0x25, RISING);					// TYA; AND rising
+	as.Op(0x85, RISING);								// STA rising, what came up
+	as.Op(0x24, RISING);								// BIT rising
+	const u16 no_hit = as.Branch(0x50);					// BVC no_hit
+	as.Op(0xE6, HITS);									// INC hits
+	as.Land(no_hit);
+	as.Op(0x29, 0x20);									// AND #$20
+	const u16 no_overflow = as.Branch(0xF0);			// BEQ no_overflow
+	as.Op(0xE6, OVERFLOWS);								// INC overflows
+	as.Land(no_overflow);
+
+	as.Op(0x98); as.Op16(0x9D, LOG);					// TYA; STA log,X
+	as.Op(0xA5, COUNTER); as.Op16(0x9D, LOG + 1);		// the count
+	as.Op(0xA5, COUNTER + 1); as.Op16(0x9D, LOG + 2);
+	as.Op(0xA5, FRAME); as.Op16(0x9D, LOG + 3);			// the frame
+	as.Op(0xE8); as.Op(0xE8); as.Op(0xE8); as.Op(0xE8);	// INX, 4 times
+	as.Op16(0x4C, poll);								// JMP poll
+
+	// NMI: move the sprites and copy them in, the height and left column
+	const u16 nmi = as.pc;
+	as.Op(0x48);										// PHA
+	as.Op(0xE6, FRAME);									// INC frame
+	as.Op(0xA5, FRAME); as.Op(0x0A);					// LDA frame; ASL
+	as.Op(0x18); as.Op(0x65, FRAME);					// CLC; ADC frame
+	as.Op16(0x8D, SPRITES);								// sprite 0 y, 3 a frame
+	as.Op(0xA5, FRAME);
+	as.Op(0x0A); as.Op(0x0A); as.Op(0x0A);				// ASL, 3 times
+	as.Op(0x38); as.Op(0xE5, FRAME);					// SEC; SBC frame
+	as.Op16(0x8D, SPRITES + 3);							// sprite 0 x, 7 a frame
+	as.Op(0xA5, FRAME);
+	as.Op(0x0A); as.Op(0x0A);							// ASL, twice
+	as.Op(0x18); as.Op(0x65, FRAME);					// CLC; ADC frame
+	for (u32 i = 1; i <= ROW; i++)
+		as.Op16(0x8D, SPRITES + i * 4);					// the row's y, 5 a frame
+	as.Op(0xA9, 0x00); as.Op16(0x8D, 0x2003);			// OAMADDR 0
+	as.Op(0xA9, SPRITES >> 8); as.Op16(0x8D, 0x4014);	// OAM DMA
+
+	as.Op(0xA5, FRAME); as.Op(0x29, 0x04);				// 8x16 four frames in eight
+	as.Op(0x0A); as.Op(0x0A); as.Op(0x0A);				// ASL, 3 times
+	as.Op(0x09, 0x80);									// ORA #$80, NMI on
+	as.Op16(0x8D, 0x2000);								// STA $2000
+
+	as.Op(0xA5, FRAME); as.Op(0x29, 0x08);				// LDA frame; AND #8
+	const u16 hide_left = as.Branch(0xD0);				// BNE hide_left
+	as.Op(0xA9, 0x1E);									// LDA #$1E
+	const u16 store = as.Branch(0xD0);					// BNE store
+	as.Land(hide_left);
+	as.Op(0xA9, 0x18);									// LDA #$18
+	as.Land(store);
+	as.Op16(0x8D, 0x2001);								// STA $2001
+	as.Op(0x68);										// PLA
+	as.Op(0x40);										// RTI
+
+	const u16 vectors[3] = { nmi, 0x8000, nmi };
+	for (u32 i = 0; i < 3; i++)
+	{
+		as.Poke(0xFFFA + i * 2, vectors[i] & 0xFF);
+		as.Poke(0xFFFB + i * 2, vectors[i] >> 8);
+	} // end for
+
+	std::vector<u8> chr(8192, 0);
+	memset(&chr[1 * 16], 0xFF, 8);						// tile 1, plane 0
+	memset(&chr[2 * 16], 0xFF, 32);						// tiles 2 and 3, both planes
+
+	return Ines_Image(0, as.rom, chr);
+} // end Build
+
+
+//=====================================================================|
+int main()
+{
+	const std::vector<u8> image = Build();
+
+	std::unique_ptr<NES> drawing = std::make_unique<NES>(), skipping = std::make_unique<NES>();
+	NES& drawn = *drawing;
+	NES& skipped = *skipping;
+	if (!Check(Insert_Image(drawn, image, "skip-pixels.nes") &&
+		Insert_Image(skipped, image, "skip-pixels.nes"), "the cartridge won't go in"))
+		return 1;
+
+	NES_Snapshot want, got;
+	u32 compared = 0;
+	for (u32 frame = 0; frame < FRAMES; frame++)
+	{
+		const bool draw = frame % DRAW_EVERY == DRAW_EVERY - 1;
+		drawn.Run_Frame(true);
+		skipped.Run_Frame(draw);
+		drawn.Take_Snapshot(want);
+		skipped.Take_Snapshot(got);
+
+		const bool same = got.pc == want.pc && got.a == want.a && got.x == want.x &&
+			got.y == want.y && got.sp == want.sp && got.status == want.status &&
+			skipped.cpu.Get_Cycles() == drawn.cpu.Get_Cycles() &&
+			memcmp(got.memory, want.memory, RAM_SIZE) == 0;
+		if (!Check(same, "frame %u: skipping pixels left the CPU at %04X after %llu cycles, not %04X after %llu",
+			frame, got.pc, (unsigned long long)skipped.cpu.Get_Cycles(),
+			want.pc, (unsigned long long)drawn.cpu.Get_Cycles()))
+			break;
+
+		if (draw)
+		{
+			if (!Check(memcmp(skipped.ppu.Get_Frame_Buffer(), drawn.ppu.Get_Frame_Buffer(),
+				SCREEN_WIDTH * SCREEN_HEIGHT) == 0, "frame %u: drawn after skipping, the picture differs", frame))
+				break;
+			++compared;
+		} // end if
+	} // end for
+
+	// or the flags never changed and this tested nothing
+	const u8 hits = want.memory[HITS], overflows = want.memory[OVERFLOWS];
+	Check(hits > 0 && hits < FRAMES, "sprite 0 hit came up %u times in %u frames", hits, FRAMES);
+	Check(overflows > 0 && overflows < FRAMES, "overflow came up %u times in %u frames", overflows, FRAMES);
+
+	printf("skip-pixels: %u frames, %u pictures compared, %u sprite 0 hits, %u overflows\n",
+		FRAMES, compared, hits, overflows);
+	return failures ? 1 : 0;
+} // end main
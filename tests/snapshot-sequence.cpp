@@ -0,0 +1,90 @@
+/**
+ * @brief The snapshots IV draws from, across frames the render thread
+ *	never got to. The console goes through the triple buffer the way
+ *	NEST::Update sends it, while the reader only looks every so often
+ *	and keeps its own copy of RAM up to date the way IV::Draw_RAM does:
+ *	the written bits when the snapshot follows the last, all of it when
+ *	it doesn't. Its copy has to match every snapshot it takes.
+ *
+ * @author Rediet Worku
+ * @date 26th of October 2021, Sunday
+ */
+
+
+//=====================================================================|
+#include "test.hpp"
+#include "triple-buffer.hpp"
+
+
+
+//=====================================================================|
+int main()
+{
+	// a byte of page 2 goes up every 1300 cycles or so, 7 bytes on from
+	//	the last; a frame writes a couple of dozen, few of them twice running
+	const std::vector<u8> code = {
+		0xA2, 0x00,				// $8000	LDX #0
+		0xA0, 0x00,				// $8002	LDY #0
+		0x88,					// $8004	DEY
+		0xD0, 0xFD,				// $8005	BNE $8004
+		0xFE, 0x00, 0x02,		// $8007	INC $0200,X
+		0x8A,					// $800A	TXA
+		0x18,					// $800B	CLC
+		0x69, 0x07,				// $800C	ADC #7
+		0xAA,					// $800E	TAX
+		0x4C, 0x02, 0x80,		// $800F	JMP $8002
+	};
+
+	std::unique_ptr<NES> nes = std::make_unique<NES>();
+	Load_Program(*nes, code);
+	nes->Track_Writes(true);
+
+	TripleBuffer<NES_Snapshot> frames;
+	u8 view[RAM_SIZE] = {};		// kept the way IV does
+	u8 naive[RAM_SIZE] = {};	// written bits only, right as of the last look
+	u64 seen = 0;
+
+	u32 looks = 0, missed = 0, stale = 0;
+	u32 rng = 12345;
+	for (u32 frame = 0; frame < 300; frame++)
+	{
+		nes->Run_Frame(false);
+		nes->Take_Snapshot(frames.Back());
+		frames.Publish();
+
+		// the reader looks after one frame in three, on average
+		rng = rng * 1103515245 + 12345;
+		if ((rng >> 16) % 3 || !frames.Acquire())
+			continue;
+
+		NES_Snapshot& snap = frames.Front();
+		const bool follows = snap.Follows(seen);
+		seen = snap.sequence;
+
+		snap.Drain_Written([&](const u16 addr)
+		{
+			if (addr < RAM_SIZE)
+				view[addr] = naive[addr] = snap.Peek(addr);
+		});
+		if (!follows)
+		{
+			memcpy(view, snap.memory, RAM_SIZE);
+			missed++;
+		} // end if
+
+		looks++;
+		Check(memcmp(view, snap.memory, RAM_SIZE) == 0,
+			"snapshot %llu: the view doesn't match RAM", (unsigned long long)snap.sequence);
+		if (memcmp(naive, snap.memory, RAM_SIZE) != 0)
+			stale++;
+		memcpy(naive, snap.memory, RAM_SIZE);
+	} // end for
+
+	// or the test never got to the case it is for
+	Check(missed > 0, "the reader never missed a snapshot");
+	Check(stale > 0, "no dropped frame wrote anything the next one didn't");
+
+	printf("snapshot-sequence: %u looks, %u after a dropped frame, %u would have been stale\n",
+		looks, missed, stale);
+	return failures ? 1 : 0;
+} // end main
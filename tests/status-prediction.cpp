@@ -0,0 +1,293 @@
+/**
+ * @brief PPUSTATUS polled with its changes predicted, against a console
+ *	that runs the lines for every read. The program polls all frame and
+ *	keeps the count it got to when it first saw sprite 0 hit and vblank.
+ *
+ *	Some way down the frame, before sprite 0's line, it makes one of the
+ *	writes that have to throw the prediction away, each bringing the hit
+ *	in earlier than predicted, which a poll going by the old prediction
+ *	would see late:
+ *
+ *		frame & 3 == 0	nothing; sprite 0 low down
+ *		frame & 3 == 1	sprite 0 moved up, through OAMDATA or OAM DMA
+ *		frame & 3 == 2	PPUMASK turning sprites on
+ *		frame & 3 == 3	the mapper switching in the CHR bank whose
+ *						background is there to hit
+ *
+ *	RAM, registers and cycles have to match after every frame.
+ *
+ * @author Rediet Worku
+ * @date 26th of October 2021, Sunday
+ */
+
+
+//=====================================================================|
+#include "test.hpp"
+
+
+
+//=====================================================================|
+constexpr u32 FRAMES = 64;
+constexpr u8 EARLY = 100;				// sprite 0's y, and where it is moved up from
+constexpr u8 LATE = 200;
+constexpr u8 CHANGE_AT = 1;				// the count's high byte the write is made at
+
+// where the program keeps things
+constexpr u16 FRAME = 0x0030;			// counted by the NMI
+constexpr u16 FLAG = 0x0031;			// set by it
+constexpr u16 SEEN = 0x0032;
+constexpr u16 RESULTS = 0x0034;			// 4 bytes for each frame & 3, which the NMI
+constexpr u16 HIT_AT = RESULTS;			//	starting the next one doesn't touch: the
+constexpr u16 VBLANK_AT = RESULTS + 2;	//	count sprite 0 hit was first seen at, and vblank
+constexpr u16 COUNTER = 0x0044;			// the polling loop's, 16 bits
+constexpr u16 LATE_OAM = 0x0200;		// sprite 0 low down
+constexpr u16 EARLY_OAM = 0x0300;		// and up
+
+constexpr u8 palette[8] = { 0x0F, 0x16, 0x2A, 0x12, 0x0F, 0x30, 0x27, 0x17 };
+
+
+
+//=====================================================================|
+/**
+ * @brief The cartridge: CNROM, the program in 32KB of PRG and two banks
+ *	of CHR. Tile 1 fills the background and tile 2 is sprite 0, both
+ *	solid in bank 0; bank 1 has the same sprite over a background of
+ *	nothing, which sprite 0 can't hit.
+ */
+static std::vector<u8> Build()
+{
+	Assembler as;
+	as.Op(0x78);										// SEI
+	as.Op(0xD8);										// CLD
+	as.Op(0xA2, 0xFF); as.Op(0x9A);						// LDX #$FF; TXS
+	for (u32 i = 0; i < 2; i++)
+	{
+		const u16 vblank = as.pc;
+		as.Op16(0x2C, 0x2002);							// BIT $2002
+		as.Branch(0x10, vblank);						// BPL vblank
+	} // end for
+
+	// the background and sprite palettes
+	for (u32 half = 0; half < 2; half++)
+	{
+		as.Op(0xA9, 0x3F); as.Op16(0x8D, 0x2006);
+		as.Op(0xA9, (u8)(half * 0x10)); as.Op16(0x8D, 0x2006);
+		for (u32 i = 0; i < 4; i++)
+		{
+			as.Op(0xA9, palette[half * 4 + i]);			// LDA #color
+			as.Op16(0x8D, 0x2007);						// STA $2007
+		} // end for
+	} // end for
+
+	// nametable 0 all tile 1, attributes all 0
+	as.Op(0xA9, 0x20); as.Op16(0x8D, 0x2006);
+	as.Op(0xA9, 0x00); as.Op16(0x8D, 0x2006);
+	as.Op(0xA9, 0x01);									// LDA #1
+	as.Op(0xA2, 240);									// LDX #240
+	const u16 fill = as.pc;
+	for (u32 i = 0; i < 4; i++)
+		as.Op16(0x8D, 0x2007);							// STA $2007, 4 times
+	as.Op(0xCA);										// DEX
+	as.Branch(0xD0, fill);								// BNE fill
+	as.Op(0xA9, 0x00);
+	as.Op(0xA2, 64);									// LDX #64
+	const u16 attributes = as.pc;
+	as.Op16(0x8D, 0x2007);								// STA $2007
+	as.Op(0xCA);										// DEX
+	as.Branch(0xD0, attributes);						// BNE attributes
+	as.Op16(0x8D, 0x2005); as.Op16(0x8D, 0x2005);		// no scroll
+
+	// both OAM pages: every sprite off the screen but sprite 0
+	as.Op(0xA9, 0xFF);
+	as.Op(0xA2, 0x00);									// LDX #0
+	const u16 hide = as.pc;
+	as.Op16(0x9D, LATE_OAM); as.Op16(0x9D, EARLY_OAM);	// STA page,X
+	as.Op(0xE8);										// INX
+	as.Branch(0xD0, hide);								// BNE hide
+	const u8 sprite[4] = { 0, 0x02, 0x00, 64 };
+	for (u32 i = 0; i < 4; i++)
+	{
+		as.Op(0xA9, i ? sprite[i] : LATE); as.Op16(0x8D, LATE_OAM + i);
+		as.Op(0xA9, i ? sprite[i] : EARLY); as.Op16(0x8D, EARLY_OAM + i);
+	} // end for
+
+	as.Op(0xA9, 0x80); as.Op16(0x8D, 0x2000);			// NMI on
+	as.Op(0xA9, 0x1E); as.Op16(0x8D, 0x2001);			// everything on
+
+	// wait for the NMI, then for the pre-render line to clear the hit
+	const u16 main = as.pc;
+	as.Op(0xA5, FLAG);									// LDA flag
+	as.Branch(0xF0, main);								// BEQ main
+	as.Op(0xA9, 0x00);
+	as.Op(0x85, FLAG); as.Op(0x85, SEEN);
+	as.Op(0x85, COUNTER); as.Op(0x85, COUNTER + 1);
+	as.Op(0xA5, FRAME); as.Op(0x29, 0x03);				// LDA frame; AND #3
+	as.Op(0x0A); as.Op(0x0A); as.Op(0xAA);				// ASL; ASL; TAX, the frame's results
+	as.Op(0xA9, 0xFF);
+	as.Op(0x95, HIT_AT); as.Op(0x95, HIT_AT + 1);		// STA hit,X
+	as.Op(0x95, VBLANK_AT); as.Op(0x95, VBLANK_AT + 1);
+	const u16 clear = as.pc;
+	as.Op16(0xAD, 0x2002);								// LDA $2002
+	as.Op(0x29, 0x40);									// AND #$40
+	as.Branch(0xD0, clear);								// BNE clear
+
+	// poll, making the write once on the way
+	const u16 poll = as.pc;
+	as.Op(0xE6, COUNTER);								// INC counter
+	const u16 carry = as.Branch(0xD0);					// BNE carry
+	as.Op(0xE6, COUNTER + 1);							// INC counter + 1
+	as.Land(carry);
+	as.Op(0xA5, COUNTER);								// LDA counter
+	const u16 look = as.Branch(0xD0);					// BNE look
+	as.Op(0xA5, COUNTER + 1);							// LDA counter + 1
+	as.Op(0xC9, CHANGE_AT);								// CMP #CHANGE_AT
+	const u16 look_too = as.Branch(0xD0);				// BNE look
+	const u16 call = as.pc;
+	as.Op16(0x20, 0);									// JSR change
+	as.Land(look);
+	as.Land(look_too);
+
+	as.Op16(0xAD, 0x2002);								// LDA $2002
+	as.Op(0xA8);										// TAY
+	as.Op(0x29, 0x40);									// AND #$40
+	const u16 no_hit = as.Branch(0xF0);					// BEQ no_hit
+	as.Op(0x24, SEEN);									// BIT seen
+	const u16 seen = as.Branch(0x70);					// BVS seen
+	as.Op(0x85, SEEN);									// STA seen
+	as.Op(0xA5, COUNTER); as.Op(0x95, HIT_AT);			// STA hit,X
+	as.Op(0xA5, COUNTER + 1); as.Op(0x95, HIT_AT + 1);
+	as.Land(no_hit);
+	as.Land(seen);
+	as.Op(0x98);										// TYA
+	as.Branch(0x10, poll);								// BPL poll
+	as.Op(0xA5, COUNTER); as.Op(0x95, VBLANK_AT);		// STA vblank,X
+	as.Op(0xA5, COUNTER + 1); as.Op(0x95, VBLANK_AT + 1);
+	as.Op16(0x4C, main);								// JMP main
+
+	// change: the write this frame makes, if any
+	const u16 change = as.pc;
+	as.Poke(call + 1, change & 0xFF);
+	as.Poke(call + 2, change >> 8);
+	as.Op(0xA5, FRAME); as.Op(0x29, 0x03);				// LDA frame; AND #3
+	as.Op(0xC9, 0x01);									// CMP #1
+	const u16 not_oam = as.Branch(0xD0);				// BNE not_oam
+	as.Op(0xA5, FRAME); as.Op(0x29, 0x04);				// LDA frame; AND #4
+	const u16 by_data = as.Branch(0xF0);				// BEQ by_data
+	as.Op(0xA9, EARLY_OAM >> 8); as.Op16(0x8D, 0x4014);	// OAM DMA
+	as.Op(0x60);										// RTS
+	as.Land(by_data);
+	as.Op(0xA9, EARLY); as.Op16(0x8D, 0x2004);			// sprite 0's y; OAMADDR is still 0
+	as.Op(0x60);										// RTS
+	as.Land(not_oam);
+	as.Op(0xC9, 0x02);									// CMP #2
+	const u16 not_mask = as.Branch(0xD0);				// BNE not_mask
+	as.Op(0xA9, 0x1E); as.Op16(0x8D, 0x2001);			// sprites on
+	as.Op(0x60);										// RTS
+	as.Land(not_mask);
+	as.Op(0xC9, 0x03);									// CMP #3
+	const u16 done = as.Branch(0xD0);					// BNE done
+	as.Op(0xA9, 0x00); as.Op16(0x8D, 0x8000);			// CHR bank 0
+	as.Land(done);
+	as.Op(0x60);										// RTS
+
+	// NMI: how the frame starts off; sprite 0 low down only for 0 and 1
+	const u16 nmi = as.pc;
+	as.Op(0x48);										// PHA
+	as.Op(0xE6, FRAME); as.Op(0xE6, FLAG);				// INC frame; INC flag
+	as.Op(0xA9, 0x00); as.Op16(0x8D, 0x2003);			// OAMADDR 0
+	as.Op(0xA5, FRAME); as.Op(0x29, 0x03);				// LDA frame; AND #3
+	as.Op(0xC9, 0x02);									// CMP #2, carry for 2 and 3
+	as.Op(0xA9, LATE_OAM >> 8); as.Op(0x69, 0x00);		// LDA #page; ADC #0
+	as.Op16(0x8D, 0x4014);								// OAM DMA
+
+	as.Op(0xA5, FRAME); as.Op(0x29, 0x03);
+	as.Op(0xC9, 0x02);									// CMP #2
+	const u16 sprites_on = as.Branch(0xD0);				// BNE sprites_on
+	as.Op(0xA9, 0x0A);									// LDA #$0A, background only
+	const u16 store_mask = as.Branch(0xD0);				// BNE store_mask
+	as.Land(sprites_on);
+	as.Op(0xA9, 0x1E);									// LDA #$1E
+	as.Land(store_mask);
+	as.Op16(0x8D, 0x2001);								// STA $2001
+
+	as.Op(0xA5, FRAME); as.Op(0x29, 0x03);
+	as.Op(0xC9, 0x03);									// CMP #3, carry for 3
+	as.Op(0xA9, 0x00); as.Op(0x2A);						// LDA #0; ROL
+	as.Op16(0x8D, 0x8000);								// CHR bank 1 for 3
+	as.Op(0x68);										// PLA
+	as.Op(0x40);										// RTI
+
+	const u16 vectors[3] = { nmi, 0x8000, nmi };
+	for (u32 i = 0; i < 3; i++)
+	{
+		as.Poke(0xFFFA + i * 2, vectors[i] & 0xFF);
+		as.Poke(0xFFFB + i * 2, vectors[i] >> 8);
+	} // end for
+
+	std::vector<u8> chr(16384, 0);
+	memset(&chr[1 * 16], 0xFF, 8);						// bank 0 tile 1, plane 0
+	memset(&chr[2 * 16], 0xFF, 16);						// tile 2, both planes
+	memset(&chr[8192 + 2 * 16], 0xFF, 16);				// and in bank 1
+
+	return Ines_Image(3, as.rom, chr);
+} // end Build
+
+
+//=====================================================================|
+int main()
+{
+	static const char* changes[4] = { "nothing", "OAM", "PPUMASK", "the mapper" };
+	const std::vector<u8> image = Build();
+
+	std::unique_ptr<NES> predicting = std::make_unique<NES>(), running = std::make_unique<NES>();
+	if (!Check(Insert_Image(*predicting, image, "status-prediction.nes") &&
+		Insert_Image(*running, image, "status-prediction.nes"), "the cartridge won't go in"))
+		return 1;
+	running->ppu.Set_Status_Prediction(false);
+
+	NES_Snapshot want, got;
+	u16 late_hit = 0;
+	u32 earlier = 0;
+	for (u32 frame = 0; frame < FRAMES; frame++)
+	{
+		running->Run_Frame(false);
+		predicting->Run_Frame(false);
+		running->Take_Snapshot(want);
+		predicting->Take_Snapshot(got);
+
+		// the results of the frame the NMI just ended
+		const u8 change = (want.memory[FRAME] - 1) & 3;
+		const u8* results = want.memory + RESULTS + change * 4;
+		const u8* got_results = got.memory + RESULTS + change * 4;
+		const u16 hit_at = results[0] | (results[1] << 8);
+		const u16 vblank_at = results[2] | (results[3] << 8);
+		const u16 got_hit = got_results[0] | (got_results[1] << 8);
+		const u16 got_vblank = got_results[2] | (got_results[3] << 8);
+
+		const bool same = got.pc == want.pc && got.a == want.a && got.x == want.x &&
+			got.y == want.y && got.sp == want.sp && got.status == want.status &&
+			predicting->cpu.Get_Cycles() == running->cpu.Get_Cycles() &&
+			memcmp(got.memory, want.memory, RAM_SIZE) == 0;
+		if (!Check(same, "frame %u, after %s: hit seen at %u and vblank at %u, not %u and %u",
+			frame, changes[change], got_hit, got_vblank, hit_at, vblank_at))
+			break;
+
+		// the first frames are the setting up, and the one the first NMI starts
+		if (frame < 3 || vblank_at == 0xFFFF)
+			continue;
+		// or the write changed nothing, and this tested nothing of it
+		if (change == 0)
+			late_hit = hit_at;
+		else if (late_hit)
+		{
+			Check(hit_at < late_hit, "frame %u: %s brought the hit in to %u, from %u",
+				frame, changes[change], hit_at, late_hit);
+			++earlier;
+		} // end else if
+	} // end for
+
+	Check(earlier > 0, "no frame had the hit brought in");
+
+	printf("status-prediction: %u frames, %u with the hit brought in earlier than predicted\n", FRAMES, earlier);
+	return failures ? 1 : 0;
+} // end main
@@ -0,0 +1,153 @@
+/**
+ * @brief What the tests share. Check reports a condition that doesn't
+ *	hold and counts it, and main returns whether any didn't. Programs run
+ *	out of the console's own 32KB at 0x8000, with no cartridge in, so no
+ *	test needs a ROM file; one that needs a mapper makes its cartridge up
+ *	and has it written to the temp directory just long enough to load.
+ *
+ * @author Rediet Worku
+ * @date 26th of October 2021, Sunday
+ */
+#pragma once
+
+
+//=====================================================================|
+#include "nes.hpp"
+
+#include <cstdarg>
+#include <cstdio>
+#include <filesystem>
+
+
+
+//=====================================================================|
+inline u32 failures = 0;
+
+
+//=====================================================================|
+/**
+ * @brief Reports format when ok is false, and counts it against the test.
+ *
+ * @return ok
+ */
+inline bool Check(const bool ok, const char* format, ...)
+{
+	if (ok)
+		return true;
+
+	va_list args;
+	va_start(args, format);
+	fputs("FAIL: ", stderr);
+	vfprintf(stderr, format, args);
+	fputc('\n', stderr);
+	va_end(args);
+
+	failures++;
+	return false;
+} // end Check
+
+
+//=====================================================================|
+/**
+ * @brief A little xorshift, so every run of a test sees the same; state
+ *	must not start at 0.
+ */
+inline u32 Random(u32& state)
+{
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+	return state;
+} // end Random
+
+
+//=====================================================================|
+/**
+ * @brief Just enough of an assembler: bytes at a running address, and
+ *	branches to labels further on patched once they are known. rom is the
+ *	32KB at 0x8000, what Load_Program takes.
+ */
+struct Assembler
+{
+	std::vector<u8> rom = std::vector<u8>(PRG_ROM_SIZE, 0);
+	u16 pc = 0x8000;
+
+	void Byte(const u8 b) { rom[pc++ - 0x8000] = b; }
+	void Op(const u8 opc) { Byte(opc); }
+	void Op(const u8 opc, const u8 operand) { Byte(opc); Byte(operand); }
+	void Op16(const u8 opc, const u16 operand) { Byte(opc); Byte(operand & 0xFF); Byte(operand >> 8); }
+	void Poke(const u16 addr, const u8 b) { rom[addr - 0x8000] = b; }
+
+	// a branch back to target
+	void Branch(const u8 opc, const u16 target) { Op(opc, (u8)(target - (pc + 2))); }
+
+	// a branch forward; returns where to Land it
+	u16 Branch(const u8 opc) { Op(opc, 0); return pc - 1; }
+	void Land(const u16 at) { Poke(at, (u8)(pc - (at + 1))); }
+};
+
+
+//=====================================================================|
+/**
+ * @brief Puts code at 0x8000 with the reset vector on it, and resets the
+ *	console onto it. NMI and IRQ/BRK go to nmi and irq.
+ */
+inline void Load_Program(NES& nes, const std::vector<u8>& code,
+	const u16 nmi = 0x8000, const u16 irq = 0x8000)
+{
+	iZero(nes.prg_rom, PRG_ROM_SIZE);
+	memcpy(nes.prg_rom, code.data(), code.size());
+
+	const u16 vectors[3] = { nmi, 0x8000, irq };
+	for (u32 i = 0; i < 3; i++)
+	{
+		nes.prg_rom[0x7FFA + i * 2] = vectors[i] & 0xFF;
+		nes.prg_rom[0x7FFB + i * 2] = vectors[i] >> 8;
+	} // end for
+
+	nes.cpu.Reset();
+} // end Load_Program
+
+
+//=====================================================================|
+/**
+ * @brief An iNES image: the 16 byte header, then PRG and CHR; no CHR
+ *	makes it CHR RAM. flags6 goes in with the mapper's low nibble.
+ */
+inline std::vector<u8> Ines_Image(const u8 mapper, const std::vector<u8>& prg,
+	const std::vector<u8>& chr, const u8 flags6 = 0)
+{
+	std::vector<u8> image(16);
+	memcpy(image.data(), "NES\x1A", 4);
+	image[4] = (u8)(prg.size() / 16384);
+	image[5] = (u8)(chr.size() / 8192);
+	image[6] = (u8)((mapper << 4) | (flags6 & 0x0F));
+	image[7] = mapper & 0xF0;
+
+	image.insert(image.end(), prg.begin(), prg.end());
+	image.insert(image.end(), chr.begin(), chr.end());
+	return image;
+} // end Ines_Image
+
+
+//=====================================================================|
+/**
+ * @brief Writes image out to the temp directory as name, puts it in the
+ *	console, and deletes it again.
+ *
+ * @return what Insert_Cartridge says
+ */
+inline bool Insert_Image(NES& nes, const std::vector<u8>& image, const char* name)
+{
+	const std::string path = (std::filesystem::temp_directory_path() / name).string();
+	FILE* fp = fopen(path.c_str(), "wb");
+	if (!fp)
+		return Check(false, "can't write %s", path.c_str());
+	const bool written = fwrite(image.data(), 1, image.size(), fp) == image.size();
+	fclose(fp);
+
+	const bool ok = written && nes.Insert_Cartridge(path);
+	std::error_code ignored;
+	std::filesystem::remove(path, ignored);
+	return ok;
+} // end Insert_Image